@@ -0,0 +1,256 @@
+// Copyright (c) 2009-2010 Satoshi Nakamoto
+// Copyright (c) 2009-2015 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "addressbalance.h"
+
+CAddressBalanceRanking addressBalanceRanking;
+
+/**
+ * Treap node, ordered by descending balance then by key. Every node keeps the size of its subtree
+ * so ranks and offsets are resolved in O(log n).
+ */
+struct CAddressBalanceRanking::Node {
+    CAmount balance;
+    CAddressBalanceKey key;
+    uint32_t priority;
+    size_t size;
+    Node *left;
+    Node *right;
+
+    Node(CAmount nBalance, const CAddressBalanceKey &keyIn, uint32_t nPriority) :
+        balance(nBalance), key(keyIn), priority(nPriority), size(1), left(NULL), right(NULL) {}
+};
+
+namespace {
+
+// xorshift, the priorities only need to be well spread
+uint32_t NextPriority()
+{
+    static uint32_t state = 2463534242U;
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+} // anon namespace
+
+static inline size_t NodeSize(const CAddressBalanceRanking::Node *node)
+{
+    return node != NULL ? node->size : 0;
+}
+
+static inline void UpdateSize(CAddressBalanceRanking::Node *node)
+{
+    node->size = 1 + NodeSize(node->left) + NodeSize(node->right);
+}
+
+// richer addresses first, ties broken by key so every address has a distinct position
+static inline bool RankLess(CAmount balanceA, const CAddressBalanceKey &keyA, CAmount balanceB, const CAddressBalanceKey &keyB)
+{
+    return balanceA > balanceB || (balanceA == balanceB && keyA < keyB);
+}
+
+// splits t into the nodes ranked before (balance, key) and the rest
+static void Split(CAddressBalanceRanking::Node *t, CAmount balance, const CAddressBalanceKey &key, CAddressBalanceRanking::Node *&l, CAddressBalanceRanking::Node *&r)
+{
+    if (t == NULL) {
+        l = r = NULL;
+    } else if (RankLess(t->balance, t->key, balance, key)) {
+        Split(t->right, balance, key, t->right, r);
+        l = t;
+        UpdateSize(l);
+    } else {
+        Split(t->left, balance, key, l, t->left);
+        r = t;
+        UpdateSize(r);
+    }
+}
+
+static CAddressBalanceRanking::Node *Merge(CAddressBalanceRanking::Node *l, CAddressBalanceRanking::Node *r)
+{
+    if (l == NULL)
+        return r;
+    if (r == NULL)
+        return l;
+    if (l->priority > r->priority) {
+        l->right = Merge(l->right, r);
+        UpdateSize(l);
+        return l;
+    }
+    r->left = Merge(l, r->left);
+    UpdateSize(r);
+    return r;
+}
+
+static CAddressBalanceRanking::Node *RemoveFirst(CAddressBalanceRanking::Node *t)
+{
+    if (t->left == NULL) {
+        CAddressBalanceRanking::Node *right = t->right;
+        delete t;
+        return right;
+    }
+    t->left = RemoveFirst(t->left);
+    UpdateSize(t);
+    return t;
+}
+
+static void DeleteTree(CAddressBalanceRanking::Node *t)
+{
+    if (t == NULL)
+        return;
+    DeleteTree(t->left);
+    DeleteTree(t->right);
+    delete t;
+}
+
+static void Collect(const CAddressBalanceRanking::Node *t, size_t &offset, size_t &remaining, std::vector<std::pair<CAmount, CAddressBalanceKey> > &vect)
+{
+    if (t == NULL || remaining == 0)
+        return;
+    if (offset >= t->size) {
+        offset -= t->size;
+        return;
+    }
+    Collect(t->left, offset, remaining, vect);
+    if (remaining == 0)
+        return;
+    if (offset > 0) {
+        offset--;
+    } else {
+        vect.push_back(std::make_pair(t->balance, t->key));
+        remaining--;
+    }
+    Collect(t->right, offset, remaining, vect);
+}
+
+CAddressBalanceRanking::CAddressBalanceRanking() : root(NULL), fLoaded(false)
+{
+}
+
+CAddressBalanceRanking::~CAddressBalanceRanking()
+{
+    DeleteTree(root);
+}
+
+void CAddressBalanceRanking::Clear()
+{
+    LOCK(cs);
+    DeleteTree(root);
+    root = NULL;
+    balances.clear();
+    stats = CAddressBalanceStats();
+    fLoaded = false;
+}
+
+void CAddressBalanceRanking::Insert(const CAddressBalanceKey &key, CAmount balance)
+{
+    Node *l, *r;
+    Split(root, balance, key, l, r);
+    root = Merge(Merge(l, new Node(balance, key, NextPriority())), r);
+}
+
+void CAddressBalanceRanking::Erase(const CAddressBalanceKey &key, CAmount balance)
+{
+    Node *l, *r;
+    Split(root, balance, key, l, r);
+    if (r != NULL) {
+        // the node itself is the first one of r
+        r = RemoveFirst(r);
+    }
+    root = Merge(l, r);
+}
+
+void CAddressBalanceRanking::Set(const CAddressBalanceKey &key, const CAddressBalanceValue &value, bool fIgnored)
+{
+    LOCK(cs);
+    std::map<CAddressBalanceKey, CAddressBalanceValue>::iterator it = balances.find(key);
+    if (it != balances.end()) {
+        const CAddressBalanceValue &old = it->second;
+        if (key.type == 3) {
+            stats.ccTotal -= old.balance;
+            stats.ccUtxos -= old.utxos;
+        } else if (fIgnored) {
+            stats.ignoredUtxos -= old.utxos;
+        } else {
+            stats.total -= old.balance;
+            stats.utxos -= old.utxos;
+            if (old.balance > 0)
+                Erase(key, old.balance);
+        }
+        balances.erase(it);
+    }
+    if (value.IsNull())
+        return;
+
+    balances.insert(std::make_pair(key, value));
+    if (key.type == 3) {
+        stats.ccTotal += value.balance;
+        stats.ccUtxos += value.utxos;
+    } else if (fIgnored) {
+        stats.ignoredUtxos += value.utxos;
+    } else {
+        stats.total += value.balance;
+        stats.utxos += value.utxos;
+        if (value.balance > 0)
+            Insert(key, value.balance);
+    }
+}
+
+void CAddressBalanceRanking::SetLoaded(bool fLoadedIn)
+{
+    LOCK(cs);
+    fLoaded = fLoadedIn;
+}
+
+bool CAddressBalanceRanking::IsLoaded() const
+{
+    LOCK(cs);
+    return fLoaded;
+}
+
+size_t CAddressBalanceRanking::Size() const
+{
+    LOCK(cs);
+    return NodeSize(root);
+}
+
+CAddressBalanceStats CAddressBalanceRanking::GetStats() const
+{
+    LOCK(cs);
+    return stats;
+}
+
+bool CAddressBalanceRanking::GetRank(const CAddressBalanceKey &key, size_t &rank, CAmount &balance) const
+{
+    LOCK(cs);
+    std::map<CAddressBalanceKey, CAddressBalanceValue>::const_iterator it = balances.find(key);
+    if (it == balances.end() || key.type == 3 || it->second.balance <= 0)
+        return false;
+
+    balance = it->second.balance;
+    rank = 0;
+    const Node *t = root;
+    while (t != NULL) {
+        if (RankLess(balance, key, t->balance, t->key)) {
+            t = t->left;
+        } else if (RankLess(t->balance, t->key, balance, key)) {
+            rank += NodeSize(t->left) + 1;
+            t = t->right;
+        } else {
+            rank += NodeSize(t->left);
+            return true;
+        }
+    }
+    // ignored addresses are kept in the balances but not in the tree
+    return false;
+}
+
+void CAddressBalanceRanking::GetTop(size_t offset, size_t count, std::vector<std::pair<CAmount, CAddressBalanceKey> > &vect) const
+{
+    LOCK(cs);
+    size_t remaining = count != 0 ? count : NodeSize(root);
+    Collect(root, offset, remaining, vect);
+}
@@ -0,0 +1,141 @@
+// Copyright (c) 2009-2010 Satoshi Nakamoto
+// Copyright (c) 2009-2015 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_ADDRESSBALANCE_H
+#define BITCOIN_ADDRESSBALANCE_H
+
+#include "amount.h"
+#include "serialize.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <map>
+#include <vector>
+
+/**
+ * Address balance index: the balance and unspent output count of every address in the address index,
+ * updated from the address index deltas of each connected/disconnected block.
+ * The ranking keeps the snapshot eligible addresses (not cc, not ignored, positive balance) in an
+ * order statistic tree, so the top N and the rank of an address are found without scanning the utxo set.
+ */
+
+struct CAddressBalanceKey {
+    unsigned int type;
+    uint160 hashBytes;
+
+    size_t GetSerializeSize(int nType, int nVersion) const {
+        return 21;
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata8(s, type);
+        hashBytes.Serialize(s);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        type = ser_readdata8(s);
+        hashBytes.Unserialize(s);
+    }
+
+    CAddressBalanceKey(unsigned int addressType, uint160 addressHash) {
+        type = addressType;
+        hashBytes = addressHash;
+    }
+
+    CAddressBalanceKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        type = 0;
+        hashBytes.SetNull();
+    }
+
+    friend bool operator<(const CAddressBalanceKey& a, const CAddressBalanceKey& b) {
+        return a.type < b.type || (a.type == b.type && a.hashBytes < b.hashBytes);
+    }
+    friend bool operator==(const CAddressBalanceKey& a, const CAddressBalanceKey& b) {
+        return a.type == b.type && a.hashBytes == b.hashBytes;
+    }
+};
+
+struct CAddressBalanceValue {
+    CAmount balance;
+    int64_t utxos;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(balance);
+        READWRITE(utxos);
+    }
+
+    CAddressBalanceValue(CAmount nBalance, int64_t nUtxos) {
+        balance = nBalance;
+        utxos = nUtxos;
+    }
+
+    CAddressBalanceValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        balance = 0;
+        utxos = 0;
+    }
+
+    bool IsNull() const {
+        return balance == 0 && utxos == 0;
+    }
+};
+
+/** Totals over the whole index, as reported by getsnapshot */
+struct CAddressBalanceStats {
+    CAmount total;          // ranked addresses
+    int64_t utxos;          // utxos of ranked addresses
+    int64_t ignoredUtxos;   // utxos of addresses on the snapshot ignore list
+    CAmount ccTotal;        // cc addresses, not ranked
+    int64_t ccUtxos;
+
+    CAddressBalanceStats() : total(0), utxos(0), ignoredUtxos(0), ccTotal(0), ccUtxos(0) {}
+};
+
+class CAddressBalanceRanking
+{
+public:
+    struct Node;  // treap node, defined in addressbalance.cpp
+
+private:
+    mutable CCriticalSection cs;
+    Node *root;
+    std::map<CAddressBalanceKey, CAddressBalanceValue> balances;
+    CAddressBalanceStats stats;
+    bool fLoaded;
+
+    void Erase(const CAddressBalanceKey &key, CAmount balance);
+    void Insert(const CAddressBalanceKey &key, CAmount balance);
+
+public:
+    CAddressBalanceRanking();
+    ~CAddressBalanceRanking();
+
+    void Clear();
+    //! Replaces the balance of an address, fIgnored addresses are counted but never ranked
+    void Set(const CAddressBalanceKey &key, const CAddressBalanceValue &value, bool fIgnored);
+    void SetLoaded(bool fLoadedIn);
+    bool IsLoaded() const;
+
+    size_t Size() const;
+    CAddressBalanceStats GetStats() const;
+    //! Zero based rank of an address by descending balance, false if the address is not ranked
+    bool GetRank(const CAddressBalanceKey &key, size_t &rank, CAmount &balance) const;
+    //! Up to count ranked addresses starting at rank offset, count 0 returns all
+    void GetTop(size_t offset, size_t count, std::vector<std::pair<CAmount, CAddressBalanceKey> > &vect) const;
+};
+
+extern CAddressBalanceRanking addressBalanceRanking;
+
+#endif // BITCOIN_ADDRESSBALANCE_H
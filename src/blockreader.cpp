@@ -0,0 +1,200 @@
+// Copyright (c) 2009-2014 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockreader.h"
+
+#include "chainparams.h"
+#include "clientversion.h"
+#include "compat.h"
+#include "crypto/common.h"
+#include "main.h"
+#include "protocol.h"
+#include "streams.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include <boost/bind.hpp>
+
+CMappedBlockFile::CMappedBlockFile(int nFileIn) : nFile(nFileIn), pdata(NULL), nSize(0)
+{
+    std::string strPath = GetBlockPosFilename(CDiskBlockPos(nFile, 0), "blk").string();
+#ifndef _WIN32
+    int fd = open(strPath.c_str(), O_RDONLY);
+    if (fd < 0)
+        return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *ptr = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (ptr != MAP_FAILED) {
+            // the blocks are read front to back, more or less
+            posix_madvise(ptr, st.st_size, POSIX_MADV_SEQUENTIAL);
+            pdata = (unsigned char *)ptr;
+            nSize = st.st_size;
+        }
+    }
+    close(fd);
+#else
+    FILE *file = fopen(strPath.c_str(), "rb");
+    if (!file)
+        return;
+    fseek(file, 0, SEEK_END);
+    long nFileSize = ftell(file);
+    rewind(file);
+    if (nFileSize > 0 && (pdata = (unsigned char *)malloc(nFileSize)) != NULL) {
+        if (fread(pdata, 1, nFileSize, file) == (size_t)nFileSize)
+            nSize = nFileSize;
+        else {
+            free(pdata);
+            pdata = NULL;
+        }
+    }
+    fclose(file);
+#endif
+}
+
+CMappedBlockFile::~CMappedBlockFile()
+{
+    if (pdata == NULL)
+        return;
+#ifndef _WIN32
+    munmap(pdata, nSize);
+#else
+    free(pdata);
+#endif
+}
+
+std::vector<CDiskBlockPos> CMappedBlockFile::FindBlocks() const
+{
+    std::vector<CDiskBlockPos> vBlocks;
+    const unsigned char *pchMessageStart = (const unsigned char *)Params().MessageStart();
+    const size_t nHeaderSize = MESSAGE_START_SIZE + sizeof(uint32_t);
+    size_t nOffset = 0;
+    while (pdata != NULL && nOffset + nHeaderSize <= nSize) {
+        // locate a header, as LoadExternalBlockFile does
+        const unsigned char *p = (const unsigned char *)memchr(pdata + nOffset, pchMessageStart[0], nSize - nHeaderSize - nOffset + 1);
+        if (p == NULL)
+            break;
+        nOffset = p - pdata;
+        if (memcmp(p, pchMessageStart, MESSAGE_START_SIZE) != 0) {
+            nOffset++;
+            continue;
+        }
+        uint32_t nBlockSize = ReadLE32(p + MESSAGE_START_SIZE);
+        if (nBlockSize < 80 || nBlockSize > (uint32_t)MAX_BLOCK_SIZE(10000000)) {
+            nOffset++;
+            continue;
+        }
+        if (nBlockSize > nSize - nOffset - nHeaderSize)
+            break;
+        vBlocks.push_back(CDiskBlockPos(nFile, nOffset + nHeaderSize));
+        nOffset += nHeaderSize + nBlockSize;
+    }
+    return vBlocks;
+}
+
+bool CMappedBlockFile::ReadBlock(unsigned int nPos, CBlock& block) const
+{
+    if (pdata == NULL || nPos < sizeof(uint32_t) || nPos > nSize)
+        return false;
+    uint32_t nBlockSize = ReadLE32(pdata + nPos - sizeof(uint32_t));
+    if (nBlockSize < 80 || nBlockSize > nSize - nPos)
+        return false;
+    try {
+        CDataStream ss((const char *)pdata + nPos, (const char *)pdata + nPos + nBlockSize, SER_DISK, CLIENT_VERSION);
+        ss >> block;
+    } catch (const std::exception&) {
+        return false;
+    }
+    return true;
+}
+
+CBlockReader::CBlockReader(const std::vector<CDiskBlockPos>& vPosIn, int nThreads, size_t nAheadIn) :
+    vPos(vPosIn), nAhead(std::max(nAheadIn, (size_t)1)), vSlots(nAhead), nNext(0), nConsumed(0), fStop(false)
+{
+    for (size_t i = 0; i < vPos.size(); i++)
+        mapFileLast[vPos[i].nFile] = i;
+    for (int i = 0; i < nThreads; i++)
+        threads.create_thread(boost::bind(&CBlockReader::Run, this));
+}
+
+CBlockReader::~CBlockReader()
+{
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        fStop = true;
+        condFree.notify_all();
+    }
+    threads.join_all();
+}
+
+std::shared_ptr<CMappedBlockFile> CBlockReader::GetFile(int nFile)
+{
+    std::shared_ptr<CMappedBlockFile>& file = mapFiles[nFile];
+    if (!file)
+        file.reset(new CMappedBlockFile(nFile));
+    return file;
+}
+
+bool CBlockReader::Read(const std::shared_ptr<CMappedBlockFile>& file, const CDiskBlockPos& pos, CBlock& block)
+{
+    block.SetNull();
+    if (file->ReadBlock(pos.nPos, block))
+        return true;
+    // not mapped, or written after it was: read it the usual way
+    return ReadBlockFromDisk(0, block, pos, false);
+}
+
+void CBlockReader::Run()
+{
+    RenameThread("komodo-blockread");
+    while (true) {
+        size_t i;
+        std::shared_ptr<CMappedBlockFile> file;
+        {
+            boost::unique_lock<boost::mutex> lock(cs);
+            // the slot of position i is free once the caller took position i - nAhead
+            while (!fStop && nNext < vPos.size() && nNext >= nConsumed + nAhead)
+                condFree.wait(lock);
+            if (fStop || nNext >= vPos.size())
+                return;
+            i = nNext++;
+            file = GetFile(vPos[i].nFile);
+        }
+        Slot& slot = vSlots[i % nAhead];
+        slot.fOk = Read(file, vPos[i], slot.block);
+        {
+            boost::unique_lock<boost::mutex> lock(cs);
+            slot.fReady = true;
+            condReady.notify_all();
+        }
+    }
+}
+
+bool CBlockReader::Next(CBlock& block, bool& fOk)
+{
+    boost::unique_lock<boost::mutex> lock(cs);
+    if (nConsumed >= vPos.size())
+        return false;
+    const CDiskBlockPos& pos = vPos[nConsumed];
+    Slot& slot = vSlots[nConsumed % nAhead];
+    if (threads.size() == 0) {
+        slot.fOk = Read(GetFile(pos.nFile), pos, slot.block);
+        slot.fReady = true;
+    }
+    while (!slot.fReady)
+        condReady.wait(lock);
+    std::swap(block, slot.block);
+    fOk = slot.fOk;
+    slot.fReady = false;
+    if (mapFileLast[pos.nFile] == nConsumed)
+        mapFiles.erase(pos.nFile);
+    nConsumed++;
+    condFree.notify_all();
+    return true;
+}
@@ -0,0 +1,98 @@
+// Copyright (c) 2009-2014 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_BLOCKREADER_H
+#define BITCOIN_BLOCKREADER_H
+
+#include "chain.h"
+#include "primitives/block.h"
+#include "sync.h"
+
+#include <map>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+#include <boost/thread.hpp>
+
+/** Default for -blockreaderthreads, 0 reads the blocks on the calling thread */
+static const int DEFAULT_BLOCK_READER_THREADS = 2;
+/** Number of blocks a CBlockReader deserializes ahead of its caller */
+static const size_t BLOCK_READ_AHEAD = 64;
+
+/** A blk?????.dat file mapped read-only, or read into memory where mmap is not available. */
+class CMappedBlockFile
+{
+private:
+    int nFile;
+    unsigned char *pdata;
+    size_t nSize;
+
+    CMappedBlockFile(const CMappedBlockFile&);
+    CMappedBlockFile& operator=(const CMappedBlockFile&);
+
+public:
+    explicit CMappedBlockFile(int nFileIn);
+    ~CMappedBlockFile();
+
+    bool IsNull() const { return pdata == NULL; }
+    size_t size() const { return nSize; }
+
+    /** Positions of the blocks in the file, found by the message start and size written in front of each. */
+    std::vector<CDiskBlockPos> FindBlocks() const;
+
+    /** Deserializes the block at nPos, false if the size in front of it or the block is not valid. */
+    bool ReadBlock(unsigned int nPos, CBlock& block) const;
+};
+
+/**
+ * Reads blocks ahead of the caller. Worker threads deserialize the upcoming blocks from the
+ * memory mapped block files into a bounded ring, the caller takes them in the order of the
+ * positions it gave, so disk reads and deserialization overlap the validation of the block
+ * before. A file is unmapped once the caller is past its last block. Used by -reindex and
+ * wallet rescans.
+ */
+class CBlockReader
+{
+private:
+    struct Slot
+    {
+        CBlock block;
+        bool fOk;
+        bool fReady;
+
+        Slot() : fOk(false), fReady(false) {}
+    };
+
+    const std::vector<CDiskBlockPos> vPos;
+    const size_t nAhead;
+    std::vector<Slot> vSlots;
+    size_t nNext;     //!< the next position a worker takes
+    size_t nConsumed; //!< the positions handed to the caller
+    bool fStop;
+    std::map<int, std::shared_ptr<CMappedBlockFile> > mapFiles;
+    std::map<int, size_t> mapFileLast; //!< the last position in each file
+
+    CWaitableCriticalSection cs;
+    CConditionVariable condReady;
+    CConditionVariable condFree;
+    boost::thread_group threads;
+
+    std::shared_ptr<CMappedBlockFile> GetFile(int nFile);
+    bool Read(const std::shared_ptr<CMappedBlockFile>& file, const CDiskBlockPos& pos, CBlock& block);
+    void Run();
+
+public:
+    CBlockReader(const std::vector<CDiskBlockPos>& vPosIn, int nThreads, size_t nAheadIn = BLOCK_READ_AHEAD);
+    ~CBlockReader();
+
+    /**
+     * Waits for the next block in order, false once all of them were handed out. fOk is false if
+     * that block could not be read, the caller may read it again with ReadBlockFromDisk to get
+     * the error.
+     */
+    bool Next(CBlock& block, bool& fOk);
+};
+
+#endif // BITCOIN_BLOCKREADER_H
@@ -22,6 +22,8 @@
 
 //#define EVAL_HEIR 0xea
 
+extern bool fHeirIndex;  // if heir index enabled
+
 bool HeirValidate(struct CCcontract_info *cp,Eval* eval,const CTransaction &tx, uint32_t nIn);
 
 class CoinHelper;
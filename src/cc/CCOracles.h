@@ -19,6 +19,8 @@
 
 #include "CCinclude.h"
 
+extern bool fOracleDataIndex;  // if oracle data index enabled
+
 bool OraclesValidate(struct CCcontract_info *cp,Eval* eval,const CTransaction &tx, uint32_t nIn);
 UniValue OracleCreate(const CPubKey& pk, int64_t txfee,std::string name,std::string description,std::string format);
 UniValue OracleFund(const CPubKey& pk, int64_t txfee,uint256 oracletxid);
@@ -28,6 +30,7 @@ UniValue OracleData(const CPubKey& pk, int64_t txfee,uint256 oracletxid,std::vec
 // CCcustom
 UniValue OracleDataSample(uint256 reforacletxid,uint256 txid);
 UniValue OracleDataSamples(uint256 reforacletxid,char* batonaddr,int32_t num);
+UniValue OracleDataSeries(uint256 reforacletxid,char* batonaddr,int32_t fromheight,int32_t toheight,int32_t num,bool fColumnar);
 UniValue OracleInfo(uint256 origtxid);
 UniValue OraclesList();
 
@@ -58,6 +58,7 @@ UniValue PricesCashout(int64_t txfee,uint256 bettxid);
 UniValue PricesInfo(uint256 bettxid,int32_t refheight);
 UniValue PricesList(uint32_t filter, CPubKey mypk);
 UniValue PricesGetOrderbook();
+UniValue PricesRektCandidates(int32_t height);
 UniValue PricesRefillFund(int64_t amount);
 
 
@@ -17,6 +17,7 @@
 #include "CCtokens.h"
 #include "cc/CCupgrades.h"
 #include "CCTokelData.h"
+#include "CCbatonindex.h"
 
 #include <iomanip> 
 
@@ -516,4 +517,51 @@ bool AssetsFillOrderIsDust(int32_t royaltyFract, CAmount nOutputValue, bool &isR
         return true;
     }
     return false;
-}
\ No newline at end of file
+}
+
+// baton chain index rules, see cc/CCbatonindex.cpp
+// a bid or ask order keeps its unfilled remainder in the global address vout, each partial fill spends it and recreates it
+static bool AssetsBatonRoot(uint8_t funcid, const CTransaction &tx, int32_t &batonvout)
+{
+    if (funcid != 'b' && funcid != 's')
+        return false;
+    batonvout = tx.vout.size() > 1 && tx.vout[ASSETS_GLOBALADDR_VOUT].scriptPubKey.IsPayToCryptoCondition() ? ASSETS_GLOBALADDR_VOUT : -1;
+    return true;
+}
+
+static bool AssetsBatonNext(uint8_t funcid, const CTransaction &tx, int32_t vini, int32_t &batonvout)
+{
+    if (tx.vin[vini].prevout.n != ASSETS_GLOBALADDR_VOUT)
+        return false;
+    // any spender ends up as the latest state of the order, only fills pass the remainder on
+    batonvout = (funcid == 'B' || funcid == 'S') && tx.vout.size() > 1 && tx.vout[ASSETS_GLOBALADDR_VOUT].scriptPubKey.IsPayToCryptoCondition() ? ASSETS_GLOBALADDR_VOUT : -1;
+    return true;
+}
+
+bool AssetsV1BatonRoot(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata)
+{
+    uint8_t evalcode; CAmount unit_price; vscript_t origpubkey; int32_t expiryHeight;
+    funcid = DecodeAssetTokenOpRetV1(tx.vout.back().scriptPubKey, evalcode, rootdata, unit_price, origpubkey, expiryHeight);
+    return evalcode == EVAL_ASSETS && AssetsBatonRoot(funcid, tx, batonvout);
+}
+
+bool AssetsV2BatonRoot(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata)
+{
+    uint8_t evalcode; CAmount unit_price; vscript_t origpubkey; int32_t expiryHeight;
+    funcid = DecodeAssetTokenOpRetV2(tx.vout.back().scriptPubKey, evalcode, rootdata, unit_price, origpubkey, expiryHeight);
+    return evalcode == EVAL_ASSETSV2 && AssetsBatonRoot(funcid, tx, batonvout);
+}
+
+bool AssetsV1BatonNext(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid)
+{
+    uint8_t evalcode; uint256 tokenid; CAmount unit_price; vscript_t origpubkey; int32_t expiryHeight;
+    funcid = DecodeAssetTokenOpRetV1(tx.vout.back().scriptPubKey, evalcode, tokenid, unit_price, origpubkey, expiryHeight);
+    return AssetsBatonNext(funcid, tx, vini, batonvout);
+}
+
+bool AssetsV2BatonNext(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid)
+{
+    uint8_t evalcode; uint256 tokenid; CAmount unit_price; vscript_t origpubkey; int32_t expiryHeight;
+    funcid = DecodeAssetTokenOpRetV2(tx.vout.back().scriptPubKey, evalcode, tokenid, unit_price, origpubkey, expiryHeight);
+    return AssetsBatonNext(funcid, tx, vini, batonvout);
+}
@@ -19,6 +19,7 @@
 #include "CCtokens.h"
 #include "CCassets.h"
 #include "CCTokelData.h"
+#include "CCbatonindex.h"
 
 template<class T, class A>
 UniValue AssetOrders(uint256 refassetid, const CPubKey &mypk, const UniValue &params)
@@ -78,8 +79,11 @@ UniValue AssetOrders(uint256 refassetid, const CPubKey &mypk, const UniValue &pa
                 uint256 init_txid = ordertxid;
                 int32_t spentvin;
                 int32_t height;
+                CCCBatonTipValue tip;
                 // try to get unspent partially filled order (if it is a search by global assets address)
-                while(CCgetspenttxid(spenttxid, spentvin, height, init_txid, ASSETS_GLOBALADDR_VOUT) == 0) 
+                if (GetCCBatonTip(A::EvalCode(), ordertxid, tip, false))
+                    init_txid = tip.txid;
+                else while(CCgetspenttxid(spenttxid, spentvin, height, init_txid, ASSETS_GLOBALADDR_VOUT) == 0) 
                 {
                     {
                         LOCK(cs_main);
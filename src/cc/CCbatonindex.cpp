@@ -0,0 +1,280 @@
+/******************************************************************************
+ * Copyright © 2014-2022 The SuperNET Developers.                             *
+ *                                                                            *
+ * See the AUTHORS, DEVELOPER-AGREEMENT and LICENSE files at                  *
+ * the top-level directory of this distribution for the individual copyright  *
+ * holder information and the developer policies on copyright and licensing.  *
+ *                                                                            *
+ * Unless otherwise agreed in a custom licensing agreement, no part of the    *
+ * SuperNET software, including this file may be copied, modified, propagated *
+ * or distributed except according to the terms contained in the LICENSE file *
+ *                                                                            *
+ * Removal or modification of this copyright notice is prohibited.            *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "CCbatonindex.h"
+#include "main.h"
+#include "txdb.h"
+#include "txmempool.h"
+
+/*
+ Baton chain index.
+ Agreements, token tags, oracle publishers and asset orders keep their state in a chain of transactions, each one spending
+ the baton output of the previous one. Finding the latest state used to mean walking the chain with the spent index and loading
+ every tx on it. The index keeps, per (evalcode, root txid), the current baton outpoint and every event by sequence number.
+ It is maintained in ConnectBlock/DisconnectBlock and is never used by validation code. The index records the last block it
+ applied, so blocks connected again after an unclean shutdown are not applied twice.
+*/
+
+static const CCBatonRule ccBatonRules[] = {
+    { EVAL_AGREEMENTS, AgreementsBatonRoot, AgreementsBatonNext, AgreementsBatonPostings },
+    { EVAL_TOKENTAGS, TokenTagsBatonRoot, TokenTagsBatonNext, TokenTagsBatonPostings },
+    { EVAL_ORACLES, OraclesBatonRoot, OraclesBatonNext, NULL },
+    { EVAL_ASSETS, AssetsV1BatonRoot, AssetsV1BatonNext, NULL },
+    { EVAL_ASSETSV2, AssetsV2BatonRoot, AssetsV2BatonNext, NULL },
+    { EVAL_CHANNELS, ChannelsBatonRoot, ChannelsBatonNext, NULL },
+};
+
+static const CCBatonRule *FindCCBatonRule(uint8_t evalcode)
+{
+    for (int32_t i = 0; i < sizeof(ccBatonRules) / sizeof(ccBatonRules[0]); i++)
+        if (ccBatonRules[i].evalcode == evalcode)
+            return &ccBatonRules[i];
+    return NULL;
+}
+
+// all baton chain txns are cc txns with an opreturn, skip everything else without touching the db
+static bool IsCCBatonCandidate(const CTransaction &tx)
+{
+    if (tx.IsCoinBase() || tx.vout.size() < 2 || tx.vout.back().scriptPubKey.size() < 3 || tx.vout.back().scriptPubKey[0] != OP_RETURN)
+        return false;
+    for (const auto &vout : tx.vout)
+        if (vout.scriptPubKey.IsPayToCryptoCondition())
+            return true;
+    return false;
+}
+
+// lookups through the entries already updated by this block
+static bool LookupCCBatonTip(const CCCBatonIndexUpdate &update, const CCCBatonKey &key, CCCBatonTipValue &tip)
+{
+    std::map<CCCBatonKey, CCCBatonTipValue>::const_iterator it = update.tips.find(key);
+    if (it != update.tips.end()) {
+        tip = it->second;
+        return !tip.IsNull();
+    }
+    return pblocktree->ReadCCBatonTip(key, tip);
+}
+
+static bool LookupCCBatonEvent(const CCCBatonIndexUpdate &update, const CCCBatonEventKey &key, CCCBatonEventValue &event)
+{
+    std::map<CCCBatonEventKey, CCCBatonEventValue>::const_iterator it = update.events.find(key);
+    if (it != update.events.end()) {
+        event = it->second;
+        return !event.IsNull();
+    }
+    return pblocktree->ReadCCBatonEvent(key, event);
+}
+
+static bool LookupCCBatonOutpoint(const CCCBatonIndexUpdate &update, const COutPoint &outpoint, CCCBatonRefValue &ref)
+{
+    std::map<COutPoint, CCCBatonRefValue>::const_iterator it = update.outpoints.find(outpoint);
+    if (it != update.outpoints.end()) {
+        ref = it->second;
+        return !ref.IsNull();
+    }
+    return pblocktree->ReadCCBatonOutpoint(outpoint, ref);
+}
+
+// collects the index changes made by a connected block, txns are processed in block order so batons spent in the same block are followed
+void CCBatonIndexConnectBlock(const CBlock &block, int32_t height, CCCBatonIndexUpdate &update)
+{
+    for (const auto &tx : block.vtx)
+    {
+        if (!IsCCBatonCandidate(tx))
+            continue;
+
+        uint256 txid = tx.GetHash();
+        std::vector<CCCBatonRefValue> refs;
+        int32_t batonvout;
+        uint8_t funcid;
+
+        for (int32_t j = 0; j < tx.vin.size(); j++)
+        {
+            CCCBatonRefValue ref;
+            CCCBatonTipValue tip;
+            const CCBatonRule *rule;
+
+            if (!LookupCCBatonOutpoint(update, tx.vin[j].prevout, ref))
+                continue;
+            CCCBatonKey key(ref.evalcode, ref.rootid);
+            if ((rule = FindCCBatonRule(ref.evalcode)) == NULL || !LookupCCBatonTip(update, key, tip) || !rule->next(tx, j, tip, batonvout, funcid))
+                continue;
+
+            update.outpoints[tx.vin[j].prevout].SetNull();
+            CCCBatonRefValue newref(ref.evalcode, ref.rootid, tip.nEvents);
+            tip.txid = txid;
+            tip.batonvout = batonvout;
+            tip.blockHeight = height;
+            tip.funcid = funcid;
+            tip.nEvents++;
+            update.tips[key] = tip;
+            update.events[CCCBatonEventKey(ref.evalcode, ref.rootid, newref.seq)] = CCCBatonEventValue(txid, batonvout, height, funcid);
+            if (batonvout >= 0)
+                update.outpoints[COutPoint(txid, batonvout)] = newref;
+            refs.push_back(newref);
+        }
+
+        for (const auto &rule : ccBatonRules)
+        {
+            uint256 rootdata;
+            if (!rule.root(tx, batonvout, funcid, rootdata))
+                continue;
+
+            CCCBatonTipValue tip;
+            CCCBatonRefValue newref(rule.evalcode, txid, 0);
+            tip.txid = txid;
+            tip.batonvout = batonvout;
+            tip.blockHeight = height;
+            tip.funcid = funcid;
+            tip.nEvents = 1;
+            tip.rootdata = rootdata;
+            update.tips[CCCBatonKey(rule.evalcode, txid)] = tip;
+            update.events[CCCBatonEventKey(rule.evalcode, txid, 0)] = CCCBatonEventValue(txid, batonvout, height, funcid);
+            if (batonvout >= 0)
+                update.outpoints[COutPoint(txid, batonvout)] = newref;
+            refs.push_back(newref);
+
+            if (rule.postings != NULL)
+            {
+                std::vector<std::pair<std::vector<uint8_t>, uint8_t> > postings;
+                rule.postings(tx, postings);
+                for (const auto &posting : postings)
+                    update.postings[CCCBatonPostingKey(rule.evalcode, posting.first, posting.second, txid)] = height;
+            }
+        }
+
+        if (!refs.empty())
+            update.txrefs[txid] = refs;
+    }
+}
+
+// collects the index changes undoing a disconnected block, txns and their events are unwound in reverse order
+void CCBatonIndexDisconnectBlock(const CBlock &block, CCCBatonIndexUpdate &update)
+{
+    for (int32_t i = block.vtx.size() - 1; i >= 0; i--)
+    {
+        const CTransaction &tx = block.vtx[i];
+        uint256 txid = tx.GetHash();
+        std::vector<CCCBatonRefValue> refs;
+
+        if (!IsCCBatonCandidate(tx) || !pblocktree->ReadCCBatonTxRefs(txid, refs))
+            continue;
+        update.txrefs[txid].clear();
+
+        for (int32_t k = refs.size() - 1; k >= 0; k--)
+        {
+            const CCCBatonRefValue &ref = refs[k];
+            CCCBatonKey key(ref.evalcode, ref.rootid);
+            CCCBatonEventKey eventkey(ref.evalcode, ref.rootid, ref.seq);
+            CCCBatonEventValue event, prev;
+            CCCBatonTipValue tip;
+
+            if (!LookupCCBatonEvent(update, eventkey, event))
+                continue;
+            if (event.batonvout >= 0)
+                update.outpoints[COutPoint(event.txid, event.batonvout)].SetNull();
+            update.events[eventkey].SetNull();
+
+            if (ref.seq == 0) {
+                const CCBatonRule *rule = FindCCBatonRule(ref.evalcode);
+                if (rule != NULL && rule->postings != NULL)
+                {
+                    std::vector<std::pair<std::vector<uint8_t>, uint8_t> > postings;
+                    rule->postings(tx, postings);
+                    for (const auto &posting : postings)
+                        update.postings[CCCBatonPostingKey(ref.evalcode, posting.first, posting.second, ref.rootid)] = -1;
+                }
+                update.tips[key].SetNull();
+                continue;
+            }
+            if (!LookupCCBatonTip(update, key, tip) || !LookupCCBatonEvent(update, CCCBatonEventKey(ref.evalcode, ref.rootid, ref.seq - 1), prev))
+                continue;
+            tip.txid = prev.txid;
+            tip.batonvout = prev.batonvout;
+            tip.blockHeight = prev.blockHeight;
+            tip.funcid = prev.funcid;
+            tip.nEvents = ref.seq;
+            update.tips[key] = tip;
+            if (prev.batonvout >= 0)
+                update.outpoints[COutPoint(prev.txid, prev.batonvout)] = CCCBatonRefValue(ref.evalcode, ref.rootid, ref.seq - 1);
+        }
+    }
+}
+
+// follows baton spends waiting in the mempool from a confirmed tip, optionally collecting them as events with height 0
+static void FollowCCBatonMempool(const CCBatonRule *rule, uint256 rootid, CCCBatonTipValue &tip, std::vector<std::pair<CCCBatonEventKey, CCCBatonEventValue> > *pevents)
+{
+    LOCK(mempool.cs);
+    while (tip.batonvout >= 0)
+    {
+        CTxMemPool::mapNextTxType::const_iterator it = mempool.mapNextTx.find(COutPoint(tip.txid, tip.batonvout));
+        int32_t batonvout;
+        uint8_t funcid;
+
+        if (it == mempool.mapNextTx.end() || !rule->next(*it->second.ptx, it->second.n, tip, batonvout, funcid))
+            break;
+        tip.txid = it->second.ptx->GetHash();
+        tip.batonvout = batonvout;
+        tip.blockHeight = 0;
+        tip.funcid = funcid;
+        if (pevents != NULL)
+            pevents->push_back(std::make_pair(CCCBatonEventKey(rule->evalcode, rootid, tip.nEvents), CCCBatonEventValue(tip.txid, batonvout, 0, funcid)));
+        tip.nEvents++;
+    }
+}
+
+bool GetCCBatonTip(uint8_t evalcode, uint256 rootid, CCCBatonTipValue &tip, bool fMempool)
+{
+    const CCBatonRule *rule;
+
+    if (!fCCBatonIndex || (rule = FindCCBatonRule(evalcode)) == NULL)
+        return false;
+    if (!pblocktree->ReadCCBatonTip(CCCBatonKey(evalcode, rootid), tip))
+        return false;
+    if (fMempool)
+        FollowCCBatonMempool(rule, rootid, tip, NULL);
+    return true;
+}
+
+bool GetCCBatonMempoolEvents(uint8_t evalcode, uint256 rootid, const CCCBatonTipValue &tip, std::vector<std::pair<CCCBatonEventKey, CCCBatonEventValue> > &events)
+{
+    const CCBatonRule *rule;
+
+    if (!fCCBatonIndex || (rule = FindCCBatonRule(evalcode)) == NULL)
+        return false;
+    CCCBatonTipValue mempooltip = tip;
+    FollowCCBatonMempool(rule, rootid, mempooltip, &events);
+    return true;
+}
+
+bool GetCCBatonEvents(uint8_t evalcode, uint256 rootid, uint32_t firstseq, uint32_t maxevents, std::vector<std::pair<CCCBatonEventKey, CCCBatonEventValue> > &events)
+{
+    if (!fCCBatonIndex)
+        return false;
+    return pblocktree->ReadCCBatonEvents(CCCBatonKey(evalcode, rootid), firstseq, maxevents, events);
+}
+
+bool GetCCBatonTips(uint8_t evalcode, std::vector<std::pair<CCCBatonKey, CCCBatonTipValue> > &tips)
+{
+    if (!fCCBatonIndex)
+        return false;
+    return pblocktree->ReadCCBatonTips(evalcode, tips);
+}
+
+bool GetCCBatonPostings(uint8_t evalcode, const std::vector<uint8_t> &owner, std::vector<std::pair<CCCBatonPostingKey, int32_t> > &postings)
+{
+    if (!fCCBatonIndex)
+        return false;
+    return pblocktree->ReadCCBatonPostings(evalcode, owner, postings);
+}
@@ -0,0 +1,91 @@
+/******************************************************************************
+ * Copyright © 2014-2022 The SuperNET Developers.                             *
+ *                                                                            *
+ * See the AUTHORS, DEVELOPER-AGREEMENT and LICENSE files at                  *
+ * the top-level directory of this distribution for the individual copyright  *
+ * holder information and the developer policies on copyright and licensing.  *
+ *                                                                            *
+ * Unless otherwise agreed in a custom licensing agreement, no part of the    *
+ * SuperNET software, including this file may be copied, modified, propagated *
+ * or distributed except according to the terms contained in the LICENSE file *
+ *                                                                            *
+ * Removal or modification of this copyright notice is prohibited.            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef CC_BATONINDEX_H
+#define CC_BATONINDEX_H
+
+#include "CCinclude.h"
+#include "../ccbatonindex.h"
+
+/// Checks if tx starts a baton chain of the module.
+/// @param tx the transaction to check
+/// @param batonvout [out] vout index of the first baton
+/// @param funcid [out] funcid of the root tx
+/// @param rootdata [out] module data kept with the chain tip, passed back to the next rule
+/// @returns true if tx is a root tx
+typedef bool (*CCBatonRootFn)(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata);
+
+/// Checks if tx continues a baton chain by spending its current baton in vin vini.
+/// @param tx the spending transaction
+/// @param vini index of the vin spending the baton
+/// @param tip current chain tip
+/// @param batonvout [out] vout index of the new baton or -1 if tx ends the chain
+/// @param funcid [out] funcid of the event
+/// @returns true if tx is the next event of the chain
+typedef bool (*CCBatonNextFn)(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid);
+
+/// Returns the (owner key, role) pairs a root tx is posted under, optional.
+/// @param tx the root transaction
+/// @param postings [out] owner keys (a pubkey or a module defined id) and module defined roles
+typedef void (*CCBatonPostingsFn)(const CTransaction &tx, std::vector<std::pair<std::vector<uint8_t>, uint8_t> > &postings);
+
+struct CCBatonRule
+{
+    uint8_t evalcode;
+    CCBatonRootFn root;
+    CCBatonNextFn next;
+    CCBatonPostingsFn postings;
+};
+
+extern bool fCCBatonIndex;  // if cc baton index enabled
+
+/// Returns the current tip of the baton chain (evalcode, rootid).
+/// Consensus-neutral, must not be used in validation code.
+/// @param evalcode module evalcode
+/// @param rootid txid of the root transaction
+/// @param tip [out] tip of the chain
+/// @param fMempool follow baton spends found in the mempool
+/// @returns false if the index is disabled or the chain is not indexed
+bool GetCCBatonTip(uint8_t evalcode, uint256 rootid, CCCBatonTipValue &tip, bool fMempool);
+
+/// Returns up to maxevents confirmed events of a baton chain starting at sequence firstseq (0 is the root tx)
+bool GetCCBatonEvents(uint8_t evalcode, uint256 rootid, uint32_t firstseq, uint32_t maxevents, std::vector<std::pair<CCCBatonEventKey, CCCBatonEventValue> > &events);
+
+/// Returns the events following a confirmed tip that are waiting in the mempool, numbered on from tip.nEvents
+bool GetCCBatonMempoolEvents(uint8_t evalcode, uint256 rootid, const CCCBatonTipValue &tip, std::vector<std::pair<CCCBatonEventKey, CCCBatonEventValue> > &events);
+
+/// Returns the tips of all confirmed baton chains of a module
+bool GetCCBatonTips(uint8_t evalcode, std::vector<std::pair<CCCBatonKey, CCCBatonTipValue> > &tips);
+
+/// Returns the confirmed baton chains posted under an owner key, with the role and the root height
+bool GetCCBatonPostings(uint8_t evalcode, const std::vector<uint8_t> &owner, std::vector<std::pair<CCCBatonPostingKey, int32_t> > &postings);
+
+// baton chain rules of the modules
+bool AgreementsBatonRoot(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata);
+bool AgreementsBatonNext(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid);
+void AgreementsBatonPostings(const CTransaction &tx, std::vector<std::pair<std::vector<uint8_t>, uint8_t> > &postings);
+bool TokenTagsBatonRoot(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata);
+bool TokenTagsBatonNext(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid);
+void TokenTagsBatonPostings(const CTransaction &tx, std::vector<std::pair<std::vector<uint8_t>, uint8_t> > &postings);
+bool OraclesBatonRoot(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata);
+bool OraclesBatonNext(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid);
+bool AssetsV1BatonRoot(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata);
+bool AssetsV2BatonRoot(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata);
+bool AssetsV1BatonNext(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid);
+bool AssetsV2BatonNext(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid);
+bool ChannelsBatonRoot(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata);
+bool ChannelsBatonNext(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid);
+
+#endif // CC_BATONINDEX_H
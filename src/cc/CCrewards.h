@@ -23,6 +23,8 @@
 #define EVAL_REWARDS 0xe5
 #define REWARDSCC_MAXAPR (COIN * 25)
 
+extern bool fRewardsIndex;  // if rewards index enabled
+
 bool RewardsValidate(struct CCcontract_info *cp,Eval* eval,const CTransaction &tx, uint32_t nIn);
 UniValue RewardsInfo(uint256 rewardid);
 UniValue RewardsList();
@@ -728,9 +728,8 @@ UniValue TokenList()
 	return(result);
 }
 
-UniValue TokenV2List(const UniValue &params)
+void TokenV2List(const UniValue &params, JSONStream &out)
 {
-	UniValue result(UniValue::VARR);
     const bool CC_OUTPUTS_TRUE = true;
 
     int32_t beginHeight = 0;
@@ -757,22 +756,24 @@ UniValue TokenV2List(const UniValue &params)
         if (DecodeTokenCreateOpRetV2(opreturn, origpubkey, name, description, oprets) != 0) {
             if (checkPK.IsValid()) { 
                 if (checkPK == pubkey2pk(origpubkey))
-                    result.push_back(tokenid.GetHex());
+                    out.Push(tokenid.GetHex());
             }
             else if (!checkAddr.empty())  {
                 char origaddr[KOMODO_ADDRESS_BUFSIZE];
                 Getscriptaddress(origaddr, TokensV2::MakeCC1vout(EVAL_TOKENSV2, 0LL, pubkey2pk(origpubkey)).scriptPubKey);
                 if (checkAddr == origaddr)
-                    result.push_back(tokenid.GetHex());
+                    out.Push(tokenid.GetHex());
             }
             else 
-                result.push_back(tokenid.GetHex());
+                out.Push(tokenid.GetHex());
         }
         else {
             LOGSTREAMFN(cctokens_log, CCLOG_DEBUG1, stream << "DecodeTokenCreateOpRetV2 failed for tokenid=" << tokenid.GetHex() << " opreturn.size=" << opreturn.size() << std::endl);
         }
     };
 
+    // each tokenid is written out when found, only the index query result is held
+    out.BeginArray();
     if (beginHeight > 0 || endHeight > 0)    {
         if (endHeight <= 0) {
             LOCK(cs_main);
@@ -838,7 +839,7 @@ UniValue TokenV2List(const UniValue &params)
         }
     }
 
-	return(result);
+    out.EndArray();
 }
 
 // get token indexkey for pubkey for old tokens:
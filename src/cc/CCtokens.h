@@ -280,7 +280,7 @@ CTxOut MakeTokensCCMofNvoutMixed(uint8_t evalcode1, uint8_t evalcode2, CAmount n
 CTxOut MakeTokensCCMofNDestVoutMixed(uint8_t evalcode1, uint8_t evalcode2, CAmount nValue, uint8_t M, const std::vector<CTxDestination> &dests, vscript_t* pvData);
 
 UniValue TokenList();
-UniValue TokenV2List(const UniValue &params);
+void TokenV2List(const UniValue &params, JSONStream &out);
 
 /// @private 
 std::vector<std::string> GetTokenV1IndexKeys(const CPubKey &pk);
@@ -14,6 +14,7 @@
  ******************************************************************************/
 
 #include "CCagreements.h"
+#include "CCbatonindex.h"
 
 /*
 The goal here is to create FSM-like on-chain agreements, which are created and their state updated by mutual assent of two separate keys.
@@ -1452,6 +1453,65 @@ bool AgreementsValidate(struct CCcontract_info *cp, Eval* eval, const CTransacti
 
 // --- End of consensus code ---
 
+// --- Baton chain index rules, see cc/CCbatonindex.cpp ---
+
+// Checks if vout0 of tx is an event baton, sent to the address made from the Agreements global pubkey and the offertxid-pubkey.
+static bool IsAgreementEventBaton(const CTransaction &tx, uint256 offertxid)
+{
+	struct CCcontract_info *cp, C;
+	char eventCCaddress[KOMODO_ADDRESS_BUFSIZE];
+	CPubKey Agreementspk, offertxidpk;
+
+	cp = CCinit(&C, EVAL_AGREEMENTS);
+	Agreementspk = GetUnspendable(cp, NULL);
+	offertxidpk = CCtxidaddr_tweak(NULL, offertxid);
+	GetCCaddress1of2(cp, eventCCaddress, Agreementspk, offertxidpk, true);
+	return (tx.vout.size() > 0 && IsAgreementsvout(cp, tx, 0, eventCCaddress) != 0);
+}
+
+// The event log of an agreement starts at the agreement (accept) transaction.
+bool AgreementsBatonRoot(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata)
+{
+	uint8_t version;
+	uint256 offertxid;
+
+	if ((funcid = DecodeAgreementAcceptOpRet(tx.vout.back().scriptPubKey, version, offertxid)) != 'c')
+		return false;
+	batonvout = IsAgreementEventBaton(tx, offertxid) ? 0 : -1;
+	rootdata = offertxid;
+	return true;
+}
+
+// Every event spends the vout0 baton, closures, resolutions, unlocks and terminations end the log.
+bool AgreementsBatonNext(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid)
+{
+	if (tx.vin[vini].prevout.n != 0 || (funcid = DecodeAgreementOpRet(tx.vout.back().scriptPubKey)) == 0)
+		return false;
+	if (funcid == 'c' || funcid == 'r' || funcid == 'u' || funcid == 't' || !IsAgreementEventBaton(tx, tip.rootdata))
+		batonvout = -1;
+	else
+		batonvout = 0;
+	return true;
+}
+
+// Agreements are posted under the offeror ('o'), signer ('s') and arbitrator ('a') keys of the accepted offer.
+void AgreementsBatonPostings(const CTransaction &tx, std::vector<std::pair<std::vector<uint8_t>, uint8_t> > &postings)
+{
+	uint8_t version, offerflags;
+	uint256 offertxid, hashBlock;
+	std::vector<uint8_t> offerorkey, signerkey, arbkey;
+	CTransaction offertx;
+
+	if (DecodeAgreementAcceptOpRet(tx.vout.back().scriptPubKey, version, offertxid) != 'c' ||
+	!myGetTransaction(offertxid, offertx, hashBlock) || offertx.vout.size() == 0 ||
+	DecodeAgreementOfferOpRet(offertx.vout.back().scriptPubKey, version, offerorkey, signerkey, arbkey, offerflags) != 'o')
+		return;
+	postings.push_back(std::make_pair(offerorkey, (uint8_t)'o'));
+	postings.push_back(std::make_pair(signerkey, (uint8_t)'s'));
+	if (!arbkey.empty())
+		postings.push_back(std::make_pair(arbkey, (uint8_t)'a'));
+}
+
 // --- Helper functions for RPC implementations ---
 
 uint8_t FindLatestAgreementEvent(uint256 agreementtxid, struct CCcontract_info *cp, uint256 &eventtxid)
@@ -1467,6 +1527,14 @@ uint8_t FindLatestAgreementEvent(uint256 agreementtxid, struct CCcontract_info *
 
 	eventtxid = zeroid;
 
+	// Use the baton chain index if it's enabled, only confirmed events are returned as in the walk below.
+	CCCBatonTipValue tip;
+	if (GetCCBatonTip(EVAL_AGREEMENTS, agreementtxid, tip, false))
+	{
+		eventtxid = tip.txid;
+		return tip.funcid;
+	}
+
 	// Get agreement transaction and its op_return, containing the offertxid.
 	if (myGetTransactionCCV2(cp, agreementtxid, sourcetx, hashBlock) && !hashBlock.IsNull() && sourcetx.vout.size() > 0 &&
 	(funcid = DecodeAgreementAcceptOpRet(sourcetx.vout.back().scriptPubKey, version, offertxid)) != 0)
@@ -3106,6 +3174,54 @@ UniValue AgreementEventLog(const uint256 agreementtxid,uint8_t flags,int64_t sam
 	struct CCcontract_info *cp,C;
 	cp = CCinit(&C,EVAL_AGREEMENTS);
 
+	auto AddEvent = [&](uint8_t funcid, uint256 batontxid)
+	{
+		switch(funcid)
+		{
+			case 'c':
+				if (flags & ASF_AMENDMENTS && batontxid != agreementtxid) result.push_back(batontxid.GetHex());
+				break;
+			case 't':
+				if (flags & ASF_CLOSURES) result.push_back(batontxid.GetHex());
+				break;
+			case 'd':
+				if (flags & ASF_DISPUTES) result.push_back(batontxid.GetHex());
+				break;
+			case 'r':
+				if (flags & ASF_RESOLUTIONS) result.push_back(batontxid.GetHex());
+				break;
+			case 'u':
+				if (flags & ASF_UNLOCKS) result.push_back(batontxid.GetHex());
+				break;
+			case 'x':
+				if (flags & ASF_DISPUTECANCELS) result.push_back(batontxid.GetHex());
+				break;
+		}
+	};
+
+	// With the baton chain index only the requested page of events is read, event 0 is the agreement itself.
+	CCCBatonTipValue tip;
+	std::vector<std::pair<CCCBatonEventKey, CCCBatonEventValue> > events;
+	if (GetCCBatonTip(EVAL_AGREEMENTS, agreementtxid, tip, false))
+	{
+		uint32_t nevents = tip.nEvents - 1, firstseq = 1;
+
+		if (samplenum > 0 && samplenum < nevents)
+		{
+			if (bReverse)
+				firstseq = tip.nEvents - samplenum;
+			nevents = samplenum;
+		}
+		if (nevents > 0 && GetCCBatonEvents(EVAL_AGREEMENTS, agreementtxid, firstseq, nevents, events))
+		{
+			if (bReverse)
+				std::reverse(events.begin(), events.end());
+			for (const auto &event : events)
+				AddEvent(event.second.funcid, event.second.txid);
+		}
+		return(result);
+	}
+
 	if (myGetTransactionCCV2(cp,agreementtxid,agreementtx,hashBlock) && (numvouts = agreementtx.vout.size()) > 0 &&
 	DecodeAgreementOpRet(agreementtx.vout[numvouts-1].scriptPubKey) == 'c')
 	{
@@ -3125,27 +3241,7 @@ UniValue AgreementEventLog(const uint256 agreementtxid,uint8_t flags,int64_t sam
 			// Fetch function id.
 			(funcid = DecodeAgreementOpRet(batontx.vout.back().scriptPubKey)) != 0)
 			{
-				switch(funcid)
-				{
-					case 'c':
-						if (flags & ASF_AMENDMENTS && batontxid != agreementtxid) result.push_back(batontxid.GetHex());
-						break;
-					case 't':
-						if (flags & ASF_CLOSURES) result.push_back(batontxid.GetHex());
-						break;
-					case 'd':
-						if (flags & ASF_DISPUTES) result.push_back(batontxid.GetHex());
-						break;
-					case 'r':
-						if (flags & ASF_RESOLUTIONS) result.push_back(batontxid.GetHex());
-						break;
-					case 'u':
-						if (flags & ASF_UNLOCKS) result.push_back(batontxid.GetHex());
-						break;
-					case 'x':
-						if (flags & ASF_DISPUTECANCELS) result.push_back(batontxid.GetHex());
-						break;
-				}
+				AddEvent(funcid, batontxid);
 				
 				if (batontxid != agreementtxid) total++;
 
@@ -3258,9 +3354,35 @@ UniValue AgreementInventory(const CPubKey pk)
 		}
 	};
 
-	SetCCunspents(addressIndexCCMarker,AgreementsCCaddr,true);
-	for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it = addressIndexCCMarker.begin(); it != addressIndexCCMarker.end(); it++)
-		AddAgreementWithKey(it->first.txhash);
+	// With the baton chain index the agreements are found from the pk postings, an agreement is active while its event log is open.
+	std::vector<std::pair<CCCBatonPostingKey, int32_t> > postings;
+	if (GetCCBatonPostings(EVAL_AGREEMENTS, std::vector<uint8_t>(pk.begin(), pk.end()), postings))
+	{
+		CCCBatonTipValue tip;
+		for (const auto &posting : postings)
+		{
+			if (!GetCCBatonTip(EVAL_AGREEMENTS, posting.first.rootid, tip, false) || tip.batonvout < 0)
+				continue;
+			switch (posting.first.role)
+			{
+				case 'o':
+					offerorlist.push_back(posting.first.rootid.GetHex());
+					break;
+				case 's':
+					signerlist.push_back(posting.first.rootid.GetHex());
+					break;
+				case 'a':
+					arblist.push_back(posting.first.rootid.GetHex());
+					break;
+			}
+		}
+	}
+	else
+	{
+		SetCCunspents(addressIndexCCMarker,AgreementsCCaddr,true);
+		for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it = addressIndexCCMarker.begin(); it != addressIndexCCMarker.end(); it++)
+			AddAgreementWithKey(it->first.txhash);
+	}
 	result.push_back(Pair("offeror",offerorlist));
 	result.push_back(Pair("signer",signerlist));
 	result.push_back(Pair("arbitrator",arblist));
@@ -3311,7 +3433,14 @@ UniValue AgreementList(const uint8_t flags,const uint256 filtertxid,const int64_
 			}
 		}
 	}
-	if (flags & ASF_AGREEMENTS)
+	std::vector<std::pair<CCCBatonKey, CCCBatonTipValue> > tips;
+	if ((flags & ASF_AGREEMENTS) && filterdeposit == 0 && pk == CPubKey() && GetCCBatonTips(EVAL_AGREEMENTS, tips))
+	{
+		// Every indexed event log starts at an agreement transaction, no need to load them.
+		for (const auto &tip : tips)
+			result.push_back(tip.first.rootid.GetHex());
+	}
+	else if (flags & ASF_AGREEMENTS)
 	{
 		SetCCtxids(agreementtxids,AgreementsCCaddr,true,cp->evalcode,filterdeposit,zeroid,'c');
 		for (std::vector<uint256>::const_iterator it=agreementtxids.begin(); it!=agreementtxids.end(); it++)
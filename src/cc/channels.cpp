@@ -16,6 +16,7 @@
 #include "CCtokens.h"
 #include "CCtokens_impl.h"
 #include "CCchannels.h"
+#include "CCbatonindex.h"
 
 /*
  The idea here is to allow instant (mempool) payments that are secured by dPoW. In order to simplify things, channels CC will require creating reserves for each payee locked in the destination user's CC address. This will look like the payment is already made, but it is locked until further released. The dPoW protection comes from the cancel channel having a delayed effect until the next notarization. This way, if a payment release is made and the chain reorged, the same payment release will still be valid when it is re-broadcast into the mempool.
@@ -394,6 +395,33 @@ bool ChannelsValidate(struct CCcontract_info *cp,Eval* eval,const CTransaction &
 }
 // end of consensus code
 
+// channel funds are a baton chain for the cc baton index: the open tx locks them in vout0, each payment and the close
+// spend the previous vout0 and recreate it in vout0, the refund pays them out and ends the chain
+
+bool ChannelsBatonRoot(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata)
+{
+    uint256 opentxid,hashchain,tokenid=zeroid; CPubKey srcpub,destpub; int32_t numpayments; int64_t payment;
+
+    if (tx.vout.size() < 2 || (funcid=DecodeChannelsOpRet(tx.vout.back().scriptPubKey,tokenid,opentxid,srcpub,destpub,numpayments,payment,hashchain))!='O')
+        return false;
+    batonvout=0;
+    rootdata=tokenid;
+    return true;
+}
+
+bool ChannelsBatonNext(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid)
+{
+    uint256 opentxid,param3,tokenid=zeroid; CPubKey srcpub,destpub; int32_t param1; int64_t param2;
+
+    if (tx.vin[vini].prevout.n != 0 || tx.vout.size() < 2)
+        return false;
+    funcid=DecodeChannelsOpRet(tx.vout.back().scriptPubKey,tokenid,opentxid,srcpub,destpub,param1,param2,param3);
+    if ((funcid!='P' && funcid!='C' && funcid!='R') || tokenid!=tip.rootdata)
+        return false;
+    batonvout=(funcid=='R')?-1:0;
+    return true;
+}
+
 // helper functions for rpc calls in rpcwallet.cpp
 
 int64_t AddChannelsInputs(struct CCcontract_info *cp,CMutableTransaction &mtx, CTransaction openTx, uint256 &prevtxid, CPubKey mypk)
@@ -402,12 +430,12 @@ int64_t AddChannelsInputs(struct CCcontract_info *cp,CMutableTransaction &mtx, C
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
     CPubKey srcpub,destpub;
     uint8_t myprivkey[32];    
+    CCCBatonTipValue tip; bool fTip;
 
     if ((numvouts=openTx.vout.size()) > 0 && DecodeChannelsOpRet(openTx.vout[numvouts-1].scriptPubKey,tokenid,tmp_txid,srcpub,destpub,param1,param2,param3)=='O')
     {
         if (tokenid!=zeroid) GetTokensCCaddress1of2(cp,coinaddr,srcpub,destpub);
         else GetCCaddress1of2(cp,coinaddr,srcpub,destpub);
-        SetCCunspents(unspentOutputs,coinaddr,true);
     }
     else
     {
@@ -416,6 +444,14 @@ int64_t AddChannelsInputs(struct CCcontract_info *cp,CMutableTransaction &mtx, C
     }
     if (srcpub==mypk) marker=1;
     else marker=2;
+    // with the baton index the current vout0 is the chain tip, mempool payments included
+    if ((fTip=GetCCBatonTip(EVAL_CHANNELS,openTx.GetHash(),tip,true)))
+    {
+        if (tip.batonvout==0 && myGetTransaction(tip.txid,tx,hashBlock) != 0 && IsChannelsMarkervout(cp,tx,marker==1?srcpub:destpub,marker)>0 &&
+          (totalinputs=IsChannelsvout(cp,tx,srcpub,destpub,0))>0)
+            txid=tip.txid;
+    }
+    else SetCCunspents(unspentOutputs,coinaddr,true);
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=unspentOutputs.begin(); it!=unspentOutputs.end(); it++)
     {
         if ( (int32_t)it->first.index==0 && myGetTransaction(it->first.txhash,tx,hashBlock) != 0 && (numvouts=tx.vout.size()) > 0)
@@ -429,7 +465,7 @@ int64_t AddChannelsInputs(struct CCcontract_info *cp,CMutableTransaction &mtx, C
             }
         }
     }
-    if (txid!=zeroid && myIsutxo_spentinmempool(ignoretxid,ignorevin,txid,0) != 0)
+    if (txid!=zeroid && fTip==0 && myIsutxo_spentinmempool(ignoretxid,ignorevin,txid,0) != 0)
     {
         txid=zeroid;
         int32_t mindepth=CHANNELS_MAXPAYMENTS;
@@ -716,6 +752,7 @@ UniValue ChannelsInfo(const CPubKey& pk,uint256 channeltxid)
     struct CCcontract_info *cp,C; char CCaddr[65],addr[65],str[512]; int32_t vout,numvouts,param1,numpayments;
     int64_t param2,payment; CPubKey srcpub,destpub,mypk;
     std::vector<uint256> txids; std::vector<CTransaction> txs;
+    CCCBatonTipValue tip; std::vector<std::pair<CCCBatonEventKey, CCCBatonEventValue> > events; uint8_t funcid;
     
     cp = CCinit(&C,EVAL_CHANNELS);
     mypk = pk.IsValid()?pk:pubkey2pk(Mypubkey());
@@ -740,22 +777,43 @@ UniValue ChannelsInfo(const CPubKey& pk,uint256 channeltxid)
             result.push_back(Pair("Denomination (satoshi)",i64tostr(param2)));
             result.push_back(Pair("Amount (satoshi)",i64tostr(param1*param2)));
         }
-        GetCCaddress(cp,CCaddr,mypk);
-        SetCCtxids(txids,CCaddr,true,EVAL_CHANNELS,0,channeltxid,0);                      
-        for (std::vector<uint256>::const_iterator it=txids.begin(); it!=txids.end(); it++)
+        if (GetCCBatonTip(EVAL_CHANNELS,channeltxid,tip,false))
         {
-            if (myGetTransaction(*it,tx,hashBlock) != 0 && (numvouts= tx.vout.size()) > 0 &&
-                DecodeChannelsOpRet(tx.vout[numvouts-1].scriptPubKey,tokenid,tmp_txid,srcpub,destpub,param1,param2,param3)!=0 && (tmp_txid==channeltxid || tx.GetHash()==channeltxid))
-                    txs.push_back(tx);               
+            // with the baton index the channel events are read in order from the index, mempool payments follow the confirmed tip
+            if (GetCCBatonEvents(EVAL_CHANNELS,channeltxid,0,tip.nEvents,events) && GetCCBatonMempoolEvents(EVAL_CHANNELS,channeltxid,tip,events))
+            {
+                for (std::vector<std::pair<CCCBatonEventKey, CCCBatonEventValue> >::const_iterator it=events.begin(); it!=events.end(); it++)
+                    if (myGetTransaction(it->second.txid,tx,hashBlock) != 0)
+                        txs.push_back(tx);
+            }
+            if (!txs.empty() && (numvouts=txs.back().vout.size()) > 0 &&
+                (funcid=DecodeChannelsOpRet(txs.back().vout[numvouts-1].scriptPubKey,tokenid,tmp_txid,srcpub,destpub,param1,param2,param3)) != 0)
+            {
+                result.push_back(Pair("Status",funcid=='R'?"refunded":(funcid=='C'?"closed":"open")));
+                result.push_back(Pair("Last txid",txs.back().GetHash().GetHex().data()));
+                result.push_back(Pair("Payments left",funcid=='R'?0:param1));
+                result.push_back(Pair("Funds left",i64tostr(funcid=='R'?0:txs.back().vout[0].nValue)));
+            }
         }
-        std::vector<CTransaction> tmp_txs;
-        myGet_mempool_txs(tmp_txs,EVAL_CHANNELS,'P');
-        for (std::vector<CTransaction>::const_iterator it=tmp_txs.begin(); it!=tmp_txs.end(); it++)
+        else
         {
-            const CTransaction &txmempool = *it;
+            GetCCaddress(cp,CCaddr,mypk);
+            SetCCtxids(txids,CCaddr,true,EVAL_CHANNELS,0,channeltxid,0);                      
+            for (std::vector<uint256>::const_iterator it=txids.begin(); it!=txids.end(); it++)
+            {
+                if (myGetTransaction(*it,tx,hashBlock) != 0 && (numvouts= tx.vout.size()) > 0 &&
+                    DecodeChannelsOpRet(tx.vout[numvouts-1].scriptPubKey,tokenid,tmp_txid,srcpub,destpub,param1,param2,param3)!=0 && (tmp_txid==channeltxid || tx.GetHash()==channeltxid))
+                        txs.push_back(tx);               
+            }
+            std::vector<CTransaction> tmp_txs;
+            myGet_mempool_txs(tmp_txs,EVAL_CHANNELS,'P');
+            for (std::vector<CTransaction>::const_iterator it=tmp_txs.begin(); it!=tmp_txs.end(); it++)
+            {
+                const CTransaction &txmempool = *it;
 
-            if ((numvouts=txmempool.vout.size()) > 0 && DecodeChannelsOpRet(txmempool.vout[numvouts-1].scriptPubKey,tokenid,tmp_txid,srcpub,destpub,param1,param2,param3) == 'P' && tmp_txid==channeltxid)
-                txs.push_back(txmempool);                
+                if ((numvouts=txmempool.vout.size()) > 0 && DecodeChannelsOpRet(txmempool.vout[numvouts-1].scriptPubKey,tokenid,tmp_txid,srcpub,destpub,param1,param2,param3) == 'P' && tmp_txid==channeltxid)
+                    txs.push_back(txmempool);                
+            }
         }
         for (std::vector<CTransaction>::const_iterator it=txs.begin(); it!=txs.end(); it++)
         {
@@ -953,7 +953,7 @@ UniValue GatewaysDeposit(const CPubKey& pk, uint64_t txfee,uint256 bindtxid,int3
     {
         pubkey33_str(str,(uint8_t *)&pubkeys[i]);
         LOGSTREAM("gatewayscc",CCLOG_INFO, stream << "pubkeys[" << i << "] " << str << std::endl);
-        if ( (mhash= CCOraclesReverseScan("gatewayscc-2",txid,height,oracletxid,OraclesBatontxid(oracletxid,pubkeys[i]))) != zeroid )
+        if ( (mhash= CCOraclesReverseScan("gatewayscc-2",txid,height,oracletxid,OraclesBatontxidIndexed(oracletxid,pubkeys[i]))) != zeroid )
         {
             if ( merkleroot == zeroid )
                 merkleroot = mhash, m = 1;
@@ -15,6 +15,8 @@
 
 #include "CCHeir.h"
 #include "heir_validate.h"
+#include "main.h"
+#include "txdb.h"
 #include <iomanip>
 
 class CoinHelper;
@@ -561,6 +563,167 @@ template <class Helper> int64_t LifetimeHeirContractFunds(struct CCcontract_info
     return (total);
 }
 
+/* heir index, the confirmed state of each plan updated in ConnectBlock (see ccheirindex.h)
+ * consensus-neutral: validation and tx creation keep using FindLatestFundingTx
+ */
+
+// decodes the heir opret of a tx and returns its funcid, fundingtxid is the plan the tx belongs to
+static uint8_t HeirIndexDecode(const CTransaction &tx, uint256 &fundingtxid, uint256 &tokenid, CPubKey &ownerPubkey, CPubKey &heirPubkey, int64_t &inactivityTime, uint8_t &hasHeirSpendingBegun)
+{
+    std::string heirName, memo;
+    uint256 fundingTxidInOpret;
+    bool hasCCvout = false;
+
+    if (tx.IsCoinBase() || tx.vout.size() < 2 || tx.vout.back().scriptPubKey.size() < 3 || tx.vout.back().scriptPubKey[0] != OP_RETURN)
+        return 0;
+    for (const auto &vout : tx.vout)
+        if (vout.scriptPubKey.IsPayToCryptoCondition())
+            hasCCvout = true;
+    if (!hasCCvout)
+        return 0;
+
+    tokenid = zeroid;
+    hasHeirSpendingBegun = 0;
+    uint8_t funcId = _DecodeHeirEitherOpRetV1(tx.vout.back().scriptPubKey, tokenid, ownerPubkey, heirPubkey, inactivityTime, heirName, memo, fundingTxidInOpret, hasHeirSpendingBegun, true);
+    if (funcId == 0)
+        return 0;
+    fundingtxid = (funcId == 'F') ? tx.GetHash() : fundingTxidInOpret;
+    return funcId;
+}
+
+// the 1of2 address holding the funds of an indexed plan
+static void HeirIndexFundsAddress(const CCCHeirStateValue &state, char *fundsaddr)
+{
+    if (state.tokenid.IsNull())
+        CoinHelper::GetCoinsOrTokensCCaddress1of2(fundsaddr, state.ownerPubkey, state.heirPubkey);
+    else
+        TokenHelper::GetCoinsOrTokensCCaddress1of2(fundsaddr, state.ownerPubkey, state.heirPubkey);
+}
+
+// total paid to the plan 1of2 address by the vouts of tx
+static CAmount HeirIndexFunds(const CTransaction &tx, const char *fundsaddr)
+{
+    char destaddr[KOMODO_ADDRESS_BUFSIZE];
+    CAmount total = 0;
+
+    for (int32_t i = 0; i < (int32_t)tx.vout.size() - 1; i++)
+        if (tx.vout[i].scriptPubKey.IsPayToCryptoCondition() && Getscriptaddress(destaddr, tx.vout[i].scriptPubKey) && strcmp(destaddr, fundsaddr) == 0)
+            total += tx.vout[i].nValue;
+    return total;
+}
+
+// total spent by tx from the plan 1of2 address, only outputs of the same plan are counted like in Add1of2AddressInputs()
+static CAmount HeirIndexSpent(const std::map<uint256, const CTransaction*> &blocktxs, const CTransaction &tx, uint256 fundingtxid, const char *fundsaddr)
+{
+    char destaddr[KOMODO_ADDRESS_BUFSIZE];
+    CAmount total = 0;
+
+    for (const auto &vin : tx.vin) {
+        CTransaction prevtx;
+        uint256 hashBlock, prevFundingtxid, tokenid;
+        CPubKey ownerPubkey, heirPubkey;
+        int64_t inactivityTime;
+        uint8_t hasHeirSpendingBegun;
+
+        if (!IsCCInput(vin.scriptSig))
+            continue;
+        std::map<uint256, const CTransaction*>::const_iterator it = blocktxs.find(vin.prevout.hash);
+        if (it != blocktxs.end())
+            prevtx = *it->second;
+        else if (!myGetTransaction(vin.prevout.hash, prevtx, hashBlock))
+            continue;
+        if (vin.prevout.n >= prevtx.vout.size() || HeirIndexDecode(prevtx, prevFundingtxid, tokenid, ownerPubkey, heirPubkey, inactivityTime, hasHeirSpendingBegun) == 0 || prevFundingtxid != fundingtxid)
+            continue;
+        if (Getscriptaddress(destaddr, prevtx.vout[vin.prevout.n].scriptPubKey) && strcmp(destaddr, fundsaddr) == 0)
+            total += prevtx.vout[vin.prevout.n].nValue;
+    }
+    return total;
+}
+
+// collects the new plan states of a connected block and the replaced states as undo records, keyed by txid
+void HeirIndexConnectBlock(const CBlock &block, int32_t height, std::vector<std::pair<uint256, CCCHeirStateValue> > &states, std::vector<std::pair<uint256, CCCHeirStateValue> > &undo)
+{
+    std::map<uint256, CCCHeirStateValue> updated;
+    std::map<uint256, const CTransaction*> blocktxs;
+
+    for (const auto &tx : block.vtx) {
+        uint256 txid = tx.GetHash(), fundingtxid, tokenid;
+        CPubKey ownerPubkey, heirPubkey;
+        int64_t inactivityTime;
+        uint8_t hasHeirSpendingBegun, funcId;
+        CCCHeirStateValue state;
+        char fundsaddr[KOMODO_ADDRESS_BUFSIZE];
+
+        blocktxs[txid] = &tx;
+        if ((funcId = HeirIndexDecode(tx, fundingtxid, tokenid, ownerPubkey, heirPubkey, inactivityTime, hasHeirSpendingBegun)) == 0)
+            continue;
+
+        std::map<uint256, CCCHeirStateValue>::const_iterator it = updated.find(fundingtxid);
+        if (it != updated.end())
+            state = it->second;
+        else if (!pblocktree->ReadHeirState(fundingtxid, state))
+            state.SetNull();
+
+        if (funcId == 'F') {
+            if (!state.IsNull())
+                continue;
+            undo.push_back(std::make_pair(txid, state));
+            state.tokenid = tokenid;
+            state.ownerPubkey = ownerPubkey;
+            state.heirPubkey = heirPubkey;
+            state.inactivityTime = inactivityTime;
+            state.fundingHeight = height;
+            state.lasttxid = txid;
+            state.lastHeight = height;
+            state.lastFuncid = funcId;
+        } else {
+            // the same plan match as FindLatestFundingTx
+            if (state.IsNull() || (!state.tokenid.IsNull() && tokenid != state.tokenid))
+                continue;
+            undo.push_back(std::make_pair(txid, state));
+            // 'donations' with no owner inputs don't count as owner activity
+            if (TotalPubkeyNormalInputs(nullptr, tx, state.ownerPubkey) > 0 || TotalPubkeyCCInputs(nullptr, tx, state.ownerPubkey) > 0) {
+                state.lasttxid = txid;
+                state.lastHeight = height;
+                state.lastFuncid = funcId;
+                state.hasHeirSpendingBegun = hasHeirSpendingBegun;
+            }
+        }
+
+        HeirIndexFundsAddress(state, fundsaddr);
+        CAmount funds = HeirIndexFunds(tx, fundsaddr);
+        if (!isSpendingTx(funcId))
+            state.lifetime += funds;
+        state.balance += funds - HeirIndexSpent(blocktxs, tx, fundingtxid, fundsaddr);
+        state.nTxns++;
+        updated[fundingtxid] = state;
+    }
+    for (const auto &entry : updated)
+        states.push_back(entry);
+}
+
+// restores the plan states replaced by the txns of a disconnected block from their undo records
+void HeirIndexDisconnectBlock(const CBlock &block, std::vector<std::pair<uint256, CCCHeirStateValue> > &states, std::vector<std::pair<uint256, CCCHeirStateValue> > &undo)
+{
+    std::map<uint256, CCCHeirStateValue> updated;
+
+    for (int32_t i = block.vtx.size() - 1; i >= 0; i--) {
+        const CTransaction &tx = block.vtx[i];
+        uint256 txid = tx.GetHash(), fundingtxid, tokenid;
+        CPubKey ownerPubkey, heirPubkey;
+        int64_t inactivityTime;
+        uint8_t hasHeirSpendingBegun;
+        CCCHeirStateValue prevstate;
+
+        if (HeirIndexDecode(tx, fundingtxid, tokenid, ownerPubkey, heirPubkey, inactivityTime, hasHeirSpendingBegun) == 0 || !pblocktree->ReadHeirUndo(txid, prevstate))
+            continue;
+        updated[fundingtxid] = prevstate;  // a null state erases the plan
+        undo.push_back(std::make_pair(txid, prevstate));
+    }
+    for (const auto &entry : updated)
+        states.push_back(entry);
+}
+
 /* rpc functions' implementation: */
 
 /**
@@ -1039,7 +1202,23 @@ UniValue HeirInfo(uint256 fundingtxid)
         
         uint8_t hasHeirSpendingBegun = 0;
         
-        uint256 latestFundingTxid = FindLatestFundingTx(fundingtxid, funcId, tokenid, ownerPubkey, heirPubkey, inactivityTimeSec, heirName, memo, hasHeirSpendingBegun);
+        uint256 latestFundingTxid;
+        CCCHeirStateValue state;
+        bool fIndexed = fHeirIndex && pblocktree->ReadHeirState(fundingtxid, state);
+
+        if (fIndexed) {
+            // the plan state is read from the heir index, only the name and memo are decoded from the funding tx
+            DecodeHeirEitherOpRetV1(fundingtx.vout.back().scriptPubKey, dummyTokenid, ownerPubkey, heirPubkey, inactivityTimeSec, heirName, memo, true);
+            tokenid = state.tokenid;
+            ownerPubkey = state.ownerPubkey;
+            heirPubkey = state.heirPubkey;
+            inactivityTimeSec = state.inactivityTime;
+            funcId = state.lastFuncid;
+            hasHeirSpendingBegun = state.hasHeirSpendingBegun;
+            latestFundingTxid = state.lasttxid;
+        }
+        else
+            latestFundingTxid = FindLatestFundingTx(fundingtxid, funcId, tokenid, ownerPubkey, heirPubkey, inactivityTimeSec, heirName, memo, hasHeirSpendingBegun);
         
         if (latestFundingTxid != zeroid) {
             int32_t numblocks;
@@ -1079,7 +1258,9 @@ UniValue HeirInfo(uint256 fundingtxid)
                 cp = CCinit(&C, EVAL_TOKENS);
             
             int64_t total;
-            if (tokenid == zeroid)
+            if (fIndexed)
+                total = state.lifetime;
+            else if (tokenid == zeroid)
                 total = LifetimeHeirContractFunds<CoinHelper>(cp, fundingtxid, ownerPubkey, heirPubkey);
             else
                 total = LifetimeHeirContractFunds<TokenHelper>(cp, fundingtxid, ownerPubkey, heirPubkey);
@@ -1107,7 +1288,9 @@ UniValue HeirInfo(uint256 fundingtxid)
             stream.clear();
             
             int64_t inputs;
-            if (tokenid == zeroid)
+            if (fIndexed)
+                inputs = state.balance;
+            else if (tokenid == zeroid)
                 inputs = Add1of2AddressInputs<CoinHelper>(cp, fundingtxid, mtx, ownerPubkey, heirPubkey, 0, 60); //NOTE: amount = 0 means all unspent inputs
             else
                 inputs = Add1of2AddressInputs<TokenHelper>(cp, fundingtxid, mtx, ownerPubkey, heirPubkey, 0, 60);
@@ -534,7 +534,7 @@ UniValue ImportGatewayDeposit(const CPubKey& pk, uint64_t txfee,uint256 bindtxid
     {
         pubkey33_str(str,(uint8_t *)&pubkeys[i]);
         LOGSTREAM("importgateway",CCLOG_INFO, stream << "pubkeys[" << i << "] " << str << std::endl);
-        if ( (mhash= CCOraclesReverseScan("importgateway-2",txid,height,oracletxid,OraclesBatontxid(oracletxid,pubkeys[i]))) != zeroid )
+        if ( (mhash= CCOraclesReverseScan("importgateway-2",txid,height,oracletxid,OraclesBatontxidIndexed(oracletxid,pubkeys[i]))) != zeroid )
         {
             if ( merkleroot == zeroid )
                 merkleroot = mhash, m = 1;
@@ -583,7 +583,7 @@ UniValue ImportGatewayWithdraw(const CPubKey& pk, uint64_t txfee,uint256 bindtxi
         CCERR_RESULT("importgateway",CCLOG_ERROR, stream << "withdraw destination pubkey is invalid");
     n = (int32_t)msigpubkeys.size();
     for (i=0; i<n; i++)
-        if ( (balance=CCOraclesGetDepositBalance("importgateway-2",oracletxid,OraclesBatontxid(oracletxid,msigpubkeys[i])))==0 || amount > balance )
+        if ( (balance=CCOraclesGetDepositBalance("importgateway-2",oracletxid,OraclesBatontxidIndexed(oracletxid,msigpubkeys[i])))==0 || amount > balance )
             CCERR_RESULT("importgateway",CCLOG_ERROR, stream << "withdraw amount is not possible, deposit balance is lower than the amount!");
     if( AddNormalinputs(mtx, mypk, txfee+CC_MARKER_VALUE+amount, 64,pk.IsValid()) > 0 )
     {
@@ -15,6 +15,9 @@
 
 #include "komodo_defs.h"
 #include "CCOracles.h"
+#include "CCbatonindex.h"
+#include "main.h"
+#include "txdb.h"
 #include <secp256k1.h>
 
 /*
@@ -311,6 +314,40 @@ uint256 OracleBatonUtxo(uint64_t value, struct CCcontract_info* cp, uint256 refo
     return (batontxid);
 }
 
+// baton chain index rules, see cc/CCbatonindex.cpp
+// each publisher registration starts a chain with its baton in vout1, every data tx spends the previous baton in vin1 and recreates it in vout1
+static bool IsOracleBatonvout(const CTransaction &tx)
+{
+    return (tx.vout.size() > 2 && tx.vout[1].nValue == CC_MARKER_VALUE && tx.vout[1].scriptPubKey.IsPayToCryptoCondition());
+}
+
+bool OraclesBatonRoot(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata)
+{
+    uint256 oracletxid;
+    CPubKey pk;
+    int64_t datafee;
+
+    if ((funcid = DecodeOraclesOpRet(tx.vout.back().scriptPubKey, oracletxid, pk, datafee)) != 'R')
+        return false;
+    batonvout = IsOracleBatonvout(tx) ? 1 : -1;
+    rootdata = oracletxid;
+    return true;
+}
+
+bool OraclesBatonNext(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid)
+{
+    uint256 oracletxid, batontxid;
+    CPubKey pk;
+    std::vector<uint8_t> data;
+
+    if (vini != 1 || tx.vin[vini].prevout.n != 1)
+        return false;
+    if ((funcid = DecodeOraclesData(tx.vout.back().scriptPubKey, oracletxid, batontxid, pk, data)) != 'D' || oracletxid != tip.rootdata || batontxid != tx.vin[vini].prevout.hash)
+        return false;
+    batonvout = IsOracleBatonvout(tx) ? 1 : -1;
+    return true;
+}
+
 uint256 OraclesBatontxid(uint256 reforacletxid, CPubKey refpk)
 {
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> unspentOutputs;
@@ -342,6 +379,76 @@ uint256 OraclesBatontxid(uint256 reforacletxid, CPubKey refpk)
     return (batontxid);
 }
 
+// same as OraclesBatontxid, but reads the tips from the baton chain index when it is enabled.
+// only for rpcs: the index is optional and follows the local mempool, so validation code keeps using OraclesBatontxid
+uint256 OraclesBatontxidIndexed(uint256 reforacletxid, CPubKey refpk)
+{
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> unspentOutputs;
+    CTransaction regtx;
+    uint256 txid, batontxid, oracletxid;
+    CPubKey pk;
+    int32_t maxheight = 0;
+    int64_t datafee;
+    char markeraddr[64];
+    struct CCcontract_info *cp, C;
+    CCCBatonTipValue tip;
+
+    if (!fCCBatonIndex)
+        return (OraclesBatontxid(reforacletxid, refpk));
+    batontxid = zeroid;
+    cp = CCinit(&C, EVAL_ORACLES);
+    CCtxidaddr(markeraddr, reforacletxid);
+    SetCCunspents(unspentOutputs, markeraddr, false);
+    for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>::const_iterator it = unspentOutputs.begin(); it != unspentOutputs.end(); it++) {
+        txid = it->first.txhash;
+        if (FetchCCtx(txid, regtx, cp) && regtx.vout.size() >= 2 && DecodeOraclesOpRet(regtx.vout.back().scriptPubKey, oracletxid, pk, datafee) == 'R' && oracletxid == reforacletxid && pk == refpk) {
+            if (!GetCCBatonTip(EVAL_ORACLES, txid, tip, true))
+                return (OraclesBatontxid(reforacletxid, refpk));
+            // take the most recent tip over all registrations of the publisher, mempool tips first
+            if (batontxid == zeroid || tip.blockHeight == 0 || (maxheight != 0 && tip.blockHeight > maxheight)) {
+                batontxid = tip.txid;
+                maxheight = tip.blockHeight;
+            }
+        }
+    }
+    return (batontxid);
+}
+
+// oracle data index, every confirmed data tx appends a sample to the series of its oracle and baton address
+static bool GetOracleSample(const CTransaction& tx, CCCOracleSeriesKey& series, std::vector<uint8_t>& data)
+{
+    uint256 btxid;
+    CPubKey pk;
+    char batonaddr[KOMODO_ADDRESS_BUFSIZE];
+
+    if (tx.IsCoinBase() || tx.vout.size() < 3 || !IsOracleBatonvout(tx) || DecodeOraclesData(tx.vout.back().scriptPubKey, series.oracletxid, btxid, pk, data) != 'D')
+        return false;
+    Getscriptaddress(batonaddr, tx.vout[1].scriptPubKey);
+    series.batonaddr = batonaddr;
+    return true;
+}
+
+void OraclesDataIndexConnectBlock(const CBlock& block, int32_t height, std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue>>& samples)
+{
+    CCCOracleSeriesKey series;
+    std::vector<uint8_t> data;
+
+    for (int32_t i = 0; i < block.vtx.size(); i++) {
+        if (GetOracleSample(block.vtx[i], series, data))
+            samples.push_back(std::make_pair(CCCOracleSampleKey(series.oracletxid, series.batonaddr, height, i), CCCOracleSampleValue(block.vtx[i].GetHash(), data)));
+    }
+}
+
+void OraclesDataIndexDisconnectBlock(const CBlock& block, int32_t height, std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue>>& samples)
+{
+    CCCOracleSeriesKey series;
+    std::vector<uint8_t> data;
+
+    for (int32_t i = 0; i < block.vtx.size(); i++) {
+        if (GetOracleSample(block.vtx[i], series, data))
+            samples.push_back(std::make_pair(CCCOracleSampleKey(series.oracletxid, series.batonaddr, height, i), CCCOracleSampleValue()));
+    }
+}
 
 /*int64_t OraclePrice(int32_t height,uint256 reforacletxid,char *markeraddr,char *format)
 {
@@ -923,6 +1030,22 @@ UniValue OracleDataSamples(uint256 reforacletxid, char* batonaddr, int32_t num)
                     }
                 }
             }
+            std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue>> samples;
+            if (fOracleDataIndex) {
+                // the index keeps the decoded samples, latest first, no need to load the data txns
+                if ((formatstr = (char*)format.c_str()) == NULL)
+                    formatstr = (char*)"";
+                if (pblocktree->ReadOracleSamples(CCCOracleSeriesKey(reforacletxid, batonaddr), 0, 0xffffffff, num != 0 ? num - n : 0, true, samples)) {
+                    for (const auto& sample : samples) {
+                        UniValue a(UniValue::VOBJ);
+                        a.push_back(Pair("txid", sample.second.txid.GetHex()));
+                        a.push_back(Pair("data", OracleFormat((uint8_t*)sample.second.data.data(), (int32_t)sample.second.data.size(), formatstr, (int32_t)format.size())));
+                        b.push_back(a);
+                    }
+                }
+                result.push_back(Pair("samples", b));
+                return (result);
+            }
             SetCCtxids(txids, batonaddr, true, EVAL_ORACLES, CC_MARKER_VALUE, reforacletxid, 'D');
             if (txids.size() > 0) {
                 for (std::vector<uint256>::const_iterator it = txids.end() - 1; it != txids.begin(); it--) {
@@ -951,6 +1074,54 @@ UniValue OracleDataSamples(uint256 reforacletxid, char* batonaddr, int32_t num)
     return (result);
 }
 
+UniValue OracleDataSeries(uint256 reforacletxid, char* batonaddr, int32_t fromheight, int32_t toheight, int32_t num, bool fColumnar)
+{
+    UniValue result(UniValue::VOBJ), rows(UniValue::VARR), heights(UniValue::VARR), txids(UniValue::VARR), values(UniValue::VARR);
+    CTransaction oracletx;
+    uint256 hashBlock;
+    std::string name, description, format;
+    std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue>> samples;
+    char* formatstr;
+
+    if (!fOracleDataIndex)
+        CCERR_RESULT("oraclescc", CCLOG_INFO, stream << "oracle data index is not enabled, restart with -oracledataindex");
+    if (myGetTransaction(reforacletxid, oracletx, hashBlock) == 0 || oracletx.vout.size() == 0)
+        CCERR_RESULT("oraclescc", CCLOG_INFO, stream << "cant find oracletxid " << reforacletxid.GetHex());
+    if (DecodeOraclesCreateOpRet(oracletx.vout.back().scriptPubKey, name, description, format) != 'C')
+        CCERR_RESULT("oraclescc", CCLOG_INFO, stream << "invalid oracletxid " << reforacletxid.GetHex());
+    if (fromheight < 0 || (toheight != 0 && toheight < fromheight) || num < 0)
+        CCERR_RESULT("oraclescc", CCLOG_INFO, stream << "invalid height range or sample count");
+    if (!pblocktree->ReadOracleSamples(CCCOracleSeriesKey(reforacletxid, batonaddr), fromheight, toheight != 0 ? toheight : 0xffffffff, num, false, samples))
+        CCERR_RESULT("oraclescc", CCLOG_INFO, stream << "error reading oracle data index");
+
+    if ((formatstr = (char*)format.c_str()) == NULL)
+        formatstr = (char*)"";
+    for (const auto& sample : samples) {
+        UniValue data = OracleFormat((uint8_t*)sample.second.data.data(), (int32_t)sample.second.data.size(), formatstr, (int32_t)format.size());
+        if (fColumnar) {
+            heights.push_back((int64_t)sample.first.blockHeight);
+            txids.push_back(sample.second.txid.GetHex());
+            values.push_back(data);
+        } else {
+            UniValue a(UniValue::VOBJ);
+            a.push_back(Pair("height", (int64_t)sample.first.blockHeight));
+            a.push_back(Pair("txid", sample.second.txid.GetHex()));
+            a.push_back(Pair("data", data));
+            rows.push_back(a);
+        }
+    }
+    result.push_back(Pair("result", "success"));
+    if (fColumnar) {
+        UniValue columns(UniValue::VOBJ);
+        columns.push_back(Pair("height", heights));
+        columns.push_back(Pair("txid", txids));
+        columns.push_back(Pair("data", values));
+        result.push_back(Pair("samples", columns));
+    } else
+        result.push_back(Pair("samples", rows));
+    return (result);
+}
+
 UniValue OracleInfo(uint256 origtxid)
 {
     UniValue result(UniValue::VOBJ), a(UniValue::VARR);
@@ -74,12 +74,19 @@ GetKomodoEarlytxidScriptPub is on line #2080 of komodo_bitcoind.h
 
 #include <cstdlib>
 #include <gmp.h>
+#include <boost/thread.hpp>
 
 #define IS_CHARINSTR(c, str) (std::string(str).find((char)(c)) != std::string::npos)
 
 #define NVOUT_CCMARKER 1
 #define NVOUT_NORMALMARKER 3
 
+#ifndef TESTMODE
+#define PRICES_COSTBASIS_PERIOD PRICES_DAYWINDOW
+#else
+#define PRICES_COSTBASIS_PERIOD 7
+#endif
+
 typedef struct OneBetData {
     int64_t positionsize;
     int32_t firstheight;
@@ -89,6 +96,15 @@ typedef struct OneBetData {
     OneBetData() { positionsize = 0; firstheight = 0; costbasis = 0; profits = 0; }  // it is important to clear costbasis as it will be calculated as minmax from inital value 0
 } onebetdata;
 
+// synthetic expression compiled once per bet, see prices_syntheticcompile()
+typedef struct PricesSynthetic {
+    std::vector<uint16_t> vec;                          // source opcodes, evaluated by the gmp interpreter if the fast path can't be used
+    std::vector<std::pair<uint16_t, uint16_t> > ops;    // decoded (opcode & KOMODO_PRICEMASK, index or weight)
+    bool fCompiled;                                     // stack use checked, only price or overflow errors are left at evaluation
+
+    PricesSynthetic() { fCompiled = false; }
+} PricesSynthetic;
+
 typedef struct BetInfo {
     uint256 txid;
     int64_t averageCostbasis, firstprice, lastprice, liquidationprice, equity;
@@ -99,6 +115,7 @@ typedef struct BetInfo {
     uint256 tokenid;
 
     std::vector<uint16_t> vecparsed;
+    PricesSynthetic synthetic;
     std::vector<onebetdata> bets;
     CPubKey pk;
 
@@ -132,7 +149,8 @@ typedef struct TotalFund {
 
 } TotalFund;
 
-int32_t prices_syntheticprofits(int64_t &costbasis, int32_t firstheight, int32_t height, int16_t leverage, std::vector<uint16_t> vec, int64_t positionsize, int64_t &profits, int64_t &outprice);
+int32_t prices_syntheticprofits(int64_t &costbasis, int32_t firstheight, int32_t height, int16_t leverage, const PricesSynthetic &synthetic, int64_t positionsize, int64_t &profits, int64_t &outprice);
+static void prices_profitsatprice(int64_t &costbasis, int32_t minmax, int16_t leverage, int64_t price, int64_t positionsize, int64_t &profits);
 static bool prices_isacceptableamount(const std::vector<uint16_t> &vecparsed, int64_t amount, int16_t leverage);
 
 // helpers:
@@ -1232,25 +1250,191 @@ int64_t prices_syntheticprice(std::vector<uint16_t> vec, int32_t height, int32_t
     return priceIndex;
 }
 
+typedef __int128 prices_int128_t;
+
+// smoothed prices read by synthetic expressions, shared by all bets.
+// the prices at a height are only rewritten when the block at that height is connected again (see komodo_pricesupdate),
+// which drops the cached prices from that height up once the new prices are written.
+// a price read from the files before an invalidation is not cached, it may be the old one.
+static CCriticalSection cs_pricescache;
+static std::map<std::pair<int32_t, uint16_t>, int64_t> pricesCache;  // (height, price index) -> smoothed price
+static uint64_t pricesCacheGeneration;  // incremented by every invalidation
+
+void prices_pricecacheinvalidate(int32_t height)
+{
+    LOCK(cs_pricescache);
+    pricesCache.erase(pricesCache.lower_bound(std::make_pair(height, (uint16_t)0)), pricesCache.end());
+    pricesCacheGeneration++;
+}
+
+// returns false if the price is not available or zero, the gmp interpreter then reports the error
+static bool prices_getcachedprice(uint16_t ind, int32_t height, int64_t &price)
+{
+    int64_t pricedata[PRICES_MAXDATAPOINTS];
+    uint64_t generation;
+    {
+        LOCK(cs_pricescache);
+        std::map<std::pair<int32_t, uint16_t>, int64_t>::iterator it = pricesCache.find(std::make_pair(height, ind));
+        if (it != pricesCache.end()) {
+            price = it->second;
+            return true;
+        }
+        generation = pricesCacheGeneration;
+    }
+    memset(pricedata, 0, sizeof(pricedata));
+    if (komodo_priceget(pricedata, ind, height, 1) < 0 || pricedata[2] == 0)
+        return false;
+    price = pricedata[2];
+
+    LOCK(cs_pricescache);
+    if (generation != pricesCacheGeneration)
+        return true;
+    if (pricesCache.size() >= (1 << 20))
+        pricesCache.clear();
+    pricesCache[std::make_pair(height, ind)] = price;
+    return true;
+}
+
+// validates the opcodes once, an expression with errors is left uncompiled so the gmp interpreter returns the same error codes
+void prices_syntheticcompile(const std::vector<uint16_t> &vec, PricesSynthetic &synthetic)
+{
+    int32_t depth = 0, need; bool fWeight = false;
+    synthetic.vec = vec;
+    synthetic.ops.clear();
+    synthetic.fCompiled = false;
+    for (int32_t i = 0; i < vec.size(); i++)
+    {
+        uint16_t opcode = vec[i] & KOMODO_PRICEMASK, value = vec[i] & (KOMODO_MAXPRICES - 1);
+        switch (opcode)
+        {
+        case 0:
+            if (depth >= 4)
+                return;
+            depth++;
+            break;
+        case PRICES_WEIGHT:
+            if (depth != 1)
+                return;
+            depth--;
+            fWeight |= (value != 0);
+            break;
+        case PRICES_MULT:
+        case PRICES_DIV:
+        case PRICES_INV:
+        case PRICES_MDD:
+        case PRICES_MMD:
+        case PRICES_MMM:
+        case PRICES_DDD:
+            need = (opcode == PRICES_INV) ? 1 : (opcode == PRICES_MULT || opcode == PRICES_DIV) ? 2 : 3;
+            if (depth < need)
+                return;
+            depth -= need - 1;
+            break;
+        default:
+            return;
+        }
+        synthetic.ops.push_back(std::make_pair(opcode, value));
+    }
+    synthetic.fCompiled = (depth == 0 && fWeight);
+}
+
+// evaluates a compiled expression in 128 bit fixed point with the rounding of the gmp interpreter.
+// returns false on a missing price, a zero divisor or a result out of the int64 range, the caller then runs the gmp interpreter.
+static bool prices_syntheticeval(const PricesSynthetic &synthetic, int32_t height, int64_t &priceIndex)
+{
+    const prices_int128_t den8 = SATOSHIDEN;
+    int64_t pricestack[4]; int32_t depth = 0;
+    prices_int128_t a, b, c, r, total = 0, den = 0;
+
+    for (const auto &op : synthetic.ops)
+    {
+        switch (op.first)
+        {
+        case 0:
+            if (!prices_getcachedprice(op.second, height, pricestack[depth]))
+                return false;
+            depth++;
+            continue;
+        case PRICES_WEIGHT:
+            total += (prices_int128_t)pricestack[--depth] * op.second;
+            den += op.second;
+            continue;
+        case PRICES_MULT:
+            b = pricestack[--depth], a = pricestack[--depth];
+            r = (a * b) / den8;
+            break;
+        case PRICES_DIV:
+            b = pricestack[--depth], a = pricestack[--depth];
+            if (b == 0)
+                return false;
+            r = (a * den8) / b;
+            break;
+        case PRICES_INV:
+            a = pricestack[--depth];
+            if (a == 0)
+                return false;
+            r = (den8 * den8) / a;
+            break;
+        case PRICES_MDD:
+            c = pricestack[--depth], b = pricestack[--depth], a = pricestack[--depth];
+            if (b == 0 || c == 0)
+                return false;
+            r = (((a * den8) / b) * den8) / c;
+            break;
+        case PRICES_MMD:
+            c = pricestack[--depth], b = pricestack[--depth], a = pricestack[--depth];
+            if (c == 0)
+                return false;
+            r = (a * b) / c;
+            break;
+        case PRICES_MMM:
+            c = pricestack[--depth], b = pricestack[--depth], a = pricestack[--depth];
+            if (__builtin_mul_overflow((a * b) / den8, c, &r))
+                return false;
+            r /= den8;
+            break;
+        case PRICES_DDD:
+            c = pricestack[--depth], b = pricestack[--depth], a = pricestack[--depth];
+            if (a == 0 || b == 0 || c == 0)
+                return false;
+            r = (((((den8 * den8) / a) * den8) / b) * den8) / c;
+            break;
+        default:
+            return false;
+        }
+        if (r > std::numeric_limits<int64_t>::max() || r < std::numeric_limits<int64_t>::min())
+            return false;
+        pricestack[depth++] = (int64_t)r;
+    }
+    r = total / den;
+    if (r > std::numeric_limits<int64_t>::max() || r < std::numeric_limits<int64_t>::min())
+        return false;
+    priceIndex = (int64_t)r;
+    return true;
+}
+
+// calculates price for a compiled synthetic expression, same results as the gmp interpreter
+int64_t prices_syntheticprice(const PricesSynthetic &synthetic, int32_t height, int32_t minmax, int16_t leverage)
+{
+    int64_t priceIndex;
+    if (synthetic.fCompiled && prices_syntheticeval(synthetic, height, priceIndex))
+        return priceIndex;
+    return prices_syntheticprice(synthetic.vec, height, minmax, leverage);
+}
+
 // calculates costbasis and profit/loss for the bet
-int32_t prices_syntheticprofits(int64_t &costbasis, int32_t firstheight, int32_t height, int16_t leverage, std::vector<uint16_t> vec, int64_t positionsize,  int64_t &profits, int64_t &outprice)
+int32_t prices_syntheticprofits(int64_t &costbasis, int32_t firstheight, int32_t height, int16_t leverage, const PricesSynthetic &synthetic, int64_t positionsize,  int64_t &profits, int64_t &outprice)
 {
     int64_t price;
-#ifndef TESTMODE
-    const int32_t COSTBASIS_PERIOD = PRICES_DAYWINDOW;
-#else
-    const int32_t COSTBASIS_PERIOD = 7;
-#endif
-
 
     if (height < firstheight) {
         fprintf(stderr, "requested height is lower than bet firstheight.%d\n", height);
         return -1;
     }
 
-    int32_t minmax = (height < firstheight + COSTBASIS_PERIOD);  // if we are within 24h then use min or max value 
+    int32_t minmax = (height < firstheight + PRICES_COSTBASIS_PERIOD);  // if we are within 24h then use min or max value 
 
-    if ((price = prices_syntheticprice(vec, height, minmax, leverage)) < 0)
+    if ((price = prices_syntheticprice(synthetic, height, minmax, leverage)) < 0)
     {
         fprintf(stderr, "error getting synthetic price at height.%d\n", height);
         return -1;
@@ -1260,7 +1444,13 @@ int32_t prices_syntheticprofits(int64_t &costbasis, int32_t firstheight, int32_t
     //price /= PRICES_POINTFACTOR;
     //price *= PRICES_POINTFACTOR;
     outprice = price;
-   
+    prices_profitsatprice(costbasis, minmax, leverage, price, positionsize, profits);
+    return 0; //  (positionsize + addedbets + profits);
+}
+
+// updates costbasis within the day window and calculates profit/loss of the bet at synthetic price 
+static void prices_profitsatprice(int64_t &costbasis, int32_t minmax, int16_t leverage, int64_t price, int64_t positionsize, int64_t &profits)
+{
     if (minmax)    { // if we are within day window, set temp costbasis to max (or min) price value
         if (leverage > 0 && price > costbasis) {
             costbasis = price;  // set temp costbasis
@@ -1275,7 +1465,7 @@ int32_t prices_syntheticprofits(int64_t &costbasis, int32_t firstheight, int32_t
         //}
     }
     else   { 
-        //if (height == firstheight + COSTBASIS_PERIOD) {
+        //if (height == firstheight + PRICES_COSTBASIS_PERIOD) {
             // if costbasis not set, just set it
             //costbasis = price;
 
@@ -1339,7 +1529,6 @@ int32_t prices_syntheticprofits(int64_t &costbasis, int32_t firstheight, int32_t
         profits = 0;
 
     //std::cerr << "prices_syntheticprofits() profits=" << profits << std::endl;
-    return 0; //  (positionsize + addedbets + profits);
 }
 
 // makes result json object
@@ -1600,7 +1789,7 @@ UniValue PricesAddFunding(int64_t txfee, uint256 bettxid, int64_t amount)
 }
 
 // scan chain from the initial bet's first position upto the chain tip and calculate bet's costbasises and profits, breaks if rekt detected 
-int32_t prices_scanchain(std::vector<OneBetData> &bets, int16_t leverage, std::vector<uint16_t> vec, int64_t &lastprice, int32_t &endheight) {
+int32_t prices_scanchain(std::vector<OneBetData> &bets, int16_t leverage, const PricesSynthetic &synthetic, int64_t &lastprice, int32_t &endheight) {
 
     if (bets.size() == 0)
         return -1;
@@ -1616,7 +1805,7 @@ int32_t prices_scanchain(std::vector<OneBetData> &bets, int16_t leverage, std::v
 
             if (height > bets[i].firstheight) {
 
-                int32_t retcode = prices_syntheticprofits(bets[i].costbasis, bets[i].firstheight, height, leverage, vec, bets[i].positionsize, bets[i].profits, lastprice);
+                int32_t retcode = prices_syntheticprofits(bets[i].costbasis, bets[i].firstheight, height, leverage, synthetic, bets[i].positionsize, bets[i].profits, lastprice);
                 if (retcode < 0) {
                     std::cerr << "prices_scanchain() prices_syntheticprofits returned -1, finishing..." << std::endl;
                     stop = true;
@@ -1765,6 +1954,7 @@ int32_t prices_getbetinfo(uint256 bettxid, BetInfo &betinfo)
             int32_t finaltxheight; //, endheight;
                                    //std::vector<OneBetData> bets;
             betinfo.txid = bettxid;
+            prices_syntheticcompile(betinfo.vecparsed, betinfo.synthetic);
 
             if (CCgetspenttxid(finaltxid, vini, finaltxheight, bettxid, NVOUT_CCMARKER) == 0)
                 betinfo.isOpen = false;
@@ -1796,7 +1986,7 @@ int32_t prices_getbetinfo(uint256 bettxid, BetInfo &betinfo)
             }
 
 
-            if (prices_scanchain(betinfo.bets, betinfo.leverage, betinfo.vecparsed, betinfo.lastprice, betinfo.lastheight) < 0) {
+            if (prices_scanchain(betinfo.bets, betinfo.leverage, betinfo.synthetic, betinfo.lastprice, betinfo.lastheight) < 0) {
                 return -4;
             }
 
@@ -2518,3 +2708,254 @@ UniValue PricesGetOrderbook()
 //    result.push_back(Pair("TotalLiabilities", ValueFromAmount(totalLiabilities)));
     return result;
 }
+
+// open bets kept in memory between pricesrektcandidates calls, updated from the blocks connected since the last call.
+// positions with the same synthetic expression and leverage are scanned together, reading each price once per height
+typedef struct PricesOpenPosition {
+    uint256 bettxid, batontxid;
+    CPubKey pk;
+    std::vector<onebetdata> bets;
+    int32_t scannedheight;      // last height the equity was calculated for
+    int64_t lastprice, totalposition, equity;
+    int32_t rektheight;         // first height the equity fell to the min margin, 0 if not rekt
+
+    PricesOpenPosition() { scannedheight = rektheight = 0; lastprice = totalposition = equity = 0; }
+} PricesOpenPosition;
+
+typedef struct PricesOpenGroup {
+    PricesSynthetic synthetic;
+    int16_t leverage;
+    std::vector<PricesOpenPosition> positions;
+
+    PricesOpenGroup() { leverage = 0; }
+} PricesOpenGroup;
+
+// guarded by cs_main
+static std::map<std::pair<std::vector<uint16_t>, int16_t>, PricesOpenGroup> pricesOpenBook;
+static int32_t pricesOpenBookHeight;
+static uint256 pricesOpenBookHash;
+
+// clears the scan state of a position so it is scanned again from the bet height
+static void prices_resetposition(PricesOpenPosition &pos)
+{
+    for (auto &b : pos.bets)
+        b.costbasis = b.profits = 0;
+    pos.scannedheight = pos.bets[0].firstheight;
+    pos.lastprice = pos.totalposition = pos.equity = 0;
+    pos.rektheight = 0;
+}
+
+// adds a bet found on the prices normal marker address to the open book if it is not closed yet
+static void prices_addopenposition(uint256 bettxid)
+{
+    CTransaction bettx;
+    uint256 hashBlock, finaltxid, tokenid;
+    int32_t vini, finalheight;
+    PricesOpenPosition pos;
+    onebetdata bet1;
+    int16_t leverage;
+    int64_t firstprice;
+    std::vector<uint16_t> vec;
+
+    if (CCgetspenttxid(finaltxid, vini, finalheight, bettxid, NVOUT_CCMARKER) == 0)
+        return;
+    if (!myGetTransaction(bettxid, bettx, hashBlock) || hashBlock.IsNull() || bettx.vout.size() <= 3)
+        return;
+    if (prices_betopretdecode(bettx.vout.back().scriptPubKey, pos.pk, bet1.firstheight, bet1.positionsize, leverage, firstprice, vec, tokenid) != 'B')
+        return;
+
+    pos.bettxid = bettxid;
+    pos.bets.push_back(bet1);
+    if (prices_enumaddedbets(pos.batontxid, pos.bets, bettxid) < 0)
+        return;
+    prices_resetposition(pos);
+
+    PricesOpenGroup &group = pricesOpenBook[std::make_pair(vec, leverage)];
+    if (group.positions.empty()) {
+        prices_syntheticcompile(vec, group.synthetic);
+        group.leverage = leverage;
+    }
+    group.positions.push_back(pos);
+}
+
+// brings the open book to the chain tip: adds new bets, drops closed ones and picks up added funding
+static void prices_refreshopenbook()
+{
+    struct CCcontract_info *cp, C;
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    int32_t tip = chainActive.Height();
+
+    if (pricesOpenBookHeight > tip || (pricesOpenBookHeight > 0 && chainActive[pricesOpenBookHeight]->GetBlockHash() != pricesOpenBookHash)) {
+        // reorg, the costbasis and rekt heights may have changed
+        pricesOpenBook.clear();
+        pricesOpenBookHeight = 0;
+    }
+    if (pricesOpenBookHeight == tip && pricesOpenBookHeight > 0)
+        return;
+
+    // existing positions: closed bets and added funding since the last refresh
+    for (auto git = pricesOpenBook.begin(); git != pricesOpenBook.end(); ) {
+        std::vector<PricesOpenPosition> &positions = git->second.positions;
+        for (size_t i = 0; i < positions.size(); ) {
+            PricesOpenPosition &pos = positions[i];
+            uint256 spenttxid;
+            int32_t vini, height;
+
+            if (CCgetspenttxid(spenttxid, vini, height, pos.bettxid, NVOUT_CCMARKER) == 0) {
+                positions[i] = positions.back();
+                positions.pop_back();
+                continue;
+            }
+            if (CCgetspenttxid(spenttxid, vini, height, pos.batontxid, 0) == 0) {
+                std::vector<onebetdata> bets(1, pos.bets[0]);
+                if (prices_enumaddedbets(pos.batontxid, bets, pos.bettxid) >= 0) {
+                    bool fRescan = false;
+                    for (size_t j = pos.bets.size(); j < bets.size(); j++) {
+                        if (bets[j].firstheight <= pos.scannedheight)
+                            fRescan = true;
+                        pos.bets.push_back(bets[j]);
+                    }
+                    if (fRescan)
+                        prices_resetposition(pos);
+                }
+            }
+            i++;
+        }
+        if (positions.empty())
+            pricesOpenBook.erase(git++);
+        else
+            ++git;
+    }
+
+    cp = CCinit(&C, EVAL_PRICES);
+    if (pricesOpenBookHeight == 0)
+        SetAddressIndexOutputs(addressIndex, cp->normaladdr, false);
+    else
+        SetAddressIndexOutputs(addressIndex, cp->normaladdr, false, pricesOpenBookHeight + 1, tip);
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it = addressIndex.begin(); it != addressIndex.end(); it++)
+    {
+        if (it->first.index == NVOUT_NORMALMARKER && !it->first.spending)
+            prices_addopenposition(it->first.txhash);
+    }
+
+    pricesOpenBookHeight = tip;
+    pricesOpenBookHash = chainActive[tip]->GetBlockHash();
+}
+
+// scans the positions of a group up to endheight, same rules as prices_scanchain().
+// runs without cs_main, the caller holds it so the prices are not updated meanwhile
+static void prices_scangroup(PricesOpenGroup &group, int32_t endheight)
+{
+    int32_t startheight = endheight + 1;
+    for (const auto &pos : group.positions)
+        if (pos.rektheight == 0 && pos.scannedheight + 1 < startheight)
+            startheight = pos.scannedheight + 1;
+
+    for (int32_t height = startheight; height <= endheight; height++)
+    {
+        int64_t price = prices_syntheticprice(group.synthetic, height, 0, group.leverage);   // the same for all positions
+        if (price < 0)
+            break;
+
+        for (auto &pos : group.positions) {
+            if (pos.rektheight != 0 || pos.scannedheight >= height)
+                continue;
+
+            int64_t totalposition = 0;
+            int64_t totalprofits = 0;
+            for (auto &b : pos.bets) {
+                if (height > b.firstheight) {
+                    prices_profitsatprice(b.costbasis, (height < b.firstheight + PRICES_COSTBASIS_PERIOD), group.leverage, price, b.positionsize, b.profits);
+                    totalposition += b.positionsize;
+                    totalprofits += b.profits;
+                }
+            }
+            pos.scannedheight = height;
+            pos.lastprice = price;
+            pos.totalposition = totalposition;
+            pos.equity = totalposition + totalprofits;
+            if (pos.equity <= (int64_t)((double)totalposition * prices_minmarginpercent(group.leverage)))
+                pos.rektheight = height;
+        }
+    }
+}
+
+static void prices_scangroups(std::vector<PricesOpenGroup*> groups, int32_t endheight)
+{
+    for (auto group : groups)
+        prices_scangroup(*group, endheight);
+}
+
+static double prices_positionmargin(const PricesOpenPosition &pos)
+{
+    return pos.totalposition > 0 ? (double)pos.equity / (double)pos.totalposition : 0.0;
+}
+
+// pricesrektcandidates rpc impl: open bets which reached the min margin at or before height, lowest margin first
+UniValue PricesRektCandidates(int32_t height)
+{
+    UniValue result(UniValue::VOBJ), candidates(UniValue::VARR);
+    std::vector<const PricesOpenPosition*> rekt;
+    std::vector<std::vector<PricesOpenGroup*> > work;
+    std::map<const PricesOpenPosition*, const PricesOpenGroup*> groupof;
+    int32_t nThreads, npositions = 0;
+
+    AssertLockHeld(cs_main);
+    prices_refreshopenbook();
+    if (height <= 0 || height > pricesOpenBookHeight)
+        height = pricesOpenBookHeight;
+
+    nThreads = std::max(1, std::min(GetNumCores(), 16));
+    nThreads = std::min(nThreads, std::max(1, (int32_t)pricesOpenBook.size()));
+    work.resize(nThreads);
+    int32_t n = 0;
+    for (auto &g : pricesOpenBook)
+        work[n++ % nThreads].push_back(&g.second);
+
+    if (nThreads == 1) {
+        prices_scangroups(work[0], pricesOpenBookHeight);
+    }
+    else {
+        boost::thread_group threads;
+        for (int32_t i = 0; i < nThreads; i++)
+            threads.create_thread(boost::bind(&prices_scangroups, work[i], pricesOpenBookHeight));
+        threads.join_all();
+    }
+
+    for (const auto &g : pricesOpenBook) {
+        for (const auto &pos : g.second.positions) {
+            npositions++;
+            if (pos.rektheight != 0 && pos.rektheight <= height) {
+                rekt.push_back(&pos);
+                groupof[&pos] = &g.second;
+            }
+        }
+    }
+    std::sort(rekt.begin(), rekt.end(), [](const PricesOpenPosition *a, const PricesOpenPosition *b) {
+        return prices_positionmargin(*a) < prices_positionmargin(*b);
+    });
+
+    for (auto pos : rekt) {
+        const PricesOpenGroup *group = groupof[pos];
+        UniValue entry(UniValue::VOBJ);
+        entry.push_back(Pair("bettxid", pos->bettxid.GetHex()));
+        entry.push_back(Pair("pubkey", HexStr(pos->pk)));
+        entry.push_back(Pair("expression", prices_getsourceexpression(group->synthetic.vec)));
+        entry.push_back(Pair("leverage", group->leverage));
+        entry.push_back(Pair("positionsize", pos->totalposition));
+        entry.push_back(Pair("equity", pos->equity));
+        entry.push_back(Pair("margin", prices_positionmargin(*pos)));
+        entry.push_back(Pair("minmargin", prices_minmarginpercent(group->leverage)));
+        entry.push_back(Pair("lastprice", pos->lastprice));
+        entry.push_back(Pair("rektheight", pos->rektheight));
+        candidates.push_back(entry);
+    }
+
+    result.push_back(Pair("result", "success"));
+    result.push_back(Pair("height", height));
+    result.push_back(Pair("scannedheight", pricesOpenBookHeight));
+    result.push_back(Pair("groups", (int64_t)pricesOpenBook.size()));
+    result.push_back(Pair("positions", npositions));
+    result.push_back(Pair("candidates", candidates));
+    return result;
+}
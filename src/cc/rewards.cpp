@@ -14,6 +14,10 @@
  ******************************************************************************/
 
 #include "CCrewards.h"
+#include "main.h"
+#include "txdb.h"
+
+extern bool fAddressIndex;
 
 /*
  The rewards CC contract is initially for OOT, which needs this functionality. However, many of the attributes can be parameterized to allow different rewards programs to run. Multiple rewards plans could even run on the same blockchain, though the user would need to choose which one to lock funds into.
@@ -349,6 +353,35 @@ static uint64_t myIs_unlockedtx_inmempool(uint256 &txid,int32_t &vout,uint64_t r
     memset(&txid,0,sizeof(txid));
     vout = -1;
     nValue = 0;
+    if ( fAddressIndex != 0 )
+    {
+        // only the txs paying to the rewards global CC address
+        struct CCcontract_info *cp,C; uint160 hashBytes; int type;
+        std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > deltas;
+        std::vector<std::pair<uint160, int> > addresses;
+        cp = CCinit(&C,EVAL_REWARDS);
+        if ( CBitcoinAddress(cp->unspendableCCaddr).GetIndexKey(hashBytes,type,true) == 0 )
+            return(0);
+        addresses.push_back(std::make_pair(hashBytes,type));
+        LOCK(mempool.cs);
+        mempool.getAddressIndex(addresses,deltas);
+        for (std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> >::const_iterator it=deltas.begin(); it!=deltas.end(); it++)
+        {
+            CTransaction tx;
+            if ( it->first.spending != 0 || it->first.index != 0 || it->second.amount < (int64_t)needed || mempool.lookup(it->first.txhash,tx) == 0 )
+                continue;
+            const uint256 &hash = tx.GetHash();
+            if ( myIsutxo_spentinmempool(ignoretxid,ignorevin,hash,0) == 0 && (funcid= DecodeRewardsOpRet(hash,tx.vout[tx.vout.size()-1].scriptPubKey,sbits,fundingtxid)) == 'U' && sbits == refsbits && fundingtxid == reffundingtxid )
+            {
+                txid = hash;
+                vout = 0;
+                nValue = tx.vout[0].nValue;
+                fprintf(stderr,"found 'U' %s %.8f in unspent in mempool\n",uint256_str(str,txid),(double)nValue/COIN);
+                return(nValue);
+            }
+        }
+        return(nValue);
+    }
     BOOST_FOREACH(const CTxMemPoolEntry &e,mempool.mapTx)
     {
         const CTransaction &tx = e.GetTx();
@@ -371,19 +404,162 @@ static uint64_t myIs_unlockedtx_inmempool(uint256 &txid,int32_t &vout,uint64_t r
     return(nValue);
 }
 
+// returns the rewards output of vout v, if it is an unspent output on the rewards global CC address indexed by the rewards index
+static bool RewardsIndexOutput(struct CCcontract_info *cp,const CTransaction &tx,int32_t v,int32_t height,uint32_t blocktime,CCCRewardsOutputKey &key,CCCRewardsOutputValue &value)
+{
+    char destaddr[64]; uint64_t sbits; uint256 fundingtxid; uint8_t funcid; int32_t numvouts = (int32_t)tx.vout.size();
+    if ( v < 0 || v >= numvouts-1 || tx.vout[v].scriptPubKey.IsPayToCryptoCondition() == 0 )
+        return(false);
+    if ( Getscriptaddress(destaddr,tx.vout[v].scriptPubKey) == 0 || strcmp(destaddr,cp->unspendableCCaddr) != 0 )
+        return(false);
+    if ( (funcid= DecodeRewardsOpRet(tx.GetHash(),tx.vout[numvouts-1].scriptPubKey,sbits,fundingtxid)) == 0 )
+        return(false);
+    key = CCCRewardsOutputKey(fundingtxid,sbits,tx.GetHash(),v);
+    value = CCCRewardsOutputValue(tx.vout[v].nValue,funcid,height,blocktime,numvouts > 1 ? tx.vout[1].scriptPubKey : CScript());
+    return(true);
+}
+
+// the prevout tx of a rewards CC vin, from the block being connected or from the tx index
+static bool RewardsIndexPrevTx(const std::map<uint256,const CTransaction*> &blocktxs,const COutPoint &prevout,int32_t height,uint32_t blocktime,CTransaction &prevtx,int32_t &prevheight,uint32_t &prevtime)
+{
+    uint256 hashBlock; CBlockIndex *pindex;
+    std::map<uint256,const CTransaction*>::const_iterator it = blocktxs.find(prevout.hash);
+    if ( it != blocktxs.end() )
+    {
+        prevtx = *it->second;
+        prevheight = height;
+        prevtime = blocktime;
+        return(true);
+    }
+    if ( myGetTransaction(prevout.hash,prevtx,hashBlock) == 0 || (pindex= komodo_getblockindex(hashBlock)) == 0 )
+        return(false);
+    prevheight = pindex->GetHeight();
+    prevtime = pindex->nTime;
+    return(true);
+}
+
+void RewardsIndexConnectBlock(const CBlock &block,int32_t height,uint32_t blocktime,std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> > &outputs)
+{
+    struct CCcontract_info *cp,C; CCCRewardsOutputKey key; CCCRewardsOutputValue value; CTransaction prevtx; int32_t prevheight; uint32_t prevtime;
+    std::map<uint256,const CTransaction*> blocktxs;
+    cp = CCinit(&C,EVAL_REWARDS);
+    for (int32_t i=0; i<block.vtx.size(); i++)
+    {
+        const CTransaction &tx = block.vtx[i];
+        blocktxs[tx.GetHash()] = &tx;
+        if ( tx.IsCoinBase() == 0 )
+        {
+            for (int32_t j=0; j<tx.vin.size(); j++)
+            {
+                if ( cp->ismyvin(tx.vin[j].scriptSig) != 0 && RewardsIndexPrevTx(blocktxs,tx.vin[j].prevout,height,blocktime,prevtx,prevheight,prevtime) &&
+                     RewardsIndexOutput(cp,prevtx,tx.vin[j].prevout.n,prevheight,prevtime,key,value) )
+                    outputs.push_back(std::make_pair(key,CCCRewardsOutputValue()));
+            }
+        }
+        for (int32_t v=0; v<(int32_t)tx.vout.size()-1; v++)
+        {
+            if ( RewardsIndexOutput(cp,tx,v,height,blocktime,key,value) )
+                outputs.push_back(std::make_pair(key,value));
+        }
+    }
+}
+
+void RewardsIndexDisconnectBlock(const CBlock &block,int32_t height,uint32_t blocktime,std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> > &outputs)
+{
+    struct CCcontract_info *cp,C; CCCRewardsOutputKey key; CCCRewardsOutputValue value; CTransaction prevtx; int32_t prevheight; uint32_t prevtime;
+    std::map<uint256,const CTransaction*> blocktxs;
+    cp = CCinit(&C,EVAL_REWARDS);
+    for (int32_t i=0; i<block.vtx.size(); i++)
+        blocktxs[block.vtx[i].GetHash()] = &block.vtx[i];
+    for (int32_t i=block.vtx.size()-1; i>=0; i--)
+    {
+        const CTransaction &tx = block.vtx[i];
+        for (int32_t v=0; v<(int32_t)tx.vout.size()-1; v++)
+        {
+            if ( RewardsIndexOutput(cp,tx,v,height,blocktime,key,value) )
+                outputs.push_back(std::make_pair(key,CCCRewardsOutputValue()));
+        }
+        if ( tx.IsCoinBase() == 0 )
+        {
+            // restore the spent rewards outputs
+            for (int32_t j=0; j<tx.vin.size(); j++)
+            {
+                if ( cp->ismyvin(tx.vin[j].scriptSig) != 0 && RewardsIndexPrevTx(blocktxs,tx.vin[j].prevout,height,blocktime,prevtx,prevheight,prevtime) &&
+                     RewardsIndexOutput(cp,prevtx,tx.vin[j].prevout.n,prevheight,prevtime,key,value) )
+                    outputs.push_back(std::make_pair(key,value));
+            }
+        }
+    }
+}
+
+// same as CCduration() for an indexed output
+static int64_t RewardsIndexDuration(const CCCRewardsOutputValue &value)
+{
+    CBlockIndex *pindex;
+    if ( value.blockTime == 0 || value.blockHeight <= 0 || (pindex= chainActive.LastTip()) == 0 )
+        return(0);
+    if ( pindex->nTime < value.blockTime || pindex->GetHeight() <= value.blockHeight )
+        return(0);
+    return(pindex->nTime - value.blockTime);
+}
+
+// AddRewardsInputs on the rewards index, picks the same outputs without loading the txs
+static int64_t AddRewardsIndexInputs(CScript &scriptPubKey,uint64_t maxseconds,CMutableTransaction &mtx,int64_t total,int32_t maxinputs,uint64_t threshold,uint64_t refsbits,uint256 reffundingtxid,int32_t &n)
+{
+    uint64_t totalinputs = 0; uint256 txid; int32_t j,vout; uint8_t funcid;
+    std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> > outputs;
+    if ( pblocktree->ReadRewardsOutputs(reffundingtxid,outputs) == 0 )
+        return(0);
+    for (std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> >::const_iterator it=outputs.begin(); it!=outputs.end(); it++)
+    {
+        txid = it->first.txhash;
+        vout = (int32_t)it->first.index;
+        funcid = it->second.funcid;
+        if ( it->first.sbits != refsbits || it->second.satoshis < threshold )
+            continue;
+        for (j=0; j<mtx.vin.size(); j++)
+            if ( txid == mtx.vin[j].prevout.hash && vout == mtx.vin[j].prevout.n )
+                break;
+        if ( j != mtx.vin.size() || myIsutxo_spentinmempool(ignoretxid,ignorevin,txid,vout) != 0 )
+            continue;
+        if ( maxseconds == 0 && funcid != 'F' && funcid != 'A' && funcid != 'U' )
+            continue;
+        else if ( maxseconds != 0 && funcid != 'L' )
+        {
+            if ( RewardsIndexDuration(it->second) < maxseconds )
+                continue;
+        }
+        fprintf(stderr,"maxseconds.%d (%c) %.8f\n",(int32_t)maxseconds,funcid,(double)it->second.satoshis/COIN);
+        if ( total != 0 && maxinputs != 0 )
+        {
+            if ( maxseconds != 0 )
+                scriptPubKey = it->second.unlockScript;
+            mtx.vin.push_back(CTxIn(txid,vout,CScript()));
+        }
+        totalinputs += it->second.satoshis;
+        n++;
+        if ( (total > 0 && totalinputs >= total) || (maxinputs > 0 && n >= maxinputs) )
+            break;
+    }
+    return(totalinputs);
+}
+
 // 'L' vs 'F' and 'A'
 int64_t AddRewardsInputs(CScript &scriptPubKey,uint64_t maxseconds,struct CCcontract_info *cp,CMutableTransaction &mtx,CPubKey pk,int64_t total,int32_t maxinputs,uint64_t refsbits,uint256 reffundingtxid)
 {
     char coinaddr[64],str[65]; uint64_t threshold,sbits,nValue,totalinputs = 0; uint256 txid,hashBlock,fundingtxid; CTransaction tx; int32_t numblocks,j,vout,n = 0; uint8_t funcid;
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
     GetCCaddress(cp,coinaddr,pk);
-    SetCCunspents(unspentOutputs,coinaddr,true);
+    if ( fRewardsIndex == 0 || pk != GetUnspendable(cp,0) )
+        SetCCunspents(unspentOutputs,coinaddr,true);
     if ( maxinputs > CC_MAXVINS )
         maxinputs = CC_MAXVINS;
     if ( maxinputs > 0 )
         threshold = total/maxinputs;
     else threshold = total;
-    for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=unspentOutputs.begin(); it!=unspentOutputs.end(); it++)
+    if ( fRewardsIndex != 0 && pk == GetUnspendable(cp,0) )
+        totalinputs = AddRewardsIndexInputs(scriptPubKey,maxseconds,mtx,total,maxinputs,threshold,refsbits,reffundingtxid,n);
+    else for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=unspentOutputs.begin(); it!=unspentOutputs.end(); it++)
     {
         txid = it->first.txhash;
         vout = (int32_t)it->first.index;
@@ -441,6 +617,20 @@ int64_t RewardsPlanFunds(uint64_t &lockedfunds,uint64_t refsbits,struct CCcontra
     char coinaddr[64]; uint64_t sbits; int64_t nValue,totalinputs = 0; uint256 txid,hashBlock,fundingtxid; CTransaction tx; int32_t vout; uint8_t funcid;
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
     lockedfunds = 0;
+    if ( fRewardsIndex != 0 && pk == GetUnspendable(cp,0) )
+    {
+        std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> > outputs;
+        if ( pblocktree->ReadRewardsOutputs(reffundingtxid,outputs) != 0 )
+        {
+            for (std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> >::const_iterator it=outputs.begin(); it!=outputs.end(); it++)
+            {
+                if ( it->second.funcid == 'L' )
+                    lockedfunds += it->second.satoshis;
+                else totalinputs += it->second.satoshis;
+            }
+        }
+        return(totalinputs);
+    }
     GetCCaddress(cp,coinaddr,pk);
     SetCCunspents(unspentOutputs,coinaddr,true);
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=unspentOutputs.begin(); it!=unspentOutputs.end(); it++)
@@ -16,6 +16,7 @@
 #include "CCtokentags.h"
 #include "CCtokens.h"
 #include "CCtokens_impl.h"
+#include "CCbatonindex.h"
 
 /*
 This is an implementation of a simple linked list data storage method, similar to Oracles in functionality.
@@ -718,6 +719,60 @@ static CTxOut MakeTokensCCvoutforTag(uint256 tokenid, uint8_t evalcode, CAmount
 	return CTxOut();
 }
 
+// --- Baton chain index rules, see cc/CCbatonindex.cpp ---
+
+// Checks if vout0 of tx is an update baton, sent to the address made from the Token Tags global pubkey and the tokenid-pubkey.
+static bool IsTokenTagBaton(const CTransaction &tx, uint256 tokenid)
+{
+	struct CCcontract_info *cp, C;
+	char tagCCaddress[KOMODO_ADDRESS_BUFSIZE];
+	CPubKey TokenTagspk, tagtxidpk;
+
+	cp = CCinit(&C, EVAL_TOKENTAGS);
+	TokenTagspk = GetUnspendable(cp, NULL);
+	tagtxidpk = CCtxidaddr(NULL, tokenid);
+	GetCCaddress1of2(cp, tagCCaddress, TokenTagspk, tagtxidpk, true);
+	return (tx.vout.size() > 0 && IsTokenTagsvout(cp, tx, 0, tagCCaddress) != 0);
+}
+
+// The update log of a token tag starts at its creation transaction.
+bool TokenTagsBatonRoot(const CTransaction &tx, int32_t &batonvout, uint8_t &funcid, uint256 &rootdata)
+{
+	uint8_t version, flags;
+	CPubKey creatorpub;
+	uint256 tokenid;
+	int64_t tokensupply, updatesupply;
+	std::string name, data;
+
+	if ((funcid = DecodeTokenTagCreateOpRet(tx.vout.back().scriptPubKey, version, creatorpub, tokenid, tokensupply, updatesupply, flags, name, data)) != 'c')
+		return false;
+	batonvout = IsTokenTagBaton(tx, tokenid) ? 0 : -1;
+	rootdata = tokenid;
+	return true;
+}
+
+// Every update spends the vout0 baton and passes it on in its own vout0.
+bool TokenTagsBatonNext(const CTransaction &tx, int32_t vini, const CCCBatonTipValue &tip, int32_t &batonvout, uint8_t &funcid)
+{
+	if (tx.vin[vini].prevout.n != 0 || (funcid = DecodeTokenTagOpRet(tx.vout.back().scriptPubKey)) == 0)
+		return false;
+	batonvout = IsTokenTagBaton(tx, tip.rootdata) ? 0 : -1;
+	return true;
+}
+
+// Token tags are posted under their tokenid ('t'), so the tags of a token are listed without scanning its tag address.
+void TokenTagsBatonPostings(const CTransaction &tx, std::vector<std::pair<std::vector<uint8_t>, uint8_t> > &postings)
+{
+	uint8_t version, flags;
+	CPubKey creatorpub;
+	uint256 tokenid;
+	int64_t tokensupply, updatesupply;
+	std::string name, data;
+
+	if (DecodeTokenTagCreateOpRet(tx.vout.back().scriptPubKey, version, creatorpub, tokenid, tokensupply, updatesupply, flags, name, data) == 'c')
+		postings.push_back(std::make_pair(std::vector<uint8_t>(tokenid.begin(), tokenid.end()), (uint8_t)'t'));
+}
+
 // Finds the function id of the transaction that spent the latest baton for the specified token tag.
 // Returns 'c' if event log baton is unspent, or 0 if token tag with the specified txid couldn't be found.
 // Also returns the txid of the latest update the function found in the latesttxid variable.
@@ -735,6 +790,14 @@ static uint8_t FindLatestTagUpdate(uint256 tokentagid, struct CCcontract_info *c
 
 	latesttxid = zeroid;
 
+	// Use the baton chain index if it's enabled, overlaid with the mempool as in the walk below.
+	CCCBatonTipValue tip;
+	if (GetCCBatonTip(EVAL_TOKENTAGS, tokentagid, tip, true))
+	{
+		latesttxid = tip.txid;
+		return tip.funcid;
+	}
+
 	// Get token tag creation transaction and its op_return, containing the tokenid.
 	if (myGetTransactionCCV2(cp, tokentagid, sourcetx, hashBlock) && sourcetx.vout.size() > 0 &&
 	DecodeTokenTagCreateOpRet(sourcetx.vout.back().scriptPubKey,version,creatorpub,tokenid,tokensupply,updatesupply,flags,name,data) != 0)
@@ -1301,6 +1364,31 @@ UniValue TokenTagHistory(const uint256 tokentagid,int64_t samplenum,bool bRevers
 	struct CCcontract_info *cp,C;
 	cp = CCinit(&C,EVAL_TOKENTAGS);
 
+	// With the baton chain index the requested samples are read by sequence number, followed by the updates still in the mempool.
+	CCCBatonTipValue tip;
+	std::vector<std::pair<CCCBatonEventKey, CCCBatonEventValue> > events, mempoolevents;
+	if (GetCCBatonTip(EVAL_TOKENTAGS, tokentagid, tip, false) && GetCCBatonMempoolEvents(EVAL_TOKENTAGS, tokentagid, tip, mempoolevents))
+	{
+		uint32_t nevents = tip.nEvents + mempoolevents.size(), firstseq = 0;
+
+		if (samplenum > 0 && samplenum < nevents)
+		{
+			if (bReverse)
+				firstseq = nevents - samplenum;
+			nevents = samplenum;
+		}
+		if (firstseq < tip.nEvents && !GetCCBatonEvents(EVAL_TOKENTAGS, tokentagid, firstseq, std::min(nevents, tip.nEvents - firstseq), events))
+			return(result);
+		for (const auto &event : mempoolevents)
+			if (event.first.seq >= firstseq && event.first.seq < firstseq + nevents)
+				events.push_back(event);
+		if (bReverse)
+			std::reverse(events.begin(), events.end());
+		for (const auto &event : events)
+			result.push_back(event.second.txid.GetHex());
+		return(result);
+	}
+
 	if (myGetTransactionCCV2(cp,tokentagid,tokentagtx,hashBlock) != 0 && (numvouts = tokentagtx.vout.size()) > 0 &&
 	DecodeTokenTagOpRet(tokentagtx.vout[numvouts-1].scriptPubKey) == 'c')
 	{
@@ -1362,6 +1450,20 @@ UniValue TokenTagList(uint256 tokenid, CPubKey pubkey)
 	else if (tokensversion == 1)
 		CCERR_RESULT("tokentagscc", CCLOG_INFO, stream << "Token id in tag is version 1, which is not supported by this CC");
 
+	// With the baton chain index the tags of the token are read from its postings, txns are only loaded to filter by pubkey.
+	std::vector<std::pair<CCCBatonPostingKey, int32_t> > postings;
+	if (GetCCBatonPostings(EVAL_TOKENTAGS, std::vector<uint8_t>(tokenid.begin(), tokenid.end()), postings))
+	{
+		for (const auto &posting : postings)
+		{
+			if (pubkey == CPubKey())
+				result.push_back(posting.first.rootid.GetHex());
+			else if (myGetTransactionCCV2(cp,posting.first.rootid,tx,hashBlock) != 0 && TotalPubkeyNormalInputs(nullptr,tx,pubkey) != 0)
+				result.push_back(posting.first.rootid.GetHex());
+		}
+		return (result);
+	}
+
 	TokenTagspk = GetUnspendable(cp, NULL);
 	tagtxidpk = CCtxidaddr(txidaddr,tokenid);
 	GetCCaddress1of2(cp, tagCCaddress, TokenTagspk, tagtxidpk, true);
@@ -0,0 +1,304 @@
+/******************************************************************************
+ * Copyright © 2014-2022 The SuperNET Developers.                             *
+ *                                                                            *
+ * See the AUTHORS, DEVELOPER-AGREEMENT and LICENSE files at                  *
+ * the top-level directory of this distribution for the individual copyright  *
+ * holder information and the developer policies on copyright and licensing.  *
+ *                                                                            *
+ * Unless otherwise agreed in a custom licensing agreement, no part of the    *
+ * SuperNET software, including this file may be copied, modified, propagated *
+ * or distributed except according to the terms contained in the LICENSE file *
+ *                                                                            *
+ * Removal or modification of this copyright notice is prohibited.            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef CCBATONINDEX_H
+#define CCBATONINDEX_H
+
+#include "uint256.h"
+#include "serialize.h"
+#include "primitives/transaction.h"
+
+#include <map>
+#include <vector>
+
+// cc baton chain index: a baton chain is a sequence of cc transactions each spending the baton output of the previous one,
+// started by a root transaction (agreement, token tag, oracle registration, asset order).
+// The index maps (evalcode, root txid) to the current baton outpoint and keeps every event of the chain by sequence number.
+
+// baton chain key, (evalcode, root txid)
+struct CCCBatonKey {
+    uint8_t evalcode;
+    uint256 rootid;
+
+    size_t GetSerializeSize(int nType, int nVersion) const {
+        return sizeof(uint8_t) + sizeof(uint256);
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata8(s, evalcode);
+        rootid.Serialize(s);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        evalcode = ser_readdata8(s);
+        rootid.Unserialize(s);
+    }
+
+    CCCBatonKey(uint8_t _evalcode, uint256 _rootid) {
+        evalcode = _evalcode;
+        rootid = _rootid;
+    }
+
+    CCCBatonKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        evalcode = 0;
+        rootid.SetNull();
+    }
+
+    friend bool operator<(const CCCBatonKey& a, const CCCBatonKey& b) {
+        return a.evalcode < b.evalcode || (a.evalcode == b.evalcode && a.rootid < b.rootid);
+    }
+};
+
+// baton chain event key, sequence is stored big endian so the events of a chain are iterated in order
+struct CCCBatonEventKey {
+    uint8_t evalcode;
+    uint256 rootid;
+    uint32_t seq;
+
+    size_t GetSerializeSize(int nType, int nVersion) const {
+        return sizeof(uint8_t) + sizeof(uint256) + sizeof(uint32_t);
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        ser_writedata8(s, evalcode);
+        rootid.Serialize(s);
+        ser_writedata32be(s, seq);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        evalcode = ser_readdata8(s);
+        rootid.Unserialize(s);
+        seq = ser_readdata32be(s);
+    }
+
+    CCCBatonEventKey(uint8_t _evalcode, uint256 _rootid, uint32_t _seq) {
+        evalcode = _evalcode;
+        rootid = _rootid;
+        seq = _seq;
+    }
+
+    CCCBatonEventKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        evalcode = 0;
+        rootid.SetNull();
+        seq = 0;
+    }
+
+    friend bool operator<(const CCCBatonEventKey& a, const CCCBatonEventKey& b) {
+        if (a.evalcode != b.evalcode)
+            return a.evalcode < b.evalcode;
+        if (a.rootid != b.rootid)
+            return a.rootid < b.rootid;
+        return a.seq < b.seq;
+    }
+};
+
+// one event of a baton chain, seq 0 is the root tx itself
+struct CCCBatonEventValue {
+    uint256 txid;
+    int32_t batonvout;  // -1 if the event ended the chain
+    int32_t blockHeight;
+    uint8_t funcid;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txid);
+        READWRITE(batonvout);
+        READWRITE(blockHeight);
+        READWRITE(funcid);
+    }
+
+    CCCBatonEventValue(uint256 _txid, int32_t _batonvout, int32_t _height, uint8_t _funcid) {
+        txid = _txid;
+        batonvout = _batonvout;
+        blockHeight = _height;
+        funcid = _funcid;
+    }
+
+    CCCBatonEventValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        txid.SetNull();
+        batonvout = -1;
+        blockHeight = 0;
+        funcid = 0;
+    }
+
+    bool IsNull() const {
+        return txid.IsNull();
+    }
+};
+
+// current state of a baton chain
+struct CCCBatonTipValue {
+    uint256 txid;       // latest event, the root txid if the baton was never spent
+    int32_t batonvout;  // -1 if the chain has ended
+    int32_t blockHeight; // 0 for an event overlaid from the mempool
+    uint8_t funcid;
+    uint32_t nEvents;   // number of events including the root
+    uint256 rootdata;   // module specific data decoded once from the root tx (offertxid for agreements, tokenid for token tags)
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txid);
+        READWRITE(batonvout);
+        READWRITE(blockHeight);
+        READWRITE(funcid);
+        READWRITE(nEvents);
+        READWRITE(rootdata);
+    }
+
+    CCCBatonTipValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        txid.SetNull();
+        batonvout = -1;
+        blockHeight = 0;
+        funcid = 0;
+        nEvents = 0;
+        rootdata.SetNull();
+    }
+
+    bool IsNull() const {
+        return (nEvents == 0);
+    }
+};
+
+// reference from a live baton outpoint or an event txid back to its chain
+struct CCCBatonRefValue {
+    uint8_t evalcode;
+    uint256 rootid;
+    uint32_t seq;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(evalcode);
+        READWRITE(rootid);
+        READWRITE(seq);
+    }
+
+    CCCBatonRefValue(uint8_t _evalcode, uint256 _rootid, uint32_t _seq) {
+        evalcode = _evalcode;
+        rootid = _rootid;
+        seq = _seq;
+    }
+
+    CCCBatonRefValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        evalcode = 0;
+        rootid.SetNull();
+        seq = 0;
+    }
+
+    bool IsNull() const {
+        return rootid.IsNull();
+    }
+};
+
+// posting of a baton chain under an owner key (a pubkey, or an id like a tokenid) and a module defined role, for listing the chains of an owner
+struct CCCBatonPostingKey {
+    uint8_t evalcode;
+    std::vector<uint8_t> owner;
+    uint8_t role;
+    uint256 rootid;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(evalcode);
+        READWRITE(owner);
+        READWRITE(role);
+        READWRITE(rootid);
+    }
+
+    CCCBatonPostingKey(uint8_t _evalcode, const std::vector<uint8_t> &_owner, uint8_t _role, uint256 _rootid) {
+        evalcode = _evalcode;
+        owner = _owner;
+        role = _role;
+        rootid = _rootid;
+    }
+
+    CCCBatonPostingKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        evalcode = 0;
+        owner.clear();
+        role = 0;
+        rootid.SetNull();
+    }
+
+    friend bool operator<(const CCCBatonPostingKey& a, const CCCBatonPostingKey& b) {
+        if (a.evalcode != b.evalcode)
+            return a.evalcode < b.evalcode;
+        if (a.owner != b.owner)
+            return a.owner < b.owner;
+        if (a.role != b.role)
+            return a.role < b.role;
+        return a.rootid < b.rootid;
+    }
+};
+
+// partial posting key for seeking all postings of an owner
+struct CCCBatonPostingKeyOwner {
+    uint8_t evalcode;
+    std::vector<uint8_t> owner;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(evalcode);
+        READWRITE(owner);
+    }
+
+    CCCBatonPostingKeyOwner(uint8_t _evalcode, const std::vector<uint8_t> &_owner) {
+        evalcode = _evalcode;
+        owner = _owner;
+    }
+};
+
+// final state of every index entry touched by a block, null values are erased
+struct CCCBatonIndexUpdate {
+    std::map<CCCBatonKey, CCCBatonTipValue> tips;
+    std::map<CCCBatonEventKey, CCCBatonEventValue> events;
+    std::map<COutPoint, CCCBatonRefValue> outpoints;
+    std::map<uint256, std::vector<CCCBatonRefValue> > txrefs;
+    std::map<CCCBatonPostingKey, int32_t> postings;  // value is the root height, -1 to erase
+};
+
+#endif // #ifndef CCBATONINDEX_H
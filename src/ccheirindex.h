@@ -0,0 +1,85 @@
+/******************************************************************************
+ * Copyright © 2014-2022 The SuperNET Developers.                             *
+ *                                                                            *
+ * See the AUTHORS, DEVELOPER-AGREEMENT and LICENSE files at                  *
+ * the top-level directory of this distribution for the individual copyright  *
+ * holder information and the developer policies on copyright and licensing.  *
+ *                                                                            *
+ * Unless otherwise agreed in a custom licensing agreement, no part of the    *
+ * SuperNET software, including this file may be copied, modified, propagated *
+ * or distributed except according to the terms contained in the LICENSE file *
+ *                                                                            *
+ * Removal or modification of this copyright notice is prohibited.            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef CCHEIRINDEX_H
+#define CCHEIRINDEX_H
+
+#include "amount.h"
+#include "uint256.h"
+#include "serialize.h"
+#include "pubkey.h"
+
+// heir index: the confirmed state of every heir plan, keyed by fundingtxid.
+// The state is updated by each heir tx of the plan in ConnectBlock. The state a tx replaced is
+// kept as an undo record keyed by the txid and written back in DisconnectBlock.
+
+// plan state value
+struct CCCHeirStateValue {
+    uint256 tokenid;            // null for a coins plan
+    CPubKey ownerPubkey;
+    CPubKey heirPubkey;
+    int64_t inactivityTime;
+    int32_t fundingHeight;
+    uint256 lasttxid;           // latest tx with owner inputs, same rule as FindLatestFundingTx
+    int32_t lastHeight;
+    uint8_t lastFuncid;
+    uint8_t hasHeirSpendingBegun;
+    uint32_t nTxns;             // heir txns of the plan including the funding tx
+    CAmount lifetime;           // total added to the 1of2 address by 'F' and 'A' txns
+    CAmount balance;            // unspent on the 1of2 address
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(tokenid);
+        READWRITE(ownerPubkey);
+        READWRITE(heirPubkey);
+        READWRITE(inactivityTime);
+        READWRITE(fundingHeight);
+        READWRITE(lasttxid);
+        READWRITE(lastHeight);
+        READWRITE(lastFuncid);
+        READWRITE(hasHeirSpendingBegun);
+        READWRITE(nTxns);
+        READWRITE(lifetime);
+        READWRITE(balance);
+    }
+
+    CCCHeirStateValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        tokenid.SetNull();
+        ownerPubkey = CPubKey();
+        heirPubkey = CPubKey();
+        inactivityTime = 0;
+        fundingHeight = 0;
+        lasttxid.SetNull();
+        lastHeight = 0;
+        lastFuncid = 0;
+        hasHeirSpendingBegun = 0;
+        nTxns = 0;
+        lifetime = 0;
+        balance = 0;
+    }
+
+    bool IsNull() const {
+        return nTxns == 0;
+    }
+};
+
+#endif // #ifndef CCHEIRINDEX_H
@@ -0,0 +1,137 @@
+/******************************************************************************
+ * Copyright © 2014-2022 The SuperNET Developers.                             *
+ *                                                                            *
+ * See the AUTHORS, DEVELOPER-AGREEMENT and LICENSE files at                  *
+ * the top-level directory of this distribution for the individual copyright  *
+ * holder information and the developer policies on copyright and licensing.  *
+ *                                                                            *
+ * Unless otherwise agreed in a custom licensing agreement, no part of the    *
+ * SuperNET software, including this file may be copied, modified, propagated *
+ * or distributed except according to the terms contained in the LICENSE file *
+ *                                                                            *
+ * Removal or modification of this copyright notice is prohibited.            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef CCORACLEDATAINDEX_H
+#define CCORACLEDATAINDEX_H
+
+#include "uint256.h"
+#include "serialize.h"
+
+#include <string>
+#include <vector>
+
+// oracle data index: a time series of the decoded data samples of every (oracletxid, publisher) pair.
+// The publisher is identified by its baton address, as in oraclessamples.
+// Height and block position are stored big endian so the samples of a series are iterated in chain order.
+
+// series key, (oracletxid, publisher baton address)
+struct CCCOracleSeriesKey {
+    uint256 oracletxid;
+    std::string batonaddr;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(oracletxid);
+        READWRITE(batonaddr);
+    }
+
+    CCCOracleSeriesKey(uint256 _oracletxid, const std::string &_batonaddr) {
+        oracletxid = _oracletxid;
+        batonaddr = _batonaddr;
+    }
+
+    CCCOracleSeriesKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        oracletxid.SetNull();
+        batonaddr.clear();
+    }
+};
+
+// sample key, the series key followed by the block height and the position of the data tx in the block
+struct CCCOracleSampleKey {
+    uint256 oracletxid;
+    std::string batonaddr;
+    uint32_t blockHeight;
+    uint32_t blockPos;
+
+    size_t GetSerializeSize(int nType, int nVersion) const {
+        return sizeof(uint256) + ::GetSerializeSize(batonaddr, nType, nVersion) + sizeof(uint32_t) + sizeof(uint32_t);
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        oracletxid.Serialize(s);
+        ::Serialize(s, batonaddr);
+        ser_writedata32be(s, blockHeight);
+        ser_writedata32be(s, blockPos);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        oracletxid.Unserialize(s);
+        ::Unserialize(s, batonaddr);
+        blockHeight = ser_readdata32be(s);
+        blockPos = ser_readdata32be(s);
+    }
+
+    CCCOracleSampleKey(uint256 _oracletxid, const std::string &_batonaddr, uint32_t _height, uint32_t _pos) {
+        oracletxid = _oracletxid;
+        batonaddr = _batonaddr;
+        blockHeight = _height;
+        blockPos = _pos;
+    }
+
+    CCCOracleSampleKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        oracletxid.SetNull();
+        batonaddr.clear();
+        blockHeight = 0;
+        blockPos = 0;
+    }
+
+    bool IsSameSeries(const CCCOracleSeriesKey &series) const {
+        return oracletxid == series.oracletxid && batonaddr == series.batonaddr;
+    }
+};
+
+// one data sample, the raw data as published in the 'D' opreturn
+struct CCCOracleSampleValue {
+    uint256 txid;
+    std::vector<uint8_t> data;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(txid);
+        READWRITE(data);
+    }
+
+    CCCOracleSampleValue(uint256 _txid, const std::vector<uint8_t> &_data) {
+        txid = _txid;
+        data = _data;
+    }
+
+    CCCOracleSampleValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        txid.SetNull();
+        data.clear();
+    }
+
+    bool IsNull() const {
+        return txid.IsNull();
+    }
+};
+
+#endif // #ifndef CCORACLEDATAINDEX_H
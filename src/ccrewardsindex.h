@@ -0,0 +1,117 @@
+/******************************************************************************
+ * Copyright © 2014-2022 The SuperNET Developers.                             *
+ *                                                                            *
+ * See the AUTHORS, DEVELOPER-AGREEMENT and LICENSE files at                  *
+ * the top-level directory of this distribution for the individual copyright  *
+ * holder information and the developer policies on copyright and licensing.  *
+ *                                                                            *
+ * Unless otherwise agreed in a custom licensing agreement, no part of the    *
+ * SuperNET software, including this file may be copied, modified, propagated *
+ * or distributed except according to the terms contained in the LICENSE file *
+ *                                                                            *
+ * Removal or modification of this copyright notice is prohibited.            *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef CCREWARDSINDEX_H
+#define CCREWARDSINDEX_H
+
+#include "amount.h"
+#include "uint256.h"
+#include "serialize.h"
+#include "script/script.h"
+
+// rewards index: the unspent outputs on the rewards global CC address, grouped by plan.
+// Funding ('F', 'A'), unlock change ('U') and locked deposits ('L') are kept with the data
+// rewardslock, rewardsunlock and rewardsinfo need, so they don't load the transactions.
+
+// output key, (fundingtxid, sbits, txid, vout)
+struct CCCRewardsOutputKey {
+    uint256 fundingtxid;
+    uint64_t sbits;
+    uint256 txhash;
+    uint32_t index;
+
+    size_t GetSerializeSize(int nType, int nVersion) const {
+        return sizeof(uint256) + sizeof(uint64_t) + sizeof(uint256) + sizeof(uint32_t);
+    }
+    template<typename Stream>
+    void Serialize(Stream& s) const {
+        fundingtxid.Serialize(s);
+        ser_writedata64(s, sbits);
+        txhash.Serialize(s);
+        ser_writedata32(s, index);
+    }
+    template<typename Stream>
+    void Unserialize(Stream& s) {
+        fundingtxid.Unserialize(s);
+        sbits = ser_readdata64(s);
+        txhash.Unserialize(s);
+        index = ser_readdata32(s);
+    }
+
+    CCCRewardsOutputKey(uint256 _fundingtxid, uint64_t _sbits, uint256 _txhash, uint32_t _index) {
+        fundingtxid = _fundingtxid;
+        sbits = _sbits;
+        txhash = _txhash;
+        index = _index;
+    }
+
+    CCCRewardsOutputKey() {
+        SetNull();
+    }
+
+    void SetNull() {
+        fundingtxid.SetNull();
+        sbits = 0;
+        txhash.SetNull();
+        index = 0;
+    }
+};
+
+// output value, the amount, the funcid of the tx and the block it was confirmed in.
+// unlockScript is the normal vout.1 of the tx, where a locked deposit is paid on unlock
+struct CCCRewardsOutputValue {
+    CAmount satoshis;
+    uint8_t funcid;
+    int32_t blockHeight;
+    uint32_t blockTime;
+    CScript unlockScript;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(satoshis);
+        READWRITE(funcid);
+        READWRITE(blockHeight);
+        READWRITE(blockTime);
+        READWRITE(*(CScriptBase*)(&unlockScript));
+    }
+
+    CCCRewardsOutputValue(CAmount _satoshis, uint8_t _funcid, int32_t _height, uint32_t _time, const CScript &_unlockScript) {
+        satoshis = _satoshis;
+        funcid = _funcid;
+        blockHeight = _height;
+        blockTime = _time;
+        unlockScript = _unlockScript;
+    }
+
+    CCCRewardsOutputValue() {
+        SetNull();
+    }
+
+    void SetNull() {
+        satoshis = 0;
+        funcid = 0;
+        blockHeight = 0;
+        blockTime = 0;
+        unlockScript.clear();
+    }
+
+    bool IsNull() const {
+        return funcid == 0;
+    }
+};
+
+#endif // #ifndef CCREWARDSINDEX_H
@@ -44,9 +44,55 @@
 
 int NOTARISATION_SCAN_LIMIT_BLOCKS = 1440;
 
-/* On KMD */
-uint256 CalculateProofRoot(const char* symbol, uint32_t targetCCid, int kmdHeight,
-        std::vector<uint256> &moms, uint256 &destNotarisationTxid)
+
+/*
+ * Import proofs are requested over and over for the same KMD notarisation windows,
+ * so the notarisations of scanned blocks and the MoMoM windows built from them are cached.
+ *
+ * A MoMoM window only depends on the KMD block it is calculated from, since the scan
+ * only visits that block and its ancestors, so it is keyed by (symbol, CCid, block hash).
+ * A reorg simply makes the old keys unreachable. Each window keeps all merkle layers
+ * over its MoMs, so a proof branch is read off the tree without rehashing.
+ */
+struct MoMoMWindow
+{
+    uint256 MoMoM, destNotarisationTxid;
+    std::vector<uint256> moms;          // sorted and unique
+    std::vector<uint256> vMerkleTree;   // all layers as built by BuildMerkleTree
+};
+
+typedef std::tuple<std::string, uint32_t, uint256> MoMoMWindowKey;
+
+static const size_t MAX_CACHED_BLOCK_NOTARISATIONS = 20000;
+static const size_t MAX_CACHED_MOMOM_WINDOWS = 1000;
+
+static CCriticalSection cs_crosschainCache;
+static std::map<uint256, NotarisationsInBlock> mapCachedBlockNotarisations;
+static std::map<MoMoMWindowKey, MoMoMWindow> mapCachedMoMoMWindows;
+
+
+static bool GetCachedBlockNotarisations(const uint256 &blockHash, NotarisationsInBlock &notarisations)
+{
+    {
+        LOCK(cs_crosschainCache);
+        auto it = mapCachedBlockNotarisations.find(blockHash);
+        if (it != mapCachedBlockNotarisations.end()) {
+            notarisations = it->second;
+            return !notarisations.empty();
+        }
+    }
+    if (!GetBlockNotarisations(blockHash, notarisations))
+        notarisations.clear();
+
+    LOCK(cs_crosschainCache);
+    if (mapCachedBlockNotarisations.size() >= MAX_CACHED_BLOCK_NOTARISATIONS)
+        mapCachedBlockNotarisations.clear();
+    mapCachedBlockNotarisations[blockHash] = notarisations;
+    return !notarisations.empty();
+}
+
+
+static bool GetMoMoMWindow(const char* symbol, uint32_t targetCCid, int kmdHeight, MoMoMWindow &window)
 {
     /*
      * Notaries don't wait for confirmation on KMD before performing a backnotarisation,
@@ -60,10 +106,20 @@ uint256 CalculateProofRoot(const char* symbol, uint32_t targetCCid, int kmdHeigh
      */
 
     if (targetCCid < 2)
-        return uint256();
+        return false;
 
     if (kmdHeight < 0 || kmdHeight > chainActive.Height())
-        return uint256();
+        return false;
+
+    MoMoMWindowKey key(symbol, targetCCid, *chainActive[kmdHeight]->phashBlock);
+    {
+        LOCK(cs_crosschainCache);
+        auto it = mapCachedMoMoMWindows.find(key);
+        if (it != mapCachedMoMoMWindows.end()) {
+            window = it->second;
+            return true;
+        }
+    }
 
     int seenOwnNotarisations = 0, i = 0;
 
@@ -74,7 +130,7 @@ uint256 CalculateProofRoot(const char* symbol, uint32_t targetCCid, int kmdHeigh
         if (i > kmdHeight) break;
         NotarisationsInBlock notarisations;
         uint256 blockHash = *chainActive[kmdHeight-i]->phashBlock;
-        if (!GetBlockNotarisations(blockHash, notarisations))
+        if (!GetCachedBlockNotarisations(blockHash, notarisations))
             continue;
 
         // See if we have an own notarisation in this block
@@ -83,7 +139,7 @@ uint256 CalculateProofRoot(const char* symbol, uint32_t targetCCid, int kmdHeigh
             {
                 seenOwnNotarisations++;
                 if (seenOwnNotarisations == 1)
-                    destNotarisationTxid = nota.first;
+                    window.destNotarisationTxid = nota.first;
                 else if (seenOwnNotarisations == 7)
                     goto end;
                 //break;
@@ -102,16 +158,36 @@ uint256 CalculateProofRoot(const char* symbol, uint32_t targetCCid, int kmdHeigh
     }
 
     // Not enough own notarisations found to return determinate MoMoM
-    destNotarisationTxid = uint256();
-    moms.clear();
-    return uint256();
+    return false;
 
 end:
     // add set to vector. Set makes sure there are no dupes included. 
-    moms.clear();
-    std::copy(tmp_moms.begin(), tmp_moms.end(), std::back_inserter(moms));
-    //fprintf(stderr, "SeenOwnNotarisations.%i moms.size.%li blocks scanned.%i\n",seenOwnNotarisations, moms.size(), i);
-    return GetMerkleRoot(moms);
+    window.moms.assign(tmp_moms.begin(), tmp_moms.end());
+    bool fMutated;
+    window.MoMoM = BuildMerkleTree(&fMutated, window.moms, window.vMerkleTree);
+    //fprintf(stderr, "SeenOwnNotarisations.%i moms.size.%li blocks scanned.%i\n",seenOwnNotarisations, window.moms.size(), i);
+
+    LOCK(cs_crosschainCache);
+    if (mapCachedMoMoMWindows.size() >= MAX_CACHED_MOMOM_WINDOWS)
+        mapCachedMoMoMWindows.clear();
+    mapCachedMoMoMWindows[key] = window;
+    return true;
+}
+
+
+/* On KMD */
+uint256 CalculateProofRoot(const char* symbol, uint32_t targetCCid, int kmdHeight,
+        std::vector<uint256> &moms, uint256 &destNotarisationTxid)
+{
+    MoMoMWindow window;
+    if (!GetMoMoMWindow(symbol, targetCCid, kmdHeight, window)) {
+        destNotarisationTxid = uint256();
+        moms.clear();
+        return uint256();
+    }
+    moms = window.moms;
+    destNotarisationTxid = window.destNotarisationTxid;
+    return window.MoMoM;
 }
 
 
@@ -129,7 +205,7 @@ int ScanNotarisationsFromHeight(int nHeight, const IsTarget f, Notarisation &fou
     for (int h=start; h<limit; h++) {
         NotarisationsInBlock notarisations;
 
-        if (!GetBlockNotarisations(*chainActive[h]->phashBlock, notarisations))
+        if (!GetCachedBlockNotarisations(*chainActive[h]->phashBlock, notarisations))
             continue;
 
         BOOST_FOREACH(found, notarisations) {
@@ -184,43 +260,28 @@ TxProof GetCrossChainProof(const uint256 txid, const char* targetSymbol, uint32_
         kmdHeight += offset;
 
     // Get MoMs for kmd height and symbol
-    std::vector<uint256> moms;
-    uint256 targetChainNotarisationTxid;
-    uint256 MoMoM = CalculateProofRoot(targetSymbol, targetCCid, kmdHeight, moms, targetChainNotarisationTxid);
-    if (MoMoM.IsNull())
+    MoMoMWindow window;
+    if (!GetMoMoMWindow(targetSymbol, targetCCid, kmdHeight, window) || window.MoMoM.IsNull())
         throw std::runtime_error("No MoMs found");
 
     // Find index of source MoM in MoMoM
-    int nIndex;
-    for (nIndex=0; nIndex<moms.size(); nIndex++) {
-        if (moms[nIndex] == MoM)
-            goto cont;
-    }
-    throw std::runtime_error("Couldn't find MoM within MoMoM set");
-cont:
+    auto itMoM = std::lower_bound(window.moms.begin(), window.moms.end(), MoM);
+    if (itMoM == window.moms.end() || *itMoM != MoM)
+        throw std::runtime_error("Couldn't find MoM within MoMoM set");
+    int nIndex = itMoM - window.moms.begin();
 
-    // Create a branch
-    std::vector<uint256> vBranch;
-    {
-        CBlock fakeBlock;
-        for (int i=0; i<moms.size(); i++) {
-            CTransaction fakeTx;
-            // first value in CTransaction memory is it's hash
-            memcpy((void*)&fakeTx, moms[i].begin(), 32);
-            fakeBlock.vtx.push_back(fakeTx);
-        }
-        vBranch = fakeBlock.GetMerkleBranch(nIndex);
-    }
+    // Create a branch from the cached merkle layers
+    std::vector<uint256> vBranch = GetMerkleBranch(nIndex, window.moms.size(), window.vMerkleTree);
 
     // Concatenate branches
     MerkleBranch newBranch = assetChainProof.second;
     newBranch << MerkleBranch(nIndex, vBranch);
 
     // Check proof
-    if (newBranch.Exec(txid) != MoMoM)
+    if (newBranch.Exec(txid) != window.MoMoM)
         throw std::runtime_error("Proof check failed");
 
-    return std::make_pair(targetChainNotarisationTxid,newBranch);
+    return std::make_pair(window.destNotarisationTxid,newBranch);
 }
 
 
@@ -10,13 +10,21 @@
 #include <stdexcept>
 
 #if defined(__x86_64__) || defined(__amd64__)
-#if defined(EXPERIMENTAL_ASM)
 #include <cpuid.h>
+#if defined(EXPERIMENTAL_ASM)
 namespace sha256_sse4
 {
 void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks);
 }
 #endif
+namespace sha256_shani
+{
+void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks);
+}
+namespace sha256d64_avx2
+{
+void Transform_8way(unsigned char* out, const unsigned char* in);
+}
 #endif
 
 // Internal implementation code.
@@ -144,6 +152,35 @@ void Transform(uint32_t* s, const unsigned char* chunk, size_t blocks)
 } // namespace sha256
 
 typedef void (*TransformType)(uint32_t*, const unsigned char*, size_t);
+typedef void (*TransformD64Type)(unsigned char*, const unsigned char*);
+
+/** Double SHA-256 of one 64 byte input on top of a single block transform. */
+template<TransformType tr>
+void TransformD64Wrapper(unsigned char* out, const unsigned char* in)
+{
+    // padding blocks of a 64 byte and of a 32 byte message
+    static const unsigned char padding1[64] = {
+        0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0
+    };
+    unsigned char buffer2[64] = {
+        0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+        0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0
+    };
+    uint32_t s[8];
+    int i;
+
+    sha256::Initialize(s);
+    tr(s, in, 1);
+    tr(s, padding1, 1);
+    for (i = 0; i < 8; i++)
+        WriteBE32(buffer2 + 4 * i, s[i]);
+
+    sha256::Initialize(s);
+    tr(s, buffer2, 1);
+    for (i = 0; i < 8; i++)
+        WriteBE32(out + 4 * i, s[i]);
+}
 
 bool SelfTest(TransformType tr) {
     static const unsigned char in1[65] = {0, 0x80};
@@ -172,23 +209,89 @@ bool SelfTest(TransformType tr) {
     return true;
 }
 
+/** Checks the batched double hashes against the standard transform, for 1 to 9 inputs. */
+bool SelfTestD64(TransformD64Type d64, TransformD64Type d64_8way)
+{
+    unsigned char in[64 * 9], expected[32 * 9], out[32 * 9];
+    for (size_t i = 0; i < sizeof(in); i++)
+        in[i] = (unsigned char)(i * 7 + (i >> 6));
+    for (size_t i = 0; i < 9; i++)
+        TransformD64Wrapper<sha256::Transform>(expected + 32 * i, in + 64 * i);
+
+    for (size_t i = 0; i < 9; i++)
+        d64(out + 32 * i, in + 64 * i);
+    if (memcmp(out, expected, sizeof(out))) return false;
+    if (d64_8way) {
+        // lanes must not leak into each other, check both 8 input windows
+        for (size_t offset = 0; offset < 2; offset++) {
+            memset(out, 0, sizeof(out));
+            d64_8way(out, in + 64 * offset);
+            if (memcmp(out, expected + 32 * offset, 32 * 8)) return false;
+        }
+    }
+    return true;
+}
+
 TransformType Transform = sha256::Transform;
+TransformD64Type TransformD64 = TransformD64Wrapper<sha256::Transform>;
+TransformD64Type TransformD64_8way = nullptr;
+
+#if defined(__x86_64__) || defined(__amd64__)
+/** The AVX registers must be saved by the OS before any AVX2 instruction is used. */
+bool AVXEnabled()
+{
+    uint32_t a, d;
+    __asm__("xgetbv" : "=a"(a), "=d"(d) : "c"(0));
+    return (a & 6) == 6;
+}
+#endif
 
 } // namespace
 
 std::string SHA256AutoDetect()
 {
-#if defined(EXPERIMENTAL_ASM) && (defined(__x86_64__) || defined(__amd64__))
+    std::string ret = "standard";
+    Transform = sha256::Transform;
+    TransformD64 = TransformD64Wrapper<sha256::Transform>;
+    TransformD64_8way = nullptr;
+
+#if defined(__x86_64__) || defined(__amd64__)
     uint32_t eax, ebx, ecx, edx;
-    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx >> 19) & 1) {
-        Transform = sha256_sse4::Transform;
-        assert(SelfTest(Transform));
-        return "sse4";
+    bool have_sse4 = false, have_avx2 = false, have_shani = false;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        have_sse4 = (ecx >> 19) & 1;
+        // OSXSAVE is required for xgetbv
+        bool enabled_avx = ((ecx >> 27) & 1) && AVXEnabled();
+        if (__get_cpuid_max(0, NULL) >= 7) {
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            have_avx2 = enabled_avx && ((ebx >> 5) & 1);
+            have_shani = have_sse4 && ((ebx >> 29) & 1);
+        }
+    }
+
+    if (have_shani) {
+        // faster than the 8 lanes of AVX2 for the merkle double hashes too
+        Transform = sha256_shani::Transform;
+        TransformD64 = TransformD64Wrapper<sha256_shani::Transform>;
+        ret = "shani";
+    } else {
+#if defined(EXPERIMENTAL_ASM)
+        if (have_sse4) {
+            Transform = sha256_sse4::Transform;
+            TransformD64 = TransformD64Wrapper<sha256_sse4::Transform>;
+            ret = "sse4";
+        }
+#endif
+        if (have_avx2) {
+            TransformD64_8way = sha256d64_avx2::Transform_8way;
+            ret += ",avx2(8way)";
+        }
     }
 #endif
 
     assert(SelfTest(Transform));
-    return "standard";
+    assert(SelfTestD64(TransformD64, TransformD64_8way));
+    return ret;
 }
 
 ////// SHA-256
@@ -256,3 +359,21 @@ CSHA256& CSHA256::Reset()
     sha256::Initialize(s);
     return *this;
 }
+
+void SHA256D64(unsigned char* out, const unsigned char* in, size_t blocks)
+{
+    if (TransformD64_8way) {
+        while (blocks >= 8) {
+            TransformD64_8way(out, in);
+            out += 256;
+            in += 512;
+            blocks -= 8;
+        }
+    }
+    while (blocks) {
+        TransformD64(out, in);
+        out += 32;
+        in += 64;
+        --blocks;
+    }
+}
@@ -91,6 +91,8 @@ int             cc_isFulfilled(const CC *cond);
 int             cc_verify(const struct CC *cond, const uint8_t *msg, size_t msgLength,
                         int doHashMessage, const uint8_t *condBin, size_t condBinLength,
                         VerifyEval verifyEval, void *evalContext);
+int             cc_verifySignatures(const struct CC *cond, const uint8_t *msg, size_t msgLength,
+                        int doHashMessage, const uint8_t *condBin, size_t condBinLength);
 int             cc_verifyEval(const CC *cond, VerifyEval verify, void *context);
 int             cc_visit(CC *cond, struct CCVisitor visitor);
 int             cc_signTreeEd25519(CC *cond, const uint8_t *privateKey, const uint8_t *msg,
@@ -108,6 +110,8 @@ struct CC*      cc_readConditionBinary(const uint8_t *cond_bin, size_t cond_bin_
 struct CC*      cc_readFulfillmentBinary(const uint8_t *ffill_bin, size_t ffill_bin_len);
 struct CC*      cc_readFulfillmentBinaryMixedMode(const uint8_t *ffill_bin, size_t ffill_bin_len);
 int             cc_readFulfillmentBinaryExt(const unsigned char *ffill_bin, size_t ffill_bin_len, CC **ppcc);
+/* The asn1c decoder only, without the fast path for the common shapes; to check and time it */
+struct CC*      cc_readFulfillmentBinaryAsn1c(const uint8_t *ffill_bin, size_t ffill_bin_len, int mixedMode);
 struct CC*      cc_new(int typeId);
 struct cJSON*   cc_conditionToJSON(const CC *cond);
 char*           cc_conditionToJSONString(const CC *cond);
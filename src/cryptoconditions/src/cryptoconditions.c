@@ -29,6 +29,7 @@
 #include "anon.c"
 #include "eval.c"
 #include "json_rpc.c"
+#include "fast_decode.c"
 
 struct CCType *CCTypeRegistry[] = {
     &CC_PreimageType,
@@ -223,7 +224,7 @@ CC *fulfillmentToCC(Fulfillment_t *ffill, const FulfillmentFlags flags) {
 }
 
 
-CC *cc_readFulfillmentBinaryWithFlags(const unsigned char *ffill_bin, size_t ffill_bin_len, FulfillmentFlags flags) {
+static CC *asnReadFulfillmentBinary(const unsigned char *ffill_bin, size_t ffill_bin_len, FulfillmentFlags flags) {
     CC *cond = 0;
     unsigned char *buf = calloc(1,ffill_bin_len);
     Fulfillment_t *ffill = 0;
@@ -248,6 +249,17 @@ end:
     return cond;
 }
 
+CC *cc_readFulfillmentBinaryWithFlags(const unsigned char *ffill_bin, size_t ffill_bin_len, FulfillmentFlags flags) {
+    CC *cond = 0;
+    if (fastReadFulfillmentBinary(ffill_bin, ffill_bin_len, flags, &cond))
+        return cond;
+    return asnReadFulfillmentBinary(ffill_bin, ffill_bin_len, flags);
+}
+
+CC *cc_readFulfillmentBinaryAsn1c(const unsigned char *ffill_bin, size_t ffill_bin_len, int mixedMode) {
+    return asnReadFulfillmentBinary(ffill_bin, ffill_bin_len, mixedMode ? MixedMode : 0);
+}
+
 CC *cc_readFulfillmentBinary(const unsigned char *ffill_bin, size_t ffill_bin_len) {
     return cc_readFulfillmentBinaryWithFlags(ffill_bin, ffill_bin_len, 0);
 }
@@ -270,9 +282,12 @@ int cc_visit(CC *cond, CCVisitor visitor) {
     return out;
 }
 
-int cc_verify(const struct CC *cond, const unsigned char *msg, size_t msgLength, int doHashMsg,
-              const unsigned char *condBin, size_t condBinLength,
-              VerifyEval verifyEval, void *evalContext) {
+/*
+ * Checks the condition binary and the signatures of the tree, the evals are not run.
+ * The result only depends on the arguments so the caller may cache it.
+ */
+int cc_verifySignatures(const struct CC *cond, const unsigned char *msg, size_t msgLength, int doHashMsg,
+              const unsigned char *condBin, size_t condBinLength) {
     unsigned char targetBinary[1000];
     //fprintf(stderr,"in cc_verify cond.%p msg.%p[%d] dohash.%d condbin.%p[%d]\n",cond,msg,(int32_t)msgLength,doHashMsg,condBin,(int32_t)condBinLength);
     const size_t binLength = cc_conditionBinary(cond, targetBinary);
@@ -304,6 +319,15 @@ int cc_verify(const struct CC *cond, const unsigned char *msg, size_t msgLength,
         return 0;
     }
 
+    return 1;
+}
+
+
+int cc_verify(const struct CC *cond, const unsigned char *msg, size_t msgLength, int doHashMsg,
+              const unsigned char *condBin, size_t condBinLength,
+              VerifyEval verifyEval, void *evalContext) {
+    if (!cc_verifySignatures(cond, msg, msgLength, doHashMsg, condBin, condBinLength))
+        return 0;
     if (!cc_verifyEval(cond, verifyEval, evalContext)) {
         //fprintf(stderr,"cc_verify error D\n");
         return 0;
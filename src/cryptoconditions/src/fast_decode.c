@@ -0,0 +1,326 @@
+/******************************************************************************
+ * Copyright © 2014-2019 The SuperNET Developers.                             *
+ *                                                                            *
+ * See the AUTHORS, DEVELOPER-AGREEMENT and LICENSE files at                  *
+ * the top-level directory of this distribution for the individual copyright  *
+ * holder information and the developer policies on copyright and licensing.  *
+ *                                                                            *
+ * Unless otherwise agreed in a custom licensing agreement, no part of the    *
+ * SuperNET software, including this file may be copied, modified, propagated *
+ * or distributed except according to the terms contained in the LICENSE file *
+ *                                                                            *
+ * Removal or modification of this copyright notice is prohibited.            *
+ *                                                                            *
+ ******************************************************************************/
+
+/*
+ * Fast path for reading the fulfillments almost every CC input uses: thresholds of secp256k1
+ * and eval fulfillments and anonymous conditions, in plain and mixed mode.
+ *
+ * The DER is walked in place into a small table on the stack, without building the asn1c
+ * structs and re-encoding them for the malleability check, and the CC tree is only allocated
+ * once the whole binary was understood. Only the encodings the DER encoder produces are
+ * accepted; anything else (other types, long or non minimal lengths, unsorted sets, an eval
+ * param, deeper trees...) is left to the asn1c decoder, as is anything the tree builders
+ * would refuse. So both paths accept the same binaries and build the same trees.
+ */
+
+#include "internal.h"
+
+
+#define FAST_MAX_NODES 16
+#define FAST_MAX_CHILDREN 8
+#define FAST_MAX_DEPTH 4
+
+
+typedef struct FastNode {
+    int typeId;                   // CC_Threshold, CC_Secp256k1, CC_Eval or CC_Anon
+    const unsigned char *data;    // public key, eval code or anon fingerprint
+    size_t dataLength;
+    const unsigned char *signature;
+    int threshold;
+    int nChildren;
+    int children[FAST_MAX_CHILDREN];
+    CCType *conditionType;        // anon only
+    unsigned long cost;
+    uint32_t subtypes;
+} FastNode;
+
+
+typedef struct FastTree {
+    FastNode nodes[FAST_MAX_NODES];
+    int nNodes;
+} FastTree;
+
+
+/*
+ * Reads a tag of one byte and a DER length (short form, or long form of one or two bytes
+ * without leading zeros). Returns the end of the element, or NULL.
+ */
+static const unsigned char *fastReadTLV(const unsigned char *p, const unsigned char *end,
+        unsigned char *tag, const unsigned char **value, size_t *length) {
+    if (end - p < 2) return NULL;
+    *tag = *p++;
+    size_t len = *p++;
+    if (len == 0x81) {
+        if (end - p < 1 || p[0] < 0x80) return NULL;
+        len = *p++;
+    } else if (len == 0x82) {
+        if (end - p < 2 || p[0] == 0) return NULL;
+        len = (p[0] << 8) | p[1];
+        p += 2;
+    } else if (len > 0x7f) {
+        return NULL;
+    }
+    if ((size_t)(end - p) < len) return NULL;
+    *value = p;
+    *length = len;
+    return p + len;
+}
+
+
+/* Reads a primitive element with the expected tag. */
+static const unsigned char *fastReadExpect(const unsigned char *p, const unsigned char *end,
+        unsigned char expected, const unsigned char **value, size_t *length) {
+    unsigned char tag;
+    p = fastReadTLV(p, end, &tag, value, length);
+    return (p && tag == expected) ? p : NULL;
+}
+
+
+/* The order the DER encoder sorts SET OF elements in. */
+static int fastCmpElements(const unsigned char *a, size_t aLength, const unsigned char *b, size_t bLength) {
+    int ret = memcmp(a, b, aLength < bLength ? aLength : bLength);
+    if (ret == 0)
+        ret = aLength < bLength ? -1 : aLength > bLength ? 1 : 0;
+    return ret;
+}
+
+
+/* A cost: a minimally encoded non negative INTEGER below 2^32. */
+static int fastReadCost(const unsigned char *value, size_t length, unsigned long *cost) {
+    if (length == 0 || length > 5 || (value[0] & 0x80)) return 0;
+    if (length > 1 && value[0] == 0 && !(value[1] & 0x80)) return 0;
+    if (length == 5 && value[0] != 0) return 0;
+    unsigned long v = 0;
+    for (size_t i = 0; i < length; i++)
+        v = (v << 8) | value[i];
+    *cost = v;
+    return 1;
+}
+
+
+/* Subtypes, only in the form asnSubtypes writes them. */
+static int fastReadSubtypes(const unsigned char *value, size_t length, uint32_t *subtypes) {
+    if (length < 2 || length > 5) return 0;
+    uint32_t mask = 0;
+    int maxId = 0;
+    for (int i = 0; i < (int)(length - 1) * 8; i++) {
+        if (value[1 + (i >> 3)] & (1 << (7 - i % 8))) {
+            mask |= 1 << i;
+            maxId = i;
+        }
+    }
+    if (length != (size_t)(2 + (maxId >> 3)) || value[0] != 7 - maxId % 8) return 0;
+    *subtypes = mask;
+    return 1;
+}
+
+
+static int fastNewNode(FastTree *tree) {
+    if (tree->nNodes == FAST_MAX_NODES) return -1;
+    memset(&tree->nodes[tree->nNodes], 0, sizeof(FastNode));
+    return tree->nNodes++;
+}
+
+
+/* An anonymous subcondition of a threshold, as mkAnon reads it. */
+static int fastReadCondition(FastTree *tree, unsigned char tag, const unsigned char *p, const unsigned char *end) {
+    int typeId = tag == 0xaf ? CC_Eval : tag - 0xa0;
+    if (tag < 0xa0 || (typeId > CC_Secp256k1hash && typeId != CC_Eval) || !CCTypeRegistry[typeId])
+        return -1;
+    int compound = typeId == CC_Prefix || typeId == CC_Threshold;
+
+    const unsigned char *fingerprint, *cost, *subtypes;
+    size_t fingerprintLength, costLength, subtypesLength;
+    if (!(p = fastReadExpect(p, end, 0x80, &fingerprint, &fingerprintLength)) || fingerprintLength != 32) return -1;
+    if (!(p = fastReadExpect(p, end, 0x81, &cost, &costLength))) return -1;
+    if (compound && !(p = fastReadExpect(p, end, 0x82, &subtypes, &subtypesLength))) return -1;
+    if (p != end) return -1;
+
+    int n = fastNewNode(tree);
+    if (n < 0) return -1;
+    FastNode *node = &tree->nodes[n];
+    node->typeId = CC_Anon;
+    node->conditionType = CCTypeRegistry[typeId];
+    node->data = fingerprint;
+    node->dataLength = fingerprintLength;
+    if (!fastReadCost(cost, costLength, &node->cost)) return -1;
+    if (compound && !fastReadSubtypes(subtypes, subtypesLength, &node->subtypes)) return -1;
+    return n;
+}
+
+
+static int fastReadFulfillment(FastTree *tree, unsigned char tag, const unsigned char *p, const unsigned char *end,
+        FulfillmentFlags flags, int depth);
+
+
+static int fastReadThreshold(FastTree *tree, const unsigned char *p, const unsigned char *end,
+        FulfillmentFlags flags, int depth) {
+    const unsigned char *ffills, *ffillsEnd, *conds, *condsEnd;
+    size_t length;
+    if (!(p = fastReadExpect(p, end, 0xa0, &ffills, &length))) return -1;
+    ffillsEnd = p;
+    if (!(p = fastReadExpect(p, end, 0xa1, &conds, &length))) return -1;
+    condsEnd = p;
+    if (p != end) return -1;
+
+    int n = fastNewNode(tree);
+    if (n < 0) return -1;
+    int nFulfillments = 0;
+    int marker = -1;
+
+    for (int set = 0; set < 2; set++) {
+        const unsigned char *q = set ? conds : ffills, *qEnd = set ? condsEnd : ffillsEnd;
+        const unsigned char *prev = NULL;
+        size_t prevLength = 0;
+        while (q != qEnd) {
+            unsigned char subTag;
+            const unsigned char *value;
+            const unsigned char *next = fastReadTLV(q, qEnd, &subTag, &value, &length);
+            if (!next) return -1;
+            if (prev && fastCmpElements(prev, prevLength, q, next - q) > 0) return -1;
+            prev = q;
+            prevLength = next - q;
+
+            if (!set && (flags & MixedMode) && marker < 0) {
+                // the real threshold, a preimage of one byte sorted in front of the fulfillments
+                const unsigned char *preimage;
+                size_t preimageLength;
+                if (subTag != 0xa0) return -1;
+                if (fastReadExpect(value, next, 0x80, &preimage, &preimageLength) != next || preimageLength != 1) return -1;
+                marker = preimage[0];
+                q = next;
+                continue;
+            }
+
+            int child = set ? fastReadCondition(tree, subTag, value, next)
+                            : fastReadFulfillment(tree, subTag, value, next, flags, depth + 1);
+            if (child < 0 || tree->nodes[n].nChildren == FAST_MAX_CHILDREN) return -1;
+            tree->nodes[n].children[tree->nodes[n].nChildren++] = child;
+            if (!set) nFulfillments++;
+            q = next;
+        }
+    }
+
+    FastNode *node = &tree->nodes[n];
+    node->typeId = CC_Threshold;
+    if (flags & MixedMode) {
+        if (marker < 0 || marker > node->nChildren) return -1;
+        node->threshold = marker;
+    } else {
+        if (nFulfillments == 0) return -1;
+        node->threshold = nFulfillments;
+    }
+    return n;
+}
+
+
+static int fastReadFulfillment(FastTree *tree, unsigned char tag, const unsigned char *p, const unsigned char *end,
+        FulfillmentFlags flags, int depth) {
+    if (depth > FAST_MAX_DEPTH) return -1;
+
+    if (tag == 0xa2)
+        return fastReadThreshold(tree, p, end, flags, depth);
+
+    if (tag == 0xa5) {
+        const unsigned char *pk, *sig;
+        size_t pkLength, sigLength;
+        if (!(p = fastReadExpect(p, end, 0x80, &pk, &pkLength)) || pkLength != 33) return -1;
+        if (!(p = fastReadExpect(p, end, 0x81, &sig, &sigLength)) || sigLength != 64) return -1;
+        if (p != end) return -1;
+        int n = fastNewNode(tree);
+        if (n < 0) return -1;
+        tree->nodes[n].typeId = CC_Secp256k1;
+        tree->nodes[n].data = pk;
+        tree->nodes[n].dataLength = pkLength;
+        tree->nodes[n].signature = sig;
+        return n;
+    }
+
+    if (tag == 0xaf) {
+        const unsigned char *code;
+        size_t codeLength;
+        // with a param the asn1c decoder has to drop it
+        if (!(p = fastReadExpect(p, end, 0x80, &code, &codeLength)) || codeLength == 0 || p != end) return -1;
+        int n = fastNewNode(tree);
+        if (n < 0) return -1;
+        tree->nodes[n].typeId = CC_Eval;
+        tree->nodes[n].data = code;
+        tree->nodes[n].dataLength = codeLength;
+        return n;
+    }
+
+    return -1;
+}
+
+
+static CC *fastBuild(const FastTree *tree, int n) {
+    const FastNode *node = &tree->nodes[n];
+    CC *cond;
+
+    switch (node->typeId) {
+        case CC_Threshold:
+            cond = cc_new(CC_Threshold);
+            cond->threshold = node->threshold;
+            cond->size = node->nChildren;
+            cond->subconditions = calloc(cond->size, sizeof(CC*));
+            for (int i=0; i<node->nChildren; i++) {
+                if (!(cond->subconditions[i] = fastBuild(tree, node->children[i]))) {
+                    cc_free(cond);
+                    return NULL;
+                }
+            }
+            return cond;
+        case CC_Secp256k1:
+            // NULL if the public key does not parse
+            return cc_secp256k1Condition(node->data, node->signature);
+        case CC_Eval:
+            cond = cc_new(CC_Eval);
+            cond->code = calloc(1, node->dataLength);
+            memcpy(cond->code, node->data, node->dataLength);
+            cond->codeLength = node->dataLength;
+            return cond;
+        case CC_Anon:
+            cond = cc_new(CC_Anon);
+            cond->conditionType = node->conditionType;
+            memcpy(cond->fingerprint, node->data, 32);
+            cond->cost = node->cost;
+            cond->subtypes = node->subtypes;
+            return cond;
+    }
+    return NULL;
+}
+
+
+/*
+ * Reads a fulfillment binary of one of the shapes above. Returns 0 if it has to go through the
+ * asn1c decoder instead.
+ */
+int fastReadFulfillmentBinary(const unsigned char *ffill_bin, size_t ffill_bin_len, FulfillmentFlags flags, CC **ppcc) {
+    FastTree tree;
+    unsigned char tag;
+    const unsigned char *value;
+    size_t length;
+    const unsigned char *end = ffill_bin + ffill_bin_len;
+
+    tree.nNodes = 0;
+    const unsigned char *next = fastReadTLV(ffill_bin, end, &tag, &value, &length);
+    if (!next || next != end)
+        return 0;
+    int root = fastReadFulfillment(&tree, tag, value, end, flags, 1);
+    if (root < 0)
+        return 0;
+    *ppcc = fastBuild(&tree, root);
+    return *ppcc != NULL;
+}
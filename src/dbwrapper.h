@@ -148,6 +148,16 @@ public:
         return true;
     }
 
+    bool GetValueDataStream(CDataStream &ssValue) {
+        leveldb::Slice slValue = piter->value();
+        try {
+            ssValue = CDataStream(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
+        } catch(std::exception &e) {
+            return false;
+        }
+        return true;
+    }
+
     unsigned int GetValueSize() {
         return piter->value().size();
     }
@@ -184,8 +194,9 @@ public:
      * @param[in] nCacheSize  Configures various leveldb cache settings.
      * @param[in] fMemory     If true, use leveldb's memory environment.
      * @param[in] fWipe       If true, remove all existing data.
+     * @param[in] nWriteBufferSize  Size of the write buffers, 0 for a quarter of nCacheSize.
      */
-    CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool compression = false, int maxOpenFiles = 64);
+    CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool compression = false, int maxOpenFiles = 64, size_t nWriteBufferSize = 0);
     ~CDBWrapper();
 
     template <typename K, typename V>
@@ -0,0 +1,374 @@
+// Copyright (c) 2015 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_FLATHASHMAP_H
+#define BITCOIN_FLATHASHMAP_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * Open addressing hash map for the hot maps of the coins cache and the mempool.
+ *
+ * The table is a flat array of (hash, node pointer) slots probed linearly, so a lookup touches
+ * one or two cache lines of the table and then the one node it wants, without chasing a bucket
+ * chain. The entries themselves live in nodes carved out of large chunks and recycled through a
+ * free list, instead of one heap allocation per entry.
+ *
+ * It follows the subset of the std::unordered_map interface these maps use, with two
+ * differences worth knowing:
+ * - Erasing leaves a tombstone and never moves other entries, so erasing the current element
+ *   while iterating is fine, as with the node based maps.
+ * - Growing the table invalidates iterators for iteration, but entries never move: pointers and
+ *   references to them stay valid until they are erased, and an iterator can still be
+ *   dereferenced and erased after the map grew (CCoinsModifier relies on that).
+ *
+ * The hasher is expected to be salted (see CCoinsKeyHasher), the low bits of the hash pick the
+ * slot.
+ */
+template<typename K, typename V, typename Hasher>
+class flathashmap
+{
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<const K, V> value_type;
+    typedef size_t size_type;
+
+private:
+    /** Storage of one entry, or the link of the free list while it is unused. */
+    union Node {
+        typename std::aligned_storage<sizeof(value_type), alignof(value_type)>::type value;
+        Node* pnext;
+
+        value_type& get() { return *reinterpret_cast<value_type*>(&value); }
+    };
+
+    enum { SLOT_EMPTY = 0, SLOT_DELETED = 1 };
+
+    struct Slot {
+        size_t nHash;   //!< hash of the key, or SLOT_EMPTY/SLOT_DELETED if pnode is NULL
+        Node* pnode;
+    };
+
+    /** The first chunk holds this many nodes, each one after that twice as many up to the max. */
+    static const size_t MIN_CHUNK_NODES = 16;
+    static const size_t MAX_CHUNK_NODES = 4096;
+    /** Smallest table, grown once entries plus tombstones exceed 3/4 of the slots. */
+    static const size_t MIN_SLOTS = 16;
+
+    Hasher hasher;
+    Slot* slots;
+    size_t nSlots;      //!< 0 or a power of two
+    size_t nSize;
+    size_t nDeleted;    //!< tombstones in the table
+    std::vector<Node*> vChunks;
+    Node* pfree;
+    size_t nChunkNodes; //!< nodes of the next chunk
+    size_t nPoolBytes;
+
+    Node* AllocNode()
+    {
+        if (pfree == NULL) {
+            Node* pchunk = static_cast<Node*>(malloc(nChunkNodes * sizeof(Node)));
+            if (pchunk == NULL)
+                throw std::bad_alloc();
+            vChunks.push_back(pchunk);
+            nPoolBytes += nChunkNodes * sizeof(Node);
+            for (size_t i = nChunkNodes; i > 0; i--) {
+                pchunk[i - 1].pnext = pfree;
+                pfree = &pchunk[i - 1];
+            }
+            if (nChunkNodes < MAX_CHUNK_NODES)
+                nChunkNodes *= 2;
+        }
+        Node* pnode = pfree;
+        pfree = pnode->pnext;
+        return pnode;
+    }
+
+    void FreeNode(Node* pnode)
+    {
+        pnode->get().~value_type();
+        pnode->pnext = pfree;
+        pfree = pnode;
+    }
+
+    /** Never SLOT_EMPTY or SLOT_DELETED, so those can mark the slots without a node. */
+    size_t Hash(const K& key) const
+    {
+        size_t nHash = hasher(key);
+        return nHash <= SLOT_DELETED ? nHash + 2 : nHash;
+    }
+
+    /** Slot of the key, or nSlots if it is not in the map. */
+    size_t Find(const K& key, size_t nHash) const
+    {
+        if (nSize == 0)
+            return nSlots;
+        const size_t nMask = nSlots - 1;
+        for (size_t i = nHash & nMask; ; i = (i + 1) & nMask) {
+            const Slot& slot = slots[i];
+            if (slot.pnode == NULL) {
+                if (slot.nHash == SLOT_EMPTY)
+                    return nSlots;
+            } else if (slot.nHash == nHash && slot.pnode->get().first == key) {
+                return i;
+            }
+        }
+    }
+
+    /** Slot for a key that is not in the map, reusing the first tombstone on the way. */
+    size_t FindFree(size_t nHash) const
+    {
+        const size_t nMask = nSlots - 1;
+        for (size_t i = nHash & nMask; ; i = (i + 1) & nMask)
+            if (slots[i].pnode == NULL)
+                return i;
+    }
+
+    void Rehash(size_t nSlotsNew)
+    {
+        Slot* slotsOld = slots;
+        size_t nSlotsOld = nSlots;
+        slots = static_cast<Slot*>(calloc(nSlotsNew, sizeof(Slot)));
+        if (slots == NULL) {
+            slots = slotsOld;
+            throw std::bad_alloc();
+        }
+        nSlots = nSlotsNew;
+        nDeleted = 0;
+        for (size_t i = 0; i < nSlotsOld; i++) {
+            if (slotsOld[i].pnode != NULL)
+                slots[FindFree(slotsOld[i].nHash)] = slotsOld[i];
+        }
+        free(slotsOld);
+    }
+
+    /** Makes room for one more entry. */
+    void Grow()
+    {
+        if ((nSize + nDeleted + 1) * 4 <= nSlots * 3)
+            return;
+        size_t nSlotsNew = nSlots == 0 ? MIN_SLOTS : nSlots;
+        // mostly tombstones: clean up at the same size
+        while ((nSize + 1) * 2 > nSlotsNew)
+            nSlotsNew *= 2;
+        Rehash(nSlotsNew);
+    }
+
+    void EraseSlot(size_t i)
+    {
+        FreeNode(slots[i].pnode);
+        slots[i].pnode = NULL;
+        // a tombstone is only needed if a probe could continue past this slot
+        if (slots[(i + 1) & (nSlots - 1)].pnode == NULL && slots[(i + 1) & (nSlots - 1)].nHash == SLOT_EMPTY) {
+            slots[i].nHash = SLOT_EMPTY;
+        } else {
+            slots[i].nHash = SLOT_DELETED;
+            nDeleted++;
+        }
+        nSize--;
+    }
+
+    template<typename P, typename R>
+    class iterator_base
+    {
+        friend class flathashmap;
+
+    private:
+        P pmap;
+        size_t nSlot;
+        Node* pnode;
+
+        iterator_base(P pmapIn, size_t nSlotIn) : pmap(pmapIn), nSlot(nSlotIn), pnode(NULL)
+        {
+            Skip();
+        }
+
+        void Skip()
+        {
+            while (nSlot < pmap->nSlots && pmap->slots[nSlot].pnode == NULL)
+                nSlot++;
+            pnode = nSlot < pmap->nSlots ? pmap->slots[nSlot].pnode : NULL;
+        }
+
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename flathashmap::value_type value_type;
+        typedef ptrdiff_t difference_type;
+        typedef R* pointer;
+        typedef R& reference;
+
+        iterator_base() : pmap(NULL), nSlot(0), pnode(NULL) {}
+        template<typename P2, typename R2>
+        iterator_base(const iterator_base<P2, R2>& it) : pmap(it.pmap), nSlot(it.nSlot), pnode(it.pnode) {}
+
+        R& operator*() const { return pnode->get(); }
+        R* operator->() const { return &pnode->get(); }
+        iterator_base& operator++() { nSlot++; Skip(); return *this; }
+        iterator_base operator++(int) { iterator_base copy(*this); ++(*this); return copy; }
+        bool operator==(const iterator_base& it) const { return pnode == it.pnode; }
+        bool operator!=(const iterator_base& it) const { return pnode != it.pnode; }
+
+        template<typename P2, typename R2> friend class iterator_base;
+    };
+
+public:
+    typedef iterator_base<flathashmap*, value_type> iterator;
+    typedef iterator_base<const flathashmap*, const value_type> const_iterator;
+
+    explicit flathashmap(const Hasher& hasherIn = Hasher()) :
+        hasher(hasherIn), slots(NULL), nSlots(0), nSize(0), nDeleted(0), pfree(NULL), nChunkNodes(MIN_CHUNK_NODES), nPoolBytes(0) {}
+
+    flathashmap(const flathashmap& other) :
+        hasher(other.hasher), slots(NULL), nSlots(0), nSize(0), nDeleted(0), pfree(NULL), nChunkNodes(MIN_CHUNK_NODES), nPoolBytes(0)
+    {
+        for (const_iterator it = other.begin(); it != other.end(); ++it)
+            insert(*it);
+    }
+
+    flathashmap& operator=(const flathashmap& other)
+    {
+        if (this != &other) {
+            clear();
+            hasher = other.hasher;
+            for (const_iterator it = other.begin(); it != other.end(); ++it)
+                insert(*it);
+        }
+        return *this;
+    }
+
+    ~flathashmap()
+    {
+        clear();
+    }
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, nSlots); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, nSlots); }
+
+    size_t size() const { return nSize; }
+    bool empty() const { return nSize == 0; }
+    size_t bucket_count() const { return nSlots; }
+
+    /** Bytes of the slot table and of the node chunks, for memory usage accounting. */
+    size_t table_bytes() const { return nSlots * sizeof(Slot); }
+    size_t pool_bytes() const { return nPoolBytes; }
+
+    iterator find(const K& key)
+    {
+        size_t i = Find(key, Hash(key));
+        return i == nSlots ? end() : iterator(this, i);
+    }
+
+    const_iterator find(const K& key) const
+    {
+        size_t i = Find(key, Hash(key));
+        return i == nSlots ? end() : const_iterator(this, i);
+    }
+
+    size_t count(const K& key) const
+    {
+        return Find(key, Hash(key)) == nSlots ? 0 : 1;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value)
+    {
+        size_t nHash = Hash(value.first);
+        size_t i = Find(value.first, nHash);
+        if (i != nSlots)
+            return std::make_pair(iterator(this, i), false);
+        Grow();
+        i = FindFree(nHash);
+        Node* pnode = AllocNode();
+        try {
+            new (&pnode->value) value_type(value);
+        } catch (...) {
+            pnode->pnext = pfree;
+            pfree = pnode;
+            throw;
+        }
+        if (slots[i].nHash == SLOT_DELETED)
+            nDeleted--;
+        slots[i].nHash = nHash;
+        slots[i].pnode = pnode;
+        nSize++;
+        return std::make_pair(iterator(this, i), true);
+    }
+
+    V& operator[](const K& key)
+    {
+        return insert(value_type(key, V())).first->second;
+    }
+
+    void erase(iterator it)
+    {
+        // the map may have grown since the iterator was taken, the node did not move
+        size_t i = it.nSlot;
+        if (i >= nSlots || slots[i].pnode != it.pnode)
+            i = Find(it->first, Hash(it->first));
+        assert(i != nSlots);
+        EraseSlot(i);
+    }
+
+    size_t erase(const K& key)
+    {
+        size_t i = Find(key, Hash(key));
+        if (i == nSlots)
+            return 0;
+        EraseSlot(i);
+        return 1;
+    }
+
+    /** Destroys all entries and gives the table and the chunks back. */
+    void clear()
+    {
+        for (size_t i = 0; i < nSlots; i++)
+            if (slots[i].pnode != NULL)
+                slots[i].pnode->get().~value_type();
+        free(slots);
+        slots = NULL;
+        nSlots = nSize = nDeleted = 0;
+        for (size_t i = 0; i < vChunks.size(); i++)
+            free(vChunks[i]);
+        vChunks.clear();
+        pfree = NULL;
+        nChunkNodes = MIN_CHUNK_NODES;
+        nPoolBytes = 0;
+    }
+
+    /** Sizes the table for n entries, so filling it does not grow it on the way. */
+    void reserve(size_t n)
+    {
+        size_t nSlotsNew = nSlots == 0 ? MIN_SLOTS : nSlots;
+        while (n * 4 > nSlotsNew * 3)
+            nSlotsNew *= 2;
+        if (nSlotsNew > nSlots)
+            Rehash(nSlotsNew);
+    }
+
+    void swap(flathashmap& other)
+    {
+        std::swap(hasher, other.hasher);
+        std::swap(slots, other.slots);
+        std::swap(nSlots, other.nSlots);
+        std::swap(nSize, other.nSize);
+        std::swap(nDeleted, other.nDeleted);
+        vChunks.swap(other.vChunks);
+        std::swap(pfree, other.pfree);
+        std::swap(nChunkNodes, other.nChunkNodes);
+        std::swap(nPoolBytes, other.nPoolBytes);
+    }
+};
+
+#endif // BITCOIN_FLATHASHMAP_H
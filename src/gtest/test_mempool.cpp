@@ -285,3 +285,44 @@ TEST(Mempool, SproutNegativeVersionTxWhenOverwinterActive) {
     // Revert to default
     UpdateNetworkUpgradeParameters(Consensus::UPGRADE_OVERWINTER, Consensus::NetworkUpgrade::NO_ACTIVATION_HEIGHT);
 }
+
+TEST(Mempool, CandidateUpdates) {
+    CTxMemPool pool(CFeeRate(0));
+    CMutableTransaction mtx1 = GetValidTransaction();
+    CMutableTransaction mtx2 = GetValidTransaction();
+    mtx2.nLockTime = 1;
+    CTransaction tx1(mtx1), tx2(mtx2);
+
+    // nothing tracked before the first call, which asks for a full scan
+    std::set<uint256> updates;
+    bool fReset = false;
+    pool.addUnchecked(tx1.GetHash(), CTxMemPoolEntry(tx1, 0, 0, 0.0, 1, true, false, SPROUT_BRANCH_ID));
+    pool.GetCandidateUpdates(updates, fReset);
+    EXPECT_TRUE(fReset);
+    EXPECT_TRUE(updates.empty());
+
+    pool.addUnchecked(tx2.GetHash(), CTxMemPoolEntry(tx2, 0, 0, 0.0, 1, true, false, SPROUT_BRANCH_ID));
+    std::list<CTransaction> removed;
+    pool.remove(tx1, removed);
+    pool.GetCandidateUpdates(updates, fReset);
+    EXPECT_FALSE(fReset);
+    EXPECT_EQ(updates.size(), 2);
+    EXPECT_EQ(updates.count(tx1.GetHash()), 1);
+    EXPECT_EQ(updates.count(tx2.GetHash()), 1);
+
+    pool.PrioritiseTransaction(tx2.GetHash(), tx2.GetHash().ToString(), 1.0, 1000);
+    pool.GetCandidateUpdates(updates, fReset);
+    EXPECT_FALSE(fReset);
+    EXPECT_EQ(updates.size(), 1);
+
+    pool.PrioritiseTransaction(tx2.GetHash(), tx2.GetHash().ToString(), 1.0, 1000);
+    pool.ResetCandidateUpdates();
+    pool.GetCandidateUpdates(updates, fReset);
+    EXPECT_TRUE(fReset);
+    EXPECT_TRUE(updates.empty());
+
+    pool.clear();
+    pool.GetCandidateUpdates(updates, fReset);
+    EXPECT_TRUE(fReset);
+    EXPECT_TRUE(updates.empty());
+}
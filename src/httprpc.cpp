@@ -31,6 +31,9 @@
 // WWW-Authenticate to present with 401 Unauthorized response
 static const char *WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
 
+// Streamed replies are sent in chunks of at least this size
+static const size_t RPC_STREAM_CHUNK_SIZE = 64 * 1024;
+
 /** Simple one-shot callback timer to be used by the RPC mechanism to e.g.
  * re-lock the wallet.
  */
@@ -102,6 +105,49 @@ static bool RPCAuthorized(const std::string& strAuth)
     return TimingResistantEqual(strUserPass, strRPCUserColonPass);
 }
 
+/**
+ * Reply to a single request of a streaming command, the result is sent as a chunked reply while
+ * it is written. A result smaller than one chunk is sent as a normal reply.
+ * An error before the first chunk is thrown as usual, after it the reply can only be cut short.
+ */
+static void JSONRPCStreamReply(HTTPRequest* req, const JSONRequest& jreq)
+{
+    bool fStarted = false;
+    TextJSONStream out(RPC_STREAM_CHUNK_SIZE, [req, &fStarted](const std::string& chunk) {
+        if (!fStarted) {
+            req->WriteHeader("Content-Type", "application/json");
+            req->StartChunkedReply(HTTP_OK);
+            fStarted = true;
+        }
+        if (!req->WriteReplyChunk(chunk))
+            throw std::runtime_error("client closed the connection");
+    });
+
+    // same text as JSONRPCReply
+    out.Raw("{\"result\":");
+    try {
+        tableRPC.executeStream(jreq.strMethod, jreq.params, out);
+        out.Raw(",\"error\":null,\"id\":" + jreq.id.write() + "}\n");
+        if (fStarted)
+            out.Flush();
+    } catch (const UniValue& objError) {
+        if (!fStarted)
+            throw;
+        LogPrintf("%s: %s reply cut short: %s\n", __func__, jreq.strMethod, objError.write());
+    } catch (const std::exception& e) {
+        if (!fStarted)
+            throw;
+        LogPrintf("%s: %s reply cut short: %s\n", __func__, jreq.strMethod, e.what());
+    }
+
+    if (fStarted) {
+        req->EndChunkedReply();
+    } else {
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, out.Buffered());
+    }
+}
+
 static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 {
     // JSONRPC handles only POST
@@ -151,6 +197,11 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
                 return false;
             }
 
+            if (tableRPC.hasStream(jreq.strMethod)) {
+                JSONRPCStreamReply(req, jreq);
+                return true;
+            }
+
             UniValue result = tableRPC.execute(jreq.strMethod, jreq.params);
 
             // Send reply
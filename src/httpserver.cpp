@@ -552,11 +552,17 @@ void HTTPEvent::trigger(struct timeval* tv)
         evtimer_add(ev, tv); // trigger after timeval passed
 }
 HTTPRequest::HTTPRequest(struct evhttp_request* req) : req(req),
+                                                       chunkedCloseArg(NULL),
+                                                       chunkedReply(false),
                                                        replySent(false)
 {
 }
 HTTPRequest::~HTTPRequest()
 {
+    if (chunkedReply) {
+        // a handler that threw in the middle of a chunked reply, the client gets a truncated body
+        EndChunkedReply();
+    }
     if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
@@ -635,6 +641,80 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = 0; // transferred back to main thread
 }
 
+static void http_chunked_close_cb(struct evhttp_connection*, void* arg)
+{
+    // the connection and its requests are freed after this, the pending chunk events check the flag
+    ((std::shared_ptr<std::atomic<bool>>*)arg)->get()->store(true);
+}
+
+void HTTPRequest::StartChunkedReply(int nStatus)
+{
+    assert(!replySent && req);
+    chunkedClosed = std::make_shared<std::atomic<bool>>(false);
+    chunkedCloseArg = new std::shared_ptr<std::atomic<bool>>(chunkedClosed);
+    auto req_copy = req;
+    auto arg = chunkedCloseArg;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, nStatus, arg]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn)
+            evhttp_connection_set_closecb(conn, http_chunked_close_cb, arg);
+        evhttp_send_reply_start(req_copy, nStatus, (const char*)NULL);
+    });
+    ev->trigger(0);
+    replySent = true;
+    chunkedReply = true;
+}
+
+bool HTTPRequest::WriteReplyChunk(const std::string& strChunk)
+{
+    assert(chunkedReply && req);
+    if (chunkedClosed->load())
+        return false;
+    auto req_copy = req;
+    auto closed = chunkedClosed;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, closed, strChunk]{
+        if (closed->load())
+            return;
+        struct evbuffer* evb = evbuffer_new();
+        evbuffer_add(evb, strChunk.data(), strChunk.size());
+        evhttp_send_reply_chunk(req_copy, evb);
+        evbuffer_free(evb);
+    });
+    ev->trigger(0);
+    return true;
+}
+
+void HTTPRequest::EndChunkedReply()
+{
+    assert(chunkedReply && req);
+    auto req_copy = req;
+    auto arg = chunkedCloseArg;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, arg]{
+        // a closed connection has run its close callback already and freed the request
+        bool closed = arg->get()->load();
+        evhttp_connection* conn = closed ? NULL : evhttp_request_get_connection(req_copy);
+        if (conn)
+            evhttp_connection_set_closecb(conn, NULL, NULL);
+        delete arg;
+        if (closed)
+            return;
+        evhttp_send_reply_end(req_copy);
+        // Re-enable reading from the socket, as in WriteReply.
+        if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+            if (conn) {
+                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+                if (bev) {
+                    bufferevent_enable(bev, EV_READ | EV_WRITE);
+                }
+            }
+        }
+    });
+    ev->trigger(0);
+    chunkedReply = false;
+    chunkedCloseArg = NULL;
+    req = 0; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer()
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -5,6 +5,8 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
+#include <atomic>
+#include <memory>
 #include <string>
 #include <stdint.h>
 #ifdef _WIN32
@@ -59,6 +61,11 @@ class HTTPRequest
 {
 private:
     struct evhttp_request* req;
+    // set on the http thread when the connection of a chunked reply closes
+    std::shared_ptr<std::atomic<bool>> chunkedClosed;
+    // the close callback argument, owned by the http thread until the reply ends
+    std::shared_ptr<std::atomic<bool>>* chunkedCloseArg;
+    bool chunkedReply;
 
     // For test access
 protected:
@@ -118,6 +125,26 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     virtual void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a chunked HTTP reply instead of WriteReply, the body follows with WriteReplyChunk.
+     *
+     * @note Call WriteHeader before this. EndChunkedReply must be called at the end, the
+     * destructor does it when it was not.
+     */
+    void StartChunkedReply(int nStatus);
+
+    /**
+     * Send a part of the body of a chunked reply.
+     * Returns false once the client has closed the connection, the rest of the reply can be
+     * skipped then.
+     */
+    bool WriteReplyChunk(const std::string& strChunk);
+
+    /**
+     * End a chunked reply, this gives the request back to the main thread like WriteReply.
+     */
+    void EndChunkedReply();
 };
 
 /** Event handler closure.
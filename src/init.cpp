@@ -28,6 +28,7 @@
 #include "primitives/block.h"
 #include "addrman.h"
 #include "amount.h"
+#include "blockreader.h"
 #include "checkpoints.h"
 #include "compat/sanity.h"
 #include "consensus/upgrades.h"
@@ -47,6 +48,7 @@
 #include "net.h"
 #include "rpc/server.h"
 #include "rpc/register.h"
+#include "script/sigcache.h"
 #include "script/standard.h"
 #include "scheduler.h"
 #include "txdb.h"
@@ -378,6 +380,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-alerts", strprintf(_("Receive and display P2P network alerts (default: %u)"), DEFAULT_ALERTS));
     strUsage += HelpMessageOpt("-alertnotify=<cmd>", _("Execute command when a relevant alert is received or we see a really long fork (%s in cmd is replaced by message)"));
     strUsage += HelpMessageOpt("-blocknotify=<cmd>", _("Execute command when the best block changes (%s in cmd is replaced by block hash)"));
+    strUsage += HelpMessageOpt("-blockreaderthreads=<n>", strprintf(_("Set the number of threads reading blocks ahead during -reindex and -rescan, 0 reads them on the validating thread (default: %d)"), DEFAULT_BLOCK_READER_THREADS));
     strUsage += HelpMessageOpt("-checkblocks=<n>", strprintf(_("How many blocks to check at startup (default: %u, 0 = all)"), 288));
     strUsage += HelpMessageOpt("-checklevel=<n>", strprintf(_("How thorough the block verification of -checkblocks is (0-4, default: %u)"), 3));
     strUsage += HelpMessageOpt("-clientname=<SomeName>", _("Full node client name, default 'MagicBean'"));
@@ -391,6 +394,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-datadir=<dir>", _("Specify data directory"));
     strUsage += HelpMessageOpt("-exportdir=<dir>", _("Specify directory to be used when exporting data"));
     strUsage += HelpMessageOpt("-dbcache=<n>", strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), nMinDbCache, nMaxDbCache, nDefaultDbCache));
+    strUsage += HelpMessageOpt("-indexdbcache=<index>:<n>", _("Set the cache size in megabytes of an index database (txindex, address, spent, timestamp or cc) instead of its share of -dbcache, can be specified multiple times"));
     strUsage += HelpMessageOpt("-loadblock=<file>", _("Imports blocks from external blk000??.dat file") + " " + _("on startup"));
     strUsage += HelpMessageOpt("-maxorphantx=<n>", strprintf(_("Keep at most <n> unconnectable transactions in memory (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS));
     strUsage += HelpMessageOpt("-mempooltxinputlimit=<n>", _("[DEPRECATED FROM OVERWINTER] Set the maximum number of transparent inputs in a transaction that the mempool will accept (default: 0 = no limit applied)"));
@@ -409,7 +413,12 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-txindex", strprintf(_("Maintain a full transaction index, used by the getrawtransaction rpc call (default: %u)"), 0));
     strUsage += HelpMessageOpt("-addressindex", strprintf(_("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses (default: %u)"), DEFAULT_ADDRESSINDEX));
     strUsage += HelpMessageOpt("-timestampindex", strprintf(_("Maintain a timestamp index for block hashes, used to query blocks hashes by a range of timestamps (default: %u)"), DEFAULT_TIMESTAMPINDEX));
+    strUsage += HelpMessageOpt("-addressbalanceindex", strprintf(_("Maintain the balance of every address and a rich list ranking, used by the getsnapshot and getaddressrank rpc calls and the payments snapshot, requires -addressindex (default: %u)"), DEFAULT_ADDRESSBALANCEINDEX));
     strUsage += HelpMessageOpt("-spentindex", strprintf(_("Maintain a full spent index, used to query the spending txid and input index for an outpoint (default: %u)"), DEFAULT_SPENTINDEX));
+    strUsage += HelpMessageOpt("-ccbatonindex", strprintf(_("Maintain an index of cc baton chain tips (agreements, token tags, oracles, asset orders, channels), used by cc rpc calls (default: %u)"), DEFAULT_CCBATONINDEX));
+    strUsage += HelpMessageOpt("-oracledataindex", strprintf(_("Maintain a time series of the data samples of every oracle publisher, used by the oraclessamples and oraclesseries rpc calls (default: %u)"), DEFAULT_ORACLEDATAINDEX));
+    strUsage += HelpMessageOpt("-rewardsindex", strprintf(_("Maintain an index of the unspent funding and locked deposits of every rewards plan, used by the rewards rpc calls (default: %u)"), DEFAULT_REWARDSINDEX));
+    strUsage += HelpMessageOpt("-heirindex", strprintf(_("Maintain the state of every heir plan, used by the heirinfo rpc call (default: %u)"), DEFAULT_HEIRINDEX));
     strUsage += HelpMessageGroup(_("Connection options:"));
     strUsage += HelpMessageOpt("-addnode=<ip>", _("Add a node to connect to and attempt to keep the connection open"));
     strUsage += HelpMessageOpt("-asmap=<file>", strprintf("Specify asn mapping used for bucketing of the peers (default: %s). Relative paths will be prefixed by the net-specific datadir location.", DEFAULT_ASMAP_FILENAME));
@@ -512,7 +521,8 @@ std::string HelpMessage(HelpMessageMode mode)
     {
         strUsage += HelpMessageOpt("-limitfreerelay=<n>", strprintf("Continuously rate-limit free transactions to <n>*1000 bytes per minute (default: %u)", 15));
         strUsage += HelpMessageOpt("-relaypriority", strprintf("Require high priority for relaying free or low-fee transactions (default: %u)", 0));
-        strUsage += HelpMessageOpt("-maxsigcachesize=<n>", strprintf("Limit size of signature cache to <n> entries (default: %u)", 50000));
+        strUsage += HelpMessageOpt("-sigcachesize=<n>", strprintf("Limit size of signature cache to <n> MiB (default: %u)", DEFAULT_MAX_SIG_CACHE_SIZE));
+        strUsage += HelpMessageOpt("-ccsigcachesize=<n>", strprintf("Limit size of the cryptocondition signature cache to <n> MiB (default: %u)", DEFAULT_MAX_CC_SIG_CACHE_SIZE));
         strUsage += HelpMessageOpt("-maxtipage=<n>", strprintf("Maximum tip age in seconds to consider node in initial block download (default: %u)", DEFAULT_MAX_TIP_AGE));
     }
     strUsage += HelpMessageOpt("-minrelaytxfee=<amt>", strprintf(_("Fees (in %s/kB) smaller than this are considered zero fee for relaying (default: %s)"),
@@ -569,6 +579,8 @@ std::string HelpMessage(HelpMessageMode mode)
         strUsage += HelpMessageOpt("-rpcworkqueue=<n>", strprintf("Set the depth of the work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE));
         strUsage += HelpMessageOpt("-rpcservertimeout=<n>", strprintf("Timeout during HTTP requests (default: %d)", DEFAULT_HTTP_SERVER_TIMEOUT));
     }
+    strUsage += HelpMessageOpt("-rpcbatchthreads=<n>", strprintf(_("Set the number of threads answering the requests of JSON-RPC batches made only of read-only lookups, 0 answers them in order on the RPC thread (default: %d)"), DEFAULT_RPC_BATCH_THREADS));
+    strUsage += HelpMessageOpt("-rpcbatchconcurrency=<n>", strprintf(_("Set the maximum number of threads answering one JSON-RPC batch (default: %d)"), DEFAULT_RPC_BATCH_CONCURRENCY));
 
     // Disabled until we can lock notes and also tune performance of libsnark which by default uses multiple threads
     //strUsage += HelpMessageOpt("-rpcasyncthreads=<n>", strprintf(_("Set the number of threads to service Async RPC calls (default: %d)"), 1));
@@ -694,8 +706,9 @@ void ThreadImport(std::vector<boost::filesystem::path> vImportFiles)
             FILE *file = OpenBlockFile(pos, true);
             if (!file)
                 break; // This error is logged in OpenBlockFile
+            fclose(file);
             LogPrintf("Reindexing block file blk%05u.dat...\n", (unsigned int)nFile);
-            LoadExternalBlockFile(file, &pos);
+            ReindexBlockFile(nFile);
             nFile++;
         }
         pblocktree->WriteReindexing(false);
@@ -1146,6 +1159,12 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     if (GetBoolArg("-benchmark", false))
         InitWarning(_("Warning: Unsupported argument -benchmark ignored, use -debug=bench."));
 
+    // the signature caches used to be sized in entries, don't read an old entry count as megabytes
+    if (mapArgs.count("-maxsigcachesize"))
+        InitWarning(_("Warning: Unsupported argument -maxsigcachesize ignored, it was a number of entries, use -sigcachesize=<MiB>."));
+    if (mapArgs.count("-maxservercheckersize"))
+        InitWarning(_("Warning: Unsupported argument -maxservercheckersize ignored, use -ccsigcachesize=<MiB>."));
+
     // Checkmempool and checkblockindex default to true in regtest mode
     int ratio = std::min<int>(std::max<int>(GetArg("-checkmempool", chainparams.DefaultConsistencyChecks() ? 1 : 0), 0), 1000000);
     if (ratio != 0) {
@@ -1399,6 +1418,8 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
     LogPrintf("Using at most %i connections (%i file descriptors available)\n", nMaxConnections, nFD);
     std::ostringstream strErrors;
 
+    InitSignatureCache();
+
     LogPrintf("Using %u threads for script verification\n", nScriptCheckThreads);
     if (nScriptCheckThreads) {
         for (int i=0; i<nScriptCheckThreads-1; i++)
@@ -1648,19 +1669,59 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
         }
     }
     nTotalCache -= nBlockTreeDBCache;
+
+    // the indexes have their own databases, the block index keeps an eighth of the share when any is
+    // enabled and the enabled ones split the rest by how much they are written during sync
+    CIndexDBCaches indexDBCaches;
+    int nIndexDBWeight[INDEXDB_COUNT] = {0}, nIndexDBWeights = 0;
+    nIndexDBWeight[INDEXDB_TX] = GetBoolArg("-txindex", true) ? 2 : 0;
+    nIndexDBWeight[INDEXDB_ADDRESS] = GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) ? 4 : 0;
+    nIndexDBWeight[INDEXDB_SPENT] = GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) ? 2 : 0;
+    nIndexDBWeight[INDEXDB_TIMESTAMP] = GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX) ? 1 : 0;
+    nIndexDBWeight[INDEXDB_CC] = (GetBoolArg("-unspentccindex", false) || GetBoolArg("-ccbatonindex", DEFAULT_CCBATONINDEX) ||
+                                  GetBoolArg("-oracledataindex", DEFAULT_ORACLEDATAINDEX) || GetBoolArg("-rewardsindex", DEFAULT_REWARDSINDEX) ||
+                                  GetBoolArg("-heirindex", DEFAULT_HEIRINDEX)) ? 1 : 0;
+    for (int i = 0; i < INDEXDB_COUNT; i++)
+        nIndexDBWeights += nIndexDBWeight[i];
+    if (nIndexDBWeights > 0) {
+        int64_t nIndexDBCache = nBlockTreeDBCache - nBlockTreeDBCache / 8;
+        nBlockTreeDBCache -= nIndexDBCache;
+        for (int i = 0; i < INDEXDB_COUNT; i++) {
+            if (nIndexDBWeight[i] == 0)
+                continue;
+            size_t nCache = std::max(nIndexDBCache * nIndexDBWeight[i] / nIndexDBWeights, (int64_t)1 << 20);
+            // the address and spent indexes take most writes, larger write buffers mean fewer level 0 compactions
+            bool fWriteHeavy = i == INDEXDB_ADDRESS || i == INDEXDB_SPENT;
+            indexDBCaches[i] = CIndexDBCache(nCache, fWriteHeavy ? nCache / 2 : 0);
+        }
+    }
+    for (const std::string &strIndexDBCache : mapMultiArgs["-indexdbcache"]) {
+        std::vector<std::string> vParams;
+        boost::split(vParams, strIndexDBCache, boost::is_any_of(":"));
+        int64_t nCache = 0;
+        int i = 0;
+        while (i < INDEXDB_COUNT && (vParams.size() != 2 || vParams[0] != IndexDBName((IndexDBType)i)))
+            i++;
+        if (i == INDEXDB_COUNT || !ParseInt64(vParams[1], &nCache) || nCache < nMinDbCache || nCache > nMaxDbCache)
+            return InitError(strprintf(_("Invalid -indexdbcache=<index>:<n>: '%s'"), strIndexDBCache));
+        indexDBCaches[i] = CIndexDBCache(nCache << 20, 0);
+    }
+
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nTotalCache -= nCoinDBCache;
     nCoinCacheUsage = nTotalCache; // the rest goes to in-memory cache
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Max cache setting possible %.1fMiB\n", nMaxDbCache);
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
+    for (int i = 0; i < INDEXDB_COUNT; i++)
+        LogPrintf("* Using %.1fMiB for %s index database\n", indexDBCaches[i].nCacheSize * (1.0 / 1024 / 1024), IndexDBName((IndexDBType)i));
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set\n", nCoinCacheUsage * (1.0 / 1024 / 1024));
 
     if ( fReindex == 0 )
     {
-        bool checkval, fAddressIndex, fSpentIndex, fUnspentCCIndexTmp;
-        pblocktree = new CBlockTreeDB(nBlockTreeDBCache, false, fReindex, dbCompression, dbMaxOpenFiles);
+        bool checkval, fAddressIndex, fSpentIndex, fUnspentCCIndexTmp, fCCBatonIndexTmp, fOracleDataIndexTmp, fRewardsIndexTmp, fHeirIndexTmp, fAddressBalanceIndexTmp;
+        pblocktree = new CBlockTreeDB(nBlockTreeDBCache, false, fReindex, dbCompression, dbMaxOpenFiles, indexDBCaches);
         fAddressIndex = GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
         checkval = false;  // need to reinit checkval otherwise it might be undefined if ReadFlag returns false
         pblocktree->ReadFlag("addressindex", checkval);
@@ -1689,6 +1750,56 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
             fprintf(stderr,"set unspentccindex, will reindex. could take a while.\n");
             fReindex = true;
         }
+
+        fCCBatonIndexTmp = GetBoolArg("-ccbatonindex", DEFAULT_CCBATONINDEX);
+        checkval = false;
+        pblocktree->ReadFlag("ccbatonindex", checkval);
+        if ( checkval != fCCBatonIndexTmp && fCCBatonIndexTmp != 0 )
+        {
+            pblocktree->WriteFlag("ccbatonindex", fCCBatonIndexTmp);
+            fprintf(stderr,"set ccbatonindex, will reindex. could take a while.\n");
+            fReindex = true;
+        }
+
+        fOracleDataIndexTmp = GetBoolArg("-oracledataindex", DEFAULT_ORACLEDATAINDEX);
+        checkval = false;
+        pblocktree->ReadFlag("oracledataindex", checkval);
+        if ( checkval != fOracleDataIndexTmp && fOracleDataIndexTmp != 0 )
+        {
+            pblocktree->WriteFlag("oracledataindex", fOracleDataIndexTmp);
+            fprintf(stderr,"set oracledataindex, will reindex. could take a while.\n");
+            fReindex = true;
+        }
+
+        fRewardsIndexTmp = GetBoolArg("-rewardsindex", DEFAULT_REWARDSINDEX);
+        checkval = false;
+        pblocktree->ReadFlag("rewardsindex", checkval);
+        if ( checkval != fRewardsIndexTmp && fRewardsIndexTmp != 0 )
+        {
+            pblocktree->WriteFlag("rewardsindex", fRewardsIndexTmp);
+            fprintf(stderr,"set rewardsindex, will reindex. could take a while.\n");
+            fReindex = true;
+        }
+
+        fHeirIndexTmp = GetBoolArg("-heirindex", DEFAULT_HEIRINDEX);
+        checkval = false;
+        pblocktree->ReadFlag("heirindex", checkval);
+        if ( checkval != fHeirIndexTmp && fHeirIndexTmp != 0 )
+        {
+            pblocktree->WriteFlag("heirindex", fHeirIndexTmp);
+            fprintf(stderr,"set heirindex, will reindex. could take a while.\n");
+            fReindex = true;
+        }
+
+        fAddressBalanceIndexTmp = fAddressIndex && GetBoolArg("-addressbalanceindex", DEFAULT_ADDRESSBALANCEINDEX);
+        checkval = false;
+        pblocktree->ReadFlag("addressbalanceindex", checkval);
+        if ( checkval != fAddressBalanceIndexTmp && fAddressBalanceIndexTmp != 0 )
+        {
+            pblocktree->WriteFlag("addressbalanceindex", fAddressBalanceIndexTmp);
+            fprintf(stderr,"set addressbalanceindex, will reindex. could take a while.\n");
+            fReindex = true;
+        }
     }
 
     bool clearWitnessCaches = false;
@@ -1710,7 +1821,7 @@ bool AppInit2(boost::thread_group& threadGroup, CScheduler& scheduler)
                 delete pblocktree;
                 delete pnotarisations;
 
-                pblocktree = new CBlockTreeDB(nBlockTreeDBCache, false, fReindex, dbCompression, dbMaxOpenFiles);
+                pblocktree = new CBlockTreeDB(nBlockTreeDBCache, false, fReindex, dbCompression, dbMaxOpenFiles, indexDBCaches);
                 pcoinsdbview = new CCoinsViewDB(nCoinDBCache, false, fReindex);
                 pcoinscatcher = new CCoinsViewErrorCatcher(pcoinsdbview);
                 pcoinsTip = new CCoinsViewCache(pcoinscatcher);
@@ -51,6 +51,7 @@ uint256 NOTARIZED_HASH,NOTARIZED_DESTTXID;
 #include "komodo_notary.h"
 
 int32_t komodo_parsestatefile(struct komodo_state *sp,FILE *fp,char *symbol,char *dest);
+void komodo_snapshot_addratify(int32_t height,uint8_t num,uint8_t pubkeys[64][33]);
 #include "komodo_kv.h"
 #include "komodo_jumblr.h"
 #include "komodo_gateway.h"
@@ -353,10 +354,12 @@ int32_t komodo_parsestatefiledata(struct komodo_state *sp,uint8_t *filedata,long
     return(-1);
 }
 
+#include "komodo_statesnapshot.h"
+
 void komodo_stateupdate(int32_t height,uint8_t notarypubs[][33],uint8_t numnotaries,uint8_t notaryid,uint256 txhash,uint64_t voutmask,uint8_t numvouts,uint32_t *pvals,uint8_t numpvals,int32_t KMDheight,uint32_t KMDtimestamp,uint64_t opretvalue,uint8_t *opretbuf,uint16_t opretlen,uint16_t vout,uint256 MoM,int32_t MoMdepth)
 {
-    static FILE *fp; static int32_t errs,didinit; static uint256 zero;
-    struct komodo_state *sp; char fname[512],symbol[KOMODO_ASSETCHAIN_MAXLEN],dest[KOMODO_ASSETCHAIN_MAXLEN]; int32_t retval,ht,func; uint8_t num,pubkeys[64][33];
+    static FILE *fp; static int32_t errs,didinit,lastsnapshot; static uint256 zero; static char fname[512];
+    struct komodo_state *sp; char symbol[KOMODO_ASSETCHAIN_MAXLEN],dest[KOMODO_ASSETCHAIN_MAXLEN]; int32_t retval,ht,func; int64_t snappos; uint8_t num,pubkeys[64][33];
     if ( didinit == 0 )
     {
         portable_mutex_init(&KOMODO_KV_mutex);
@@ -375,7 +378,15 @@ void komodo_stateupdate(int32_t height,uint8_t notarypubs[][33],uint8_t numnotar
         komodo_statefname(fname,ASSETCHAINS_SYMBOL,(char *)"komodostate");
         if ( (fp= fopen(fname,"rb+")) != 0 )
         {
-            if ( (retval= komodo_faststateinit(sp,fname,symbol,dest)) > 0 )
+            if ( (snappos= komodo_snapshot_load(sp,fp,fname,symbol)) >= 0 )
+            {
+                // only the records written after the snapshot need to be replayed
+                fseek(fp,snappos,SEEK_SET);
+                while ( komodo_parsestatefile(sp,fp,symbol,dest) >= 0 )
+                    ;
+                fseek(fp,0,SEEK_END);
+            }
+            else if ( (retval= komodo_faststateinit(sp,fname,symbol,dest)) > 0 )
                 fseek(fp,0,SEEK_END);
             else
             {
@@ -507,6 +518,12 @@ void komodo_stateupdate(int32_t height,uint8_t notarypubs[][33],uint8_t numnotar
             }
         }
         fflush(fp);
+        if ( height >= lastsnapshot+KOMODO_SNAPSHOT_INTERVAL && (height % KOMODO_SNAPSHOT_INTERVAL) == 0 && KOMODO_INITDONE != 0 )
+        {
+            if ( komodo_snapshot_write(sp,fp,fname,symbol) == 0 )
+                lastsnapshot = height;
+            else fprintf(stderr,"error writing komodostate snapshot ht.%d\n",height);
+        }
     }
 }
 
@@ -804,6 +821,22 @@ int32_t komodo_notarycmp(uint8_t *scriptPubKey,int32_t scriptlen,uint8_t pubkeys
     return(-1);
 }
 
+// true if any vout is one komodo_voutupdate looks at, a pay2pubkey or an OP_RETURN
+int32_t komodo_hasnotaryvouts(const CTransaction &tx)
+{
+    int32_t j,len; const uint8_t *script;
+    for (j=0; j<tx.vout.size(); j++)
+    {
+        len = tx.vout[j].scriptPubKey.size();
+        if ( len < sizeof(uint32_t) )
+            continue;
+        script = (const uint8_t *)&tx.vout[j].scriptPubKey[0];
+        if ( script[0] == 0x6a || (len == 35 && script[0] == 33 && script[34] == 0xac) )
+            return(1);
+    }
+    return(0);
+}
+
 // int32_t (!!!)
 /*
     read blackjok3rtt comments in main.cpp 
@@ -937,6 +970,8 @@ int32_t komodo_connectblock(bool fJustCheck, CBlockIndex *pindex,CBlock& block)
             }
             //if ( IS_KOMODO_NOTARY != 0 && ASSETCHAINS_SYMBOL[0] == 0 )
               //  printf("(tx.%d: ",i);
+            if ( komodo_hasnotaryvouts(block.vtx[i]) == 0 )
+                continue;
             for (j=0; j<numvouts; j++)
             {
                 /*if ( i == 0 && j == 0 )
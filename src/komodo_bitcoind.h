@@ -17,7 +17,9 @@
 
 #include <curl/curl.h>
 #include <curl/easy.h>
+#include <mutex>
 #include "primitives/nonce.h"
+#include "crypto/sha256.h"
 #include "consensus/params.h"
 #include "script/standard.h"
 #include "init.h"
@@ -1490,38 +1492,95 @@ int8_t komodo_segid(int32_t nocache,int32_t height)
     return(segid);
 }
 
+/**
+ * Fills hashbuf with the segids of n blocks starting at height.
+ * The 100 block window used by staking is cached and keyed by its start height and the hash of its last block:
+ * when the tip advances only the new blocks are loaded and the rest of the window is shifted,
+ * a reorg that replaces any block of the window invalidates it.
+ */
 void komodo_segids(uint8_t *hashbuf,int32_t height,int32_t n)
 {
-    static uint8_t prevhashbuf[100]; static int32_t prevheight;
-    int32_t i;
-    if ( height == prevheight && n == 100 )
-        memcpy(hashbuf,prevhashbuf,100);
-    else
+    static std::mutex segidsmtx; static uint8_t prevhashbuf[100]; static int32_t prevheight; static uint256 prevlasthash;
+    CBlockIndex *pindex; uint256 lasthash; int32_t i,shift;
+    if ( n != sizeof(prevhashbuf) || (pindex= komodo_chainactive(height+n-1)) == 0 )
     {
         memset(hashbuf,0xff,n);
         for (i=0; i<n; i++)
-        {
             hashbuf[i] = (uint8_t)komodo_segid(0,height+i);
-            //fprintf(stderr,"%02x ",hashbuf[i]);
-        }
-        if ( n == 100 )
-        {
-            memcpy(prevhashbuf,hashbuf,100);
-            prevheight = height;
-            //fprintf(stderr,"prevsegids.%d\n",height+n);
-        }
+        return;
     }
+    lasthash = pindex->GetBlockHash();
+    std::lock_guard<std::mutex> lock(segidsmtx);
+    if ( prevheight != 0 && height == prevheight && lasthash == prevlasthash )
+    {
+        memcpy(hashbuf,prevhashbuf,n);
+        return;
+    }
+    shift = height - prevheight;
+    if ( prevheight != 0 && shift > 0 && shift < n && (pindex= komodo_chainactive(prevheight+n-1)) != 0 && pindex->GetBlockHash() == prevlasthash )
+    {
+        // the cached window is still on the active chain, only the blocks connected since are new
+        memmove(prevhashbuf,&prevhashbuf[shift],n-shift);
+        for (i=n-shift; i<n; i++)
+            prevhashbuf[i] = (uint8_t)komodo_segid(0,height+i);
+    }
+    else
+    {
+        for (i=0; i<n; i++)
+            prevhashbuf[i] = (uint8_t)komodo_segid(0,height+i);
+    }
+    prevheight = height;
+    prevlasthash = lasthash;
+    memcpy(hashbuf,prevhashbuf,n);
+    //fprintf(stderr,"prevsegids.%d shift.%d\n",height+n,shift);
 }
 
+/**
+ * Per utxo memo of the part of the stake hash that does not depend on the chain: sha256(address) | txid | vout.
+ * Staking rounds recompute the stake hash of every wallet utxo for each new block, so this saves the address hashing.
+ */
+struct komodo_stakememo
+{
+    char address[64];
+    uint8_t utxobuf[sizeof(bits256) + sizeof(uint256) + sizeof(int32_t)];
+};
+
+#define KOMODO_STAKEMEMO_MAX 100000
+
 uint32_t komodo_stakehash(uint256 *hashp,char *address,uint8_t *hashbuf,uint256 txid,int32_t vout)
 {
-    bits256 addrhash;
-    vcalc_sha256(0,(uint8_t *)&addrhash,(uint8_t *)address,(int32_t)strlen(address));
-    memcpy(&hashbuf[100],&addrhash,sizeof(addrhash));
-    memcpy(&hashbuf[100+sizeof(addrhash)],&txid,sizeof(txid));
-    memcpy(&hashbuf[100+sizeof(addrhash)+sizeof(txid)],&vout,sizeof(vout));
-    vcalc_sha256(0,(uint8_t *)hashp,hashbuf,100 + (int32_t)sizeof(uint256)*2 + sizeof(vout));
-    return(addrhash.uints[0]);
+    static std::mutex memomtx; static std::map<COutPoint,komodo_stakememo> memos;
+    // midstate of the first sha256 block, which only holds segids and is shared by all utxos in a staking round
+    thread_local uint8_t midstatebuf[64]; thread_local CSHA256 midstate; thread_local bool midstatevalid = false;
+    komodo_stakememo memo; bits256 addrhash; uint32_t segid32;
+    {
+        std::lock_guard<std::mutex> lock(memomtx);
+        std::map<COutPoint,komodo_stakememo>::iterator it = memos.find(COutPoint(txid,vout));
+        if ( it != memos.end() && strcmp(it->second.address,address) == 0 )
+            memo = it->second;
+        else
+        {
+            vcalc_sha256(0,(uint8_t *)&addrhash,(uint8_t *)address,(int32_t)strlen(address));
+            strncpy(memo.address,address,sizeof(memo.address)-1);
+            memo.address[sizeof(memo.address)-1] = 0;
+            memcpy(memo.utxobuf,&addrhash,sizeof(addrhash));
+            memcpy(&memo.utxobuf[sizeof(addrhash)],&txid,sizeof(txid));
+            memcpy(&memo.utxobuf[sizeof(addrhash)+sizeof(txid)],&vout,sizeof(vout));
+            if ( memos.size() >= KOMODO_STAKEMEMO_MAX )
+                memos.clear();
+            memos[COutPoint(txid,vout)] = memo;
+        }
+    }
+    memcpy(&hashbuf[100],memo.utxobuf,sizeof(memo.utxobuf));
+    if ( midstatevalid == false || memcmp(midstatebuf,hashbuf,sizeof(midstatebuf)) != 0 )
+    {
+        memcpy(midstatebuf,hashbuf,sizeof(midstatebuf));
+        midstate.Reset().Write(midstatebuf,sizeof(midstatebuf));
+        midstatevalid = true;
+    }
+    CSHA256(midstate).Write(&hashbuf[sizeof(midstatebuf)],100 + sizeof(memo.utxobuf) - sizeof(midstatebuf)).Finalize((uint8_t *)hashp);
+    memcpy(&segid32,memo.utxobuf,sizeof(segid32));
+    return(segid32);
 }
 
 arith_uint256 komodo_adaptivepow_target(int32_t height,arith_uint256 bnTarget,uint32_t nTime)
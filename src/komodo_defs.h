@@ -700,6 +700,7 @@ uint64_t komodo_interest(int32_t txheight, uint64_t nValue, uint32_t nLockTime,
 bool komodo_dailysnapshot(int32_t height);
 void komodo_setactivation(int32_t height);
 void komodo_pricesupdate(int32_t height,CBlock *pblock);
+void prices_pricecacheinvalidate(int32_t height);
 void komodo_broadcast(CBlock *pblock,int32_t limit);
 int32_t komodo_block2pubkey33(uint8_t *pubkey33,CBlock *block);
 void komodo_event_rewind(struct komodo_state *sp,char *symbol,int32_t height);
@@ -72,7 +72,10 @@ void komodo_eventadd_pubkeys(struct komodo_state *sp,char *symbol,int32_t height
     memcpy(P.pubkeys,pubkeys,33 * num);
     komodo_eventadd(sp,height,symbol,KOMODO_EVENT_RATIFY,(uint8_t *)&P,(int32_t)(sizeof(P.num) + 33 * num));
     if ( sp != 0 )
+    {
         komodo_notarysinit(height,pubkeys,num);
+        komodo_snapshot_addratify(height,num,pubkeys);
+    }
 }
 
 void komodo_eventadd_pricefeed(struct komodo_state *sp,char *symbol,int32_t height,uint32_t *prices,uint8_t num)
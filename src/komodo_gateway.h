@@ -2684,6 +2684,8 @@ void komodo_pricesupdate(int32_t height,CBlock *pblock)
             pthread_mutex_unlock(&pricemutex);
         } else fprintf(stderr,"null PRICES[0].fp\n");
     } else fprintf(stderr,"numprices mismatch, height.%d\n",height);
+    // after the writes, so a price read before them can't be cached again
+    prices_pricecacheinvalidate(height);
 }
 
 int32_t komodo_priceget(int64_t *buf64,int32_t ind,int32_t height,int32_t numblocks)
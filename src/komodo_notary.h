@@ -19,6 +19,8 @@
 
 #include "notaries_staked.h"
 
+#include <atomic>
+
 #define KOMODO_MAINNET_START 178999
 #define KOMODO_NOTARIES_HEIGHT1 814000
 
@@ -87,20 +89,97 @@ int32_t getacseason(uint32_t timestamp)
     return(0);
 }
 
-int32_t komodo_notaries(uint8_t pubkeys[64][33],int32_t height,uint32_t timestamp)
+/**
+ * Notary sets are immutable once published. An election publishes a new set and swaps the pointers of the
+ * election periods it covers, so komodo_notaries, komodo_electednotary and komodo_chosennotary never take
+ * komodo_mutex. Sets are never freed because readers may still hold a replaced one, there are only a few per chain.
+ */
+#define KOMODO_NOTARYSET_SLOTS 128
+
+struct komodo_notaryset
+{
+    int32_t numnotaries;
+    uint8_t pubkeys[64][33];
+    int8_t slots[KOMODO_NOTARYSET_SLOTS]; // open addressing pubkey -> notaryid, -1 when empty
+};
+
+std::atomic<const struct komodo_notaryset *> Notarysets_elected[KOMODO_MAXBLOCKS / KOMODO_ELECTION_GAP];
+std::atomic<const struct komodo_notaryset *> Notarysets_season[NUM_KMD_SEASONS];
+
+static uint32_t komodo_notaryset_slot(const uint8_t *pubkey33)
+{
+    uint32_t h;
+    memcpy(&h,&pubkey33[1],sizeof(h)); // x coordinate bytes are already uniformly distributed
+    return(h % KOMODO_NOTARYSET_SLOTS);
+}
+
+int32_t komodo_notaryset_find(const struct komodo_notaryset *ns,const uint8_t *pubkey33)
+{
+    int32_t i,notaryid; uint32_t slot = komodo_notaryset_slot(pubkey33);
+    for (i=0; i<KOMODO_NOTARYSET_SLOTS; i++)
+    {
+        if ( (notaryid= ns->slots[(slot + i) % KOMODO_NOTARYSET_SLOTS]) < 0 )
+            break;
+        if ( memcmp(ns->pubkeys[notaryid],pubkey33,33) == 0 )
+            return(notaryid);
+    }
+    return(-1);
+}
+
+struct komodo_notaryset *komodo_notaryset_create(uint8_t pubkeys[64][33],int32_t num)
+{
+    struct komodo_notaryset *ns = new komodo_notaryset; int32_t k,i; uint32_t slot;
+    memset(ns,0,sizeof(*ns));
+    memset(ns->slots,0xff,sizeof(ns->slots));
+    ns->numnotaries = num;
+    memcpy(ns->pubkeys,pubkeys,33 * num);
+    for (k=0; k<num; k++)
+    {
+        if ( komodo_notaryset_find(ns,pubkeys[k]) >= 0 ) // duplicate pubkey resolves to its first notaryid
+            continue;
+        slot = komodo_notaryset_slot(pubkeys[k]);
+        for (i=0; ns->slots[(slot + i) % KOMODO_NOTARYSET_SLOTS] >= 0; i++)
+            ;
+        ns->slots[(slot + i) % KOMODO_NOTARYSET_SLOTS] = k;
+    }
+    return(ns);
+}
+
+const struct komodo_notaryset *komodo_seasonset(int32_t kmd_season)
+{
+    const struct komodo_notaryset *ns,*expected = 0; struct komodo_notaryset *created; uint8_t pubkeys[64][33]; int32_t i;
+    if ( (ns= Notarysets_season[kmd_season-1].load(std::memory_order_acquire)) != 0 )
+        return(ns);
+    for (i=0; i<NUM_KMD_NOTARIES; i++)
+        decode_hex(pubkeys[i],33,(char *)notaries_elected[kmd_season-1][i][1]);
+    if ( ASSETCHAINS_PRIVATE != 0 )
+    {
+        // this is PIRATE, we need to populate the address array for the notary exemptions.
+        for (i = 0; i<NUM_KMD_NOTARIES; i++)
+            pubkey2addr((char *)NOTARY_ADDRESSES[kmd_season-1][i],(uint8_t *)pubkeys[i]);
+    }
+    created = komodo_notaryset_create(pubkeys,NUM_KMD_NOTARIES);
+    if ( Notarysets_season[kmd_season-1].compare_exchange_strong(expected,created,std::memory_order_acq_rel) )
+        return(created);
+    delete created; // another thread published the same season first
+    return(expected);
+}
+
+uint32_t komodo_notarytimestamp(int32_t height,uint32_t timestamp)
 {
-    int32_t i,htind,n; uint64_t mask = 0; struct knotary_entry *kp,*tmp;
-    static uint8_t kmd_pubkeys[NUM_KMD_SEASONS][64][33],didinit[NUM_KMD_SEASONS];
-    
     if ( timestamp == 0 && ASSETCHAINS_SYMBOL[0] != 0 )
         timestamp = komodo_heightstamp(height);
     else if ( ASSETCHAINS_SYMBOL[0] == 0 )
         timestamp = 0;
+    return(timestamp);
+}
 
-    // If this chain is not a staked chain, use the normal Komodo logic to determine notaries. This allows KMD to still sync and use its proper pubkeys for dPoW.
+// returns the notary set for a non STAKED chain, timestamp must be normalized by komodo_notarytimestamp
+const struct komodo_notaryset *komodo_notaryset_get(int32_t height,uint32_t timestamp)
+{
+    int32_t htind,kmd_season = 0;
     if ( is_STAKED(ASSETCHAINS_SYMBOL) == 0 )
     {
-        int32_t kmd_season = 0;
         if ( ASSETCHAINS_SYMBOL[0] == 0 )
         {
             // This is KMD, use block heights to determine the KMD notary season.. 
@@ -113,34 +192,8 @@ int32_t komodo_notaries(uint8_t pubkeys[64][33],int32_t height,uint32_t timestam
             kmd_season = getacseason(timestamp);
         }
         if ( kmd_season != 0 )
-        {
-            if ( didinit[kmd_season-1] == 0 )
-            {
-                for (i=0; i<NUM_KMD_NOTARIES; i++) 
-                    decode_hex(kmd_pubkeys[kmd_season-1][i],33,(char *)notaries_elected[kmd_season-1][i][1]);
-                if ( ASSETCHAINS_PRIVATE != 0 )
-                {
-                    // this is PIRATE, we need to populate the address array for the notary exemptions. 
-                    for (i = 0; i<NUM_KMD_NOTARIES; i++)
-                        pubkey2addr((char *)NOTARY_ADDRESSES[kmd_season-1][i],(uint8_t *)kmd_pubkeys[kmd_season-1][i]);
-                }
-                didinit[kmd_season-1] = 1;
-            }
-            memcpy(pubkeys,kmd_pubkeys[kmd_season-1],NUM_KMD_NOTARIES * 33);
-            return(NUM_KMD_NOTARIES);
-        }
-    }
-    else if ( timestamp != 0 )
-    { 
-        // here we can activate our pubkeys for LABS chains everythig is in notaries_staked.cpp
-        int32_t staked_era; int8_t numSN;
-        uint8_t staked_pubkeys[64][33];
-        staked_era = STAKED_era(timestamp);
-        numSN = numStakedNotaries(staked_pubkeys,staked_era);
-        memcpy(pubkeys,staked_pubkeys,numSN * 33);
-        return(numSN);
+            return(komodo_seasonset(kmd_season));
     }
-
     htind = height / KOMODO_ELECTION_GAP;
     if ( htind >= KOMODO_MAXBLOCKS / KOMODO_ELECTION_GAP )
         htind = (KOMODO_MAXBLOCKS / KOMODO_ELECTION_GAP) - 1;
@@ -149,28 +202,44 @@ int32_t komodo_notaries(uint8_t pubkeys[64][33],int32_t height,uint32_t timestam
         komodo_init(height);
         //printf("Pubkeys.%p htind.%d vs max.%d\n",Pubkeys,htind,KOMODO_MAXBLOCKS / KOMODO_ELECTION_GAP);
     }
-    pthread_mutex_lock(&komodo_mutex);
-    n = Pubkeys[htind].numnotaries;
-    if ( 0 && ASSETCHAINS_SYMBOL[0] != 0 )
-        fprintf(stderr,"%s height.%d t.%u genesis.%d\n",ASSETCHAINS_SYMBOL,height,timestamp,n);
-    HASH_ITER(hh,Pubkeys[htind].Notaries,kp,tmp)
-    {
-        if ( kp->notaryid < n )
-        {
-            mask |= (1LL << kp->notaryid);
-            memcpy(pubkeys[kp->notaryid],kp->pubkey,33);
-        } else printf("illegal notaryid.%d vs n.%d\n",kp->notaryid,n);
+    return(Notarysets_elected[htind].load(std::memory_order_acquire));
+}
+
+int32_t komodo_notaries(uint8_t pubkeys[64][33],int32_t height,uint32_t timestamp)
+{
+    const struct komodo_notaryset *ns;
+    timestamp = komodo_notarytimestamp(height,timestamp);
+    if ( is_STAKED(ASSETCHAINS_SYMBOL) != 0 && timestamp != 0 )
+    { 
+        // here we can activate our pubkeys for LABS chains everythig is in notaries_staked.cpp
+        int32_t staked_era; int8_t numSN;
+        uint8_t staked_pubkeys[64][33];
+        staked_era = STAKED_era(timestamp);
+        numSN = numStakedNotaries(staked_pubkeys,staked_era);
+        memcpy(pubkeys,staked_pubkeys,numSN * 33);
+        return(numSN);
     }
-    pthread_mutex_unlock(&komodo_mutex);
-    if ( (n < 64 && mask == ((1LL << n)-1)) || (n == 64 && mask == 0xffffffffffffffffLL) )
-        return(n);
-    printf("error retrieving notaries ht.%d got mask.%llx for n.%d\n",height,(long long)mask,n);
-    return(-1);
+    // If this chain is not a staked chain, use the normal Komodo logic to determine notaries. This allows KMD to still sync and use its proper pubkeys for dPoW.
+    if ( (ns= komodo_notaryset_get(height,timestamp)) == 0 )
+        return(0);
+    memcpy(pubkeys,ns->pubkeys,ns->numnotaries * 33);
+    return(ns->numnotaries);
 }
 
 int32_t komodo_electednotary(int32_t *numnotariesp,uint8_t *pubkey33,int32_t height,uint32_t timestamp)
 {
-    int32_t i,n; uint8_t pubkeys[64][33];
+    int32_t i,n; uint8_t pubkeys[64][33]; const struct komodo_notaryset *ns;
+    timestamp = komodo_notarytimestamp(height,timestamp);
+    if ( is_STAKED(ASSETCHAINS_SYMBOL) == 0 || timestamp == 0 )
+    {
+        if ( (ns= komodo_notaryset_get(height,timestamp)) == 0 )
+        {
+            *numnotariesp = 0;
+            return(-1);
+        }
+        *numnotariesp = ns->numnotaries;
+        return(komodo_notaryset_find(ns,pubkey33));
+    }
     n = komodo_notaries(pubkeys,height,timestamp);
     *numnotariesp = n;
     for (i=0; i<n; i++)
@@ -187,7 +256,8 @@ int32_t komodo_ratify_threshold(int32_t height,uint64_t signedmask)
     htind = height / KOMODO_ELECTION_GAP;
     if ( htind >= KOMODO_MAXBLOCKS / KOMODO_ELECTION_GAP )
         htind = (KOMODO_MAXBLOCKS / KOMODO_ELECTION_GAP) - 1;
-    numnotaries = Pubkeys[htind].numnotaries;
+    const struct komodo_notaryset *ns = Notarysets_elected[htind].load(std::memory_order_acquire);
+    numnotaries = (ns != 0) ? ns->numnotaries : 0;
     for (i=0; i<numnotaries; i++)
         if ( ((1LL << i) & signedmask) != 0 )
             wt++;
@@ -199,7 +269,7 @@ int32_t komodo_ratify_threshold(int32_t height,uint64_t signedmask)
 void komodo_notarysinit(int32_t origheight,uint8_t pubkeys[64][33],int32_t num)
 {
     static int32_t hwmheight;
-    int32_t k,i,htind,height; struct knotary_entry *kp; struct knotaries_entry N;
+    int32_t k,i,htind,height; struct knotary_entry *kp; struct knotaries_entry N; const struct komodo_notaryset *ns;
     if ( Pubkeys == 0 )
         Pubkeys = (struct knotaries_entry *)calloc(1 + (KOMODO_MAXBLOCKS / KOMODO_ELECTION_GAP),sizeof(*Pubkeys));
     memset(&N,0,sizeof(N));
@@ -228,6 +298,7 @@ void komodo_notarysinit(int32_t origheight,uint8_t pubkeys[64][33],int32_t num)
         }
     }
     N.numnotaries = num;
+    ns = komodo_notaryset_create(pubkeys,num);
     for (i=htind; i<KOMODO_MAXBLOCKS / KOMODO_ELECTION_GAP; i++)
     {
         if ( Pubkeys[i].height != 0 && origheight < hwmheight )
@@ -237,6 +308,7 @@ void komodo_notarysinit(int32_t origheight,uint8_t pubkeys[64][33],int32_t num)
         }
         Pubkeys[i] = N;
         Pubkeys[i].height = i * KOMODO_ELECTION_GAP;
+        Notarysets_elected[i].store(ns,std::memory_order_release);
     }
     pthread_mutex_unlock(&komodo_mutex);
     if ( origheight > hwmheight )
@@ -246,7 +318,7 @@ void komodo_notarysinit(int32_t origheight,uint8_t pubkeys[64][33],int32_t num)
 int32_t komodo_chosennotary(int32_t *notaryidp,int32_t height,uint8_t *pubkey33,uint32_t timestamp)
 {
     // -1 if not notary, 0 if notary, 1 if special notary
-    struct knotary_entry *kp; int32_t numnotaries=0,htind,modval = -1;
+    const struct komodo_notaryset *ns; int32_t numnotaries=0,notaryid,htind,modval = -1;
     *notaryidp = -1;
     if ( height < 0 )//|| height >= KOMODO_MAXBLOCKS )
     {
@@ -268,16 +340,13 @@ int32_t komodo_chosennotary(int32_t *notaryidp,int32_t height,uint8_t *pubkey33,
     htind = height / KOMODO_ELECTION_GAP;
     if ( htind >= KOMODO_MAXBLOCKS / KOMODO_ELECTION_GAP )
         htind = (KOMODO_MAXBLOCKS / KOMODO_ELECTION_GAP) - 1;
-    pthread_mutex_lock(&komodo_mutex);
-    HASH_FIND(hh,Pubkeys[htind].Notaries,pubkey33,33,kp);
-    pthread_mutex_unlock(&komodo_mutex);
-    if ( kp != 0 )
+    if ( (ns= Notarysets_elected[htind].load(std::memory_order_acquire)) != 0 && (notaryid= komodo_notaryset_find(ns,pubkey33)) >= 0 )
     {
-        if ( (numnotaries= Pubkeys[htind].numnotaries) > 0 )
+        if ( (numnotaries= ns->numnotaries) > 0 )
         {
-            *notaryidp = kp->notaryid;
-            modval = ((height % numnotaries) == kp->notaryid);
-            //printf("found notary.%d ht.%d modval.%d\n",kp->notaryid,height,modval);
+            *notaryidp = notaryid;
+            modval = ((height % numnotaries) == notaryid);
+            //printf("found notary.%d ht.%d modval.%d\n",notaryid,height,modval);
         } else printf("unexpected zero notaries at height.%d\n",height);
     } //else printf("cant find kp at htind.%d ht.%d\n",htind,height);
     //int32_t i; for (i=0; i<33; i++)
@@ -0,0 +1,264 @@
+/******************************************************************************
+ * Copyright © 2014-2019 The SuperNET Developers.                             *
+ *                                                                            *
+ * See the AUTHORS, DEVELOPER-AGREEMENT and LICENSE files at                  *
+ * the top-level directory of this distribution for the individual copyright  *
+ * holder information and the developer policies on copyright and licensing.  *
+ *                                                                            *
+ * Unless otherwise agreed in a custom licensing agreement, no part of the    *
+ * SuperNET software, including this file may be copied, modified, propagated *
+ * or distributed except according to the terms contained in the LICENSE file *
+ *                                                                            *
+ * Removal or modification of this copyright notice is prohibited.            *
+ *                                                                            *
+ ******************************************************************************/
+
+// Binary snapshot of the komodo_state rebuilt from the komodostate event log.
+// At startup the snapshot is loaded and only the log records written after it are replayed,
+// instead of replaying the whole log record by record through komodo_eventadd_*.
+//
+// komodostate.snap layout (host byte order, same as komodostate itself):
+//   komodo_snapshot_header
+//   payload: komodo_state (pointers zeroed)
+//            int32 NUM_NPOINTS, NPOINTS[]
+//            int32 numevents, { uint16 len, komodo_event bytes }[]
+//            int32 numratified, komodo_snapshot_ratify[]
+//            int32 NUM_PRICES, PVALS[36 * NUM_PRICES]
+
+#ifndef H_KOMODOSTATESNAPSHOT_H
+#define H_KOMODOSTATESNAPSHOT_H
+
+#include "komodo_defs.h"
+#include "crypto/sha256.h"
+
+#include <vector>
+#include <boost/filesystem.hpp>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#define KOMODO_SNAPSHOT_MAGIC 0x504e534b // "KSNP"
+#define KOMODO_SNAPSHOT_VERSION 1
+#define KOMODO_SNAPSHOT_INTERVAL 1440 // blocks between snapshots
+#define KOMODO_SNAPSHOT_TAILSIZE 4096 // log bytes before the snapshot position that must still match
+
+struct komodo_snapshot_header
+{
+    uint32_t magic,version,statesize,checkpointsize;
+    int64_t logpos;         // komodostate offset covered by the snapshot
+    uint256 logtailhash;    // sha256 of the KOMODO_SNAPSHOT_TAILSIZE log bytes before logpos
+    uint64_t payloadlen;
+    uint256 payloadhash;    // sha256 of the payload
+    char symbol[KOMODO_ASSETCHAIN_MAXLEN];
+};
+
+// notary sets applied through komodo_notarysinit, these live in the global Pubkeys and not in komodo_state
+struct komodo_snapshot_ratify { int32_t height; uint8_t num; uint8_t pubkeys[64][33]; };
+
+std::vector<struct komodo_snapshot_ratify> Komodo_ratified;
+
+void komodo_snapshot_addratify(int32_t height,uint8_t num,uint8_t pubkeys[64][33])
+{
+    struct komodo_snapshot_ratify R;
+    memset(&R,0,sizeof(R));
+    R.height = height;
+    R.num = num;
+    memcpy(R.pubkeys,pubkeys,33 * num);
+    portable_mutex_lock(&komodo_mutex);
+    Komodo_ratified.push_back(R);
+    portable_mutex_unlock(&komodo_mutex);
+}
+
+void komodo_snapshotfname(char *fname,char *statefname)
+{
+    safecopy(fname,statefname,512-5);
+    strcat(fname,".snap");
+}
+
+uint256 komodo_snapshot_logtailhash(FILE *fp,int64_t logpos)
+{
+    uint8_t buf[KOMODO_SNAPSHOT_TAILSIZE]; uint256 hash; long savedpos; int64_t start; size_t len;
+    memset(&hash,0,sizeof(hash));
+    savedpos = ftell(fp);
+    start = (logpos > KOMODO_SNAPSHOT_TAILSIZE) ? logpos - KOMODO_SNAPSHOT_TAILSIZE : 0;
+    len = (size_t)(logpos - start);
+    if ( fseek(fp,start,SEEK_SET) == 0 && fread(buf,1,len,fp) == len )
+        CSHA256().Write(buf,len).Finalize(hash.begin());
+    fseek(fp,savedpos,SEEK_SET);
+    return(hash);
+}
+
+static void komodo_snapshot_append(std::vector<uint8_t> &payload,const void *ptr,size_t len)
+{
+    payload.insert(payload.end(),(const uint8_t *)ptr,(const uint8_t *)ptr + len);
+}
+
+/**
+ * Writes komodostate.snap for the state built from the first logpos bytes of the komodostate log in fp.
+ * Called right after a record was flushed so that sp, Pubkeys and PVALS match the log prefix exactly.
+ */
+int32_t komodo_snapshot_write(struct komodo_state *sp,FILE *fp,char *statefname,char *symbol)
+{
+    struct komodo_snapshot_header H; struct komodo_state S; std::vector<uint8_t> payload; FILE *snapfp; char fname[512],tmpfname[520]; int32_t i,n; uint16_t len;
+    memset(&H,0,sizeof(H));
+    H.magic = KOMODO_SNAPSHOT_MAGIC;
+    H.version = KOMODO_SNAPSHOT_VERSION;
+    H.statesize = sizeof(struct komodo_state);
+    H.checkpointsize = sizeof(struct notarized_checkpoint);
+    H.logpos = ftell(fp);
+    H.logtailhash = komodo_snapshot_logtailhash(fp,H.logpos);
+    safecopy(H.symbol,symbol,sizeof(H.symbol));
+    portable_mutex_lock(&komodo_mutex);
+    S = *sp;
+    S.NPOINTS = 0;
+    S.Komodo_events = 0;
+    komodo_snapshot_append(payload,&S,sizeof(S));
+    komodo_snapshot_append(payload,&sp->NUM_NPOINTS,sizeof(sp->NUM_NPOINTS));
+    komodo_snapshot_append(payload,sp->NPOINTS,sp->NUM_NPOINTS * sizeof(*sp->NPOINTS));
+    komodo_snapshot_append(payload,&sp->Komodo_numevents,sizeof(sp->Komodo_numevents));
+    for (i=0; i<sp->Komodo_numevents; i++)
+    {
+        len = sp->Komodo_events[i]->len;
+        komodo_snapshot_append(payload,&len,sizeof(len));
+        komodo_snapshot_append(payload,sp->Komodo_events[i],len);
+    }
+    n = (int32_t)Komodo_ratified.size();
+    komodo_snapshot_append(payload,&n,sizeof(n));
+    if ( n > 0 )
+        komodo_snapshot_append(payload,&Komodo_ratified[0],n * sizeof(Komodo_ratified[0]));
+    komodo_snapshot_append(payload,&NUM_PRICES,sizeof(NUM_PRICES));
+    komodo_snapshot_append(payload,PVALS,NUM_PRICES * sizeof(*PVALS) * 36);
+    portable_mutex_unlock(&komodo_mutex);
+    H.payloadlen = payload.size();
+    CSHA256().Write(payload.data(),payload.size()).Finalize(H.payloadhash.begin());
+
+    komodo_snapshotfname(fname,statefname);
+    sprintf(tmpfname,"%s.tmp",fname);
+    if ( (snapfp= fopen(tmpfname,"wb")) == 0 )
+        return(-1);
+    if ( fwrite(&H,1,sizeof(H),snapfp) != sizeof(H) || fwrite(payload.data(),1,payload.size(),snapfp) != payload.size() )
+    {
+        fclose(snapfp);
+        boost::filesystem::remove(tmpfname);
+        return(-1);
+    }
+    fclose(snapfp);
+    try
+    {
+        boost::filesystem::rename(tmpfname,fname);
+    }
+    catch (const boost::filesystem::filesystem_error &e)
+    {
+        fprintf(stderr,"komodo_snapshot_write %s: %s\n",fname,e.what());
+        return(-1);
+    }
+    return(0);
+}
+
+// maps the snapshot read-only, falls back to reading it into memory where mmap is not available
+static uint8_t *komodo_snapshot_map(char *fname,long *lenp)
+{
+#ifndef _WIN32
+    struct stat st; void *ptr; int fd;
+    *lenp = 0;
+    if ( (fd= open(fname,O_RDONLY)) < 0 )
+        return(0);
+    if ( fstat(fd,&st) != 0 || st.st_size <= 0 || (ptr= mmap(0,st.st_size,PROT_READ,MAP_PRIVATE,fd,0)) == MAP_FAILED )
+    {
+        close(fd);
+        return(0);
+    }
+    close(fd);
+    *lenp = st.st_size;
+    return((uint8_t *)ptr);
+#else
+    return(OS_fileptr(lenp,fname));
+#endif
+}
+
+static void komodo_snapshot_unmap(uint8_t *ptr,long len)
+{
+#ifndef _WIN32
+    munmap(ptr,len);
+#else
+    free(ptr);
+#endif
+}
+
+/**
+ * Loads komodostate.snap into sp if it is intact and still describes a prefix of the log in fp.
+ * Returns the log offset to resume replaying from, or -1 if the whole log has to be replayed.
+ */
+int64_t komodo_snapshot_load(struct komodo_state *sp,FILE *fp,char *statefname,char *symbol)
+{
+    struct komodo_snapshot_header H; struct komodo_state S; struct komodo_event *ep; uint8_t *filedata; char fname[512]; uint256 hash; long fpos,datalen,logsize; int32_t i,n,num_npoints,numevents; uint16_t len;
+    std::vector<struct komodo_snapshot_ratify> ratified;
+    komodo_snapshotfname(fname,statefname);
+    if ( (filedata= komodo_snapshot_map(fname,&datalen)) == 0 )
+        return(-1);
+    fpos = 0;
+    if ( memread(&H,sizeof(H),filedata,&fpos,datalen) != sizeof(H) || H.magic != KOMODO_SNAPSHOT_MAGIC || H.version != KOMODO_SNAPSHOT_VERSION || H.statesize != sizeof(S) || H.checkpointsize != sizeof(struct notarized_checkpoint) || strncmp(H.symbol,symbol,sizeof(H.symbol)) != 0 || H.payloadlen != datalen - sizeof(H) )
+    {
+        fprintf(stderr,"%s is not a usable komodostate snapshot\n",fname);
+        komodo_snapshot_unmap(filedata,datalen);
+        return(-1);
+    }
+    CSHA256().Write(&filedata[fpos],H.payloadlen).Finalize(hash.begin());
+    fseek(fp,0,SEEK_END);
+    logsize = ftell(fp);
+    rewind(fp);
+    if ( hash != H.payloadhash || H.logpos > logsize || komodo_snapshot_logtailhash(fp,H.logpos) != H.logtailhash )
+    {
+        fprintf(stderr,"%s checksum mismatch or komodostate changed, ignoring snapshot\n",fname);
+        komodo_snapshot_unmap(filedata,datalen);
+        return(-1);
+    }
+    if ( memread(&S,sizeof(S),filedata,&fpos,datalen) != sizeof(S) || memread(&num_npoints,sizeof(num_npoints),filedata,&fpos,datalen) != sizeof(num_npoints) || num_npoints < 0 || fpos + (long)(num_npoints * sizeof(*sp->NPOINTS)) > datalen )
+    {
+        komodo_snapshot_unmap(filedata,datalen);
+        return(-1);
+    }
+    portable_mutex_lock(&komodo_mutex);
+    *sp = S;
+    sp->NPOINTS = (struct notarized_checkpoint *)calloc(num_npoints + 1,sizeof(*sp->NPOINTS));
+    memread(sp->NPOINTS,num_npoints * sizeof(*sp->NPOINTS),filedata,&fpos,datalen);
+    sp->NUM_NPOINTS = num_npoints;
+    sp->Komodo_numevents = 0;
+    if ( memread(&numevents,sizeof(numevents),filedata,&fpos,datalen) == sizeof(numevents) && numevents > 0 )
+    {
+        sp->Komodo_events = (struct komodo_event **)calloc(numevents,sizeof(*sp->Komodo_events));
+        for (i=0; i<numevents; i++)
+        {
+            if ( memread(&len,sizeof(len),filedata,&fpos,datalen) != sizeof(len) || len < sizeof(*ep) || fpos + len > datalen )
+                break;
+            ep = (struct komodo_event *)calloc(1,len);
+            memread(ep,len,filedata,&fpos,datalen);
+            ep->related = 0;
+            sp->Komodo_events[sp->Komodo_numevents++] = ep;
+        }
+    }
+    if ( memread(&n,sizeof(n),filedata,&fpos,datalen) == sizeof(n) && n > 0 && fpos + (long)(n * sizeof(struct komodo_snapshot_ratify)) <= datalen )
+    {
+        ratified.resize(n);
+        memread(&ratified[0],n * sizeof(ratified[0]),filedata,&fpos,datalen);
+    }
+    if ( memread(&n,sizeof(n),filedata,&fpos,datalen) == sizeof(n) && n > 0 && fpos + (long)(n * sizeof(*PVALS) * 36) <= datalen )
+    {
+        PVALS = (uint32_t *)realloc(PVALS,n * sizeof(*PVALS) * 36);
+        memread(PVALS,n * sizeof(*PVALS) * 36,filedata,&fpos,datalen);
+        NUM_PRICES = n;
+    }
+    portable_mutex_unlock(&komodo_mutex);
+    komodo_snapshot_unmap(filedata,datalen);
+    // komodo_notarysinit takes komodo_mutex itself
+    for (i=0; i<(int32_t)ratified.size(); i++)
+        komodo_notarysinit(ratified[i].height,ratified[i].pubkeys,ratified[i].num);
+    Komodo_ratified = ratified;
+    fprintf(stderr,"loaded %s: %d npoints, %d events, %d notary sets, replaying komodostate from %lld of %ld\n",fname,sp->NUM_NPOINTS,sp->Komodo_numevents,(int32_t)ratified.size(),(long long)H.logpos,logsize);
+    return(H.logpos);
+}
+
+#endif
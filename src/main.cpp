@@ -26,6 +26,7 @@
 #include "addrman.h"
 #include "alert.h"
 #include "arith_uint256.h"
+#include "blockreader.h"
 #include "importcoin.h"
 #include "chainparams.h"
 #include "checkpoints.h"
@@ -111,6 +112,11 @@ size_t nCoinCacheUsage = 5000 * 300;
 uint64_t nPruneTarget = 0;
 bool fAlerts = DEFAULT_ALERTS;
 bool fUnspentCCIndex = false;
+bool fCCBatonIndex = false;
+bool fOracleDataIndex = false;
+bool fRewardsIndex = false;
+bool fHeirIndex = false;
+bool fAddressBalanceIndex = false;
 
 /* If the tip is older than this (in seconds), the node is considered to be in initial block download.
  */
@@ -686,6 +692,94 @@ bool komodo_snapshot2(std::map <std::string, CAmount> &addressAmounts)
     else return false;
 }
 
+bool getAddressFromIndex(const int &type, const uint160 &hash, std::string &address);
+
+/**
+ * The indexes kept as deltas are written when a block is connected, the chainstate only when it is flushed, so after
+ * an unclean shutdown the blocks since the last flush are connected again. Such indexes store the last block applied
+ * in the same batch as the update and check it here: 1 if the block was already connected (or, for fDisconnect, was
+ * never connected) and must be skipped, 0 to apply it, -1 if the index is on another branch and needs a reindex.
+ */
+int32_t IndexBlockState(const uint256 &hashIndexBest, const CBlockIndex *pindex, bool fDisconnect)
+{
+    if ( hashIndexBest.IsNull() )
+        return 0; // written before the marker existed
+    BlockMap::const_iterator mi = mapBlockIndex.find(hashIndexBest);
+    if ( mi == mapBlockIndex.end() )
+        return -1;
+    const CBlockIndex *pindexIndexBest = mi->second;
+    if ( fDisconnect )
+    {
+        if ( pindexIndexBest == pindex )
+            return 0;
+        if ( pindex->pprev != 0 && pindex->pprev->GetAncestor(pindexIndexBest->GetHeight()) == pindexIndexBest )
+            return 1;
+        return -1;
+    }
+    if ( pindexIndexBest == pindex->pprev )
+        return 0;
+    if ( pindexIndexBest->GetAncestor(pindex->GetHeight()) == pindex )
+        return 1;
+    return -1;
+}
+
+// applies the address index deltas of a block to the address balance index and the in memory ranking
+static bool UpdateAddressBalanceIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex, const CBlockIndex *pindex, bool fDisconnect)
+{
+    std::map<CAddressBalanceKey, CAddressBalanceValue> deltas, balances;
+    int64_t sign = fDisconnect ? -1 : 1;
+    std::string address;
+    uint256 hashIndexBest;
+    int32_t indexState;
+
+    if ( !pblocktree->ReadAddressBalanceBestBlock(hashIndexBest) )
+        return false;
+    if ( (indexState= IndexBlockState(hashIndexBest, pindex, fDisconnect)) != 0 )
+    {
+        if ( indexState < 0 )
+            return error("%s: address balance index is at %s, not on the chain of %s, restart with -reindex", __func__, hashIndexBest.ToString(), pindex->GetBlockHash().ToString());
+        LogPrintf("%s: block %s already %s in the address balance index\n", __func__, pindex->GetBlockHash().ToString(), fDisconnect ? "disconnected" : "connected");
+        return true;
+    }
+
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it = addressIndex.begin(); it != addressIndex.end(); it++)
+    {
+        // zero value outputs are not counted as utxos by the snapshot either
+        if ( it->second == 0 )
+            continue;
+        CAddressBalanceValue &delta = deltas[CAddressBalanceKey(it->first.type, it->first.hashBytes)];
+        delta.balance += sign * it->second;
+        delta.utxos += sign * (it->second > 0 ? 1 : -1);
+    }
+    if ( !pblocktree->UpdateAddressBalanceIndex(deltas, balances, fDisconnect ? pindex->pprev->GetBlockHash() : pindex->GetBlockHash()) )
+        return false;
+    for (std::map<CAddressBalanceKey, CAddressBalanceValue>::const_iterator it = balances.begin(); it != balances.end(); it++)
+    {
+        bool fIgnored = getAddressFromIndex(it->first.type, it->first.hashBytes, address) && IsSnapshotIgnoredAddress(address);
+        addressBalanceRanking.Set(it->first, it->second, fIgnored);
+    }
+    return true;
+}
+
+// loads the address balance index into the ranking at startup
+static bool LoadAddressBalanceRanking()
+{
+    std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > balances;
+    std::string address;
+
+    addressBalanceRanking.Clear();
+    if ( !pblocktree->ReadAddressBalances(balances) )
+        return false;
+    for (std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> >::const_iterator it = balances.begin(); it != balances.end(); it++)
+    {
+        bool fIgnored = getAddressFromIndex(it->first.type, it->first.hashBytes, address) && IsSnapshotIgnoredAddress(address);
+        addressBalanceRanking.Set(it->first, it->second, fIgnored);
+    }
+    addressBalanceRanking.SetLoaded(true);
+    LogPrintf("%s: loaded %u ranked addresses of %u\n", __func__, (unsigned int)addressBalanceRanking.Size(), (unsigned int)balances.size());
+    return true;
+}
+
 int32_t lastSnapShotHeight = 0;
 std::vector <std::pair<CAmount, CTxDestination>> vAddressSnapshot;
 
@@ -3472,6 +3566,9 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
         if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
             return AbortNode(state, "Failed to write address unspent index");
         }
+        if (fAddressBalanceIndex && !UpdateAddressBalanceIndex(addressIndex, pindex, true)) {
+            return AbortNode(state, "Failed to write address balance index");
+        }
     }
 
     if (fUnspentCCIndex) {
@@ -3480,6 +3577,52 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
         }
     }
 
+    if (fCCBatonIndex) {
+        CCCBatonIndexUpdate ccBatonUpdate;
+        uint256 hashIndexBest;
+        int32_t indexState;
+        if (!pblocktree->ReadCCBatonBestBlock(hashIndexBest) || (indexState= IndexBlockState(hashIndexBest, pindex, true)) < 0) {
+            return AbortNode(state, "The cc baton index is not on the active chain, restart with -reindex");
+        }
+        if (indexState == 0) {
+            CCBatonIndexDisconnectBlock(block, ccBatonUpdate);
+            if (!pblocktree->UpdateCCBatonIndex(ccBatonUpdate, pindex->pprev->GetBlockHash())) {
+                return AbortNode(state, "Failed to write cc baton index");
+            }
+        }
+    }
+
+    if (fOracleDataIndex) {
+        std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue> > oracleSamples;
+        OraclesDataIndexDisconnectBlock(block, pindex->GetHeight(), oracleSamples);
+        if (!oracleSamples.empty() && !pblocktree->UpdateOracleDataIndex(oracleSamples)) {
+            return AbortNode(state, "Failed to write oracle data index");
+        }
+    }
+
+    if (fRewardsIndex) {
+        std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> > rewardsOutputs;
+        RewardsIndexDisconnectBlock(block, pindex->GetHeight(), pindex->nTime, rewardsOutputs);
+        if (!rewardsOutputs.empty() && !pblocktree->UpdateRewardsIndex(rewardsOutputs)) {
+            return AbortNode(state, "Failed to write rewards index");
+        }
+    }
+
+    if (fHeirIndex) {
+        std::vector<std::pair<uint256, CCCHeirStateValue> > heirStates, heirUndo;
+        uint256 hashIndexBest;
+        int32_t indexState;
+        if (!pblocktree->ReadHeirBestBlock(hashIndexBest) || (indexState= IndexBlockState(hashIndexBest, pindex, true)) < 0) {
+            return AbortNode(state, "The heir index is not on the active chain, restart with -reindex");
+        }
+        if (indexState == 0) {
+            HeirIndexDisconnectBlock(block, heirStates, heirUndo);
+            if (!pblocktree->UpdateHeirIndex(heirStates, heirUndo, true, pindex->pprev->GetBlockHash())) {
+                return AbortNode(state, "Failed to write heir index");
+            }
+        }
+    }
+
     return fClean;
 }
 
@@ -3895,7 +4038,9 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
             //fprintf(stderr, "tx.%s nFees.%li interest.%li\n", tx.GetHash().ToString().c_str(), stakeTxValue, interest);
 
             std::vector<CScriptCheck> vChecks;
-            if (!ContextualCheckInputs(tx, state, view, fExpensiveChecks, flags, false, txdata[i], chainparams.GetConsensus(), consensusBranchId, pindex->GetBlockTime(), pindex->GetHeight(), evalcodeChecker, nScriptCheckThreads ? &vChecks : NULL))
+            // a template check keeps the cached signatures for the real connect, which frees their slots
+            bool fCacheResults = fJustCheck;
+            if (!ContextualCheckInputs(tx, state, view, fExpensiveChecks, flags, fCacheResults, txdata[i], chainparams.GetConsensus(), consensusBranchId, pindex->GetBlockTime(), pindex->GetHeight(), evalcodeChecker, nScriptCheckThreads ? &vChecks : NULL))
                 return false;
             control.Add(vChecks);
         }
@@ -4091,6 +4236,10 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
             return AbortNode(state, "Failed to write address unspent index");
         }
+
+        if (fAddressBalanceIndex && !UpdateAddressBalanceIndex(addressIndex, pindex, false)) {
+            return AbortNode(state, "Failed to write address balance index");
+        }
     }
 
     if (fUnspentCCIndex)    {
@@ -4099,6 +4248,54 @@ bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pin
         }
     }
 
+    if (fCCBatonIndex) {
+        CCCBatonIndexUpdate ccBatonUpdate;
+        uint256 hashIndexBest;
+        int32_t indexState;
+        if (!pblocktree->ReadCCBatonBestBlock(hashIndexBest) || (indexState= IndexBlockState(hashIndexBest, pindex, false)) < 0) {
+            return AbortNode(state, "The cc baton index is not on the active chain, restart with -reindex");
+        }
+        // a block replayed after an unclean shutdown is already in the index
+        if (indexState == 0) {
+            CCBatonIndexConnectBlock(block, pindex->GetHeight(), ccBatonUpdate);
+            if (!pblocktree->UpdateCCBatonIndex(ccBatonUpdate, pindex->GetBlockHash())) {
+                return AbortNode(state, "Failed to write cc baton index");
+            }
+        }
+    }
+
+    if (fOracleDataIndex) {
+        std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue> > oracleSamples;
+        OraclesDataIndexConnectBlock(block, pindex->GetHeight(), oracleSamples);
+        if (!oracleSamples.empty() && !pblocktree->UpdateOracleDataIndex(oracleSamples)) {
+            return AbortNode(state, "Failed to write oracle data index");
+        }
+    }
+
+    if (fRewardsIndex) {
+        std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> > rewardsOutputs;
+        RewardsIndexConnectBlock(block, pindex->GetHeight(), pindex->nTime, rewardsOutputs);
+        if (!rewardsOutputs.empty() && !pblocktree->UpdateRewardsIndex(rewardsOutputs)) {
+            return AbortNode(state, "Failed to write rewards index");
+        }
+    }
+
+    if (fHeirIndex) {
+        std::vector<std::pair<uint256, CCCHeirStateValue> > heirStates, heirUndo;
+        uint256 hashIndexBest;
+        int32_t indexState;
+        if (!pblocktree->ReadHeirBestBlock(hashIndexBest) || (indexState= IndexBlockState(hashIndexBest, pindex, false)) < 0) {
+            return AbortNode(state, "The heir index is not on the active chain, restart with -reindex");
+        }
+        // the plan balances are deltas, a block replayed after an unclean shutdown must not add them again
+        if (indexState == 0) {
+            HeirIndexConnectBlock(block, pindex->GetHeight(), heirStates, heirUndo);
+            if (!pblocktree->UpdateHeirIndex(heirStates, heirUndo, false, pindex->GetBlockHash())) {
+                return AbortNode(state, "Failed to write heir index");
+            }
+        }
+    }
+
     if (fSpentIndex)
         if (!pblocktree->UpdateSpentIndex(spentIndex))
             return AbortNode(state, "Failed to write transaction index");
@@ -6600,6 +6797,23 @@ bool static LoadBlockIndexDB()
     pblocktree->ReadFlag("unspentccindex", fUnspentCCIndex);
     LogPrintf("%s: unspent cc index %s\n", __func__, fUnspentCCIndex ? "enabled" : "disabled");
 
+    pblocktree->ReadFlag("ccbatonindex", fCCBatonIndex);
+    LogPrintf("%s: cc baton index %s\n", __func__, fCCBatonIndex ? "enabled" : "disabled");
+
+    pblocktree->ReadFlag("oracledataindex", fOracleDataIndex);
+    LogPrintf("%s: oracle data index %s\n", __func__, fOracleDataIndex ? "enabled" : "disabled");
+
+    pblocktree->ReadFlag("rewardsindex", fRewardsIndex);
+    LogPrintf("%s: rewards index %s\n", __func__, fRewardsIndex ? "enabled" : "disabled");
+
+    pblocktree->ReadFlag("heirindex", fHeirIndex);
+    LogPrintf("%s: heir index %s\n", __func__, fHeirIndex ? "enabled" : "disabled");
+
+    pblocktree->ReadFlag("addressbalanceindex", fAddressBalanceIndex);
+    LogPrintf("%s: address balance index %s\n", __func__, fAddressBalanceIndex ? "enabled" : "disabled");
+    if (fAddressBalanceIndex && !LoadAddressBalanceRanking())
+        return error("LoadBlockIndexDB(): failed to load address balance index");
+
     // Fill in-memory data
     BOOST_FOREACH(const PAIRTYPE(uint256, CBlockIndex*)& item, mapBlockIndex)
     {
@@ -6971,6 +7185,23 @@ bool InitBlockIndex() {
         pblocktree->WriteFlag("unspentccindex", fUnspentCCIndex);
         fprintf(stderr, "fUnspentCCIndex.%d\n", fUnspentCCIndex);
 
+        fCCBatonIndex = GetBoolArg("-ccbatonindex", DEFAULT_CCBATONINDEX);
+        pblocktree->WriteFlag("ccbatonindex", fCCBatonIndex);
+
+        fOracleDataIndex = GetBoolArg("-oracledataindex", DEFAULT_ORACLEDATAINDEX);
+        pblocktree->WriteFlag("oracledataindex", fOracleDataIndex);
+
+        fRewardsIndex = GetBoolArg("-rewardsindex", DEFAULT_REWARDSINDEX);
+        pblocktree->WriteFlag("rewardsindex", fRewardsIndex);
+
+        fHeirIndex = GetBoolArg("-heirindex", DEFAULT_HEIRINDEX);
+        pblocktree->WriteFlag("heirindex", fHeirIndex);
+
+        fAddressBalanceIndex = fAddressIndex && GetBoolArg("-addressbalanceindex", DEFAULT_ADDRESSBALANCEINDEX);
+        pblocktree->WriteFlag("addressbalanceindex", fAddressBalanceIndex);
+        if (fAddressBalanceIndex)
+            addressBalanceRanking.SetLoaded(true);
+
         LogPrintf("Initializing databases...\n");
     }
     // Only add the genesis block if not reindexing (in which case we reuse the one already on disk)
@@ -7006,11 +7237,64 @@ bool InitBlockIndex() {
 
 
 
-bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos *dbp)
+// Map of disk positions for blocks with unknown parent (only used for reindex)
+static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
+
+/** Processes a block read from a block file and the out of order children waiting for it, false on a system error */
+static bool ProcessExternalBlock(CBlock& block, CDiskBlockPos *dbp, int& nLoaded)
 {
     const CChainParams& chainparams = Params();
-    // Map of disk positions for blocks with unknown parent (only used for reindex)
-    static std::multimap<uint256, CDiskBlockPos> mapBlocksUnknownParent;
+    // detect out of order blocks, and store them for later
+    uint256 hash = block.GetHash();
+    if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex.find(block.hashPrevBlock) == mapBlockIndex.end()) {
+        LogPrint("reindex", "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
+                 block.hashPrevBlock.ToString());
+        if (dbp)
+            mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
+        return true;
+    }
+
+    // process in case the block isn't known yet
+    if (mapBlockIndex.count(hash) == 0 || (mapBlockIndex[hash]->nStatus & BLOCK_HAVE_DATA) == 0) {
+        CValidationState state;
+        if (ProcessNewBlock(0,0,state, NULL, &block, true, dbp))
+            nLoaded++;
+        if (state.IsError())
+            return false;
+    } else if (hash != chainparams.GetConsensus().hashGenesisBlock && komodo_blockheight(hash) % 1000 == 0) {
+        LogPrintf("Block Import: already had block %s at height %d\n", hash.ToString(), komodo_blockheight(hash));
+    }
+
+    // Recursively process earlier encountered successors of this block
+    deque<uint256> queue;
+    queue.push_back(hash);
+    while (!queue.empty()) {
+        uint256 head = queue.front();
+        queue.pop_front();
+        std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
+        while (range.first != range.second) {
+            std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
+            
+            if (ReadBlockFromDisk(mapBlockIndex.count(hash)!=0?mapBlockIndex[hash]->GetHeight():0,block, it->second,1))
+            {
+                LogPrintf("%s: Processing out of order child %s of %s\n", __func__, block.GetHash().ToString(),
+                          head.ToString());
+                CValidationState dummy;
+                if (ProcessNewBlock(0,0,dummy, NULL, &block, true, &it->second))
+                {
+                    nLoaded++;
+                    queue.push_back(block.GetHash());
+                }
+            }
+            range.first++;
+            mapBlocksUnknownParent.erase(it);
+        }
+    }
+    return true;
+}
+
+bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos *dbp)
+{
     int64_t nStart = GetTimeMillis();
 
     int nLoaded = 0;
@@ -7053,52 +7337,52 @@ bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos *dbp)
                 blkdat >> block;
                 
                 nRewind = blkdat.GetPos();
-                // detect out of order blocks, and store them for later
-                uint256 hash = block.GetHash();
-                if (hash != chainparams.GetConsensus().hashGenesisBlock && mapBlockIndex.find(block.hashPrevBlock) == mapBlockIndex.end()) {
-                    LogPrint("reindex", "%s: Out of order block %s, parent %s not known\n", __func__, hash.ToString(),
-                             block.hashPrevBlock.ToString());
-                    if (dbp)
-                        mapBlocksUnknownParent.insert(std::make_pair(block.hashPrevBlock, *dbp));
-                    continue;
-                }
+                if (!ProcessExternalBlock(block, dbp, nLoaded))
+                    break;
+            } catch (const std::exception& e) {
+                LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
+            }
+        }
+    } catch (const std::runtime_error& e) {
+        AbortNode(std::string("System error: ") + e.what());
+    }
+    if (nLoaded > 0)
+        LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, GetTimeMillis() - nStart);
+    return nLoaded > 0;
+}
 
-                // process in case the block isn't known yet
-                if (mapBlockIndex.count(hash) == 0 || (mapBlockIndex[hash]->nStatus & BLOCK_HAVE_DATA) == 0) {
-                    CValidationState state;
-                    if (ProcessNewBlock(0,0,state, NULL, &block, true, dbp))
-                        nLoaded++;
-                    if (state.IsError())
-                        break;
-                } else if (hash != chainparams.GetConsensus().hashGenesisBlock && komodo_blockheight(hash) % 1000 == 0) {
-                    LogPrintf("Block Import: already had block %s at height %d\n", hash.ToString(), komodo_blockheight(hash));
-                }
+bool ReindexBlockFile(int nFile)
+{
+    int64_t nStart = GetTimeMillis();
 
-                // Recursively process earlier encountered successors of this block
-                deque<uint256> queue;
-                queue.push_back(hash);
-                while (!queue.empty()) {
-                    uint256 head = queue.front();
-                    queue.pop_front();
-                    std::pair<std::multimap<uint256, CDiskBlockPos>::iterator, std::multimap<uint256, CDiskBlockPos>::iterator> range = mapBlocksUnknownParent.equal_range(head);
-                    while (range.first != range.second) {
-                        std::multimap<uint256, CDiskBlockPos>::iterator it = range.first;
-                        
-                        if (ReadBlockFromDisk(mapBlockIndex.count(hash)!=0?mapBlockIndex[hash]->GetHeight():0,block, it->second,1))
-                        {
-                            LogPrintf("%s: Processing out of order child %s of %s\n", __func__, block.GetHash().ToString(),
-                                      head.ToString());
-                            CValidationState dummy;
-                            if (ProcessNewBlock(0,0,dummy, NULL, &block, true, &it->second))
-                            {
-                                nLoaded++;
-                                queue.push_back(block.GetHash());
-                            }
-                        }
-                        range.first++;
-                        mapBlocksUnknownParent.erase(it);
-                    }
-                }
+    int nLoaded = 0;
+    try {
+        // the blocks are located in the mapped file first, then deserialized ahead of validation
+        std::vector<CDiskBlockPos> vPos;
+        {
+            CMappedBlockFile mapped(nFile);
+            if (mapped.IsNull()) {
+                CDiskBlockPos pos(nFile, 0);
+                LogPrintf("%s: Cannot map blk%05u.dat, reading it sequentially\n", __func__, (unsigned int)nFile);
+                FILE *file = OpenBlockFile(pos, true);
+                return file != NULL && LoadExternalBlockFile(file, &pos);
+            }
+            vPos = mapped.FindBlocks();
+        }
+        CBlockReader reader(vPos, std::max((int)GetArg("-blockreaderthreads", DEFAULT_BLOCK_READER_THREADS), 0));
+        CBlock block;
+        bool fOk;
+        for (size_t i = 0; reader.Next(block, fOk); i++) {
+            boost::this_thread::interruption_point();
+
+            CDiskBlockPos pos = vPos[i];
+            if (!fOk) {
+                LogPrintf("%s: Deserialize or I/O error at %s\n", __func__, pos.ToString());
+                continue;
+            }
+            try {
+                if (!ProcessExternalBlock(block, &pos, nLoaded))
+                    break;
             } catch (const std::exception& e) {
                 LogPrintf("%s: Deserialize or I/O error - %s\n", __func__, e.what());
             }
@@ -7107,7 +7391,7 @@ bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos *dbp)
         AbortNode(std::string("System error: ") + e.what());
     }
     if (nLoaded > 0)
-        LogPrintf("Loaded %i blocks from external file in %dms\n", nLoaded, GetTimeMillis() - nStart);
+        LogPrintf("Loaded %i blocks from blk%05u.dat in %dms\n", nLoaded, (unsigned int)nFile, GetTimeMillis() - nStart);
     return nLoaded > 0;
 }
 
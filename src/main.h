@@ -44,6 +44,11 @@
 #include "txmempool.h"
 #include "uint256.h"
 #include "unspentccindex.h"
+#include "ccbatonindex.h"
+#include "ccoracledataindex.h"
+#include "ccrewardsindex.h"
+#include "ccheirindex.h"
+#include "addressbalance.h"
 
 #include <algorithm>
 #include <exception>
@@ -131,6 +136,11 @@ static const bool DEFAULT_NSPV_PROCESSING = true;
 
 /** Default unspent cc enabled for Tokel */
 static const bool DEFAULT_UNSPENTCCINDEX = true;
+static const bool DEFAULT_CCBATONINDEX = false;
+static const bool DEFAULT_ORACLEDATAINDEX = false;
+static const bool DEFAULT_REWARDSINDEX = false;
+static const bool DEFAULT_HEIRINDEX = false;
+static const bool DEFAULT_ADDRESSBALANCEINDEX = false;
 
 static const bool DEFAULT_TIMESTAMPINDEX = false;
 static const unsigned int DEFAULT_DB_MAX_OPEN_FILES = 1000;
@@ -165,6 +175,7 @@ extern bool fImporting;
 extern bool fReindex;
 extern int nScriptCheckThreads;
 extern bool fTxIndex;
+extern bool fAddressBalanceIndex;
 extern bool fIsBareMultisigStd;
 extern bool fCheckBlockIndex;
 extern bool fCheckpointsEnabled;
@@ -230,6 +241,8 @@ FILE* OpenUndoFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 boost::filesystem::path GetBlockPosFilename(const CDiskBlockPos &pos, const char *prefix);
 /** Import blocks from an external file */
 bool LoadExternalBlockFile(FILE* fileIn, CDiskBlockPos *dbp = NULL);
+/** Reindex the blocks of blk?????.dat file nFile, read ahead on -blockreaderthreads threads */
+bool ReindexBlockFile(int nFile);
 /** Initialize a new block tree database + block data on disk */
 bool InitBlockIndex();
 /** Load the block tree and coins database from disk */
@@ -840,9 +853,26 @@ bool GetAddressUnspent(uint160 addressHash, int type,
 bool GetUnspentCCIndex(uint160 addressHash, uint256 creationId,
                        std::vector<std::pair<CUnspentCCIndexKey, CUnspentCCIndexValue> > &unspentOutputs, int32_t beginHeight, int32_t endHeight, int64_t maxOutputs);
 
+// cc baton chain index, maintained by cc/CCbatonindex.cpp
+void CCBatonIndexConnectBlock(const CBlock &block, int32_t height, CCCBatonIndexUpdate &update);
+void CCBatonIndexDisconnectBlock(const CBlock &block, CCCBatonIndexUpdate &update);
+
+// oracle data index, maintained by cc/oracles.cpp
+void OraclesDataIndexConnectBlock(const CBlock &block, int32_t height, std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue> > &samples);
+void OraclesDataIndexDisconnectBlock(const CBlock &block, int32_t height, std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue> > &samples);
+
+// rewards index, maintained by cc/rewards.cpp
+void RewardsIndexConnectBlock(const CBlock &block, int32_t height, uint32_t blocktime, std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> > &outputs);
+void RewardsIndexDisconnectBlock(const CBlock &block, int32_t height, uint32_t blocktime, std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> > &outputs);
+
+// heir index, maintained by cc/heir.cpp
+void HeirIndexConnectBlock(const CBlock &block, int32_t height, std::vector<std::pair<uint256, CCCHeirStateValue> > &states, std::vector<std::pair<uint256, CCCHeirStateValue> > &undo);
+void HeirIndexDisconnectBlock(const CBlock &block, std::vector<std::pair<uint256, CCCHeirStateValue> > &states, std::vector<std::pair<uint256, CCCHeirStateValue> > &undo);
+
 /** Functions for disk access for blocks */
 bool WriteBlockToDisk(const CBlock& block, CDiskBlockPos& pos, const CMessageHeader::MessageStartChars& messageStart);
 bool ReadBlockFromDisk(CBlock& block, const CDiskBlockPos& pos,bool checkPOW);
+bool ReadBlockFromDisk(int32_t height,CBlock& block, const CDiskBlockPos& pos,bool checkPOW);
 bool ReadBlockFromDisk(CBlock& block, const CBlockIndex* pindex,bool checkPOW);
 bool PruneOneBlockFile(bool tempfile, const int fileNumber);
 
@@ -857,6 +887,9 @@ bool DisconnectBlock(CBlock& block, CValidationState& state, CBlockIndex* pindex
 /** Apply the effects of this block (with given index) on the UTXO set represented by coins */
 bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockIndex* pindex, CCoinsViewCache& coins, bool fJustCheck = false,bool fCheckPOW = false);
 
+/** Whether an index whose last applied block is hashIndexBest must skip connecting (or disconnecting) pindex: 1 skip, 0 apply, -1 out of sync */
+int32_t IndexBlockState(const uint256 &hashIndexBest, const CBlockIndex *pindex, bool fDisconnect);
+
 /** Context-independent validity checks */
 bool CheckBlockHeader(int32_t *futureblockp,int32_t height,CBlockIndex *pindex,const CBlockHeader& block, CValidationState& state, bool fCheckPOW = true);
 bool CheckBlock(int32_t *futureblockp,int32_t height,CBlockIndex *pindex,const CBlock& block, CValidationState& state,
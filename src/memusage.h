@@ -20,6 +20,8 @@
 #ifndef BITCOIN_MEMUSAGE_H
 #define BITCOIN_MEMUSAGE_H
 
+#include "flathashmap.h"
+
 #include <stdlib.h>
 
 #include <map>
@@ -130,6 +132,15 @@ static inline size_t DynamicUsage(const boost::unordered_map<X, Y, Z>& m)
     return MallocUsage(sizeof(boost_unordered_node<std::pair<const X, Y> >)) * m.size() + MallocUsage(sizeof(void*) * m.bucket_count());
 }
 
+// Flat hash map: the slot table plus the node chunks, whether their nodes are in use or free.
+// The chunks are large enough that their malloc overhead does not matter.
+
+template<typename X, typename Y, typename Z>
+static inline size_t DynamicUsage(const flathashmap<X, Y, Z>& m)
+{
+    return MallocUsage(m.table_bytes()) + m.pool_bytes();
+}
+
 }
 
 #endif
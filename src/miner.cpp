@@ -85,50 +85,197 @@ int32_t My_notaryid = -1;
 // transactions in the memory pool. When we select transactions from the
 // pool, we select by highest priority or fee rate, so we might consider
 // transactions that depend on transactions that aren't yet in the block.
-// The COrphan class keeps track of these 'temporary orphans' while
-// CreateBlock is figuring out which transactions to include.
+// CBlockCandidates keeps track of these 'temporary orphans' for
+// CreateBlock to figure out which transactions to include.
 //
-class COrphan
+
+uint64_t nLastBlockTx = 0;
+uint64_t nLastBlockSize = 0;
+
+size_t CBlockCandidates::Update(const CBlockIndex* pindexPrev, CCoinsViewCache& view, uint32_t nTime, int8_t numSN, uint8_t notarypubkeys[64][33])
 {
-public:
-    const CTransaction* ptx;
-    set<uint256> setDependsOn;
-    CFeeRate feeRate;
-    double dPriority;
+    const int nHeight = pindexPrev->GetHeight() + 1;
+    uint256 hashNotariesNow = Hash(BEGIN(numSN), END(numSN), &notarypubkeys[0][0], &notarypubkeys[0][0] + 64 * 33);
+    std::set<uint256> setUpdated;
+    bool fReset;
+    mempool.GetCandidateUpdates(setUpdated, fReset);
 
-    COrphan(const CTransaction* ptxIn) : ptx(ptxIn), feeRate(0), dPriority(0)
+    if (fReset || pindexPrev->GetBlockHash() != hashTip || hashNotariesNow != hashNotaries)
     {
+        mapCandidates.clear();
+        mapDependers.clear();
+        setNotarisations.clear();
+        setByPriority.clear();
+        setByFee.clear();
+        setCoinImports.clear();
+        hashTip = pindexPrev->GetBlockHash();
+        hashNotaries = hashNotariesNow;
+        for (CTxMemPool::indexed_transaction_set::iterator mi = mempool.mapTx.begin(); mi != mempool.mapTx.end(); ++mi)
+            Add(mi->GetTx(), view, nHeight, nTime, numSN, notarypubkeys);
+        return mempool.mapTx.size();
     }
-};
 
-uint64_t nLastBlockTx = 0;
-uint64_t nLastBlockSize = 0;
+    // all removals first, a new entry may have the memory of a removed one
+    setUpdated.insert(setCoinImports.begin(), setCoinImports.end());
+    BOOST_FOREACH(const uint256& hash, setUpdated)
+        Remove(hash);
+    BOOST_FOREACH(const uint256& hash, setUpdated)
+    {
+        CTxMemPool::indexed_transaction_set::iterator mi = mempool.mapTx.find(hash);
+        if (mi != mempool.mapTx.end())
+            Add(mi->GetTx(), view, nHeight, nTime, numSN, notarypubkeys);
+    }
+    return setUpdated.size();
+}
 
-// We want to sort transactions by priority and fee rate, so:
-typedef boost::tuple<double, CFeeRate, const CTransaction*> TxPriority;
-class TxPriorityCompare
+void CBlockCandidates::Add(const CTransaction& tx, CCoinsViewCache& view, int nHeight, uint32_t nTime, int8_t numSN, uint8_t notarypubkeys[64][33])
 {
-    bool byFee;
-
-public:
-    TxPriorityCompare(bool _byFee) : byFee(_byFee) { }
+    if (tx.IsCoinBase() || KOMODO_VALUETOOBIG(tx.GetValueOut()) != 0)
+        return;
 
-    bool operator()(const TxPriority& a, const TxPriority& b)
+    double dPriority = 0;
+    CAmount nTotalIn = 0;
+    std::set<uint256> setDependsOn;
+    std::vector<int8_t> vNotaries;
+    bool fNotarisation = false, fCoinImport = false;
+    if (tx.IsCoinImport())
     {
-        if (byFee)
+        fCoinImport = true;
+        CAmount nValueIn = GetCoinImportValue(tx, nTime, nHeight); // burn amount
+        nTotalIn += nValueIn;
+        dPriority += (double)nValueIn * 1000;  // flat multiplier... max = 1e16.
+    } else {
+        bool fToCryptoAddress = false;
+        if ( numSN != 0 && notarypubkeys[0][0] != 0 && komodo_is_notarytx(tx) == 1 )
+            fToCryptoAddress = true;
+
+        BOOST_FOREACH(const CTxIn& txin, tx.vin)
         {
-            if (a.get<1>() == b.get<1>())
-                return a.get<0>() < b.get<0>();
-            return a.get<1>() < b.get<1>();
+            if (tx.IsPegsImport() && txin.prevout.n==10e8)
+            {
+                fCoinImport = true;
+                CAmount nValueIn = GetCoinImportValue(tx, nTime, nHeight); // burn amount
+                nTotalIn += nValueIn;
+                dPriority += (double)nValueIn * 1000;  // flat multiplier... max = 1e16.
+                continue;
+            }
+            // Read prev transaction
+            if (!view.HaveCoins(txin.prevout.hash))
+            {
+                // This should never happen; all transactions in the memory
+                // pool should connect to either transactions in the chain
+                // or other transactions in the memory pool.
+                CTxMemPool::indexed_transaction_set::iterator mi = mempool.mapTx.find(txin.prevout.hash);
+                if (mi == mempool.mapTx.end())
+                {
+                    LogPrintf("ERROR: mempool transaction missing input\n");
+                    return;
+                }
+
+                // Has to wait for dependencies
+                setDependsOn.insert(txin.prevout.hash);
+                nTotalIn += mi->GetTx().vout[txin.prevout.n].nValue;
+                continue;
+            }
+            const CCoins* coins = view.AccessCoins(txin.prevout.hash);
+            assert(coins);
+
+            CAmount nValueIn = coins->vout[txin.prevout.n].nValue;
+            nTotalIn += nValueIn;
+
+            int nConf = nHeight - coins->nHeight;
+
+            uint8_t *script; int32_t scriptlen; uint256 hash; CTransaction tx1;
+            // loop over notaries array and extract index of signers.
+            if ( fToCryptoAddress && myGetTransaction(txin.prevout.hash,tx1,hash) )
+            {
+                for (int8_t i = 0; i < numSN; i++)
+                {
+                    script = (uint8_t *)&tx1.vout[txin.prevout.n].scriptPubKey[0];
+                    scriptlen = (int32_t)tx1.vout[txin.prevout.n].scriptPubKey.size();
+                    if ( scriptlen == 35 && script[0] == 33 && script[34] == OP_CHECKSIG && memcmp(script+1,notarypubkeys[i],33) == 0 )
+                    {
+                        // We can add the index of each notary to vector, and clear it if this notarisation is not valid later on.
+                        vNotaries.push_back(i);
+                    }
+                }
+            }
+            dPriority += (double)nValueIn * nConf;
         }
-        else
+        if ( numSN != 0 && notarypubkeys[0][0] != 0 && vNotaries.size() >= numSN / 5 )
         {
-            if (a.get<0>() == b.get<0>())
-                return a.get<1>() < b.get<1>();
-            return a.get<0>() < b.get<0>();
+            // check a notary didnt sign twice (this would be an invalid notarisation later on and cause problems)
+            std::set<int> checkdupes( vNotaries.begin(), vNotaries.end() );
+            if ( checkdupes.size() != vNotaries.size() )
+            {
+                fprintf(stderr, "possible notarisation is signed multiple times by same notary, passed as normal transaction.\n");
+            } else fNotarisation = true;
         }
+        nTotalIn += tx.GetShieldedValueIn();
     }
-};
+
+    // Priority is sum(valuein * age) / modified_txsize
+    unsigned int nTxSize = ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
+    dPriority = tx.ComputePriority(dPriority, nTxSize);
+
+    uint256 hash = tx.GetHash();
+    mempool.ApplyDeltas(hash, dPriority, nTotalIn);
+
+    CFeeRate feeRate(nTotalIn-tx.GetValueOut(), nTxSize);
+
+    // make sure notarisation is tx[1] in block
+    if ( !fNotarisation && dPriority == 1e16 )
+        dPriority -= 10;
+
+    Candidate& candidate = mapCandidates[hash];
+    candidate.ptx = &tx;
+    candidate.dPriority = dPriority;
+    candidate.feeRate = feeRate;
+    candidate.setDependsOn.swap(setDependsOn);
+    candidate.vNotaries.swap(vNotaries);
+    candidate.fNotarisation = fNotarisation;
+    candidate.fCoinImport = fCoinImport;
+    if ( fNotarisation )
+        setNotarisations.insert(hash);
+    if ( fCoinImport )
+        setCoinImports.insert(hash);
+    if (candidate.setDependsOn.empty())
+    {
+        setByPriority.insert(TxPriority(dPriority, feeRate, &tx));
+        setByFee.insert(TxPriority(dPriority, feeRate, &tx));
+    }
+    else
+    {
+        BOOST_FOREACH(const uint256& parent, candidate.setDependsOn)
+            mapDependers[parent].push_back(hash);
+    }
+}
+
+void CBlockCandidates::Remove(const uint256& hash)
+{
+    std::map<uint256, Candidate>::iterator it = mapCandidates.find(hash);
+    if (it == mapCandidates.end())
+        return;
+    // the transaction may be gone from the mempool already, ptx is only compared
+    const Candidate& candidate = it->second;
+    if (candidate.setDependsOn.empty())
+    {
+        setByPriority.erase(TxPriority(candidate.dPriority, candidate.feeRate, candidate.ptx));
+        setByFee.erase(TxPriority(candidate.dPriority, candidate.feeRate, candidate.ptx));
+    }
+    BOOST_FOREACH(const uint256& parent, candidate.setDependsOn)
+    {
+        std::vector<uint256>& vDependers = mapDependers[parent];
+        vDependers.erase(std::remove(vDependers.begin(), vDependers.end(), hash), vDependers.end());
+        if (vDependers.empty())
+            mapDependers.erase(parent);
+    }
+    setNotarisations.erase(hash);
+    setCoinImports.erase(hash);
+    mapCandidates.erase(it);
+}
+
+static CBlockCandidates blockCandidates;
 
 void UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev)
 {
@@ -275,187 +422,66 @@ CBlockTemplate* CreateNewBlock(CPubKey _pk,const CScript& _scriptPubKeyIn, int32
         SaplingMerkleTree sapling_tree;
         assert(view.GetSaplingAnchorAt(view.GetBestAnchor(SAPLING), sapling_tree));
 
-        // Priority order to process transactions
-        list<COrphan> vOrphan; // list memory doesn't move
-        map<uint256, vector<COrphan*> > mapDependers;
         bool fPrintPriority = GetBoolArg("-printpriority", false);
 
-        // This vector will be sorted into a priority queue:
-        vector<TxPriority> vecPriority;
-        vecPriority.reserve(mempool.mapTx.size() + 1);
+        // the mempool changes since the last template, or all of it on a new tip
+        blockCandidates.Update(pindexPrev, view, pblock->nTime, numSN, notarypubkeys);
 
-        // now add transactions from the mem pool
-        int32_t Notarisations = 0; uint64_t txvalue;
-        for (CTxMemPool::indexed_transaction_set::iterator mi = mempool.mapTx.begin();
-             mi != mempool.mapTx.end(); ++mi)
+        // what depends on the block time is checked here, the rest when the candidate was added
+        int64_t nLockTimeCutoff = (STANDARD_LOCKTIME_VERIFY_FLAGS & LOCKTIME_MEDIAN_TIME_PAST)
+        ? nMedianTimePast
+        : pblock->GetBlockTime();
+        auto IsBlockTx = [&](const CTransaction& tx) -> bool
         {
-            //break; // dont add any tx to block.. debug for KMD fix. Disabled. 
-            const CTransaction& tx = mi->GetTx();
-
-            int64_t nLockTimeCutoff = (STANDARD_LOCKTIME_VERIFY_FLAGS & LOCKTIME_MEDIAN_TIME_PAST)
-            ? nMedianTimePast
-            : pblock->GetBlockTime();
-
-            if (tx.IsCoinBase() || !IsFinalTx(tx, nHeight, nLockTimeCutoff) || IsExpiredTx(tx, nHeight))
-            {
-                //fprintf(stderr,"coinbase.%d finaltx.%d expired.%d\n",tx.IsCoinBase(),IsFinalTx(tx, nHeight, nLockTimeCutoff),IsExpiredTx(tx, nHeight));
-                continue;
-            }
-            txvalue = tx.GetValueOut();
-            if ( KOMODO_VALUETOOBIG(txvalue) != 0 )
-                continue;
-            //if ( KOMODO_VALUETOOBIG(txvalue + voutsum) != 0 ) // has been commented from main.cpp ? 
-            //    continue;
-            //voutsum += txvalue;
+            if (!IsFinalTx(tx, nHeight, nLockTimeCutoff) || IsExpiredTx(tx, nHeight))
+                return false;
             if ( ASSETCHAINS_SYMBOL[0] == 0 && komodo_validate_interest(tx,nHeight,(uint32_t)pblock->nTime,0) < 0 )
             {
                 fprintf(stderr,"CreateNewBlock: komodo_validate_interest failure txid.%s nHeight.%d nTime.%u vs locktime.%u\n",tx.GetHash().ToString().c_str(),nHeight,(uint32_t)pblock->nTime,(uint32_t)tx.nLockTime);
-                continue;
+                return false;
             }
+            return true;
+        };
 
-            COrphan* porphan = NULL;
-            double dPriority = 0;
-            CAmount nTotalIn = 0;
-            bool fMissingInputs = false;
-            bool fNotarisation = false;
-            std::vector<int8_t> TMP_NotarisationNotaries;
-            if (tx.IsCoinImport())
-            {
-                CAmount nValueIn = GetCoinImportValue(tx, pblock->nTime, nHeight); // burn amount
-                nTotalIn += nValueIn;
-                dPriority += (double)nValueIn * 1000;  // flat multiplier... max = 1e16.
-            } else {
-                TMP_NotarisationNotaries.clear();
-                bool fToCryptoAddress = false;
-                if ( numSN != 0 && notarypubkeys[0][0] != 0 && komodo_is_notarytx(tx) == 1 )
-                    fToCryptoAddress = true;
+        // taken or skipped in this template
+        std::set<const CTransaction*> setConsidered;
 
-                BOOST_FOREACH(const CTxIn& txin, tx.vin)
+        // Special miner for notary pay chains, the first notarisation goes in as TX1 and any
+        // other waits for a later block. Only set if numSN/notarypubkeys is set higher up.
+        int32_t Notarisations = 0;
+        const CBlockCandidates::Candidate* pNotarisation = NULL;
+        BOOST_FOREACH(const uint256& hash, blockCandidates.setNotarisations)
+        {
+            const CBlockCandidates::Candidate& candidate = blockCandidates.mapCandidates[hash];
+            const CTransaction& tx = *candidate.ptx;
+            if ( !IsBlockTx(tx) )
+                continue;
+            if ( tx.vout.size() == 2 && tx.vout[1].nValue == 0 )
+            {
+                // Get the OP_RETURN for the notarisation
+                uint8_t *script = (uint8_t *)&tx.vout[1].scriptPubKey[0];
+                int32_t scriptlen = (int32_t)tx.vout[1].scriptPubKey.size();
+                if ( script[0] == OP_RETURN )
                 {
-                    if (tx.IsPegsImport() && txin.prevout.n==10e8)
+                    Notarisations++;
+                    if ( Notarisations > 1 )
                     {
-                        CAmount nValueIn = GetCoinImportValue(tx, pblock->nTime, nHeight); // burn amount
-                        nTotalIn += nValueIn;
-                        dPriority += (double)nValueIn * 1000;  // flat multiplier... max = 1e16.
+                        fprintf(stderr, "skipping notarization.%d\n",Notarisations);
+                        // Any attempted notarization needs to be in its own block!
+                        setConsidered.insert(&tx);
                         continue;
                     }
-                    // Read prev transaction
-                    if (!view.HaveCoins(txin.prevout.hash))
-                    {
-                        // This should never happen; all transactions in the memory
-                        // pool should connect to either transactions in the chain
-                        // or other transactions in the memory pool.
-                        if (!mempool.mapTx.count(txin.prevout.hash))
-                        {
-                            LogPrintf("ERROR: mempool transaction missing input\n");
-                            // if (fDebug) assert("mempool transaction missing input" == 0);
-                            fMissingInputs = true;
-                            if (porphan)
-                                vOrphan.pop_back();
-                            break;
-                        }
-
-                        // Has to wait for dependencies
-                        if (!porphan)
-                        {
-                            // Use list for automatic deletion
-                            vOrphan.push_back(COrphan(&tx));
-                            porphan = &vOrphan.back();
-                        }
-                        mapDependers[txin.prevout.hash].push_back(porphan);
-                        porphan->setDependsOn.insert(txin.prevout.hash);
-                        nTotalIn += mempool.mapTx.find(txin.prevout.hash)->GetTx().vout[txin.prevout.n].nValue;
-                        continue;
-                    }
-                    const CCoins* coins = view.AccessCoins(txin.prevout.hash);
-                    assert(coins);
-
-                    CAmount nValueIn = coins->vout[txin.prevout.n].nValue;
-                    nTotalIn += nValueIn;
-
-                    int nConf = nHeight - coins->nHeight;
-                    
-                    uint8_t *script; int32_t scriptlen; uint256 hash; CTransaction tx1;
-                    // loop over notaries array and extract index of signers.
-                    if ( fToCryptoAddress && myGetTransaction(txin.prevout.hash,tx1,hash) )
+                    int32_t notarizedheight = komodo_getnotarizedheight(pblock->nTime, nHeight, script, scriptlen);
+                    if ( notarizedheight != 0 )
                     {
-                        for (int8_t i = 0; i < numSN; i++) 
-                        {
-                            script = (uint8_t *)&tx1.vout[txin.prevout.n].scriptPubKey[0];
-                            scriptlen = (int32_t)tx1.vout[txin.prevout.n].scriptPubKey.size();
-                            if ( scriptlen == 35 && script[0] == 33 && script[34] == OP_CHECKSIG && memcmp(script+1,notarypubkeys[i],33) == 0 )
-                            {
-                                // We can add the index of each notary to vector, and clear it if this notarisation is not valid later on.
-                                TMP_NotarisationNotaries.push_back(i);                          
-                            }
-                        }
+                        // this is the first one we see, add it to the block as TX1
+                        NotarisationNotaries = candidate.vNotaries;
+                        pNotarisation = &candidate;
+                        fNotarisationBlock = true;
+                        //fprintf(stderr, "Notarisation %s set to maximum priority\n",hash.ToString().c_str());
                     }
-                    dPriority += (double)nValueIn * nConf;
-                }
-                if ( numSN != 0 && notarypubkeys[0][0] != 0 && TMP_NotarisationNotaries.size() >= numSN / 5 )
-                {
-                    // check a notary didnt sign twice (this would be an invalid notarisation later on and cause problems)
-                    std::set<int> checkdupes( TMP_NotarisationNotaries.begin(), TMP_NotarisationNotaries.end() );
-                    if ( checkdupes.size() != TMP_NotarisationNotaries.size() ) 
-                    {
-                        fprintf(stderr, "possible notarisation is signed multiple times by same notary, passed as normal transaction.\n");
-                    } else fNotarisation = true;
                 }
-                nTotalIn += tx.GetShieldedValueIn();
             }
-
-            if (fMissingInputs) continue;
-
-            // Priority is sum(valuein * age) / modified_txsize
-            unsigned int nTxSize = ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
-            dPriority = tx.ComputePriority(dPriority, nTxSize);
-
-            uint256 hash = tx.GetHash();
-            mempool.ApplyDeltas(hash, dPriority, nTotalIn);
-
-            CFeeRate feeRate(nTotalIn-tx.GetValueOut(), nTxSize);
-
-            if ( fNotarisation ) 
-            {
-                // Special miner for notary pay chains. Can only enter this if numSN/notarypubkeys is set higher up.
-                if ( tx.vout.size() == 2 && tx.vout[1].nValue == 0 )
-                {
-                    // Get the OP_RETURN for the notarisation
-                    uint8_t *script = (uint8_t *)&tx.vout[1].scriptPubKey[0];
-                    int32_t scriptlen = (int32_t)tx.vout[1].scriptPubKey.size();
-                    if ( script[0] == OP_RETURN )
-                    {
-                        Notarisations++;
-                        if ( Notarisations > 1 ) 
-                        {
-                            fprintf(stderr, "skipping notarization.%d\n",Notarisations);
-                            // Any attempted notarization needs to be in its own block!
-                            continue;
-                        }
-                        int32_t notarizedheight = komodo_getnotarizedheight(pblock->nTime, nHeight, script, scriptlen);
-                        if ( notarizedheight != 0 )
-                        {
-                            // this is the first one we see, add it to the block as TX1 
-                            NotarisationNotaries = TMP_NotarisationNotaries;
-                            dPriority = 1e16;
-                            fNotarisationBlock = true;
-                            //fprintf(stderr, "Notarisation %s set to maximum priority\n",hash.ToString().c_str());
-                        }
-                    }
-                }
-            }
-            else if ( dPriority == 1e16 )
-            {
-                dPriority -= 10;
-                // make sure notarisation is tx[1] in block. 
-            }
-            if (porphan)
-            {
-                porphan->dPriority = dPriority;
-                porphan->feeRate = feeRate;
-            }
-            else
-                vecPriority.push_back(TxPriority(dPriority, feeRate, &(mi->GetTx())));
         }
 
         // Collect transactions into block
@@ -464,19 +490,47 @@ CBlockTemplate* CreateNewBlock(CPubKey _pk,const CScript& _scriptPubKeyIn, int32
         int64_t interest;
         int nBlockSigOps = 100;
         bool fSortedByFee = (nBlockPrioritySize <= 0);
+        // a nearly full block stops after this many candidates in a row did not fit
+        const int nMaxConsecutiveFailed = 1000;
+        int nConsecutiveFailed = 0;
 
         TxPriorityCompare comparer(fSortedByFee);
-        std::make_heap(vecPriority.begin(), vecPriority.end(), comparer);
 
-        while (!vecPriority.empty())
+        // The candidates come from the front of the sorted set, merged with this heap of the
+        // notarisation and the transactions whose mempool inputs made it into the block
+        const std::set<TxPriority, TxPriorityOrder>* psetSorted = fSortedByFee ? &blockCandidates.setByFee : &blockCandidates.setByPriority;
+        std::set<TxPriority, TxPriorityOrder>::const_iterator itSorted = psetSorted->begin();
+        vector<TxPriority> vecPriority;
+        map<uint256, size_t> mapInputsInBlock;
+        if ( pNotarisation != NULL && pNotarisation->setDependsOn.empty() )
         {
-            // Take highest priority transaction off the priority queue:
-            double dPriority = vecPriority.front().get<0>();
-            CFeeRate feeRate = vecPriority.front().get<1>();
-            const CTransaction& tx = *(vecPriority.front().get<2>());
+            vecPriority.push_back(TxPriority(1e16, pNotarisation->feeRate, pNotarisation->ptx));
+            setConsidered.insert(pNotarisation->ptx);
+        }
+
+        while (true)
+        {
+            // Take highest priority transaction of the two
+            while (itSorted != psetSorted->end() && setConsidered.count(itSorted->get<2>()))
+                ++itSorted;
+            TxPriority next;
+            if (!vecPriority.empty() && (itSorted == psetSorted->end() || comparer(*itSorted, vecPriority.front())))
+            {
+                next = vecPriority.front();
+                std::pop_heap(vecPriority.begin(), vecPriority.end(), comparer);
+                vecPriority.pop_back();
+            }
+            else if (itSorted != psetSorted->end())
+                next = *itSorted++;
+            else
+                break;
+            double dPriority = next.get<0>();
+            CFeeRate feeRate = next.get<1>();
+            const CTransaction& tx = *(next.get<2>());
+            setConsidered.insert(&tx);
 
-            std::pop_heap(vecPriority.begin(), vecPriority.end(), comparer);
-            vecPriority.pop_back();
+            if (!IsBlockTx(tx))
+                continue;
 
             // Size limits
             unsigned int nTxSize = ::GetSerializeSize(tx, SER_NETWORK, PROTOCOL_VERSION);
@@ -517,9 +571,10 @@ CBlockTemplate* CreateNewBlock(CPubKey _pk,const CScript& _scriptPubKeyIn, int32
             if (nBlockSize + nTxSize >= nBlockMaxSize-512) // room for extra autotx
             {
                 //fprintf(stderr,"nBlockSize %d + %d nTxSize >= %d nBlockMaxSize\n",(int32_t)nBlockSize,(int32_t)nTxSize,(int32_t)nBlockMaxSize);
+                if (nBlockSize >= nBlockMaxSize-4000 && ++nConsecutiveFailed > nMaxConsecutiveFailed)
+                    break;
                 continue;
             }
-
             // Legacy limits on sigOps:
             unsigned int nTxSigOps = GetLegacySigOpCount(tx);
             if (nBlockSigOps + nTxSigOps >= MAX_BLOCK_SIGOPS-1)
@@ -545,6 +600,8 @@ CBlockTemplate* CreateNewBlock(CPubKey _pk,const CScript& _scriptPubKeyIn, int32
                 fSortedByFee = true;
                 comparer = TxPriorityCompare(fSortedByFee);
                 std::make_heap(vecPriority.begin(), vecPriority.end(), comparer);
+                psetSorted = &blockCandidates.setByFee;
+                itSorted = psetSorted->begin();
             }
 
             if (!view.HaveInputs(tx))
@@ -585,6 +642,7 @@ CBlockTemplate* CreateNewBlock(CPubKey _pk,const CScript& _scriptPubKeyIn, int32
             ++nBlockTx;
             nBlockSigOps += nTxSigOps;
             nFees += nTxFees;
+            nConsecutiveFailed = 0;
 
             if (fPrintPriority)
             {
@@ -592,18 +650,19 @@ CBlockTemplate* CreateNewBlock(CPubKey _pk,const CScript& _scriptPubKeyIn, int32
             }
 
             // Add transactions that depend on this one to the priority queue
-            if (mapDependers.count(hash))
+            map<uint256, vector<uint256> >::const_iterator itDependers = blockCandidates.mapDependers.find(hash);
+            if (itDependers != blockCandidates.mapDependers.end())
             {
-                BOOST_FOREACH(COrphan* porphan, mapDependers[hash])
+                BOOST_FOREACH(const uint256& depender, itDependers->second)
                 {
-                    if (!porphan->setDependsOn.empty())
+                    map<uint256, CBlockCandidates::Candidate>::const_iterator itCandidate = blockCandidates.mapCandidates.find(depender);
+                    if (itCandidate == blockCandidates.mapCandidates.end())
+                        continue;
+                    const CBlockCandidates::Candidate& candidate = itCandidate->second;
+                    if (++mapInputsInBlock[depender] == candidate.setDependsOn.size())
                     {
-                        porphan->setDependsOn.erase(hash);
-                        if (porphan->setDependsOn.empty())
-                        {
-                            vecPriority.push_back(TxPriority(porphan->dPriority, porphan->feeRate, porphan->ptx));
-                            std::push_heap(vecPriority.begin(), vecPriority.end(), comparer);
-                        }
+                        vecPriority.push_back(TxPriority(&candidate == pNotarisation ? 1e16 : candidate.dPriority, candidate.feeRate, candidate.ptx));
+                        std::push_heap(vecPriority.begin(), vecPriority.end(), comparer);
                     }
                 }
             }
@@ -21,12 +21,19 @@
 #ifndef BITCOIN_MINER_H
 #define BITCOIN_MINER_H
 
+#include "amount.h"
 #include "primitives/block.h"
 
+#include <map>
+#include <set>
+#include <vector>
+
 #include <boost/optional.hpp>
+#include <boost/tuple/tuple.hpp>
 #include <stdint.h>
 
 class CBlockIndex;
+class CCoinsViewCache;
 class CScript;
 #ifdef ENABLE_WALLET
 class CReserveKey;
@@ -42,6 +49,97 @@ struct CBlockTemplate
 };
 #define KOMODO_MAXGPUCOUNT 65
 
+// We want to sort transactions by priority and fee rate, so:
+typedef boost::tuple<double, CFeeRate, const CTransaction*> TxPriority;
+class TxPriorityCompare
+{
+    bool byFee;
+
+public:
+    TxPriorityCompare(bool _byFee) : byFee(_byFee) { }
+
+    bool operator()(const TxPriority& a, const TxPriority& b)
+    {
+        if (byFee)
+        {
+            if (a.get<1>() == b.get<1>())
+                return a.get<0>() < b.get<0>();
+            return a.get<1>() < b.get<1>();
+        }
+        else
+        {
+            if (a.get<0>() == b.get<0>())
+                return a.get<1>() < b.get<1>();
+            return a.get<0>() < b.get<0>();
+        }
+    }
+};
+
+// Highest first in the order the miner takes transactions, ties by the mempool entry so a set keeps them all
+class TxPriorityOrder
+{
+    bool byFee;
+
+public:
+    TxPriorityOrder(bool _byFee) : byFee(_byFee) { }
+
+    bool operator()(const TxPriority& a, const TxPriority& b) const
+    {
+        TxPriorityCompare comparer(byFee);
+        if (comparer(b, a))
+            return true;
+        if (comparer(a, b))
+            return false;
+        return a.get<2>() < b.get<2>();
+    }
+};
+
+/**
+ * The mempool transactions a block template is made of, kept between calls to CreateNewBlock.
+ * What stays the same until the next block (inputs, priority, fee rate, notary signers) is worked
+ * out once per transaction as the mempool reports it added, removed or reprioritised, and the
+ * transactions with no inputs in the mempool are kept sorted both by priority and by fee rate.
+ * A template then takes them from the front instead of walking and sorting the whole mempool.
+ * Everything is redone when the tip or the notaries change, coin imports for every template as
+ * their value depends on the block time. Used under cs_main and mempool.cs.
+ */
+class CBlockCandidates
+{
+public:
+    struct Candidate
+    {
+        const CTransaction* ptx; // the entry in mempool.mapTx, removed here before it is looked at again
+        double dPriority;
+        CFeeRate feeRate;
+        std::set<uint256> setDependsOn;
+        std::vector<int8_t> vNotaries;
+        bool fNotarisation;
+        bool fCoinImport; // the burned value, so priority and fee rate, depends on the block time
+    };
+
+    std::map<uint256, Candidate> mapCandidates;
+    std::map<uint256, std::vector<uint256> > mapDependers;
+    // ordered by uint256::operator<, the order of mempool.mapTx's first index (ordered_unique by txid, see
+    // txmempool.h), which the old mempool walk took notarisations in. keep it so the same one goes in as tx1
+    std::set<uint256> setNotarisations;
+    std::set<TxPriority, TxPriorityOrder> setByPriority;
+    std::set<TxPriority, TxPriorityOrder> setByFee;
+    // coin imports, added again for every template with its own block time
+    std::set<uint256> setCoinImports;
+
+    CBlockCandidates() : setByPriority(TxPriorityOrder(false)), setByFee(TxPriorityOrder(true)) { }
+
+    //! brings the candidates up to date for a block on pindexPrev, returns the number of transactions looked at
+    size_t Update(const CBlockIndex* pindexPrev, CCoinsViewCache& view, uint32_t nTime, int8_t numSN, uint8_t notarypubkeys[64][33]);
+
+private:
+    uint256 hashTip;
+    uint256 hashNotaries;
+
+    void Add(const CTransaction& tx, CCoinsViewCache& view, int nHeight, uint32_t nTime, int8_t numSN, uint8_t notarypubkeys[64][33]);
+    void Remove(const uint256& hash);
+};
+
 /** Generate a new block, without valid proof-of-work */
 CBlockTemplate* CreateNewBlock(CPubKey _pk,const CScript& scriptPubKeyIn, int32_t gpucount, bool isStake = false);
 #ifdef ENABLE_WALLET
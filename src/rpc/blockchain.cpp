@@ -34,6 +34,7 @@
 #include "util.h"
 #include "script/script.h"
 #include "script/script_error.h"
+#include "script/sigcache.h"
 #include "script/sign.h"
 #include "script/standard.h"
 
@@ -284,58 +285,67 @@ UniValue blockToDeltasJSON(const CBlock& block, const CBlockIndex* blockindex)
     return result;
 }
 
-UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails)
+void blockToJSON(JSONStream& out, const CBlock& block, const CBlockIndex* blockindex, bool txDetails)
 {
-    UniValue result(UniValue::VOBJ);
+    out.BeginObject();
     uint256 notarized_hash, notarized_desttxid; int32_t prevMoMheight, notarized_height;
     notarized_height = komodo_notarized_height(&prevMoMheight, &notarized_hash, &notarized_desttxid);
-    result.push_back(Pair("last_notarized_height", notarized_height));
-    result.push_back(Pair("hash", block.GetHash().GetHex()));
+    out.PushKV("last_notarized_height", notarized_height);
+    out.PushKV("hash", block.GetHash().GetHex());
     int confirmations = -1;
     // Only report confirmations if the block is on the main chain
     if (chainActive.Contains(blockindex))
         confirmations = chainActive.Height() - blockindex->GetHeight() + 1;
-    result.push_back(Pair("confirmations", komodo_dpowconfs(blockindex->GetHeight(), confirmations)));
-    result.push_back(Pair("rawconfirmations", confirmations));
-    result.push_back(Pair("size", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION)));
-    result.push_back(Pair("height", blockindex->GetHeight()));
-    result.push_back(Pair("version", block.nVersion));
-    result.push_back(Pair("merkleroot", block.hashMerkleRoot.GetHex()));
-    result.push_back(Pair("segid", (int)komodo_segid(0, blockindex->GetHeight())));
-    result.push_back(Pair("finalsaplingroot", block.hashFinalSaplingRoot.GetHex()));
-    UniValue txs(UniValue::VARR);
+    out.PushKV("confirmations", komodo_dpowconfs(blockindex->GetHeight(), confirmations));
+    out.PushKV("rawconfirmations", confirmations);
+    out.PushKV("size", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION));
+    out.PushKV("height", blockindex->GetHeight());
+    out.PushKV("version", block.nVersion);
+    out.PushKV("merkleroot", block.hashMerkleRoot.GetHex());
+    out.PushKV("segid", (int)komodo_segid(0, blockindex->GetHeight()));
+    out.PushKV("finalsaplingroot", block.hashFinalSaplingRoot.GetHex());
+    // one tx at a time, only a single tx object is built at once
+    out.Key("tx");
+    out.BeginArray();
     BOOST_FOREACH(const CTransaction&tx, block.vtx)
     {
         if (txDetails)
         {
             UniValue objTx(UniValue::VOBJ);
             TxToJSON(tx, uint256(), objTx);
-            txs.push_back(objTx);
+            out.Push(objTx);
         }
         else
-            txs.push_back(tx.GetHash().GetHex());
-    }
-    result.push_back(Pair("tx", txs));
-    result.push_back(Pair("time", block.GetBlockTime()));
-    result.push_back(Pair("nonce", block.nNonce.GetHex()));
-    result.push_back(Pair("solution", HexStr(block.nSolution)));
-    result.push_back(Pair("bits", strprintf("%08x", block.nBits)));
-    result.push_back(Pair("difficulty", GetDifficulty(blockindex)));
-    result.push_back(Pair("chainwork", blockindex->chainPower.chainWork.GetHex()));
-    result.push_back(Pair("anchor", blockindex->hashFinalSproutRoot.GetHex()));
-    result.push_back(Pair("blocktype", block.IsVerusPOSBlock() ? "minted" : "mined"));
+            out.Push(tx.GetHash().GetHex());
+    }
+    out.EndArray();
+    out.PushKV("time", block.GetBlockTime());
+    out.PushKV("nonce", block.nNonce.GetHex());
+    out.PushKV("solution", HexStr(block.nSolution));
+    out.PushKV("bits", strprintf("%08x", block.nBits));
+    out.PushKV("difficulty", GetDifficulty(blockindex));
+    out.PushKV("chainwork", blockindex->chainPower.chainWork.GetHex());
+    out.PushKV("anchor", blockindex->hashFinalSproutRoot.GetHex());
+    out.PushKV("blocktype", block.IsVerusPOSBlock() ? "minted" : "mined");
 
     UniValue valuePools(UniValue::VARR);
     valuePools.push_back(ValuePoolDesc("sprout", blockindex->nChainSproutValue, blockindex->nSproutValue));
     valuePools.push_back(ValuePoolDesc("sapling", blockindex->nChainSaplingValue, blockindex->nSaplingValue));
-    result.push_back(Pair("valuePools", valuePools));
+    out.PushKV("valuePools", valuePools);
 
     if (blockindex->pprev)
-        result.push_back(Pair("previousblockhash", blockindex->pprev->GetBlockHash().GetHex()));
+        out.PushKV("previousblockhash", blockindex->pprev->GetBlockHash().GetHex());
     CBlockIndex *pnext = chainActive.Next(blockindex);
     if (pnext)
-        result.push_back(Pair("nextblockhash", pnext->GetBlockHash().GetHex()));
-    return result;
+        out.PushKV("nextblockhash", pnext->GetBlockHash().GetHex());
+    out.EndObject();
+}
+
+UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails)
+{
+    UniValueJSONStream out;
+    blockToJSON(out, block, blockindex, txDetails);
+    return out.Get();
 }
 
 UniValue getblockcount(const UniValue& params, bool fHelp, const CPubKey& mypk)
@@ -792,7 +802,7 @@ UniValue getblockheader(const UniValue& params, bool fHelp, const CPubKey& mypk)
     return blockheaderToJSON(pblockindex);
 }
 
-UniValue getblock(const UniValue& params, bool fHelp, const CPubKey& mypk)
+void getblock_stream(const UniValue& params, bool fHelp, const CPubKey& mypk, JSONStream& out)
 {
     if (fHelp || params.size() < 1 || params.size() > 2)
         throw runtime_error(
@@ -900,10 +910,16 @@ UniValue getblock(const UniValue& params, bool fHelp, const CPubKey& mypk)
         CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
         ssBlock << block;
         std::string strHex = HexStr(ssBlock.begin(), ssBlock.end());
-        return strHex;
+        out.Push(strHex);
+        return;
     }
 
-    return blockToJSON(block, pblockindex, verbosity >= 2);
+    blockToJSON(out, block, pblockindex, verbosity >= 2);
+}
+
+UniValue getblock(const UniValue& params, bool fHelp, const CPubKey& mypk)
+{
+    return RPCStreamToUniValue(getblock_stream, params, fHelp, mypk);
 }
 
 UniValue gettxoutsetinfo(const UniValue& params, bool fHelp, const CPubKey& mypk)
@@ -1649,6 +1665,45 @@ UniValue getmempoolinfo(const UniValue& params, bool fHelp, const CPubKey& mypk)
     return mempoolInfoToJSON();
 }
 
+static UniValue sigCacheStatsToJSON(const CSignatureCacheStats &stats)
+{
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("hits", (uint64_t)stats.hits));
+    ret.push_back(Pair("misses", (uint64_t)stats.misses));
+    ret.push_back(Pair("inserts", (uint64_t)stats.inserts));
+    ret.push_back(Pair("entries", (uint64_t)stats.entries));
+    ret.push_back(Pair("bytes", (uint64_t)stats.bytes));
+    return ret;
+}
+
+UniValue getsigcacheinfo(const UniValue& params, bool fHelp, const CPubKey& mypk)
+{
+    if (fHelp || params.size() != 0)
+        throw runtime_error(
+            "getsigcacheinfo\n"
+            "\nReturns the counters of the signature caches since startup.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"signatures\": {             (object) the ecdsa signature cache\n"
+            "    \"hits\": xxxxx             (numeric) lookups found in the cache\n"
+            "    \"misses\": xxxxx           (numeric) lookups not found in the cache\n"
+            "    \"inserts\": xxxxx          (numeric) valid checks added to the cache\n"
+            "    \"entries\": xxxxx          (numeric) capacity of the cache\n"
+            "    \"bytes\": xxxxx            (numeric) memory used by the cache\n"
+            "  },\n"
+            "  \"cryptoconditions\": { ... }  (object) the cryptocondition fulfillment cache, same fields\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getsigcacheinfo", "")
+            + HelpExampleRpc("getsigcacheinfo", "")
+        );
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("signatures", sigCacheStatsToJSON(signatureCache.GetStats())));
+    ret.push_back(Pair("cryptoconditions", sigCacheStatsToJSON(ccSignatureCache.GetStats())));
+    return ret;
+}
+
 inline CBlockIndex* LookupBlockIndex(const uint256& hash)
 {
     AssertLockHeld(cs_main);
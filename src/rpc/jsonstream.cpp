@@ -0,0 +1,141 @@
+// Copyright (c) 2009-2014 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "rpc/jsonstream.h"
+
+#include <assert.h>
+
+void UniValueJSONStream::Add(const std::string& k, const UniValue& value)
+{
+    if (stack.empty())
+        result = value;
+    else if (stack.back().isObject())
+        stack.back().__pushKV(k, value);
+    else
+        stack.back().push_back(value);
+}
+
+void UniValueJSONStream::BeginObject()
+{
+    stack.push_back(UniValue(UniValue::VOBJ));
+    keys.push_back(key);
+}
+
+void UniValueJSONStream::EndObject()
+{
+    assert(!stack.empty() && stack.back().isObject());
+    UniValue value = stack.back();
+    std::string k = keys.back();
+    stack.pop_back();
+    keys.pop_back();
+    Add(k, value);
+}
+
+void UniValueJSONStream::BeginArray()
+{
+    stack.push_back(UniValue(UniValue::VARR));
+    keys.push_back(key);
+}
+
+void UniValueJSONStream::EndArray()
+{
+    assert(!stack.empty() && stack.back().isArray());
+    UniValue value = stack.back();
+    std::string k = keys.back();
+    stack.pop_back();
+    keys.pop_back();
+    Add(k, value);
+}
+
+void UniValueJSONStream::Key(const std::string& k)
+{
+    key = k;
+}
+
+void UniValueJSONStream::Push(const UniValue& value)
+{
+    Add(key, value);
+}
+
+TextJSONStream::TextJSONStream(size_t nChunkSizeIn, const FlushFn& flushIn) :
+    fAfterKey(false), nChunkSize(nChunkSizeIn), flush(flushIn)
+{
+}
+
+void TextJSONStream::Separate()
+{
+    if (fAfterKey) {
+        fAfterKey = false;
+        return;
+    }
+    if (!levels.empty()) {
+        if (!levels.back())
+            buf += ',';
+        levels.back() = false;
+    }
+}
+
+void TextJSONStream::Check()
+{
+    if (buf.size() >= nChunkSize)
+        Flush();
+}
+
+void TextJSONStream::BeginObject()
+{
+    Separate();
+    buf += '{';
+    levels.push_back(true);
+}
+
+void TextJSONStream::EndObject()
+{
+    assert(!levels.empty());
+    levels.pop_back();
+    buf += '}';
+    Check();
+}
+
+void TextJSONStream::BeginArray()
+{
+    Separate();
+    buf += '[';
+    levels.push_back(true);
+}
+
+void TextJSONStream::EndArray()
+{
+    assert(!levels.empty());
+    levels.pop_back();
+    buf += ']';
+    Check();
+}
+
+void TextJSONStream::Key(const std::string& key)
+{
+    Separate();
+    buf += UniValue(key).write();
+    buf += ':';
+    fAfterKey = true;
+}
+
+void TextJSONStream::Push(const UniValue& value)
+{
+    Separate();
+    buf += value.write();
+    Check();
+}
+
+void TextJSONStream::Raw(const std::string& text)
+{
+    buf += text;
+}
+
+void TextJSONStream::Flush()
+{
+    if (!buf.empty()) {
+        flush(buf);
+        buf.clear();
+    }
+}
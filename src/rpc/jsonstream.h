@@ -0,0 +1,100 @@
+// Copyright (c) 2009-2014 The Bitcoin Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPCJSONSTREAM_H
+#define BITCOIN_RPCJSONSTREAM_H
+
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+
+#include <univalue.h>
+
+/**
+ * Output of an RPC result written piece by piece, so a large result never has to exist as one
+ * UniValue tree. Containers are opened and closed explicitly, the members in between are
+ * pushed as complete values, keys only inside objects.
+ */
+class JSONStream
+{
+public:
+    virtual ~JSONStream() {}
+
+    virtual void BeginObject() = 0;
+    virtual void EndObject() = 0;
+    virtual void BeginArray() = 0;
+    virtual void EndArray() = 0;
+    /** Key of the next object member, which is a value or a container */
+    virtual void Key(const std::string& key) = 0;
+    virtual void Push(const UniValue& value) = 0;
+
+    void PushKV(const std::string& key, const UniValue& value)
+    {
+        Key(key);
+        Push(value);
+    }
+};
+
+/** Builds the whole result as a UniValue, for batches and in-process callers. */
+class UniValueJSONStream : public JSONStream
+{
+private:
+    std::vector<UniValue> stack;
+    std::vector<std::string> keys;
+    std::string key;
+    UniValue result;
+
+    void Add(const std::string& k, const UniValue& value);
+
+public:
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    void Key(const std::string& k);
+    void Push(const UniValue& value);
+
+    const UniValue& Get() const { return result; }
+};
+
+/**
+ * Serializes the result into the same compact text as UniValue::write(), handing the text out
+ * whenever at least nChunkSize bytes are buffered.
+ */
+class TextJSONStream : public JSONStream
+{
+public:
+    typedef boost::function<void(const std::string&)> FlushFn;
+
+private:
+    std::string buf;
+    // per open container, true until its first member is written
+    std::vector<bool> levels;
+    bool fAfterKey;
+    size_t nChunkSize;
+    FlushFn flush;
+
+    void Separate();
+    void Check();
+
+public:
+    TextJSONStream(size_t nChunkSizeIn, const FlushFn& flushIn);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    void Key(const std::string& key);
+    void Push(const UniValue& value);
+
+    /** Appends text as is, for the reply envelope around the result */
+    void Raw(const std::string& text);
+    /** Hands out what is buffered, if anything */
+    void Flush();
+    /** Text not handed out yet */
+    const std::string& Buffered() const { return buf; }
+};
+
+#endif // BITCOIN_RPCJSONSTREAM_H
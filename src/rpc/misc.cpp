@@ -996,7 +996,7 @@ UniValue getaddressmempool(const UniValue& params, bool fHelp, const CPubKey& my
     return result;
 }
 
-UniValue getaddressutxos(const UniValue& params, bool fHelp, const CPubKey& mypk)
+void getaddressutxos_stream(const UniValue& params, bool fHelp, const CPubKey& mypk, JSONStream& out)
 {
     if (fHelp || params.size() > 2 || params.size() == 0)
         throw runtime_error(
@@ -1052,7 +1052,11 @@ UniValue getaddressutxos(const UniValue& params, bool fHelp, const CPubKey& mypk
 
     std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
 
-    UniValue utxos(UniValue::VARR);
+    if (includeChainInfo) {
+        out.BeginObject();
+        out.Key("utxos");
+    }
+    out.BeginArray();
 
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=unspentOutputs.begin(); it!=unspentOutputs.end(); it++) {
         UniValue output(UniValue::VOBJ);
@@ -1067,22 +1071,23 @@ UniValue getaddressutxos(const UniValue& params, bool fHelp, const CPubKey& mypk
         output.push_back(Pair("script", HexStr(it->second.script.begin(), it->second.script.end())));
         output.push_back(Pair("satoshis", it->second.satoshis));
         output.push_back(Pair("height", it->second.blockHeight));
-        utxos.push_back(output);
+        out.Push(output);
     }
+    out.EndArray();
 
     if (includeChainInfo) {
-        UniValue result(UniValue::VOBJ);
-        result.push_back(Pair("utxos", utxos));
-
         LOCK(cs_main);
-        result.push_back(Pair("hash", chainActive.LastTip()->GetBlockHash().GetHex()));
-        result.push_back(Pair("height", (int)chainActive.Height()));
-        return result;
-    } else {
-        return utxos;
+        out.PushKV("hash", chainActive.LastTip()->GetBlockHash().GetHex());
+        out.PushKV("height", (int)chainActive.Height());
+        out.EndObject();
     }
 }
 
+UniValue getaddressutxos(const UniValue& params, bool fHelp, const CPubKey& mypk)
+{
+    return RPCStreamToUniValue(getaddressutxos_stream, params, fHelp, mypk);
+}
+
 UniValue getaddressdeltas(const UniValue& params, bool fHelp, const CPubKey& mypk)
 {
     if (fHelp || params.size() > 2 || params.size() == 0 || !params[0].isObject())
@@ -1425,6 +1430,50 @@ UniValue getsnapshot(const UniValue& params, bool fHelp, const CPubKey& mypk)
     return(result);
 }
 
+UniValue getaddressrank(const UniValue& params, bool fHelp, const CPubKey& mypk)
+{
+    if (fHelp || params.size() != 1)
+        throw runtime_error(
+            "getaddressrank \"address\"\n"
+            "\nReturns the position of an address in the getsnapshot rich list (requires addressbalanceindex to be enabled).\n"
+            "\nArguments:\n"
+            "1. \"address\"  (string, required) The base58check encoded address\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"address\"  (string) The address\n"
+            "  \"amount\"  (string) The current balance\n"
+            "  \"rank\"  (number) The position in the rich list, 1 for the richest address\n"
+            "  \"total_addresses\"  (number) Total number of addresses in the rich list\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getaddressrank", "\"RY5LccmGiX9bUHYGtSWQouNy1yFhc5rM87\"")
+            + HelpExampleRpc("getaddressrank", "\"RY5LccmGiX9bUHYGtSWQouNy1yFhc5rM87\"")
+        );
+
+    if (!fAddressBalanceIndex)
+        throw JSONRPCError(RPC_MISC_ERROR, "getaddressrank requires -addressbalanceindex");
+
+    CBitcoinAddress address(params[0].get_str());
+    uint160 hashBytes;
+    int type = 0;
+    if (!address.GetIndexKey(hashBytes, type, false))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
+
+    size_t rank;
+    CAmount balance;
+    if (!addressBalanceRanking.GetRank(CAddressBalanceKey(type, hashBytes), rank, balance))
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Address is not in the rich list");
+
+    UniValue result(UniValue::VOBJ);
+    char amount[32];
+    sprintf(amount, "%.8f", (double) balance / COIN);
+    result.push_back(Pair("address", params[0].get_str()));
+    result.push_back(Pair("amount", amount));
+    result.push_back(Pair("rank", (int64_t)rank + 1));
+    result.push_back(Pair("total_addresses", (int64_t)addressBalanceRanking.Size()));
+    return result;
+}
+
 UniValue getaddresstxids(const UniValue& params, bool fHelp, const CPubKey& mypk)
 {
     if (fHelp || params.size() > 2 || params.size() < 1)
@@ -355,6 +355,24 @@ UniValue pricesgetorderbook(const UniValue& params, bool fHelp, const CPubKey& m
     return PricesGetOrderbook();
 }
 
+// pricesrektcandidates rpc implementation
+UniValue pricesrektcandidates(const UniValue& params, bool fHelp, const CPubKey& mypk)
+{
+    if (fHelp || params.size() > 1)
+        throw runtime_error("pricesrektcandidates [height]\n"
+                            "lists open bets which reached the min margin at or before height (default the chain tip), lowest margin first\n");
+    LOCK(cs_main);
+
+    if (ASSETCHAINS_CBOPRET == 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "only -ac_cbopret chains have prices");
+
+    int32_t height = 0;
+    if (params.size() == 1)
+        height = atoi(params[0].get_str().c_str());
+
+    return PricesRektCandidates(height);
+}
+
 // pricesrekt rpc implementation
 UniValue pricesrefillfund(const UniValue& params, bool fHelp, const CPubKey& mypk)
 {
@@ -30,6 +30,8 @@
 #include "utilstrencodings.h"
 #include "asyncrpcqueue.h"
 
+#include <atomic>
+#include <deque>
 #include <memory>
 
 #include <univalue.h>
@@ -326,6 +328,7 @@ static const CRPCCommand vRPCCommands[] =
     { "blockchain",         "getchaintips",           &getchaintips,           true  },
     { "blockchain",         "getdifficulty",          &getdifficulty,          true  },
     { "blockchain",         "getmempoolinfo",         &getmempoolinfo,         true  },
+    { "blockchain",         "getsigcacheinfo",        &getsigcacheinfo,        true  },
     { "blockchain",         "getrawmempool",          &getrawmempool,          true  },
     { "blockchain",         "gettxout",               &gettxout,               true  },
     { "blockchain",         "gettxoutproof",          &gettxoutproof,          true  },
@@ -493,6 +496,7 @@ static const CRPCCommand vRPCCommands[] =
     { "oracles",       "oraclesdata",      &oraclesdata,        true },
     { "oracles",       "oraclessample",   &oraclessample,     true },
     { "oracles",       "oraclessamples",   &oraclessamples,     true },
+    { "oracles",       "oraclesseries",    &oraclesseries,      true },
 
     // Prices
     { "prices",       "prices",      &prices,      true },
@@ -506,6 +510,7 @@ static const CRPCCommand vRPCCommands[] =
     { "prices",       "pricesrekt",         &pricesrekt,         true },
     { "prices",       "pricesaddfunding",         &pricesaddfunding,         true },
     { "prices",       "pricesgetorderbook",         &pricesgetorderbook,         true },
+    { "prices",       "pricesrektcandidates",       &pricesrektcandidates,       true },
     { "prices",       "pricesrefillfund",         &pricesrefillfund,         true },
 
     // Pegs
@@ -576,6 +581,7 @@ static const CRPCCommand vRPCCommands[] =
     { "addressindex",       "getaddresstxids",        &getaddresstxids,        false },
     { "addressindex",       "getaddressbalance",      &getaddressbalance,      false },
     { "addressindex",       "getsnapshot",            &getsnapshot,            false },
+    { "addressindex",       "getaddressrank",         &getaddressrank,         false },
 
     /* Utility functions */
     { "util",               "createmultisig",         &createmultisig,         true  },
@@ -674,6 +680,20 @@ static const CRPCCommand vRPCCommands[] =
 #endif // ENABLE_WALLET
 };
 
+/**
+ * Commands answered piece by piece when called alone over HTTP, large results are then never
+ * held whole in memory. Each is in vRPCCommands as well.
+ */
+static const CRPCStreamCommand vRPCStreamCommands[] =
+{ //  name                      actor (function)
+  //  ------------------------  -----------------------
+    { "getblock",               &getblock_stream          },
+    { "getaddressutxos",        &getaddressutxos_stream   },
+#ifdef ENABLE_WALLET
+    { "listunspent",            &listunspent_stream       },
+#endif
+};
+
 CRPCTable::CRPCTable()
 {
     unsigned int vcidx;
@@ -684,6 +704,8 @@ CRPCTable::CRPCTable()
         pcmd = &vRPCCommands[vcidx];
         mapCommands[pcmd->name] = pcmd;
     }
+    for (vcidx = 0; vcidx < (sizeof(vRPCStreamCommands) / sizeof(vRPCStreamCommands[0])); vcidx++)
+        mapStreamCommands[vRPCStreamCommands[vcidx].name] = &vRPCStreamCommands[vcidx];
 }
 
 const CRPCCommand *CRPCTable::operator[](const std::string &name) const
@@ -708,6 +730,124 @@ bool CRPCTable::appendCommand(const std::string& name, const CRPCCommand* pcmd)
     return true;
 }
 
+bool CRPCTable::appendStreamCommand(const std::string& name, const CRPCStreamCommand* pcmd)
+{
+    if (IsRPCRunning())
+        return false;
+
+    map<string, const CRPCStreamCommand*>::const_iterator it = mapStreamCommands.find(name);
+    if (it != mapStreamCommands.end())
+        return false;
+
+    mapStreamCommands[name] = pcmd;
+    return true;
+}
+
+static UniValue JSONRPCExecOne(const UniValue& req);
+
+/** Requests of one batch, answered by several runners. */
+struct CRPCBatch
+{
+    // only read for an index below the batch size, the caller waits until all are answered
+    const UniValue& vReq;
+    std::vector<UniValue> vReply;
+    std::atomic<size_t> nNext;
+    size_t nDone;
+    CWaitableCriticalSection cs;
+    CConditionVariable cond;
+
+    CRPCBatch(const UniValue& vReqIn) : vReq(vReqIn), vReply(vReqIn.size()), nNext(0), nDone(0) {}
+};
+
+/** Runner of a batch, answers the next unanswered request until none is left. */
+static void RunRPCBatch(std::shared_ptr<CRPCBatch> batch)
+{
+    size_t n = batch->vReply.size();
+    size_t i;
+    while ((i = batch->nNext++) < n) {
+        try {
+            batch->vReply[i] = JSONRPCExecOne(batch->vReq[i]);
+        } catch (...) {
+            // a runner must always count its request or the caller waits forever
+            batch->vReply[i] = JSONRPCReplyObj(NullUniValue, JSONRPCError(RPC_MISC_ERROR, "Unexpected error"), NullUniValue);
+        }
+        boost::unique_lock<boost::mutex> lock(batch->cs);
+        if (++batch->nDone == n)
+            batch->cond.notify_all();
+    }
+}
+
+/**
+ * Bounded pool of threads for the runners of JSON-RPC batches, so a batch is not limited to
+ * the one HTTP worker that received it.
+ */
+class CRPCBatchQueue
+{
+private:
+    CWaitableCriticalSection cs;
+    CConditionVariable cond;
+    std::deque<std::shared_ptr<CRPCBatch> > queue;
+    boost::thread_group threads;
+    size_t maxDepth;
+    bool running;
+
+    void Run()
+    {
+        RenameThread("komodo-rpcbatch");
+        while (true) {
+            std::shared_ptr<CRPCBatch> batch;
+            {
+                boost::unique_lock<boost::mutex> lock(cs);
+                while (running && queue.empty())
+                    cond.wait(lock);
+                if (!running)
+                    return;
+                batch = queue.front();
+                queue.pop_front();
+            }
+            RunRPCBatch(batch);
+        }
+    }
+
+public:
+    CRPCBatchQueue() : maxDepth(0), running(false) {}
+
+    void Start(int nThreads, size_t nMaxDepth)
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        maxDepth = nMaxDepth;
+        running = true;
+        for (int i = 0; i < nThreads; i++)
+            threads.create_thread(boost::bind(&CRPCBatchQueue::Run, this));
+    }
+
+    /** Queues a runner for batch, false when the queue is full or stopped. */
+    bool Enqueue(const std::shared_ptr<CRPCBatch>& batch)
+    {
+        boost::unique_lock<boost::mutex> lock(cs);
+        if (!running || queue.size() >= maxDepth)
+            return false;
+        queue.push_back(batch);
+        cond.notify_one();
+        return true;
+    }
+
+    /** Queued runners are dropped, their callers answer the remaining requests themselves. */
+    void Stop()
+    {
+        {
+            boost::unique_lock<boost::mutex> lock(cs);
+            running = false;
+            queue.clear();
+            cond.notify_all();
+        }
+        threads.join_all();
+    }
+};
+
+static CRPCBatchQueue rpcBatchQueue;
+static int nRPCBatchConcurrency = DEFAULT_RPC_BATCH_CONCURRENCY;
+
 bool StartRPC()
 {
     LogPrint("rpc", "Starting RPC\n");
@@ -716,6 +856,13 @@ bool StartRPC()
 
     // Launch one async rpc worker.  The ability to launch multiple workers is not recommended at present and thus the option is disabled.
     getAsyncRPCQueue()->addWorker();
+
+    int nBatchThreads = std::max((int)GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS), 0);
+    nRPCBatchConcurrency = std::min(std::max((int)GetArg("-rpcbatchconcurrency", DEFAULT_RPC_BATCH_CONCURRENCY), 1), nBatchThreads + 1);
+    if (nBatchThreads > 0) {
+        LogPrint("rpc", "Starting %d RPC batch threads, %d runners per batch\n", nBatchThreads, nRPCBatchConcurrency);
+        rpcBatchQueue.Start(nBatchThreads, nBatchThreads * RPC_BATCH_QUEUE_DEPTH_PER_THREAD);
+    }
 /*
     int n = GetArg("-rpcasyncthreads", 1);
     if (n<1) {
@@ -742,6 +889,7 @@ void StopRPC()
 {
     LogPrint("rpc", "Stopping RPC\n");
     deadlineTimers.clear();
+    rpcBatchQueue.Stop();
     g_rpcSignals.Stopped();
 
     // Tells async queue to cancel all operations and shutdown.
@@ -829,12 +977,60 @@ static UniValue JSONRPCExecOne(const UniValue& req)
     return rpc_result;
 }
 
+// read-only lookups, requests of a batch may run out of order only if all of them are one of these
+static const char *const vRPCBatchParallelMethods[] = {
+    "getblock", "getblockhash", "getblockhashes", "getblockheader", "getbestblockhash", "getblockcount",
+    "getrawtransaction", "decoderawtransaction", "decodescript", "gettxout", "gettxoutproof", "getspentinfo",
+    "getaddressbalance", "getaddressdeltas", "getaddresstxids", "getaddressutxos", "getaddressmempool", "getaddressrank",
+};
+
+static bool IsRPCBatchParallel(const UniValue& vReq)
+{
+    for (size_t reqIdx = 0; reqIdx < vReq.size(); reqIdx++) {
+        if (!vReq[reqIdx].isObject())
+            return false;
+        const UniValue& method = find_value(vReq[reqIdx].get_obj(), "method");
+        bool fReadOnly = false;
+        if (method.isStr())
+            for (const char *name : vRPCBatchParallelMethods)
+                if (method.get_str() == name) {
+                    fReadOnly = true;
+                    break;
+                }
+        if (!fReadOnly)
+            return false;
+    }
+    return true;
+}
+
 std::string JSONRPCExecBatch(const UniValue& vReq)
 {
     UniValue ret(UniValue::VARR);
-    for (size_t reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(vReq[reqIdx]));
+    size_t nRunners = std::min(vReq.size(), (size_t)std::max(nRPCBatchConcurrency, 1));
+    // a batch that changes state is answered in order, later requests may depend on earlier ones
+    if (nRunners > 1 && !IsRPCBatchParallel(vReq))
+        nRunners = 1;
+    if (nRunners <= 1) {
+        for (size_t reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
+            ret.push_back(JSONRPCExecOne(vReq[reqIdx]));
+        return ret.write() + "\n";
+    }
+
+    // the calling thread is one of the runners, so the batch completes even if nothing is queued
+    std::shared_ptr<CRPCBatch> batch = std::make_shared<CRPCBatch>(vReq);
+    for (size_t i = 1; i < nRunners; i++)
+        if (!rpcBatchQueue.Enqueue(batch))
+            break;
+    RunRPCBatch(batch);
+    {
+        boost::unique_lock<boost::mutex> lock(batch->cs);
+        while (batch->nDone < batch->vReply.size())
+            batch->cond.wait(lock);
+    }
 
+    // replies in the order of the requests
+    for (size_t reqIdx = 0; reqIdx < batch->vReply.size(); reqIdx++)
+        ret.push_back(batch->vReply[reqIdx]);
     return ret.write() + "\n";
 }
 
@@ -869,6 +1065,48 @@ UniValue CRPCTable::execute(const std::string &strMethod, const UniValue &params
     g_rpcSignals.PostCommand(*pcmd);
 }
 
+bool CRPCTable::hasStream(const std::string &strMethod) const
+{
+    return mapStreamCommands.count(strMethod) != 0 && mapCommands.count(strMethod) != 0;
+}
+
+void CRPCTable::executeStream(const std::string &strMethod, const UniValue &params, JSONStream &out) const
+{
+    // Return immediately if in warmup
+    {
+        LOCK(cs_rpcWarmup);
+        if (fRPCInWarmup)
+            throw JSONRPCError(RPC_IN_WARMUP, rpcWarmupStatus);
+    }
+
+    // Find method
+    const CRPCCommand *pcmd = tableRPC[strMethod];
+    std::map<std::string, const CRPCStreamCommand*>::const_iterator it = mapStreamCommands.find(strMethod);
+    if (!pcmd || it == mapStreamCommands.end())
+        throw JSONRPCError(RPC_METHOD_NOT_FOUND, "Method not found");
+
+    g_rpcSignals.PreCommand(*pcmd);
+
+    try
+    {
+        // Execute
+        it->second->actor(params, false, CPubKey(), out);
+    }
+    catch (const std::exception& e)
+    {
+        throw JSONRPCError(RPC_MISC_ERROR, e.what());
+    }
+
+    g_rpcSignals.PostCommand(*pcmd);
+}
+
+UniValue RPCStreamToUniValue(rpcstreamfn_type actor, const UniValue& params, bool fHelp, const CPubKey& mypk)
+{
+    UniValueJSONStream out;
+    actor(params, fHelp, mypk, out);
+    return out.Get();
+}
+
 std::string HelpExampleCli(const std::string& methodname, const std::string& args)
 {
     if ( ASSETCHAINS_SYMBOL[0] == 0 ) {
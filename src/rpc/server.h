@@ -22,6 +22,7 @@
 #define BITCOIN_RPCSERVER_H
 
 #include "amount.h"
+#include "rpc/jsonstream.h"
 #include "rpc/protocol.h"
 #include "uint256.h"
 
@@ -42,6 +43,13 @@
 class AsyncRPCQueue;
 class CRPCCommand;
 
+/** Threads answering the requests of JSON-RPC batches, 0 answers them on the HTTP worker */
+static const int DEFAULT_RPC_BATCH_THREADS = 0;
+/** Most threads answering one batch, the HTTP worker of the batch included */
+static const int DEFAULT_RPC_BATCH_CONCURRENCY = 4;
+/** Queued batch runners per batch thread before a batch stops adding runners */
+static const int RPC_BATCH_QUEUE_DEPTH_PER_THREAD = 16;
+
 namespace RPCServer
 {
     void OnStarted(boost::function<void ()> slot);
@@ -137,6 +145,7 @@ void RPCUnregisterTimerInterface(RPCTimerInterface *iface);
 void RPCRunLater(const std::string& name, boost::function<void(void)> func, int64_t nSeconds);
 
 typedef UniValue(*rpcfn_type)(const UniValue& params, bool fHelp, const CPubKey& mypk);
+typedef void(*rpcstreamfn_type)(const UniValue& params, bool fHelp, const CPubKey& mypk, JSONStream& out);
 
 class CRPCCommand
 {
@@ -147,6 +156,17 @@ public:
     bool okSafeMode;
 };
 
+/** Command that can also write its result piece by piece, its CRPCCommand actor builds the same result as a UniValue */
+class CRPCStreamCommand
+{
+public:
+    std::string name;
+    rpcstreamfn_type actor;
+};
+
+/** Runs a streaming actor into one UniValue, for the CRPCCommand actor of a streaming command */
+UniValue RPCStreamToUniValue(rpcstreamfn_type actor, const UniValue& params, bool fHelp, const CPubKey& mypk);
+
 /**
  * Bitcoin RPC command dispatcher.
  */
@@ -154,6 +174,7 @@ class CRPCTable
 {
 private:
     std::map<std::string, const CRPCCommand*> mapCommands;
+    std::map<std::string, const CRPCStreamCommand*> mapStreamCommands;
 public:
     CRPCTable();
     const CRPCCommand* operator[](const std::string& name) const;
@@ -168,6 +189,14 @@ public:
      */
     UniValue execute(const std::string &method, const UniValue &params) const;
 
+    /** Whether method can write its result to a JSONStream */
+    bool hasStream(const std::string &method) const;
+
+    /**
+     * Execute a method writing its result to out, the same result as execute().
+     * @throws an exception (UniValue) when an error happens, possibly after a part of the result was written.
+     */
+    void executeStream(const std::string &method, const UniValue &params, JSONStream &out) const;
 
     /**
      * Appends a CRPCCommand to the dispatch table.
@@ -175,6 +204,9 @@ public:
      * Commands cannot be overwritten (returns false).
      */
     bool appendCommand(const std::string& name, const CRPCCommand* pcmd);
+
+    /** Appends the streaming actor of a command added with appendCommand. */
+    bool appendStreamCommand(const std::string& name, const CRPCStreamCommand* pcmd);
 };
 
 extern CRPCTable tableRPC;
@@ -199,6 +231,7 @@ std::string HelpExampleRpc(const std::string& methodname, const std::string& arg
 
 void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry);
 UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
+void blockToJSON(JSONStream& out, const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
 UniValue mempoolInfoToJSON();
 UniValue mempoolToJSON(bool fVerbose = false);
 void ScriptPubKeyToJSON(const CScript& scriptPubKey, UniValue& out, bool fIncludeHex);
@@ -217,9 +250,11 @@ std::string experimentalDisabledHelpMsg(const std::string& rpc, const std::strin
 UniValue getconnectioncount(const UniValue& params, bool fHelp, const CPubKey& mypk); // in rpcnet.cpp
 UniValue getaddressmempool(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue getaddressutxos(const UniValue& params, bool fHelp, const CPubKey& mypk);
+void getaddressutxos_stream(const UniValue& params, bool fHelp, const CPubKey& mypk, JSONStream& out);
 UniValue getaddressdeltas(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue getaddresstxids(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue getsnapshot(const UniValue& params, bool fHelp, const CPubKey& mypk);
+UniValue getaddressrank(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue getaddressbalance(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue getpeerinfo(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue checknotarization(const UniValue& params, bool fHelp, const CPubKey& mypk);
@@ -269,6 +304,7 @@ UniValue oraclessubscribe(const UniValue& params, bool fHelp, const CPubKey& myp
 UniValue oraclesdata(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue oraclessample(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue oraclessamples(const UniValue& params, bool fHelp, const CPubKey& mypk);
+UniValue oraclesseries(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue pricesaddress(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue priceslist(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue mypriceslist(const UniValue& params, bool fHelp, const CPubKey& mypk);
@@ -408,6 +444,7 @@ UniValue jumblr_resume(const UniValue& params, bool fHelp, const CPubKey& mypk);
 
 UniValue getrawtransaction(const UniValue& params, bool fHelp, const CPubKey& mypk); // in rcprawtransaction.cpp
 UniValue listunspent(const UniValue& params, bool fHelp, const CPubKey& mypk);
+void listunspent_stream(const UniValue& params, bool fHelp, const CPubKey& mypk, JSONStream& out);
 UniValue lockunspent(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue listlockunspent(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue createrawtransaction(const UniValue& params, bool fHelp, const CPubKey& mypk);
@@ -424,6 +461,7 @@ UniValue getbestblockhash(const UniValue& params, bool fHelp, const CPubKey& myp
 UniValue getdifficulty(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue settxfee(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue getmempoolinfo(const UniValue& params, bool fHelp, const CPubKey& mypk);
+UniValue getsigcacheinfo(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue getrawmempool(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue getblockhashes(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue getblockdeltas(const UniValue& params, bool fHelp, const CPubKey& mypk);
@@ -431,6 +469,7 @@ UniValue getblockhash(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue getblockheader(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue getlastsegidstakes(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue getblock(const UniValue& params, bool fHelp, const CPubKey& mypk);
+void getblock_stream(const UniValue& params, bool fHelp, const CPubKey& mypk, JSONStream& out);
 UniValue gettxoutsetinfo(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue gettxout(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue verifychain(const UniValue& params, bool fHelp, const CPubKey& mypk);
@@ -539,6 +578,7 @@ UniValue pricescashout(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue pricesrekt(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue pricesaddfunding(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue pricesgetorderbook(const UniValue& params, bool fHelp, const CPubKey& mypk);
+UniValue pricesrektcandidates(const UniValue& params, bool fHelp, const CPubKey& mypk);
 UniValue pricesrefillfund(const UniValue& params, bool fHelp, const CPubKey& mypk);
 
 
@@ -118,7 +118,7 @@ UniValue tokenlist(const UniValue& params, bool fHelp, const CPubKey& remotepk)
 
     return TokenList();
 }
-UniValue tokenv2list(const UniValue& params, bool fHelp, const CPubKey& remotepk)
+void tokenv2list_stream(const UniValue& params, bool fHelp, const CPubKey& remotepk, JSONStream& out)
 {
     const static std::set<std::string> acceptable = { "beginHeight", "endHeight", "pubkey", "address" };
 
@@ -139,8 +139,10 @@ UniValue tokenv2list(const UniValue& params, bool fHelp, const CPubKey& remotepk
         if (params[0].getType() == UniValue::VOBJ)
             jsonParams = params[0].get_array();
         else if (params[0].getType() == UniValue::VSTR)  { // json in quoted string '{...}'
-            if (!jsonParams.read(params[0].get_str().c_str())) 
-                return MakeResultError("parameter must be a valid json object\n");
+            if (!jsonParams.read(params[0].get_str().c_str())) {
+                out.Push(MakeResultError("parameter must be a valid json object\n"));
+                return;
+            }
         }
         if (jsonParams.getType() != UniValue::VOBJ)
             throw runtime_error("parameter 1 must be a json object");   
@@ -150,7 +152,12 @@ UniValue tokenv2list(const UniValue& params, bool fHelp, const CPubKey& remotepk
             if (acceptable.count(jsonParams.getKeys()[i]) == 0)
                 throw runtime_error(std::string("invalid json param") + jsonParams.getKeys()[i]);   
     }
-    return TokenV2List(jsonParams);
+    TokenV2List(jsonParams, out);
+}
+
+UniValue tokenv2list(const UniValue& params, bool fHelp, const CPubKey& remotepk)
+{
+    return RPCStreamToUniValue(tokenv2list_stream, params, fHelp, remotepk);
 }
 
 template <class V>
@@ -1475,8 +1482,16 @@ static const CRPCCommand commands[] =
 
 };
 
+static const CRPCStreamCommand streamCommands[] =
+{ //  name                      actor (function)
+  //  ------------------------  -----------------------
+    { "tokenv2list",            &tokenv2list_stream       },
+};
+
 void RegisterTokensRPCCommands(CRPCTable &tableRPC)
 {
     for (unsigned int vcidx = 0; vcidx < ARRAYLEN(commands); vcidx++)
         tableRPC.appendCommand(commands[vcidx].name, &commands[vcidx]);
+    for (unsigned int vcidx = 0; vcidx < ARRAYLEN(streamCommands); vcidx++)
+        tableRPC.appendStreamCommand(streamCommands[vcidx].name, &streamCommands[vcidx]);
 }
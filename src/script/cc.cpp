@@ -230,8 +230,8 @@ struct CC* cc_readConditionBinaryMaybeMixed(const uint8_t *condBin, size_t condB
 }
 
 
-int cc_verifyMaybeMixed(const struct CC *cond, const uint256 sigHash,
-        const uint8_t *condBin, size_t condBinLength, VerifyEval verifyEval, void *evalContext)
+int cc_verifySignaturesMaybeMixed(const struct CC *cond, const uint256 sigHash,
+        const uint8_t *condBin, size_t condBinLength)
 {
     if (condBinLength == 0) return 0;
     uint8_t condBuf[1000];
@@ -242,7 +242,16 @@ int cc_verifyMaybeMixed(const struct CC *cond, const uint256 sigHash,
         condBin = condBuf;
         cc_free(condMixed);
     }
-    return cc_verify(cond, sigHash.begin(), 32, 0, condBin, condBinLength, verifyEval, evalContext);
+    return cc_verifySignatures(cond, sigHash.begin(), 32, 0, condBin, condBinLength);
+}
+
+
+int cc_verifyMaybeMixed(const struct CC *cond, const uint256 sigHash,
+        const uint8_t *condBin, size_t condBinLength, VerifyEval verifyEval, void *evalContext)
+{
+    if (!cc_verifySignaturesMaybeMixed(cond, sigHash, condBin, condBinLength))
+        return 0;
+    return cc_verifyEval(cond, verifyEval, evalContext) ? 1 : 0;
 }
 
 CC_SUBVER CC_MixedModeSubVersion(int c) 
@@ -134,4 +134,10 @@ struct CC* cc_readConditionBinaryMaybeMixed(const uint8_t *condBin, size_t condB
 int cc_verifyMaybeMixed(const struct CC *cond, const uint256 sigHash,
         const uint8_t *condBin, size_t condBinLength, VerifyEval verifyEval, void *evalContext);
 
+/*
+ * Same as cc_verifyMaybeMixed without running the evals, only the condition and the signatures are checked
+ */
+int cc_verifySignaturesMaybeMixed(const struct CC *cond, const uint256 sigHash,
+        const uint8_t *condBin, size_t condBinLength);
+
 #endif /* SCRIPT_CC_H */
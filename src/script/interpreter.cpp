@@ -1391,14 +1391,21 @@ int TransactionSignatureChecker::CheckCryptoCondition(
     };
 
     //fprintf(stderr,"%s non-checker path\n", __func__);
-    int out = cc_verifyMaybeMixed(
-            cond, sighash, condBin.data(), condBin.size(), eval, (void*)this);
+    int out = 0;
+    if (VerifyCryptoConditionSignatures(cond, sighash, condBin, ffillBin))
+        out = cc_verifyEval(cond, eval, (void*)this) ? 1 : 0;
     //fprintf(stderr,"%s out.%d from cc_verify\n", __func__, (int32_t)out);
     cc_free(cond);
     return out;
 }
 
 
+bool TransactionSignatureChecker::VerifyCryptoConditionSignatures(const CC *cond, const uint256& sighash, const std::vector<unsigned char>& condBin, const std::vector<unsigned char>& ffillBin) const
+{
+    return cc_verifySignaturesMaybeMixed(cond, sighash, condBin.data(), condBin.size()) != 0;
+}
+
+
 int TransactionSignatureChecker::CheckEvalCondition(const CC *cond) const
 {
     //fprintf(stderr, "Cannot check crypto-condition Eval outside of server, returning true in pre-checks\n");
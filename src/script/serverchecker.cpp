@@ -20,90 +20,53 @@
 
 #include "serverchecker.h"
 #include "script/cc.h"
+#include "script/sigcache.h"
 #include "cc/eval.h"
 
 #include "pubkey.h"
-#include "random.h"
 #include "uint256.h"
 #include "util.h"
 
-#undef __cpuid
-#include <boost/thread.hpp>
-#include <boost/tuple/tuple_comparison.hpp>
-
-namespace {
-
-/**
- * Valid signature cache, to avoid doing expensive ECDSA signature checking
- * twice for every transaction (once when accepted into memory pool, and
- * again when accepted into the block chain)
- */
-class CSignatureCache
+bool ServerTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
-private:
-     //! sigdata_type is (signature hash, signature, public key):
-    typedef boost::tuple<uint256, std::vector<unsigned char>, CPubKey> sigdata_type;
-    std::set< sigdata_type> setValid;
-    boost::shared_mutex cs_serverchecker;
+    uint256 entry = SignatureCacheEntry(sighash, vchSig, pubkey);
 
-public:
-    bool
-    Get(const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey)
-    {
-        boost::shared_lock<boost::shared_mutex> lock(cs_serverchecker);
+    if (signatureCache.Get(entry, !store))
+        return true;
 
-        sigdata_type k(hash, vchSig, pubKey);
-        std::set<sigdata_type>::iterator mi = setValid.find(k);
-        if (mi != setValid.end())
-            return true;
+    if (!TransactionSignatureChecker::VerifySignature(vchSig, pubkey, sighash))
         return false;
-    }
-
-    void Set(const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey)
-    {
-        // DoS prevention: limit cache size to less than 10MB
-        // (~200 bytes per cache entry times 50,000 entries)
-        // Since there can be no more than 20,000 signature operations per block
-        // 50,000 is a reasonable default.
-        int64_t nMaxCacheSize = GetArg("-maxservercheckersize", 50000);
-        if (nMaxCacheSize <= 0) return;
-
-        boost::unique_lock<boost::shared_mutex> lock(cs_serverchecker);
-
-        while (static_cast<int64_t>(setValid.size()) > nMaxCacheSize)
-        {
-            // Evict a random entry. Random because that helps
-            // foil would-be DoS attackers who might try to pre-generate
-            // and re-use a set of valid signatures just-slightly-greater
-            // than our cache size.
-            uint256 randomHash = GetRandHash();
-            std::vector<unsigned char> unused;
-            std::set<sigdata_type>::iterator it =
-                setValid.lower_bound(sigdata_type(randomHash, unused, unused));
-            if (it == setValid.end())
-                it = setValid.begin();
-            setValid.erase(*it);
-        }
-
-        sigdata_type k(hash, vchSig, pubKey);
-        setValid.insert(k);
-    }
-};
 
+    if (store)
+        signatureCache.Set(entry);
+    return true;
 }
 
-bool ServerTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
+/*
+ * Valid cryptocondition signatures, so the condition and the secp256k1/ed25519 signatures of a fulfillment
+ * are checked once at mempool accept and not again at block connect.
+ * Entries are keyed by (signature hash, fulfillment, condition). Only the signatures are cached:
+ * the evals depend on the chain state and are always run.
+ */
+bool ServerTransactionSignatureChecker::VerifyCryptoConditionSignatures(const CC *cond, const uint256& sighash, const std::vector<unsigned char>& condBin, const std::vector<unsigned char>& ffillBin) const
 {
-    static CSignatureCache signatureCache;
-
-    if (signatureCache.Get(sighash, vchSig, pubkey))
+    uint256 entry;
+    uint64_t ffillSize = ffillBin.size();
+    ccSignatureCache.Hasher()
+        .Write(sighash.begin(), 32)
+        .Write((const unsigned char*)&ffillSize, sizeof(ffillSize))
+        .Write(ffillBin.data(), ffillBin.size())
+        .Write(condBin.data(), condBin.size())
+        .Finalize(entry.begin());
+
+    if (ccSignatureCache.Get(entry, !store))
         return true;
 
-    if (!TransactionSignatureChecker::VerifySignature(vchSig, pubkey, sighash))
+    if (!TransactionSignatureChecker::VerifyCryptoConditionSignatures(cond, sighash, condBin, ffillBin))
         return false;
 
     if (store)
-        signatureCache.Set(sighash, vchSig, pubkey);
+        ccSignatureCache.Set(entry);
     return true;
 }
 
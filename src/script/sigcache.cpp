@@ -24,84 +24,96 @@
 #include "random.h"
 #include "uint256.h"
 #include "util.h"
-#ifdef _WIN32
-#undef __cpuid
-#endif
-#include <boost/thread.hpp>
-#include <boost/tuple/tuple_comparison.hpp>
-
-namespace {
-
-/**
- * Valid signature cache, to avoid doing expensive ECDSA signature checking
- * twice for every transaction (once when accepted into memory pool, and
- * again when accepted into the block chain)
- */
-class CSignatureCache
+
+CSignatureCache signatureCache;
+CSignatureCache ccSignatureCache;
+
+CSignatureCache::CSignatureCache() : nHits(0), nMisses(0), nInserts(0), nEntries(0)
 {
-private:
-     //! sigdata_type is (signature hash, signature, public key):
-    typedef boost::tuple<uint256, std::vector<unsigned char>, CPubKey> sigdata_type;
-    std::set< sigdata_type> setValid;
-    boost::shared_mutex cs_sigcache;
-
-public:
-    bool
-    Get(const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey)
-    {
-        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
-
-        sigdata_type k(hash, vchSig, pubKey);
-        std::set<sigdata_type>::iterator mi = setValid.find(k);
-        if (mi != setValid.end())
-            return true;
-        return false;
-    }
+    uint256 nonce = GetRandHash();
+    // we want the nonce to be 64 bytes long to force the hasher to process this chunk,
+    // which makes later hash computations more efficient, we just write our 32-byte
+    // entropy twice to fill the 64 bytes
+    salted_hasher.Write(nonce.begin(), 32);
+    salted_hasher.Write(nonce.begin(), 32);
+}
 
-    void Set(const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey)
-    {
-        // DoS prevention: limit cache size to less than 10MB
-        // (~200 bytes per cache entry times 50,000 entries)
-        // Since there can be no more than 20,000 signature operations per block
-        // 50,000 is a reasonable default.
-        int64_t nMaxCacheSize = GetArg("-maxsigcachesize", 50000);
-        if (nMaxCacheSize <= 0) return;
-
-        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
-
-        while (static_cast<int64_t>(setValid.size()) > nMaxCacheSize)
-        {
-            // Evict a random entry. Random because that helps
-            // foil would-be DoS attackers who might try to pre-generate
-            // and re-use a set of valid signatures just-slightly-greater
-            // than our cache size.
-            uint256 randomHash = GetRandHash();
-            std::vector<unsigned char> unused;
-            std::set<sigdata_type>::iterator it =
-                setValid.lower_bound(sigdata_type(randomHash, unused, unused));
-            if (it == setValid.end())
-                it = setValid.begin();
-            setValid.erase(*it);
-        }
-
-        sigdata_type k(hash, vchSig, pubKey);
-        setValid.insert(k);
+bool CSignatureCache::Get(const uint256& entry, bool erase)
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
+    if (nEntries != 0 && setValid.contains(entry, erase)) {
+        nHits++;
+        return true;
     }
-};
+    nMisses++;
+    return false;
+}
+
+void CSignatureCache::Set(const uint256& entry)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+    if (nEntries == 0)
+        return;
+    setValid.insert(entry);
+    nInserts++;
+}
 
+uint32_t CSignatureCache::Setup(size_t nBytes)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+    nEntries = nBytes > 0 ? setValid.setup_bytes(nBytes) : 0;
+    return nEntries;
+}
+
+CSignatureCacheStats CSignatureCache::GetStats()
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
+    CSignatureCacheStats stats;
+    stats.hits = nHits;
+    stats.misses = nMisses;
+    stats.inserts = nInserts;
+    stats.entries = nEntries;
+    stats.bytes = (size_t)nEntries * sizeof(uint256);
+    return stats;
+}
+
+void InitSignatureCache()
+{
+    // the caches are sized in megabytes, 0 disables a cache
+    size_t nMaxCacheSize = std::min(std::max((int64_t)0, GetArg("-sigcachesize", DEFAULT_MAX_SIG_CACHE_SIZE)), MAX_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
+    uint32_t nEntries = signatureCache.Setup(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for signature cache, able to store %u elements\n",
+              (nEntries * sizeof(uint256)) >> 20, nMaxCacheSize >> 20, nEntries);
+
+    nMaxCacheSize = std::min(std::max((int64_t)0, GetArg("-ccsigcachesize", DEFAULT_MAX_CC_SIG_CACHE_SIZE)), MAX_MAX_SIG_CACHE_SIZE) * ((size_t) 1 << 20);
+    nEntries = ccSignatureCache.Setup(nMaxCacheSize);
+    LogPrintf("Using %zu MiB out of %zu requested for cryptocondition signature cache, able to store %u elements\n",
+              (nEntries * sizeof(uint256)) >> 20, nMaxCacheSize >> 20, nEntries);
+}
+
+uint256 SignatureCacheEntry(const uint256 &sighash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey)
+{
+    uint256 entry;
+    // the pubkey length is given by its first byte so the fields can't be shifted into each other
+    signatureCache.Hasher()
+        .Write(sighash.begin(), 32)
+        .Write(pubkey.begin(), pubkey.size())
+        .Write(vchSig.data(), vchSig.size())
+        .Finalize(entry.begin());
+    return entry;
 }
 
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
-    static CSignatureCache signatureCache;
+    uint256 entry = SignatureCacheEntry(sighash, vchSig, pubkey);
 
-    if (signatureCache.Get(sighash, vchSig, pubkey))
+    if (signatureCache.Get(entry, !store))
         return true;
 
     if (!TransactionSignatureChecker::VerifySignature(vchSig, pubkey, sighash))
         return false;
 
     if (store)
-        signatureCache.Set(sighash, vchSig, pubkey);
+        signatureCache.Set(entry);
     return true;
 }
@@ -22,11 +22,89 @@
 #define BITCOIN_SCRIPT_SIGCACHE_H
 
 #include "script/interpreter.h"
+#include "crypto/sha256.h"
+#include "cuckoocache.h"
+#include "uint256.h"
 
+#include <atomic>
 #include <vector>
 
+#include <boost/thread/shared_mutex.hpp>
+
+// signature cache sizes are in megabytes
+static const unsigned int DEFAULT_MAX_SIG_CACHE_SIZE = 32;
+static const unsigned int DEFAULT_MAX_CC_SIG_CACHE_SIZE = 8;
+// maximum cache size, 16GB
+static const int64_t MAX_MAX_SIG_CACHE_SIZE = 16384;
+
 class CPubKey;
 
+/** The cache entries are salted sha256 hashes, their 8 cuckoo hashes are taken straight from the entry */
+class SignatureCacheHasher
+{
+public:
+    template <uint8_t hash_select>
+    uint32_t operator()(const uint256& key) const
+    {
+        static_assert(hash_select < 8, "SignatureCacheHasher only has 8 hashes available.");
+        uint32_t u;
+        std::memcpy(&u, key.begin() + 4 * hash_select, 4);
+        return u;
+    }
+};
+
+/** Counters of a signature cache, reported by getsigcacheinfo */
+struct CSignatureCacheStats
+{
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t inserts;
+    uint32_t entries;   // capacity in entries
+    size_t bytes;       // memory used by the entries
+
+    CSignatureCacheStats() : hits(0), misses(0), inserts(0), entries(0), bytes(0) {}
+};
+
+/**
+ * Fixed memory cache of valid signature checks. Callers compute an entry from the salted hasher and the
+ * checked data, lookups only take a shared lock and inserts take the exclusive one.
+ */
+class CSignatureCache
+{
+private:
+    //! sha256 with a random per process salt, so the slots of an entry can't be predicted
+    CSHA256 salted_hasher;
+    CuckooCache::cache<uint256, SignatureCacheHasher> setValid;
+    boost::shared_mutex cs_sigcache;
+    std::atomic<uint64_t> nHits;
+    std::atomic<uint64_t> nMisses;
+    std::atomic<uint64_t> nInserts;
+    uint32_t nEntries;
+
+public:
+    CSignatureCache();
+
+    //! a copy of the salted hasher to compute an entry with
+    CSHA256 Hasher() const { return salted_hasher; }
+    //! erase frees the slot of a hit, used by block validation where the entry won't be seen again
+    bool Get(const uint256& entry, bool erase);
+    void Set(const uint256& entry);
+    //! sizes the cache and drops all entries, returns the number of entries
+    uint32_t Setup(size_t nBytes);
+    CSignatureCacheStats GetStats();
+};
+
+//! valid (sighash, signature, pubkey) checks
+extern CSignatureCache signatureCache;
+//! valid cryptocondition fulfillment signatures, see ServerTransactionSignatureChecker
+extern CSignatureCache ccSignatureCache;
+
+//! sizes the signature caches from -sigcachesize and -ccsigcachesize
+void InitSignatureCache();
+
+//! entry for a (sighash, signature, pubkey) check
+uint256 SignatureCacheEntry(const uint256 &sighash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey);
+
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
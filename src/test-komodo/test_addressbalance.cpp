@@ -0,0 +1,145 @@
+#include <gtest/gtest.h>
+#include "addressbalance.h"
+#include "main.h"
+
+#include <algorithm>
+
+namespace TestAddressBalance {
+
+    class TestAddressBalance : public ::testing::Test {};
+
+    static CAddressBalanceKey MakeKey(unsigned int type, uint8_t n)
+    {
+        uint160 hash;
+        *hash.begin() = n;
+        return CAddressBalanceKey(type, hash);
+    }
+
+    TEST(TestAddressBalance, ranking_top_and_rank)
+    {
+        CAddressBalanceRanking ranking;
+        std::vector<std::pair<CAmount, CAddressBalanceKey> > top;
+        size_t rank;
+        CAmount balance;
+
+        for (uint8_t i = 1; i <= 100; i++)
+            ranking.Set(MakeKey(1, i), CAddressBalanceValue(i * 10, 1), false);
+        ASSERT_EQ(ranking.Size(), 100);
+
+        ranking.GetTop(0, 3, top);
+        ASSERT_EQ(top.size(), 3);
+        EXPECT_EQ(top[0].first, 1000);
+        EXPECT_EQ(top[1].first, 990);
+        EXPECT_EQ(top[2].first, 980);
+
+        top.clear();
+        ranking.GetTop(98, 10, top);
+        ASSERT_EQ(top.size(), 2);
+        EXPECT_EQ(top[1].first, 10);
+
+        ASSERT_TRUE(ranking.GetRank(MakeKey(1, 100), rank, balance));
+        EXPECT_EQ(rank, 0);
+        ASSERT_TRUE(ranking.GetRank(MakeKey(1, 1), rank, balance));
+        EXPECT_EQ(rank, 99);
+        EXPECT_EQ(balance, 10);
+
+        // moving an address to the top and removing another
+        ranking.Set(MakeKey(1, 1), CAddressBalanceValue(5000, 2), false);
+        ranking.Set(MakeKey(1, 100), CAddressBalanceValue(), false);
+        ASSERT_EQ(ranking.Size(), 99);
+        ASSERT_TRUE(ranking.GetRank(MakeKey(1, 1), rank, balance));
+        EXPECT_EQ(rank, 0);
+        ASSERT_TRUE(ranking.GetRank(MakeKey(1, 99), rank, balance));
+        EXPECT_EQ(rank, 1);
+        ASSERT_FALSE(ranking.GetRank(MakeKey(1, 100), rank, balance));
+
+        top.clear();
+        ranking.GetTop(0, 0, top);
+        ASSERT_EQ(top.size(), 99);
+        for (size_t i = 1; i < top.size(); i++)
+            EXPECT_GE(top[i - 1].first, top[i].first);
+    }
+
+    TEST(TestAddressBalance, ranking_stats)
+    {
+        CAddressBalanceRanking ranking;
+        size_t rank;
+        CAmount balance;
+
+        ranking.Set(MakeKey(1, 1), CAddressBalanceValue(100, 2), false);
+        ranking.Set(MakeKey(2, 1), CAddressBalanceValue(50, 1), false);
+        ranking.Set(MakeKey(3, 1), CAddressBalanceValue(70, 3), false);   // cc, never ranked
+        ranking.Set(MakeKey(1, 2), CAddressBalanceValue(900, 4), true);   // ignored, never ranked
+
+        CAddressBalanceStats stats = ranking.GetStats();
+        EXPECT_EQ(ranking.Size(), 2);
+        EXPECT_EQ(stats.total, 150);
+        EXPECT_EQ(stats.utxos, 3);
+        EXPECT_EQ(stats.ccTotal, 70);
+        EXPECT_EQ(stats.ccUtxos, 3);
+        EXPECT_EQ(stats.ignoredUtxos, 4);
+        ASSERT_FALSE(ranking.GetRank(MakeKey(3, 1), rank, balance));
+        ASSERT_FALSE(ranking.GetRank(MakeKey(1, 2), rank, balance));
+
+        // equal balances keep a stable order by key
+        ranking.Set(MakeKey(2, 1), CAddressBalanceValue(100, 1), false);
+        ASSERT_TRUE(ranking.GetRank(MakeKey(1, 1), rank, balance));
+        EXPECT_EQ(rank, 0);
+        ASSERT_TRUE(ranking.GetRank(MakeKey(2, 1), rank, balance));
+        EXPECT_EQ(rank, 1);
+
+        ranking.Clear();
+        EXPECT_EQ(ranking.Size(), 0);
+        EXPECT_EQ(ranking.GetStats().total, 0);
+    }
+
+    static CBlockIndex *AddTestBlock(std::vector<CBlockIndex*> &blocks, CBlockIndex *pprev, uint8_t n)
+    {
+        uint256 hash;
+        *hash.begin() = n;
+        *(hash.end() - 1) = 0xfe;
+        CBlockIndex *pindex = new CBlockIndex();
+        pindex->phashBlock = &mapBlockIndex.insert(std::make_pair(hash, pindex)).first->first;
+        pindex->pprev = pprev;
+        pindex->SetHeight(pprev != NULL ? pprev->GetHeight() + 1 : 0);
+        blocks.push_back(pindex);
+        return pindex;
+    }
+
+    TEST(TestAddressBalance, index_block_state)
+    {
+        std::vector<CBlockIndex*> blocks;
+        CBlockIndex *genesis = AddTestBlock(blocks, NULL, 1);
+        CBlockIndex *a1 = AddTestBlock(blocks, genesis, 2);
+        CBlockIndex *a2 = AddTestBlock(blocks, a1, 3);
+        CBlockIndex *a3 = AddTestBlock(blocks, a2, 4);
+        CBlockIndex *b2 = AddTestBlock(blocks, a1, 5);
+        uint256 unknown;
+        *unknown.begin() = 6;
+
+        // indexes written before the marker apply every block
+        EXPECT_EQ(IndexBlockState(uint256(), a2, false), 0);
+        EXPECT_EQ(IndexBlockState(uint256(), a2, true), 0);
+
+        EXPECT_EQ(IndexBlockState(a1->GetBlockHash(), a2, false), 0);
+        EXPECT_EQ(IndexBlockState(a1->GetBlockHash(), b2, false), 0);
+        EXPECT_EQ(IndexBlockState(a1->GetBlockHash(), a1, true), 0);
+
+        // replayed after an unclean shutdown
+        EXPECT_EQ(IndexBlockState(a1->GetBlockHash(), a1, false), 1);
+        EXPECT_EQ(IndexBlockState(a3->GetBlockHash(), a2, false), 1);
+        EXPECT_EQ(IndexBlockState(a1->GetBlockHash(), a2, true), 1);
+        EXPECT_EQ(IndexBlockState(genesis->GetBlockHash(), a3, true), 1);
+
+        // the index is on another branch
+        EXPECT_EQ(IndexBlockState(a3->GetBlockHash(), b2, false), -1);
+        EXPECT_EQ(IndexBlockState(b2->GetBlockHash(), a3, false), -1);
+        EXPECT_EQ(IndexBlockState(a3->GetBlockHash(), a2, true), -1);
+        EXPECT_EQ(IndexBlockState(unknown, a2, false), -1);
+
+        for (CBlockIndex *pindex : blocks) {
+            mapBlockIndex.erase(pindex->GetBlockHash());
+            delete pindex;
+        }
+    }
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include "main.h"
+#include "miner.h"
+#include "txmempool.h"
+#include "utilstrencodings.h"
+#include "komodo_defs.h"
+
+#include "testutils.h"
+
+
+namespace TestBlockCandidates {
+
+class TestBlockCandidates : public ::testing::Test {
+protected:
+    static void SetUpTestCase() { setupChain(); }
+    virtual void TearDown() {
+        LOCK(cs_main);
+        mempool.clear();
+    }
+};
+
+static CScript NotaryScript()
+{
+    return CScript() << ParseHex(notaryPubkey) << OP_CHECKSIG;
+}
+
+// confirmed pay to pubkey outputs of the notary key
+static std::vector<CTransaction> ConfirmedCoins(int n)
+{
+    std::vector<CTransaction> coins(n);
+    for (int i = 0; i < n; i++)
+        getInputTx(NotaryScript(), coins[i]);
+    generateBlock();
+    return coins;
+}
+
+static CTransaction Spend(const CTransaction &txIn, CAmount nFee, CScript scriptPubKey = NotaryScript())
+{
+    CMutableTransaction mtx = spendTx(txIn);
+    mtx.vout[0].nValue = txIn.vout[0].nValue - nFee;
+    mtx.vout[0].scriptPubKey = scriptPubKey;
+    mtx.vin[0].scriptSig << getSig(mtx, txIn.vout[0].scriptPubKey);
+    acceptTxFail(mtx);
+    return CTransaction(mtx);
+}
+
+static std::vector<uint256> TemplateTxids()
+{
+    std::unique_ptr<CBlockTemplate> pblocktemplate(CreateNewBlock(CPubKey(ParseHex(notaryPubkey)), NotaryScript(), KOMODO_MAXGPUCOUNT));
+    std::vector<uint256> txids;
+    if (pblocktemplate)
+        for (size_t i = 1; i < pblocktemplate->block.vtx.size(); i++)
+            txids.push_back(pblocktemplate->block.vtx[i].GetHash());
+    return txids;
+}
+
+static std::vector<uint256> SortedTxids(const std::set<TxPriority, TxPriorityOrder> &sorted)
+{
+    std::vector<uint256> txids;
+    for (const TxPriority &entry : sorted)
+        txids.push_back(entry.get<2>()->GetHash());
+    return txids;
+}
+
+static void ExpectSameCandidates(const CBlockCandidates &a, const CBlockCandidates &b)
+{
+    ASSERT_EQ(a.mapCandidates.size(), b.mapCandidates.size());
+    for (const auto &entry : a.mapCandidates) {
+        std::map<uint256, CBlockCandidates::Candidate>::const_iterator it = b.mapCandidates.find(entry.first);
+        ASSERT_TRUE(it != b.mapCandidates.end());
+        EXPECT_EQ(entry.second.ptx, it->second.ptx);
+        EXPECT_EQ(entry.second.dPriority, it->second.dPriority);
+        EXPECT_TRUE(entry.second.feeRate == it->second.feeRate);
+        EXPECT_EQ(entry.second.setDependsOn, it->second.setDependsOn);
+        EXPECT_EQ(entry.second.vNotaries, it->second.vNotaries);
+        EXPECT_EQ(entry.second.fNotarisation, it->second.fNotarisation);
+    }
+    ASSERT_EQ(a.mapDependers.size(), b.mapDependers.size());
+    for (const auto &entry : a.mapDependers) {
+        std::map<uint256, std::vector<uint256> >::const_iterator it = b.mapDependers.find(entry.first);
+        ASSERT_TRUE(it != b.mapDependers.end());
+        EXPECT_EQ(std::set<uint256>(entry.second.begin(), entry.second.end()), std::set<uint256>(it->second.begin(), it->second.end()));
+    }
+    EXPECT_EQ(a.setNotarisations, b.setNotarisations);
+    EXPECT_EQ(SortedTxids(a.setByPriority), SortedTxids(b.setByPriority));
+    EXPECT_EQ(SortedTxids(a.setByFee), SortedTxids(b.setByFee));
+}
+
+// the template made from the candidates kept since the last one is the one a full rebuild makes
+TEST_F(TestBlockCandidates, template_matches_rebuild)
+{
+    std::vector<CTransaction> coins = ConfirmedCoins(4);
+    CTransaction parent1 = Spend(coins[0], 10000);
+    CTransaction parent2 = Spend(coins[1], 20000);
+    CTransaction child1 = Spend(parent1, 30000);
+    CTransaction grandchild1 = Spend(child1, 1000);
+    EXPECT_EQ(TemplateTxids().size(), 4);
+
+    // a dependent of a parent already in the candidates, a new tx and a prioritised one
+    CTransaction child2 = Spend(parent2, 5000);
+    CTransaction tx3 = Spend(coins[2], 1000);
+    CTransaction tx4 = Spend(coins[3], 1000);
+    mempool.PrioritiseTransaction(tx4.GetHash(), tx4.GetHash().ToString(), 1e15, 10 * COIN);
+    std::vector<uint256> incremental = TemplateTxids();
+
+    mempool.ResetCandidateUpdates();
+    std::vector<uint256> rebuilt = TemplateTxids();
+
+    ASSERT_EQ(incremental.size(), 7);
+    EXPECT_EQ(incremental, rebuilt);
+    EXPECT_EQ(incremental[0], tx4.GetHash());
+    std::map<uint256, size_t> pos;
+    for (size_t i = 0; i < incremental.size(); i++)
+        pos[incremental[i]] = i;
+    EXPECT_LT(pos[parent1.GetHash()], pos[child1.GetHash()]);
+    EXPECT_LT(pos[child1.GetHash()], pos[grandchild1.GetHash()]);
+    EXPECT_LT(pos[parent2.GetHash()], pos[child2.GetHash()]);
+    EXPECT_EQ(pos.count(tx3.GetHash()), 1);
+}
+
+// with a notary set, as on notary pay chains, the notarisation is kept apart to go in as tx1
+TEST_F(TestBlockCandidates, candidates_match_rebuild)
+{
+    std::vector<CTransaction> coins = ConfirmedCoins(3);
+    // one signer of five is enough to be taken for a notarisation
+    int8_t numSN = 5;
+    uint8_t notarypubkeys[64][33] = {{0}};
+    std::vector<uint8_t> pubkey = ParseHex(notaryPubkey);
+    memcpy(notarypubkeys[0], pubkey.data(), 33);
+    for (int8_t i = 1; i < numSN; i++) {
+        notarypubkeys[i][0] = 0x02;
+        notarypubkeys[i][1] = i;
+    }
+
+    LOCK2(cs_main, mempool.cs);
+    CCoinsViewCache view(pcoinsTip);
+    const CBlockIndex *pindexPrev = chainActive.Tip();
+    uint32_t nTime = pindexPrev->nTime + 1;
+
+    CTransaction parent = Spend(coins[0], 10000);
+    mempool.ResetCandidateUpdates();
+    CBlockCandidates incremental;
+    EXPECT_EQ(incremental.Update(pindexPrev, view, nTime, numSN, notarypubkeys), 1);
+
+    CTransaction child = Spend(parent, 20000);
+    CTransaction notarisation = Spend(coins[1], 1000, CScript() << ParseHex(CRYPTO777_PUBSECPSTR) << OP_CHECKSIG);
+    CTransaction prioritised = Spend(coins[2], 1000);
+    mempool.PrioritiseTransaction(prioritised.GetHash(), prioritised.GetHash().ToString(), 1e15, 10 * COIN);
+    EXPECT_EQ(incremental.Update(pindexPrev, view, nTime, numSN, notarypubkeys), 3);
+
+    CBlockCandidates rebuilt;
+    EXPECT_EQ(rebuilt.Update(pindexPrev, view, nTime, numSN, notarypubkeys), 4);
+    ExpectSameCandidates(incremental, rebuilt);
+
+    EXPECT_EQ(incremental.setNotarisations.size(), 1);
+    EXPECT_EQ(incremental.setNotarisations.count(notarisation.GetHash()), 1);
+    EXPECT_EQ(incremental.mapCandidates[child.GetHash()].setDependsOn.count(parent.GetHash()), 1);
+    EXPECT_EQ(incremental.setByPriority.begin()->get<2>()->GetHash(), prioritised.GetHash());
+
+    // the miner's own candidates missed the updates handed out here
+    mempool.ResetCandidateUpdates();
+}
+
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include "blockreader.h"
+#include "chainparams.h"
+#include "clientversion.h"
+#include "main.h"
+#include "random.h"
+#include "util.h"
+
+#include <boost/filesystem.hpp>
+
+namespace TestBlockReader {
+
+    class TestBlockReader : public ::testing::Test {};
+
+    TEST(TestBlockReader, reads_ahead_in_order)
+    {
+        std::string strOldDatadir = mapArgs["-datadir"];
+        ClearDatadirCache();
+        auto pathTemp = GetTempPath() / strprintf("test_komodo_blockreader_%li_%i", GetTime(), GetRand(100000));
+        boost::filesystem::create_directories(pathTemp / "blocks");
+        mapArgs["-datadir"] = pathTemp.string();
+
+        std::vector<uint256> vHashes;
+        std::vector<CDiskBlockPos> vPos;
+        CDiskBlockPos pos(0, 0);
+        for (int i = 0; i < 50; i++) {
+            CBlock block;
+            block.nTime = i;
+            CMutableTransaction mtx;
+            mtx.vin.resize(1);
+            mtx.vin[0].prevout = COutPoint(GetRandHash(), i);
+            mtx.vout.resize(i % 5 + 1);
+            block.vtx.push_back(mtx);
+            ASSERT_TRUE(WriteBlockToDisk(block, pos, Params().MessageStart()));
+            vHashes.push_back(block.GetHash());
+            vPos.push_back(pos);
+            pos.nPos += ::GetSerializeSize(block, SER_DISK, CLIENT_VERSION);
+        }
+
+        // found by their headers, as -reindex does
+        std::vector<CDiskBlockPos> vFound = CMappedBlockFile(0).FindBlocks();
+        ASSERT_EQ(vFound.size(), vPos.size());
+        for (size_t i = 0; i < vPos.size(); i++)
+            EXPECT_TRUE(vFound[i] == vPos[i]);
+
+        // on the calling thread and on workers with a ring smaller than the blocks
+        for (int nThreads = 0; nThreads <= 3; nThreads += 3) {
+            std::vector<CDiskBlockPos> vRead = vPos;
+            vRead.insert(vRead.begin() + 10, CDiskBlockPos(0, 1 << 30));
+            CBlockReader reader(vRead, nThreads, 4);
+            CBlock block;
+            bool fOk;
+            for (size_t i = 0; i < vRead.size(); i++) {
+                ASSERT_TRUE(reader.Next(block, fOk));
+                if (i == 10) {
+                    // past the end of the file, the next ones are still read
+                    EXPECT_FALSE(fOk);
+                    continue;
+                }
+                ASSERT_TRUE(fOk);
+                EXPECT_EQ(block.GetHash(), vHashes[i < 10 ? i : i - 1]);
+            }
+            EXPECT_FALSE(reader.Next(block, fOk));
+        }
+
+        // stopped with blocks still queued
+        {
+            CBlockReader reader(vPos, 2, 4);
+            CBlock block;
+            bool fOk;
+            ASSERT_TRUE(reader.Next(block, fOk));
+            EXPECT_EQ(block.GetHash(), vHashes[0]);
+        }
+
+        boost::filesystem::remove_all(pathTemp);
+        mapArgs["-datadir"] = strOldDatadir;
+        ClearDatadirCache();
+    }
+}
@@ -6,6 +6,7 @@
 #include "script/cc.h"
 #include "cc/eval.h"
 #include "primitives/transaction.h"
+#include "random.h"
 #include "script/interpreter.h"
 #include "script/serverchecker.h"
 
@@ -162,6 +163,48 @@ TEST_F(CCTest, testVerifyEvalCondition)
 }
 
 
+static bool CCVerifyStore(const CMutableTransaction &mtxTo, const CC *cond) {
+    CAmount amount;
+    ScriptError error;
+    CTransaction txTo(mtxTo);
+    PrecomputedTransactionData txdata(txTo);
+    auto checker = ServerTransactionSignatureChecker(&txTo, 0, amount, true, 0, 1, NULL, txdata);
+    return VerifyScript(CCSig(cond), CCPubKey(cond), 0, checker, 0, &error);
+};
+
+
+TEST_F(CCTest, testVerifyCryptoConditionCached)
+{
+    class EvalMock : public Eval
+    {
+    public:
+        bool fValid = true;
+        bool Dispatch(const CC *cond, const CTransaction &txTo, unsigned int nIn)
+        { return fValid ? Valid() : Invalid(""); }
+    };
+
+    EvalMock eval;
+    EVAL_TEST = &eval;
+
+    CC *cond;
+    CMutableTransaction mtxTo;
+
+    cond = CCNewThreshold(2, { CCNewSecp256k1(notaryKey.GetPubKey()), CCNewEval({2}) });
+    CCSign(mtxTo, cond);
+    ASSERT_TRUE(CCVerifyStore(mtxTo, cond));
+    ASSERT_TRUE(CCVerifyStore(mtxTo, cond));
+
+    // the signatures come from the cache but the evals are still run
+    eval.fValid = false;
+    ASSERT_FALSE(CCVerifyStore(mtxTo, cond));
+    eval.fValid = true;
+
+    // a different fulfillment is not found in the cache
+    memset(cond->subconditions[0]->signature, 0, 32);
+    ASSERT_FALSE(CCVerifyStore(mtxTo, cond));
+}
+
+
 TEST_F(CCTest, testCryptoConditionsDisabled)
 {
     CC *cond;
@@ -198,3 +241,84 @@ TEST_F(CCTest, testLargeCondition)
     EXPECT_EQ(1744, CCSig(cond).size());
     ASSERT_TRUE(CCVerify(mtxTo, cond));
 }
+
+
+static CC *RandomCondition(const std::vector<CKey> &keys, int depth)
+{
+    switch (GetRand(depth > 2 ? 2 : 4)) {
+    case 0:
+        return CCNewSecp256k1(keys[GetRand(keys.size())].GetPubKey());
+    case 1: {
+        std::vector<unsigned char> code(1 + GetRand(6));
+        for (auto &c : code) c = GetRand(256);
+        return CCNewEval(code);
+    }
+    default:
+        std::vector<CC*> subs(1 + GetRand(3));
+        for (auto &sub : subs)
+            sub = RandomCondition(keys, depth + 1);
+        return CCNewThreshold(1 + GetRand(subs.size()), subs);
+    }
+}
+
+
+static void ExpectSameTree(CC *fast, CC *asn, const std::vector<unsigned char> &bin)
+{
+    ASSERT_EQ(fast == NULL, asn == NULL) << HexStr(bin);
+    if (!fast) return;
+    char *fastJson = cc_conditionToJSONString(fast), *asnJson = cc_conditionToJSONString(asn);
+    EXPECT_STREQ(fastJson, asnJson) << HexStr(bin);
+    free(fastJson);
+    free(asnJson);
+    EXPECT_EQ(CCPubKey(fast), CCPubKey(asn)) << HexStr(bin);
+}
+
+
+TEST_F(CCTest, testFastDecoderMatchesAsn1c)
+{
+    std::vector<CKey> keys(8);
+    for (auto &key : keys)
+        key.MakeNewKey(true);
+    uint256 msg = GetRandHash();
+
+    // the encodings of random trees and corruptions of them decode the same with and without
+    // the fast path, in both modes
+    for (int i=0; i<500; i++) {
+        CC *cond = RandomCondition(keys, 0);
+        for (int j=0; j<3; j++)
+            cc_signTreeSecp256k1Msg32(cond, keys[GetRand(keys.size())].begin(), msg.begin());
+
+        for (int mixed=0; mixed<2; mixed++) {
+            std::vector<unsigned char> bin(10000);
+            size_t len = mixed ? cc_fulfillmentBinaryMixedMode(cond, bin.data(), bin.size())
+                               : cc_fulfillmentBinary(cond, bin.data(), bin.size());
+            if (!len) continue;  // not fulfilled
+            bin.resize(len);
+
+            for (int k=0; k<30; k++) {
+                std::vector<unsigned char> input = bin;
+                if (k > 0) {
+                    size_t pos = GetRand(input.size());
+                    switch (GetRand(4)) {
+                    case 0: input[pos] ^= 1 << GetRand(8); break;
+                    case 1: input[pos] = GetRand(256); break;
+                    case 2: input.resize(pos); break;
+                    case 3: input.insert(input.begin() + pos, GetRand(256)); break;
+                    }
+                }
+                for (int readMixed=0; readMixed<2; readMixed++) {
+                    CC *fast = readMixed ? cc_readFulfillmentBinaryMixedMode(input.data(), input.size())
+                                         : cc_readFulfillmentBinary(input.data(), input.size());
+                    CC *asn = cc_readFulfillmentBinaryAsn1c(input.data(), input.size(), readMixed);
+                    if (k == 0 && readMixed == mixed) {
+                        ASSERT_TRUE(fast != NULL) << HexStr(input);
+                    }
+                    ExpectSameTree(fast, asn, input);
+                    if (fast) cc_free(fast);
+                    if (asn) cc_free(asn);
+                }
+            }
+        }
+        cc_free(cond);
+    }
+}
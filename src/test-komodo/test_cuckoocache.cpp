@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+#include "crypto/sha256.h"
+#include "cuckoocache.h"
+#include "pubkey.h"
+#include "random.h"
+#include "script/sigcache.h"
+
+#include <chrono>
+#include <set>
+#include <thread>
+
+#include <boost/thread/shared_mutex.hpp>
+#include <boost/tuple/tuple_comparison.hpp>
+
+namespace TestCuckooCache {
+
+    class TestCuckooCache : public ::testing::Test {};
+
+    static std::vector<uint256> RandomEntries(size_t n)
+    {
+        std::vector<uint256> entries;
+        for (size_t i = 0; i < n; i++)
+            entries.push_back(GetRandHash());
+        return entries;
+    }
+
+    TEST(TestCuckooCache, insert_and_contains)
+    {
+        CuckooCache::cache<uint256, SignatureCacheHasher> cache;
+        uint32_t size = cache.setup_bytes(1 << 16);
+        ASSERT_EQ(size, (1 << 16) / sizeof(uint256));
+
+        // well below the capacity nothing is dropped
+        std::vector<uint256> entries = RandomEntries(size / 2);
+        for (const auto &entry : entries)
+            cache.insert(entry);
+        for (const auto &entry : entries)
+            EXPECT_TRUE(cache.contains(entry, false));
+        EXPECT_FALSE(cache.contains(GetRandHash(), false));
+    }
+
+    TEST(TestCuckooCache, erased_entries_are_replaced_first)
+    {
+        CuckooCache::cache<uint256, SignatureCacheHasher> cache;
+        uint32_t size = cache.setup(1024);
+
+        std::vector<uint256> older = RandomEntries(size / 2);
+        for (const auto &entry : older)
+            cache.insert(entry);
+        // a block connect erases the entries it hits
+        for (const auto &entry : older)
+            EXPECT_TRUE(cache.contains(entry, true));
+
+        std::vector<uint256> newer = RandomEntries(size - size / 8);
+        for (const auto &entry : newer)
+            cache.insert(entry);
+        size_t found = 0;
+        for (const auto &entry : newer)
+            found += cache.contains(entry, false);
+        // the freed slots take the new entries, almost none are lost
+        EXPECT_GE(found, newer.size() * 95 / 100);
+    }
+
+    TEST(TestCuckooCache, signature_cache_counters)
+    {
+        CSignatureCache sigcache;
+        uint256 entry = GetRandHash();
+
+        // disabled until sized
+        sigcache.Set(entry);
+        EXPECT_FALSE(sigcache.Get(entry, false));
+        EXPECT_EQ(sigcache.GetStats().inserts, 0);
+
+        ASSERT_GT(sigcache.Setup(1 << 20), 0);
+        std::vector<uint256> entries = RandomEntries(1000);
+        for (const auto &e : entries)
+            sigcache.Set(e);
+
+        // lookups from several checker threads at once
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++)
+            threads.push_back(std::thread([&sigcache, &entries]() {
+                for (const auto &e : entries)
+                    sigcache.Get(e, false);
+            }));
+        for (auto &thread : threads)
+            thread.join();
+
+        CSignatureCacheStats stats = sigcache.GetStats();
+        EXPECT_EQ(stats.inserts, 1000);
+        EXPECT_EQ(stats.hits, 4000);
+        EXPECT_EQ(stats.misses, 1);
+        EXPECT_EQ(stats.bytes, (size_t)stats.entries * sizeof(uint256));
+    }
+
+    // the set based cache sigcache.cpp had before, kept to compare against
+    class SetSignatureCache
+    {
+    private:
+        typedef boost::tuple<uint256, std::vector<unsigned char>, CPubKey> sigdata_type;
+        std::set<sigdata_type> setValid;
+        boost::shared_mutex cs_sigcache;
+
+    public:
+        bool Get(const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey)
+        {
+            boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
+            return setValid.count(sigdata_type(hash, vchSig, pubKey)) != 0;
+        }
+
+        void Set(const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubKey)
+        {
+            boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+            setValid.insert(sigdata_type(hash, vchSig, pubKey));
+        }
+    };
+
+    struct SigCheck
+    {
+        uint256 sighash;
+        std::vector<unsigned char> vchSig;
+        CPubKey pubkey;
+    };
+
+    template <typename F>
+    static int64_t TimeThreads(int nThreads, size_t nChecks, F check)
+    {
+        std::vector<std::thread> threads;
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < nThreads; t++)
+            threads.push_back(std::thread([=]() {
+                for (size_t i = t; i < nChecks; i += nThreads)
+                    check(i);
+            }));
+        for (auto &thread : threads)
+            thread.join();
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // a block worth of signature checks, 20000 of them, looked up 10 times over by 1 to 8 script check threads
+    TEST(TestCuckooCache, benchmark_vs_set_cache)
+    {
+        const size_t nSigs = 20000, nChecks = 10 * nSigs;
+        // the entries are hashed with the sha256 the node picks at startup
+        SHA256AutoDetect();
+        std::vector<SigCheck> sigs(nSigs);
+        for (auto &sig : sigs) {
+            std::vector<unsigned char> vchPubKey(33);
+            GetRandBytes(vchPubKey.data(), vchPubKey.size());
+            vchPubKey[0] = 0x02;
+            sig.sighash = GetRandHash();
+            sig.vchSig.resize(72);
+            GetRandBytes(sig.vchSig.data(), sig.vchSig.size());
+            sig.pubkey = CPubKey(vchPubKey.begin(), vchPubKey.end());
+        }
+
+        SetSignatureCache setcache;
+        ASSERT_GT(signatureCache.Setup(DEFAULT_MAX_SIG_CACHE_SIZE << 20), 0);
+        for (const auto &sig : sigs) {
+            setcache.Set(sig.sighash, sig.vchSig, sig.pubkey);
+            signatureCache.Set(SignatureCacheEntry(sig.sighash, sig.vchSig, sig.pubkey));
+        }
+
+        for (int nThreads = 1; nThreads <= 8; nThreads *= 2) {
+            std::atomic<size_t> nSetHits(0), nCuckooHits(0);
+            int64_t nSetTime = TimeThreads(nThreads, nChecks, [&](size_t i) {
+                const SigCheck &sig = sigs[i % nSigs];
+                if (setcache.Get(sig.sighash, sig.vchSig, sig.pubkey))
+                    nSetHits++;
+            });
+            int64_t nCuckooTime = TimeThreads(nThreads, nChecks, [&](size_t i) {
+                const SigCheck &sig = sigs[i % nSigs];
+                if (signatureCache.Get(SignatureCacheEntry(sig.sighash, sig.vchSig, sig.pubkey), false))
+                    nCuckooHits++;
+            });
+            std::cout << nThreads << " threads, " << nChecks << " lookups: set cache " << nSetTime / 1000 << " ms, cuckoo cache " << nCuckooTime / 1000 << " ms" << std::endl;
+            EXPECT_EQ(nSetHits, nChecks);
+            EXPECT_EQ(nCuckooHits, nChecks);
+        }
+        signatureCache.Setup(0);
+    }
+}
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include "coins.h"
+#include "flathashmap.h"
+#include "memusage.h"
+#include "random.h"
+
+#include <map>
+
+namespace TestFlatHashMap {
+
+    class TestFlatHashMap : public ::testing::Test {};
+
+    typedef flathashmap<uint256, int, CCoinsKeyHasher> Map;
+
+    TEST(TestFlatHashMap, matches_std_map)
+    {
+        Map map;
+        std::map<uint256, int> ref;
+        std::vector<uint256> keys;
+        for (int i = 0; i < 2000; i++)
+            keys.push_back(GetRandHash());
+
+        for (int step = 0; step < 200000; step++) {
+            const uint256& key = keys[GetRand(keys.size())];
+            switch (GetRand(4)) {
+            case 0:
+                map[key] = step;
+                ref[key] = step;
+                break;
+            case 1:
+                EXPECT_EQ(map.erase(key), ref.erase(key));
+                break;
+            case 2:
+                EXPECT_EQ(map.insert(std::make_pair(key, step)).second, ref.insert(std::make_pair(key, step)).second);
+                break;
+            default:
+                Map::const_iterator it = map.find(key);
+                ASSERT_EQ(it == map.end(), ref.count(key) == 0);
+                if (it != map.end())
+                    EXPECT_EQ(it->second, ref[key]);
+            }
+        }
+        ASSERT_EQ(map.size(), ref.size());
+
+        size_t n = 0;
+        for (Map::const_iterator it = map.begin(); it != map.end(); it++, n++)
+            EXPECT_EQ(it->second, ref[it->first]);
+        EXPECT_EQ(n, ref.size());
+
+        Map copy(map);
+        EXPECT_EQ(copy.size(), map.size());
+        for (Map::const_iterator it = map.begin(); it != map.end(); it++)
+            EXPECT_EQ(copy.find(it->first)->second, it->second);
+    }
+
+    TEST(TestFlatHashMap, erase_while_iterating)
+    {
+        Map map;
+        for (int i = 0; i < 1000; i++)
+            map[GetRandHash()] = i;
+        // as BatchWrite empties the child cache
+        size_t n = 0;
+        for (Map::iterator it = map.begin(); it != map.end();) {
+            Map::iterator itOld = it++;
+            if (itOld->second % 2 == 0)
+                map.erase(itOld);
+            n++;
+        }
+        EXPECT_EQ(n, 1000);
+        EXPECT_EQ(map.size(), 500);
+        for (Map::iterator it = map.begin(); it != map.end(); it++)
+            EXPECT_EQ(it->second % 2, 1);
+    }
+
+    TEST(TestFlatHashMap, entries_do_not_move)
+    {
+        Map map;
+        uint256 key = GetRandHash();
+        Map::iterator it = map.insert(std::make_pair(key, 1)).first;
+        int* pvalue = &it->second;
+        for (int i = 0; i < 10000; i++)
+            map[GetRandHash()] = i;
+        ASSERT_GT(map.bucket_count(), 10000);
+
+        // the table grew under the iterator, the entry is where it was
+        EXPECT_EQ(&map.find(key)->second, pvalue);
+        EXPECT_EQ(it->first, key);
+        map.erase(it);
+        EXPECT_EQ(map.count(key), 0);
+        EXPECT_EQ(map.size(), 10000);
+    }
+
+    TEST(TestFlatHashMap, memory_usage)
+    {
+        Map map;
+        EXPECT_EQ(memusage::DynamicUsage(map), 0);
+        for (int i = 0; i < 10000; i++)
+            map[GetRandHash()] = i;
+        size_t nUsage = memusage::DynamicUsage(map);
+        EXPECT_GE(nUsage, map.bucket_count() * sizeof(void*) + map.size() * sizeof(Map::value_type));
+
+        // erased nodes go back to the pool, the usage only drops once the map is cleared
+        for (Map::iterator it = map.begin(); it != map.end();) {
+            Map::iterator itOld = it++;
+            map.erase(itOld);
+        }
+        EXPECT_EQ(memusage::DynamicUsage(map), nUsage);
+        map.clear();
+        EXPECT_EQ(memusage::DynamicUsage(map), 0);
+    }
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include "dbwrapper.h"
+#include "main.h"
+#include "random.h"
+#include "txdb.h"
+#include "util.h"
+
+#include <boost/filesystem.hpp>
+
+namespace TestIndexDB {
+
+    class TestIndexDB : public ::testing::Test {};
+
+    TEST(TestIndexDB, migrates_old_layout)
+    {
+        std::string strOldDatadir = mapArgs["-datadir"];
+        ClearDatadirCache();
+        auto pathTemp = GetTempPath() / strprintf("test_komodo_indexdb_%li_%i", GetTime(), GetRand(100000));
+        boost::filesystem::create_directories(pathTemp / "blocks");
+        mapArgs["-datadir"] = pathTemp.string();
+
+        uint256 txid = GetRandHash();
+        uint160 addr;
+        GetRandBytes(addr.begin(), addr.size());
+        CDiskTxPos txpos(CDiskBlockPos(3, 1000), 81);
+        CAddressIndexKey addrkey(1, addr, 10, 0, txid, 0, false);
+
+        // an index written by an older version, in the block index database
+        {
+            CDBWrapper olddb(GetDataDir() / "blocks" / "index", 1 << 20);
+            CDBBatch batch(olddb);
+            batch.Write(std::make_pair('t', txid), txpos);
+            batch.Write(std::make_pair('d', addrkey), (CAmount)5000);
+            batch.Write('R', '1');
+            ASSERT_TRUE(olddb.WriteBatch(batch, true));
+        }
+
+        {
+            CBlockTreeDB db(1 << 20, false);
+            CDiskTxPos pos;
+            ASSERT_TRUE(db.ReadTxIndex(txid, pos));
+            EXPECT_EQ(pos.nFile, 3);
+            EXPECT_EQ(pos.nTxOffset, 81);
+            std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+            ASSERT_TRUE(db.ReadAddressIndex(addr, 1, addressIndex));
+            ASSERT_EQ(addressIndex.size(), 1);
+            EXPECT_EQ(addressIndex[0].first.txhash, txid);
+            EXPECT_EQ(addressIndex[0].second, 5000);
+
+            // moved, the block index keeps its own entries only
+            EXPECT_FALSE(db.Exists(std::make_pair('t', txid)));
+            EXPECT_FALSE(db.Exists(std::make_pair('d', addrkey)));
+            bool fReindexing = false;
+            db.ReadReindexing(fReindexing);
+            EXPECT_TRUE(fReindexing);
+        }
+
+        // opening again finds nothing left to move
+        {
+            CBlockTreeDB db(1 << 20, false);
+            CDiskTxPos pos;
+            EXPECT_TRUE(db.ReadTxIndex(txid, pos));
+        }
+
+        boost::filesystem::remove_all(pathTemp);
+        mapArgs["-datadir"] = strOldDatadir;
+        ClearDatadirCache();
+    }
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "rpc/jsonstream.h"
+
+namespace TestJSONStream {
+
+    class TestJSONStream : public ::testing::Test {};
+
+    // a result with nested containers, empty ones and escaped strings
+    static void WriteSample(JSONStream &out)
+    {
+        out.BeginObject();
+        out.PushKV("hash", "00ff\"\\\n");
+        out.PushKV("height", 12800);
+        out.PushKV("difficulty", 1.5);
+        out.PushKV("minted", false);
+        out.PushKV("prev", NullUniValue);
+        out.Key("tx");
+        out.BeginArray();
+        for (int i = 0; i < 100; i++) {
+            UniValue tx(UniValue::VOBJ);
+            tx.push_back(Pair("n", i));
+            tx.push_back(Pair("vin", UniValue(UniValue::VARR)));
+            out.Push(tx);
+        }
+        out.EndArray();
+        out.Key("empty");
+        out.BeginObject();
+        out.EndObject();
+        out.Key("nested");
+        out.BeginArray();
+        out.BeginArray();
+        out.Push("a");
+        out.EndArray();
+        out.BeginObject();
+        out.PushKV("b", 1);
+        out.EndObject();
+        out.EndArray();
+        out.EndObject();
+    }
+
+    TEST(TestJSONStream, text_matches_univalue)
+    {
+        UniValueJSONStream uv;
+        WriteSample(uv);
+        ASSERT_TRUE(uv.Get().isObject());
+        EXPECT_EQ(uv.Get()["tx"].size(), 100);
+
+        std::string text;
+        TextJSONStream out(1 << 20, [&text](const std::string &chunk) { text += chunk; });
+        WriteSample(out);
+        out.Flush();
+        EXPECT_EQ(text, uv.Get().write());
+
+        UniValue parsed;
+        ASSERT_TRUE(parsed.read(text));
+        EXPECT_EQ(parsed.write(), text);
+    }
+
+    TEST(TestJSONStream, chunks)
+    {
+        std::vector<std::string> chunks;
+        TextJSONStream out(256, [&chunks](const std::string &chunk) { chunks.push_back(chunk); });
+        out.Raw("{\"result\":");
+        WriteSample(out);
+        out.Raw(",\"error\":null,\"id\":1}\n");
+        out.Flush();
+        EXPECT_TRUE(out.Buffered().empty());
+
+        // flushed once a chunk is full, so the result is sent while it is written
+        ASSERT_GT(chunks.size(), 1);
+        std::string text;
+        for (size_t i = 0; i < chunks.size(); i++) {
+            if (i + 1 < chunks.size())
+                EXPECT_GE(chunks[i].size(), 256);
+            text += chunks[i];
+        }
+
+        UniValueJSONStream uv;
+        WriteSample(uv);
+        UniValue reply(UniValue::VOBJ);
+        reply.push_back(Pair("result", uv.Get()));
+        reply.push_back(Pair("error", NullUniValue));
+        reply.push_back(Pair("id", 1));
+        EXPECT_EQ(text, reply.write() + "\n");
+    }
+
+    TEST(TestJSONStream, scalar_result)
+    {
+        std::string text;
+        TextJSONStream out(1 << 20, [&text](const std::string &chunk) { text += chunk; });
+        out.Push("deadbeef");
+        // nothing is handed out below the chunk size
+        EXPECT_TRUE(text.empty());
+        EXPECT_EQ(out.Buffered(), "\"deadbeef\"");
+
+        UniValueJSONStream uv;
+        uv.Push("deadbeef");
+        EXPECT_EQ(uv.Get().get_str(), "deadbeef");
+    }
+}
@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 #include "crypto/sha256.h"
+#include "hash.h"
+#include "primitives/block.h"
 #include "uint256.h"
 #include <stdexcept>
 #include "random.h"
@@ -155,4 +157,56 @@ namespace TestSHA256Crypto {
             "d7a8fbb307d7809469ca9abcb0082e4f8d5651e46d3cdb762d02d0bf37c9e592");
     }
 
+    TEST(TestSHA256Crypto, sha256d64)
+    {
+        std::cerr << log_tab << "Using \"" << SHA256AutoDetect() << "\" SHA256 implementation ..." << std::endl;
+
+        // every batch size around the 8 lane kernel, with unaligned buffers
+        for (int i = 0; i <= 32; i++) {
+            unsigned char in[64 * 32 + 1], out1[32 * 32 + 1], out2[32 * 32];
+            for (int j = 0; j < 64 * i + 1; j++)
+                in[j] = insecure_rand();
+            for (int j = 0; j < i; j++)
+                CHash256().Write(in + 1 + 64 * j, 64).Finalize(out2 + 32 * j);
+            SHA256D64(out1 + 1, in + 1, i);
+            ASSERT_TRUE(memcmp(out1 + 1, out2, 32 * i) == 0) << i;
+        }
+    }
+
+    TEST(TestSHA256Crypto, merkle_tree_batched)
+    {
+        // the batched levels against pairwise hashing
+        for (int nLeaves = 0; nLeaves <= 40; nLeaves++) {
+            std::vector<uint256> leaves, level, tree;
+            for (int i = 0; i < nLeaves; i++)
+                leaves.push_back(GetRandHash());
+            level = leaves;
+            size_t nNodes = level.size();
+            while (level.size() > 1) {
+                std::vector<uint256> next;
+                for (size_t i = 0; i < level.size(); i += 2) {
+                    size_t i2 = std::min(i + 1, level.size() - 1);
+                    next.push_back(Hash(BEGIN(level[i]), END(level[i]), BEGIN(level[i2]), END(level[i2])));
+                }
+                level = next;
+                nNodes += level.size();
+            }
+            bool fMutated = true;
+            uint256 root = BuildMerkleTree(&fMutated, leaves, tree);
+            EXPECT_EQ(root, level.empty() ? uint256() : level[0]) << nLeaves;
+            EXPECT_FALSE(fMutated) << nLeaves;
+            EXPECT_EQ(tree.size(), nNodes) << nLeaves;
+        }
+
+        // a duplicated last pair is still flagged
+        std::vector<uint256> leaves, tree;
+        for (int i = 0; i < 6; i++)
+            leaves.push_back(GetRandHash());
+        leaves.push_back(leaves[4]);
+        leaves.push_back(leaves[5]);
+        bool fMutated = false;
+        BuildMerkleTree(&fMutated, leaves, tree);
+        EXPECT_TRUE(fMutated);
+    }
+
 }
\ No newline at end of file
@@ -59,6 +59,21 @@ static const char DB_LAST_BLOCK = 'l';
 // cc module outputs index with opdrop or opreturn data
 static const char DB_ADDRESSUNSPENT_CC_INDEX = 'O';
 
+// cc baton chain index
+static const char DB_CCBATON_TIP = 'K';
+static const char DB_CCBATON_EVENT = 'E';
+static const char DB_CCBATON_OUTPOINT = 'o';
+static const char DB_CCBATON_TXREFS = 'r';
+static const char DB_CCBATON_POSTING = 'P';
+static const char DB_ORACLESAMPLE = 'D';
+static const char DB_REWARDSOUTPUT = 'w';
+static const char DB_HEIRSTATE = 'h';
+static const char DB_HEIRUNDO = 'j';
+static const char DB_ADDRESSBALANCE = 'W';
+
+// last block applied to an index that is updated with deltas, keyed by index name
+static const char DB_INDEX_BEST_BLOCK = 'I';
+
 
 CCoinsViewDB::CCoinsViewDB(std::string dbName, size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / dbName, nCacheSize, fMemory, fWipe) {
 }
@@ -217,7 +232,94 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins,
     return db.WriteBatch(batch);
 }
 
-CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe, bool compression, int maxOpenFiles) : CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe, compression, maxOpenFiles) {
+const char *IndexDBName(IndexDBType type)
+{
+    switch (type) {
+        case INDEXDB_TX:        return "txindex";
+        case INDEXDB_ADDRESS:   return "address";
+        case INDEXDB_SPENT:     return "spent";
+        case INDEXDB_TIMESTAMP: return "timestamp";
+        case INDEXDB_CC:        return "cc";
+        default:                return "";
+    }
+}
+
+static boost::filesystem::path IndexDBPath(IndexDBType type, bool fMemory)
+{
+    if (!fMemory)
+        TryCreateDirectory(GetDataDir() / "indexes");
+    return GetDataDir() / "indexes" / IndexDBName(type);
+}
+
+CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe, bool compression, int maxOpenFiles, const CIndexDBCaches &indexCaches) :
+    CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe, compression, maxOpenFiles),
+    txIndexDB(IndexDBPath(INDEXDB_TX, fMemory), indexCaches[INDEXDB_TX].nCacheSize, fMemory, fWipe, compression, maxOpenFiles, indexCaches[INDEXDB_TX].nWriteBufferSize),
+    addressIndexDB(IndexDBPath(INDEXDB_ADDRESS, fMemory), indexCaches[INDEXDB_ADDRESS].nCacheSize, fMemory, fWipe, compression, maxOpenFiles, indexCaches[INDEXDB_ADDRESS].nWriteBufferSize),
+    spentIndexDB(IndexDBPath(INDEXDB_SPENT, fMemory), indexCaches[INDEXDB_SPENT].nCacheSize, fMemory, fWipe, compression, maxOpenFiles, indexCaches[INDEXDB_SPENT].nWriteBufferSize),
+    timestampIndexDB(IndexDBPath(INDEXDB_TIMESTAMP, fMemory), indexCaches[INDEXDB_TIMESTAMP].nCacheSize, fMemory, fWipe, compression, maxOpenFiles, indexCaches[INDEXDB_TIMESTAMP].nWriteBufferSize),
+    ccIndexDB(IndexDBPath(INDEXDB_CC, fMemory), indexCaches[INDEXDB_CC].nCacheSize, fMemory, fWipe, compression, maxOpenFiles, indexCaches[INDEXDB_CC].nWriteBufferSize)
+{
+    if (!fWipe && !MigrateIndexes())
+        throw dbwrapper_error("Moving the indexes out of the block index database failed");
+}
+
+// older versions kept the indexes in the block index database, under the same keys
+static const std::pair<char, IndexDBType> vIndexDBPrefixes[] = {
+    std::make_pair(DB_TXINDEX, INDEXDB_TX),
+    std::make_pair(DB_ADDRESSINDEX, INDEXDB_ADDRESS),
+    std::make_pair(DB_ADDRESSUNSPENTINDEX, INDEXDB_ADDRESS),
+    std::make_pair(DB_ADDRESSBALANCE, INDEXDB_ADDRESS),
+    std::make_pair(DB_SPENTINDEX, INDEXDB_SPENT),
+    std::make_pair(DB_TIMESTAMPINDEX, INDEXDB_TIMESTAMP),
+    std::make_pair(DB_BLOCKHASHINDEX, INDEXDB_TIMESTAMP),
+    std::make_pair(DB_ADDRESSUNSPENT_CC_INDEX, INDEXDB_CC),
+    std::make_pair(DB_CCBATON_TIP, INDEXDB_CC),
+    std::make_pair(DB_CCBATON_EVENT, INDEXDB_CC),
+    std::make_pair(DB_CCBATON_OUTPOINT, INDEXDB_CC),
+    std::make_pair(DB_CCBATON_TXREFS, INDEXDB_CC),
+    std::make_pair(DB_CCBATON_POSTING, INDEXDB_CC),
+    std::make_pair(DB_ORACLESAMPLE, INDEXDB_CC),
+    std::make_pair(DB_REWARDSOUTPUT, INDEXDB_CC),
+    std::make_pair(DB_HEIRSTATE, INDEXDB_CC),
+    std::make_pair(DB_HEIRUNDO, INDEXDB_CC),
+};
+
+static const size_t INDEXDB_MIGRATE_BATCH_BYTES = 16 << 20;
+
+bool CBlockTreeDB::MigrateIndexes()
+{
+    CDBWrapper *dbs[INDEXDB_COUNT] = { &txIndexDB, &addressIndexDB, &spentIndexDB, &timestampIndexDB, &ccIndexDB };
+
+    for (const std::pair<char, IndexDBType> &prefix : vIndexDBPrefixes) {
+        CDBWrapper &dst = *dbs[prefix.second];
+        size_t nMoved = 0;
+        boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+        pcursor->Seek(prefix.first);
+
+        while (true) {
+            CDBBatch copy(dst), erase(*this);
+            size_t nBytes = 0;
+            for (; pcursor->Valid() && nBytes < INDEXDB_MIGRATE_BATCH_BYTES; pcursor->Next()) {
+                CDataStream ssKey(SER_DISK, CLIENT_VERSION), ssValue(SER_DISK, CLIENT_VERSION);
+                if (!pcursor->GetKeyDataStream(ssKey) || ssKey.empty() || ssKey[0] != prefix.first)
+                    break;
+                if (!pcursor->GetValueDataStream(ssValue))
+                    return error("%s: unable to read index entry '%c'", __func__, prefix.first);
+                copy.Write(ssKey, ssValue);
+                erase.Erase(ssKey);
+                nBytes += ssKey.size() + ssValue.size();
+                nMoved++;
+            }
+            if (nBytes == 0)
+                break;
+            // the copies are on disk before the originals go, an interrupted move is redone at the next start
+            dst.WriteBatch(copy, true);
+            WriteBatch(erase);
+        }
+        if (nMoved > 0)
+            LogPrintf("%s: moved %u index entries '%c' to indexes/%s\n", __func__, nMoved, prefix.first, IndexDBName(prefix.second));
+    }
+    return true;
 }
 
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
@@ -287,6 +389,14 @@ bool CCoinsViewDB::GetStats(CCoinsStats &stats) const {
 }
 
 bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo) {
+    // the index entries of the blocks must not be lost once the block index says they are connected,
+    // they were in the same log when all was in one database
+    txIndexDB.Sync();
+    addressIndexDB.Sync();
+    spentIndexDB.Sync();
+    timestampIndexDB.Sync();
+    ccIndexDB.Sync();
+
     CDBBatch batch(*this);
     for (std::vector<std::pair<int, const CBlockFileInfo*> >::const_iterator it=fileInfo.begin(); it != fileInfo.end(); it++) {
         batch.Write(make_pair(DB_BLOCK_FILES, it->first), *it->second);
@@ -307,22 +417,22 @@ bool CBlockTreeDB::EraseBatchSync(const std::vector<const CBlockIndex*>& blockin
 }
 
 bool CBlockTreeDB::ReadTxIndex(const uint256 &txid, CDiskTxPos &pos) {
-    return Read(make_pair(DB_TXINDEX, txid), pos);
+    return txIndexDB.Read(make_pair(DB_TXINDEX, txid), pos);
 }
 
 bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> >&vect) {
-    CDBBatch batch(*this);
+    CDBBatch batch(txIndexDB);
     for (std::vector<std::pair<uint256,CDiskTxPos> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(make_pair(DB_TXINDEX, it->first), it->second);
-    return WriteBatch(batch);
+    return txIndexDB.WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value) {
-    return Read(make_pair(DB_SPENTINDEX, key), value);
+    return spentIndexDB.Read(make_pair(DB_SPENTINDEX, key), value);
 }
 
 bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect) {
-    CDBBatch batch(*this);
+    CDBBatch batch(spentIndexDB);
     for (std::vector<std::pair<CSpentIndexKey,CSpentIndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
         if (it->second.IsNull()) {
             batch.Erase(make_pair(DB_SPENTINDEX, it->first));
@@ -330,11 +440,11 @@ bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey,
             batch.Write(make_pair(DB_SPENTINDEX, it->first), it->second);
         }
     }
-    return WriteBatch(batch);
+    return spentIndexDB.WriteBatch(batch);
 }
 
 bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect) {
-    CDBBatch batch(*this);
+    CDBBatch batch(addressIndexDB);
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
         if (it->second.IsNull()) {
             batch.Erase(make_pair(DB_ADDRESSUNSPENTINDEX, it->first));
@@ -342,13 +452,13 @@ bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddres
             batch.Write(make_pair(DB_ADDRESSUNSPENTINDEX, it->first), it->second);
         }
     }
-    return WriteBatch(batch);
+    return addressIndexDB.WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
                                            std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
 
-    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    boost::scoped_ptr<CDBIterator> pcursor(addressIndexDB.NewIterator());
 
     pcursor->Seek(make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
 
@@ -381,24 +491,24 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
 }
 
 bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(*this);
+    CDBBatch batch(addressIndexDB);
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(make_pair(DB_ADDRESSINDEX, it->first), it->second);
-    return WriteBatch(batch);
+    return addressIndexDB.WriteBatch(batch);
 }
 
 bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(*this);
+    CDBBatch batch(addressIndexDB);
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Erase(make_pair(DB_ADDRESSINDEX, it->first));
-    return WriteBatch(batch);
+    return addressIndexDB.WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
                                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                                     int start, int end) {
 
-    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    boost::scoped_ptr<CDBIterator> pcursor(addressIndexDB.NewIterator());
 
     if (start > 0 && end > 0) {
         pcursor->Seek(make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
@@ -461,12 +571,84 @@ uint32_t komodo_segid32(char *coinaddr);
     {"RD6GgnrMpPaTSMn8vai6yiGA7mN4QGPVMY", 1} \
 };
 
+bool IsSnapshotIgnoredAddress(const std::string &address)
+{
+    static DECLARE_IGNORELIST
+    return ignoredMap.find(address) != ignoredMap.end();
+}
+
+// applies the balance deltas of a block and returns the new balances of the touched addresses, hashBest is written in the same batch
+bool CBlockTreeDB::UpdateAddressBalanceIndex(const std::map<CAddressBalanceKey, CAddressBalanceValue> &deltas, std::map<CAddressBalanceKey, CAddressBalanceValue> &balances, const uint256 &hashBest)
+{
+    CDBBatch batch(addressIndexDB);
+    batch.Write(make_pair(DB_INDEX_BEST_BLOCK, std::string("addressbalance")), hashBest);
+    for (std::map<CAddressBalanceKey, CAddressBalanceValue>::const_iterator it = deltas.begin(); it != deltas.end(); it++)
+    {
+        CAddressBalanceValue value;
+        if (!addressIndexDB.Read(make_pair(DB_ADDRESSBALANCE, it->first), value))
+            value.SetNull();
+        value.balance += it->second.balance;
+        value.utxos += it->second.utxos;
+        if (value.IsNull())
+            batch.Erase(make_pair(DB_ADDRESSBALANCE, it->first));
+        else
+            batch.Write(make_pair(DB_ADDRESSBALANCE, it->first), value);
+        balances[it->first] = value;
+    }
+    return addressIndexDB.WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadAddressBalanceBestBlock(uint256 &hashBest)
+{
+    if (!addressIndexDB.Read(make_pair(DB_INDEX_BEST_BLOCK, std::string("addressbalance")), hashBest))
+        hashBest.SetNull();
+    return true;
+}
+
+bool CBlockTreeDB::ReadAddressBalances(std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &vect)
+{
+    boost::scoped_ptr<CDBIterator> pcursor(addressIndexDB.NewIterator());
+
+    pcursor->Seek(make_pair(DB_ADDRESSBALANCE, CAddressBalanceKey()));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        pair<char, CAddressBalanceKey> keyObj;
+        if (!pcursor->GetKey(keyObj) || keyObj.first != DB_ADDRESSBALANCE)
+            break;
+        CAddressBalanceValue value;
+        if (!pcursor->GetValue(value))
+            return error("failed to get address balance value");
+        vect.push_back(make_pair(keyObj.second, value));
+        pcursor->Next();
+    }
+    return true;
+}
+
+// the snapshot totals, same fields as the full scan in Snapshot2
+static void AddressBalanceSnapshotStats(UniValue *ret)
+{
+    CAddressBalanceStats stats = addressBalanceRanking.GetStats();
+    int64_t total = stats.total + stats.ccTotal, totalAddresses = addressBalanceRanking.Size();
+
+    ret->push_back(make_pair("total", (double) (total)/ COIN ));
+    ret->push_back(make_pair("average",(double) (total/COIN) / totalAddresses ));
+    ret->push_back(make_pair("utxos", stats.utxos));
+    ret->push_back(make_pair("total_addresses", totalAddresses ));
+    ret->push_back(make_pair("ignored_addresses", stats.ignoredUtxos));
+    ret->push_back(make_pair("skipped_cc_utxos", stats.ccUtxos));
+    ret->push_back(make_pair("cc_utxo_value", (double) stats.ccTotal / COIN));
+    ret->push_back(make_pair("total_includeCCvouts", (double) (total+stats.ccTotal)/ COIN ));
+    ret->push_back(make_pair("ending_height", chainActive.Height()));
+}
+
 bool CBlockTreeDB::Snapshot2(std::map <std::string, CAmount> &addressAmounts, UniValue *ret)
 {
     int64_t total = 0; int64_t totalAddresses = 0; std::string address;
     int64_t utxos = 0; int64_t ignoredAddresses = 0, cryptoConditionsUTXOs = 0, cryptoConditionsTotals = 0;
+
     DECLARE_IGNORELIST
-    boost::scoped_ptr<CDBIterator> iter(NewIterator());
+    boost::scoped_ptr<CDBIterator> iter(addressIndexDB.NewIterator());
     //std::map <std::string, CAmount> addressAmounts;
     for (iter->SeekToLast(); iter->Valid(); iter->Prev())
     {
@@ -570,16 +752,29 @@ UniValue CBlockTreeDB::Snapshot(int top)
     std::map <std::string, CAmount> addressAmounts;
     UniValue result(UniValue::VOBJ);
     UniValue addressesSorted(UniValue::VARR);
+    bool fRanked = false;
     result.push_back(Pair("start_time", (int) time(NULL)));
-    if ( (vAddressSnapshot.size() > 0 && top < 0) || (Snapshot2(addressAmounts,&result) && top >= 0) )
+    if ( top >= 0 && addressBalanceRanking.IsLoaded() )
+    {
+        // top N straight from the address balance ranking, already sorted
+        std::vector<std::pair<CAmount, CAddressBalanceKey> > ranked;
+        std::string address;
+        AddressBalanceSnapshotStats(&result);
+        addressBalanceRanking.GetTop(0, top, ranked);
+        for (const auto &entry : ranked)
+            if (getAddressFromIndex(entry.second.type, entry.second.hashBytes, address))
+                vaddr.push_back(make_pair(entry.first, address));
+        fRanked = true;
+    }
+    if ( fRanked || (vAddressSnapshot.size() > 0 && top < 0) || (Snapshot2(addressAmounts,&result) && top >= 0) )
     {
-        if ( top > -1 )
+        if ( !fRanked && top > -1 )
         {
             for (std::pair<std::string, CAmount> element : addressAmounts)
                 vaddr.push_back( make_pair(element.second, element.first) );
             std::sort(vaddr.rbegin(), vaddr.rend());
         }
-        else 
+        else if ( !fRanked )
         {
             for ( auto address : vAddressSnapshot )
                 vaddr.push_back(make_pair(address.first, CBitcoinAddress(address.second).ToString()));
@@ -607,14 +802,14 @@ UniValue CBlockTreeDB::Snapshot(int top)
 }
 
 bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
-    CDBBatch batch(*this);
+    CDBBatch batch(timestampIndexDB);
     batch.Write(make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
-    return WriteBatch(batch);
+    return timestampIndexDB.WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned int &low, const bool fActiveOnly, std::vector<std::pair<uint256, unsigned int> > &hashes) {
 
-    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    boost::scoped_ptr<CDBIterator> pcursor(timestampIndexDB.NewIterator());
 
     pcursor->Seek(make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(low)));
 
@@ -648,15 +843,15 @@ bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned i
 }
 
 bool CBlockTreeDB::WriteTimestampBlockIndex(const CTimestampBlockIndexKey &blockhashIndex, const CTimestampBlockIndexValue &logicalts) {
-    CDBBatch batch(*this);
+    CDBBatch batch(timestampIndexDB);
     batch.Write(make_pair(DB_BLOCKHASHINDEX, blockhashIndex), logicalts);
-    return WriteBatch(batch);
+    return timestampIndexDB.WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadTimestampBlockIndex(const uint256 &hash, unsigned int &ltimestamp) {
 
     CTimestampBlockIndexValue(lts);
-    if (!Read(std::make_pair(DB_BLOCKHASHINDEX, hash), lts))
+    if (!timestampIndexDB.Read(std::make_pair(DB_BLOCKHASHINDEX, hash), lts))
 	return false;
 
     ltimestamp = lts.ltimestamp;
@@ -750,7 +945,7 @@ bool CBlockTreeDB::LoadBlockIndexGuts()
 
 // update or erase entry for unspent cc index
 bool CBlockTreeDB::UpdateUnspentCCIndex(const std::vector<std::pair<CUnspentCCIndexKey, CUnspentCCIndexValue > >&vect) {
-    CDBBatch batch(*this);
+    CDBBatch batch(ccIndexDB);
     for (std::vector<std::pair<CUnspentCCIndexKey, CUnspentCCIndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
         if (it->second.IsNull()) {
             batch.Erase(make_pair(DB_ADDRESSUNSPENT_CC_INDEX, it->first));
@@ -758,14 +953,14 @@ bool CBlockTreeDB::UpdateUnspentCCIndex(const std::vector<std::pair<CUnspentCCIn
             batch.Write(make_pair(DB_ADDRESSUNSPENT_CC_INDEX, it->first), it->second);
         }
     }
-    return WriteBatch(batch);
+    return ccIndexDB.WriteBatch(batch);
 }
 
 // read unspent cc index by address or address+creationid key
 bool CBlockTreeDB::ReadUnspentCCIndex(uint160 addressHash, uint256 creationid,
                                            std::vector<std::pair<CUnspentCCIndexKey, CUnspentCCIndexValue> > &unspentOutputs, int32_t beginHeight, int32_t endHeight, int64_t maxOutputs) {
 
-    boost::scoped_ptr<CDBIterator> pcursor(NewIterator());
+    boost::scoped_ptr<CDBIterator> pcursor(ccIndexDB.NewIterator());
 
     if (creationid.IsNull())
         pcursor->Seek(make_pair(DB_ADDRESSUNSPENT_CC_INDEX, CUnspentCCIndexKeyAddr(addressHash)));  //search first address
@@ -804,3 +999,236 @@ bool CBlockTreeDB::ReadUnspentCCIndex(uint160 addressHash, uint256 creationid,
     }
     return true;
 }
+
+bool CBlockTreeDB::ReadCCBatonTip(const CCCBatonKey &key, CCCBatonTipValue &value) {
+    return ccIndexDB.Read(make_pair(DB_CCBATON_TIP, key), value);
+}
+
+bool CBlockTreeDB::ReadCCBatonEvent(const CCCBatonEventKey &key, CCCBatonEventValue &value) {
+    return ccIndexDB.Read(make_pair(DB_CCBATON_EVENT, key), value);
+}
+
+// read up to maxevents events of a baton chain starting at sequence firstseq
+bool CBlockTreeDB::ReadCCBatonEvents(const CCCBatonKey &key, uint32_t firstseq, uint32_t maxevents, std::vector<std::pair<CCCBatonEventKey, CCCBatonEventValue> > &vect) {
+
+    boost::scoped_ptr<CDBIterator> pcursor(ccIndexDB.NewIterator());
+
+    pcursor->Seek(make_pair(DB_CCBATON_EVENT, CCCBatonEventKey(key.evalcode, key.rootid, firstseq)));
+
+    while (pcursor->Valid() && (maxevents == 0 || vect.size() < maxevents)) {
+        boost::this_thread::interruption_point();
+        pair<char, CCCBatonEventKey> keyObj;
+        if (!pcursor->GetKey(keyObj) || keyObj.first != DB_CCBATON_EVENT || keyObj.second.evalcode != key.evalcode || keyObj.second.rootid != key.rootid)
+            break;
+        CCCBatonEventValue eventValue;
+        if (!pcursor->GetValue(eventValue))
+            return error("failed to get cc baton event value");
+        vect.push_back(make_pair(keyObj.second, eventValue));
+        pcursor->Next();
+    }
+    return true;
+}
+
+// read the tips of all baton chains of a module
+bool CBlockTreeDB::ReadCCBatonTips(uint8_t evalcode, std::vector<std::pair<CCCBatonKey, CCCBatonTipValue> > &vect) {
+
+    boost::scoped_ptr<CDBIterator> pcursor(ccIndexDB.NewIterator());
+
+    pcursor->Seek(make_pair(DB_CCBATON_TIP, CCCBatonKey(evalcode, uint256())));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        pair<char, CCCBatonKey> keyObj;
+        if (!pcursor->GetKey(keyObj) || keyObj.first != DB_CCBATON_TIP || keyObj.second.evalcode != evalcode)
+            break;
+        CCCBatonTipValue tipValue;
+        if (!pcursor->GetValue(tipValue))
+            return error("failed to get cc baton tip value");
+        vect.push_back(make_pair(keyObj.second, tipValue));
+        pcursor->Next();
+    }
+    return true;
+}
+
+// read the baton chains posted under an owner key, in any role
+bool CBlockTreeDB::ReadCCBatonPostings(uint8_t evalcode, const std::vector<uint8_t> &owner, std::vector<std::pair<CCCBatonPostingKey, int32_t> > &vect) {
+
+    boost::scoped_ptr<CDBIterator> pcursor(ccIndexDB.NewIterator());
+
+    pcursor->Seek(make_pair(DB_CCBATON_POSTING, CCCBatonPostingKeyOwner(evalcode, owner)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        pair<char, CCCBatonPostingKey> keyObj;
+        if (!pcursor->GetKey(keyObj) || keyObj.first != DB_CCBATON_POSTING || keyObj.second.evalcode != evalcode || keyObj.second.owner != owner)
+            break;
+        int32_t height;
+        if (!pcursor->GetValue(height))
+            return error("failed to get cc baton posting value");
+        vect.push_back(make_pair(keyObj.second, height));
+        pcursor->Next();
+    }
+    return true;
+}
+
+bool CBlockTreeDB::ReadCCBatonOutpoint(const COutPoint &outpoint, CCCBatonRefValue &value) {
+    return ccIndexDB.Read(make_pair(DB_CCBATON_OUTPOINT, outpoint), value);
+}
+
+bool CBlockTreeDB::ReadCCBatonBestBlock(uint256 &hashBest) {
+    if (!ccIndexDB.Read(make_pair(DB_INDEX_BEST_BLOCK, std::string("ccbaton")), hashBest))
+        hashBest.SetNull();
+    return true;
+}
+
+bool CBlockTreeDB::ReadCCBatonTxRefs(const uint256 &txid, std::vector<CCCBatonRefValue> &vect) {
+    return ccIndexDB.Read(make_pair(DB_CCBATON_TXREFS, txid), vect);
+}
+
+// write the final state of a connected or disconnected block, null values are erased, hashBest is written in the same batch
+bool CBlockTreeDB::UpdateCCBatonIndex(const CCCBatonIndexUpdate &update, const uint256 &hashBest) {
+    CDBBatch batch(ccIndexDB);
+    batch.Write(make_pair(DB_INDEX_BEST_BLOCK, std::string("ccbaton")), hashBest);
+    for (std::map<CCCBatonKey, CCCBatonTipValue>::const_iterator it=update.tips.begin(); it!=update.tips.end(); it++) {
+        if (it->second.IsNull())
+            batch.Erase(make_pair(DB_CCBATON_TIP, it->first));
+        else
+            batch.Write(make_pair(DB_CCBATON_TIP, it->first), it->second);
+    }
+    for (std::map<CCCBatonEventKey, CCCBatonEventValue>::const_iterator it=update.events.begin(); it!=update.events.end(); it++) {
+        if (it->second.IsNull())
+            batch.Erase(make_pair(DB_CCBATON_EVENT, it->first));
+        else
+            batch.Write(make_pair(DB_CCBATON_EVENT, it->first), it->second);
+    }
+    for (std::map<COutPoint, CCCBatonRefValue>::const_iterator it=update.outpoints.begin(); it!=update.outpoints.end(); it++) {
+        if (it->second.IsNull())
+            batch.Erase(make_pair(DB_CCBATON_OUTPOINT, it->first));
+        else
+            batch.Write(make_pair(DB_CCBATON_OUTPOINT, it->first), it->second);
+    }
+    for (std::map<uint256, std::vector<CCCBatonRefValue> >::const_iterator it=update.txrefs.begin(); it!=update.txrefs.end(); it++) {
+        if (it->second.empty())
+            batch.Erase(make_pair(DB_CCBATON_TXREFS, it->first));
+        else
+            batch.Write(make_pair(DB_CCBATON_TXREFS, it->first), it->second);
+    }
+    for (std::map<CCCBatonPostingKey, int32_t>::const_iterator it=update.postings.begin(); it!=update.postings.end(); it++) {
+        if (it->second < 0)
+            batch.Erase(make_pair(DB_CCBATON_POSTING, it->first));
+        else
+            batch.Write(make_pair(DB_CCBATON_POSTING, it->first), it->second);
+    }
+    return ccIndexDB.WriteBatch(batch);
+}
+
+bool CBlockTreeDB::UpdateOracleDataIndex(const std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue> > &vect) {
+    CDBBatch batch(ccIndexDB);
+    for (std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+        if (it->second.IsNull())
+            batch.Erase(make_pair(DB_ORACLESAMPLE, it->first));
+        else
+            batch.Write(make_pair(DB_ORACLESAMPLE, it->first), it->second);
+    }
+    return ccIndexDB.WriteBatch(batch);
+}
+
+// read the samples of an oracle series within [fromheight, toheight], oldest first or, if fLatest, newest first
+bool CBlockTreeDB::ReadOracleSamples(const CCCOracleSeriesKey &series, uint32_t fromheight, uint32_t toheight, uint32_t maxsamples, bool fLatest,
+                                     std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue> > &vect) {
+
+    boost::scoped_ptr<CDBIterator> pcursor(ccIndexDB.NewIterator());
+
+    if (fLatest) {
+        // position on the last sample at or below toheight
+        pcursor->Seek(make_pair(DB_ORACLESAMPLE, CCCOracleSampleKey(series.oracletxid, series.batonaddr, toheight, 0xffffffff)));
+        if (pcursor->Valid())
+            pcursor->Prev();
+        else
+            pcursor->SeekToLast();
+    }
+    else
+        pcursor->Seek(make_pair(DB_ORACLESAMPLE, CCCOracleSampleKey(series.oracletxid, series.batonaddr, fromheight, 0)));
+
+    while (pcursor->Valid() && (maxsamples == 0 || vect.size() < maxsamples)) {
+        boost::this_thread::interruption_point();
+        pair<char, CCCOracleSampleKey> keyObj;
+        if (!pcursor->GetKey(keyObj) || keyObj.first != DB_ORACLESAMPLE || !keyObj.second.IsSameSeries(series) ||
+            keyObj.second.blockHeight < fromheight || keyObj.second.blockHeight > toheight)
+            break;
+        CCCOracleSampleValue sampleValue;
+        if (!pcursor->GetValue(sampleValue))
+            return error("failed to get oracle sample value");
+        vect.push_back(make_pair(keyObj.second, sampleValue));
+        if (fLatest)
+            pcursor->Prev();
+        else
+            pcursor->Next();
+    }
+    return true;
+}
+
+bool CBlockTreeDB::UpdateRewardsIndex(const std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> > &vect) {
+    CDBBatch batch(ccIndexDB);
+    for (std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+        if (it->second.IsNull())
+            batch.Erase(make_pair(DB_REWARDSOUTPUT, it->first));
+        else
+            batch.Write(make_pair(DB_REWARDSOUTPUT, it->first), it->second);
+    }
+    return ccIndexDB.WriteBatch(batch);
+}
+
+// read the unspent outputs of a rewards plan, all sbits
+bool CBlockTreeDB::ReadRewardsOutputs(uint256 fundingtxid, std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> > &vect) {
+
+    boost::scoped_ptr<CDBIterator> pcursor(ccIndexDB.NewIterator());
+
+    pcursor->Seek(make_pair(DB_REWARDSOUTPUT, CCCRewardsOutputKey(fundingtxid, 0, uint256(), 0)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        pair<char, CCCRewardsOutputKey> keyObj;
+        if (!pcursor->GetKey(keyObj) || keyObj.first != DB_REWARDSOUTPUT || keyObj.second.fundingtxid != fundingtxid)
+            break;
+        CCCRewardsOutputValue outputValue;
+        if (!pcursor->GetValue(outputValue))
+            return error("failed to get rewards output value");
+        vect.push_back(make_pair(keyObj.second, outputValue));
+        pcursor->Next();
+    }
+    return true;
+}
+
+// states with IsNull() are erased, undo records are written on connect and erased on disconnect, hashBest is written in the same batch
+bool CBlockTreeDB::UpdateHeirIndex(const std::vector<std::pair<uint256, CCCHeirStateValue> > &states, const std::vector<std::pair<uint256, CCCHeirStateValue> > &undo, bool fDisconnect, const uint256 &hashBest) {
+    CDBBatch batch(ccIndexDB);
+    batch.Write(make_pair(DB_INDEX_BEST_BLOCK, std::string("heir")), hashBest);
+    for (std::vector<std::pair<uint256, CCCHeirStateValue> >::const_iterator it=states.begin(); it!=states.end(); it++) {
+        if (it->second.IsNull())
+            batch.Erase(make_pair(DB_HEIRSTATE, it->first));
+        else
+            batch.Write(make_pair(DB_HEIRSTATE, it->first), it->second);
+    }
+    for (std::vector<std::pair<uint256, CCCHeirStateValue> >::const_iterator it=undo.begin(); it!=undo.end(); it++) {
+        if (fDisconnect)
+            batch.Erase(make_pair(DB_HEIRUNDO, it->first));
+        else
+            batch.Write(make_pair(DB_HEIRUNDO, it->first), it->second);
+    }
+    return ccIndexDB.WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadHeirState(uint256 fundingtxid, CCCHeirStateValue &state) {
+    return ccIndexDB.Read(make_pair(DB_HEIRSTATE, fundingtxid), state);
+}
+
+bool CBlockTreeDB::ReadHeirBestBlock(uint256 &hashBest) {
+    if (!ccIndexDB.Read(make_pair(DB_INDEX_BEST_BLOCK, std::string("heir")), hashBest))
+        hashBest.SetNull();
+    return true;
+}
+
+bool CBlockTreeDB::ReadHeirUndo(uint256 txid, CCCHeirStateValue &state) {
+    return ccIndexDB.Read(make_pair(DB_HEIRUNDO, txid), state);
+}
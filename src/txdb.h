@@ -24,7 +24,13 @@
 #include "coins.h"
 #include "dbwrapper.h"
 #include "unspentccindex.h"
+#include "ccbatonindex.h"
+#include "ccoracledataindex.h"
+#include "ccrewardsindex.h"
+#include "ccheirindex.h"
+#include "addressbalance.h"
 
+#include <array>
 #include <map>
 #include <string>
 #include <utility>
@@ -81,14 +87,55 @@ public:
     bool GetStats(CCoinsStats &stats) const;
 };
 
-/** Access to the block database (blocks/index/) */
+/** Addresses excluded from getsnapshot and the daily snapshot */
+bool IsSnapshotIgnoredAddress(const std::string &address);
+
+/** Index databases kept apart from the block index, each in indexes/<name>/ */
+enum IndexDBType {
+    INDEXDB_TX,
+    INDEXDB_ADDRESS,        // address, address unspent and address balance indexes
+    INDEXDB_SPENT,
+    INDEXDB_TIMESTAMP,      // timestamp and block timestamp indexes
+    INDEXDB_CC,             // unspent cc, baton, oracle data, rewards and heir indexes
+    INDEXDB_COUNT
+};
+
+/** Name of an index database, its directory and the key of -indexdbcache */
+const char *IndexDBName(IndexDBType type);
+
+/** LevelDB memory of one index database */
+struct CIndexDBCache {
+    size_t nCacheSize;          // block cache and, if nWriteBufferSize is 0, write buffers as for CDBWrapper
+    size_t nWriteBufferSize;
+
+    CIndexDBCache() : nCacheSize(1 << 20), nWriteBufferSize(0) {}
+    CIndexDBCache(size_t nCacheSizeIn, size_t nWriteBufferSizeIn) : nCacheSize(nCacheSizeIn), nWriteBufferSize(nWriteBufferSizeIn) {}
+};
+
+typedef std::array<CIndexDBCache, INDEXDB_COUNT> CIndexDBCaches;
+
+/**
+ * Access to the block database (blocks/index/) and the index databases (indexes/).
+ * Every index family has its own LevelDB, so index writes during sync neither evict block
+ * index entries from the cache nor queue behind the same compactions.
+ */
 class CBlockTreeDB : public CDBWrapper
 {
 public:
-    CBlockTreeDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool compression = true, int maxOpenFiles = 1000);
+    CBlockTreeDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool compression = true, int maxOpenFiles = 1000,
+                 const CIndexDBCaches &indexCaches = CIndexDBCaches());
 private:
+    CDBWrapper txIndexDB;
+    CDBWrapper addressIndexDB;
+    CDBWrapper spentIndexDB;
+    CDBWrapper timestampIndexDB;
+    CDBWrapper ccIndexDB;
+
     CBlockTreeDB(const CBlockTreeDB&);
     void operator=(const CBlockTreeDB&);
+
+    //! moves index entries written by older versions into the index databases, once
+    bool MigrateIndexes();
 public:
     bool WriteBatchSync(const std::vector<std::pair<int, const CBlockFileInfo*> >& fileInfo, int nLastFile, const std::vector<const CBlockIndex*>& blockinfo);
     bool EraseBatchSync(const std::vector<const CBlockIndex*>& blockinfo);
@@ -118,6 +165,31 @@ public:
     bool blockOnchainActive(const uint256 &hash);
     UniValue Snapshot(int top);
     bool Snapshot2(std::map <std::string, CAmount> &addressAmounts, UniValue *ret);
+    bool UpdateAddressBalanceIndex(const std::map<CAddressBalanceKey, CAddressBalanceValue> &deltas, std::map<CAddressBalanceKey, CAddressBalanceValue> &balances, const uint256 &hashBest);
+    bool ReadAddressBalanceBestBlock(uint256 &hashBest);
+    bool ReadAddressBalances(std::vector<std::pair<CAddressBalanceKey, CAddressBalanceValue> > &vect);
+
+    bool ReadCCBatonTip(const CCCBatonKey &key, CCCBatonTipValue &value);
+    bool ReadCCBatonEvent(const CCCBatonEventKey &key, CCCBatonEventValue &value);
+    bool ReadCCBatonEvents(const CCCBatonKey &key, uint32_t firstseq, uint32_t maxevents, std::vector<std::pair<CCCBatonEventKey, CCCBatonEventValue> > &vect);
+    bool ReadCCBatonOutpoint(const COutPoint &outpoint, CCCBatonRefValue &value);
+    bool ReadCCBatonTxRefs(const uint256 &txid, std::vector<CCCBatonRefValue> &vect);
+    bool ReadCCBatonTips(uint8_t evalcode, std::vector<std::pair<CCCBatonKey, CCCBatonTipValue> > &vect);
+    bool ReadCCBatonPostings(uint8_t evalcode, const std::vector<uint8_t> &owner, std::vector<std::pair<CCCBatonPostingKey, int32_t> > &vect);
+    bool ReadCCBatonBestBlock(uint256 &hashBest);
+    bool UpdateCCBatonIndex(const CCCBatonIndexUpdate &update, const uint256 &hashBest);
+
+    bool UpdateOracleDataIndex(const std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue> > &vect);
+    bool ReadOracleSamples(const CCCOracleSeriesKey &series, uint32_t fromheight, uint32_t toheight, uint32_t maxsamples, bool fLatest,
+                                 std::vector<std::pair<CCCOracleSampleKey, CCCOracleSampleValue> > &vect);
+
+    bool UpdateRewardsIndex(const std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> > &vect);
+    bool ReadRewardsOutputs(uint256 fundingtxid, std::vector<std::pair<CCCRewardsOutputKey, CCCRewardsOutputValue> > &vect);
+
+    bool UpdateHeirIndex(const std::vector<std::pair<uint256, CCCHeirStateValue> > &states, const std::vector<std::pair<uint256, CCCHeirStateValue> > &undo, bool fDisconnect, const uint256 &hashBest);
+    bool ReadHeirState(uint256 fundingtxid, CCCHeirStateValue &state);
+    bool ReadHeirUndo(uint256 txid, CCCHeirStateValue &state);
+    bool ReadHeirBestBlock(uint256 &hashBest);
 
     bool UpdateUnspentCCIndex(const std::vector<std::pair<CUnspentCCIndexKey, CUnspentCCIndexValue > >&vect);
     bool ReadUnspentCCIndex(uint160 addressHash, uint256 creationid,
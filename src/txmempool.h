@@ -22,6 +22,7 @@
 #define BITCOIN_TXMEMPOOL_H
 
 #include <list>
+#include <set>
 
 #include "addressindex.h"
 #include "spentindex.h"
@@ -130,6 +131,24 @@ public:
     size_t DynamicMemoryUsage() const { return 0; }
 };
 
+/** Salted hash of an outpoint, for the mempool maps keyed by the outputs its transactions spend. */
+class CSaltedOutPointHasher
+{
+private:
+    uint256 salt;
+
+public:
+    CSaltedOutPointHasher();
+
+    size_t operator()(const COutPoint& out) const {
+        return out.hash.GetHash(salt) ^ (out.n * 0x9e3779b97f4a7c15ULL);
+    }
+
+    size_t operator()(const CSpentIndexKey& key) const {
+        return key.txid.GetHash(salt) ^ (key.outputIndex * 0x9e3779b97f4a7c15ULL);
+    }
+};
+
 /**
  * CTxMemPool stores valid-according-to-the-current-best-chain
  * transactions that may be included in the next block.
@@ -157,7 +176,13 @@ private:
     std::map<uint256, const CTransaction*> mapSproutNullifiers;
     std::map<uint256, const CTransaction*> mapSaplingNullifiers;
 
+    //! txids added, removed or reprioritised since the miner last asked, see GetCandidateUpdates
+    std::set<uint256> setCandidateUpdates;
+    bool fTrackCandidates = false;
+    bool fCandidatesReset = false;
+
     void checkNullifiers(ShieldedType type) const;
+    void CandidateUpdated(const uint256& hash);
     
 public:
     typedef boost::multi_index_container<
@@ -180,23 +205,24 @@ private:
     typedef std::map<CMempoolAddressDeltaKey, CMempoolAddressDelta, CMempoolAddressDeltaKeyCompare> addressDeltaMap;
     addressDeltaMap mapAddress;
 
-    typedef std::map<uint256, std::vector<CMempoolAddressDeltaKey> > addressDeltaMapInserted;
+    typedef flathashmap<uint256, std::vector<CMempoolAddressDeltaKey>, CCoinsKeyHasher> addressDeltaMapInserted;
     addressDeltaMapInserted mapAddressInserted;
 
-    typedef std::map<CSpentIndexKey, CSpentIndexValue, CSpentIndexKeyCompare> mapSpentIndex;
+    typedef flathashmap<CSpentIndexKey, CSpentIndexValue, CSaltedOutPointHasher> mapSpentIndex;
     mapSpentIndex mapSpent;
 
-    typedef std::map<uint256, std::vector<CSpentIndexKey> > mapSpentIndexInserted;
+    typedef flathashmap<uint256, std::vector<CSpentIndexKey>, CCoinsKeyHasher> mapSpentIndexInserted;
     mapSpentIndexInserted mapSpentInserted;
 
     typedef std::map<CUnspentCCIndexKey, CUnspentCCIndexValue, CUnspentCCIndexKeyCompare> mapUnspentCCIndexType;
     mapUnspentCCIndexType mapUnspentCCIndex;
 
-    typedef std::map<uint256, std::vector<CUnspentCCIndexKey> > mapUnspentCCIndexInsertedType;
+    typedef flathashmap<uint256, std::vector<CUnspentCCIndexKey>, CCoinsKeyHasher> mapUnspentCCIndexInsertedType;
     mapUnspentCCIndexInsertedType mapUnspentCCIndexInserted;
 
 public:
-    std::map<COutPoint, CInPoint> mapNextTx;
+    typedef flathashmap<COutPoint, CInPoint, CSaltedOutPointHasher> mapNextTxType;
+    mapNextTxType mapNextTx;
     std::map<uint256, std::pair<double, CAmount> > mapDeltas;
 
     CTxMemPool(const CFeeRate& _minRelayFee);
@@ -252,6 +278,15 @@ public:
 
     bool nullifierExists(const uint256& nullifier, ShieldedType type) const;
 
+    /**
+     * Hands out the txids changed since the last call, for the block template candidates kept by
+     * the miner. fReset is set when the whole pool has to be looked at again: on the first call,
+     * after clear(), after ResetCandidateUpdates() or when too many changes piled up between calls.
+     */
+    void GetCandidateUpdates(std::set<uint256>& updates, bool& fReset);
+    /** Makes the miner look at the whole pool again for its next template. */
+    void ResetCandidateUpdates();
+
     void NotifyRecentlyAdded();
     bool IsFullyNotified();
     
@@ -2879,10 +2879,12 @@ UniValue resendwallettransactions(const UniValue& params, bool fHelp, const CPub
 
 extern uint32_t komodo_segid32(char *coinaddr);
 
-UniValue listunspent(const UniValue& params, bool fHelp, const CPubKey& mypk)
+void listunspent_stream(const UniValue& params, bool fHelp, const CPubKey& mypk, JSONStream& results)
 {
-    if (!EnsureWalletIsAvailable(fHelp))
-        return NullUniValue;
+    if (!EnsureWalletIsAvailable(fHelp)) {
+        results.Push(NullUniValue);
+        return;
+    }
 
     if (fHelp || params.size() > 3)
         throw runtime_error(
@@ -2948,11 +2950,11 @@ UniValue listunspent(const UniValue& params, bool fHelp, const CPubKey& mypk)
         }
     }
 
-    UniValue results(UniValue::VARR);
     vector<COutput> vecOutputs;
     assert(pwalletMain != NULL);
     LOCK2(cs_main, pwalletMain->cs_wallet);
     pwalletMain->AvailableCoins(vecOutputs, false, NULL, true);
+    results.BeginArray();
     BOOST_FOREACH(const COutput& out, vecOutputs) {
         int nDepth    = out.tx->GetDepthInMainChain();
         if( nMinDepth > 1 ) {
@@ -3013,9 +3015,14 @@ UniValue listunspent(const UniValue& params, bool fHelp, const CPubKey& mypk)
         entry.push_back(Pair("rawconfirmations",out.nDepth));
         entry.push_back(Pair("confirmations",komodo_dpowconfs(txheight,out.nDepth)));
         entry.push_back(Pair("spendable", out.fSpendable));
-        results.push_back(entry);
+        results.Push(entry);
     }
-    return results;
+    results.EndArray();
+}
+
+UniValue listunspent(const UniValue& params, bool fHelp, const CPubKey& mypk)
+{
+    return RPCStreamToUniValue(listunspent_stream, params, fHelp, mypk);
 }
 
 uint64_t komodo_interestsum()
@@ -3344,8 +3351,6 @@ UniValue zc_benchmark(const UniValue& params, bool fHelp, const CPubKey& mypk)
             );
     }
 
-    LOCK(cs_main);
-
     std::string benchmarktype = params[0].get_str();
     int samplecount = params[1].get_int();
 
@@ -3355,6 +3360,23 @@ UniValue zc_benchmark(const UniValue& params, bool fHelp, const CPubKey& mypk)
 
     std::vector<double> sample_times;
 
+    // the batch threads take cs_main themselves, so it must not be held while waiting for them
+    if (benchmarktype == "rpcbatch") {
+        int nRequests = 100;
+        if (params.size() >= 3) {
+            nRequests = params[2].get_int();
+        }
+        UniValue results(UniValue::VARR);
+        for (int i = 0; i < samplecount; i++) {
+            UniValue result(UniValue::VOBJ);
+            result.push_back(Pair("runningtime", benchmark_rpcbatch(nRequests)));
+            results.push_back(result);
+        }
+        return results;
+    }
+
+    LOCK(cs_main);
+
     JSDescription samplejoinsplit;
 
     if (benchmarktype == "verifyjoinsplit") {
@@ -3409,6 +3431,60 @@ UniValue zc_benchmark(const UniValue& params, bool fHelp, const CPubKey& mypk)
                 throw JSONRPCError(RPC_TYPE_ERROR, "Benchmark must be run in regtest mode");
             }
             sample_times.push_back(benchmark_connectblock_slow());
+        } else if (benchmarktype == "stakinground") {
+            int nUtxos = 10000;
+            if (params.size() >= 3) {
+                nUtxos = params[2].get_int();
+            }
+            sample_times.push_back(benchmark_stakinground(nUtxos));
+        } else if (benchmarktype == "merkleroot") {
+            int nTxs = 10000;
+            if (params.size() >= 3) {
+                nTxs = params[2].get_int();
+            }
+            sample_times.push_back(benchmark_merkleroot(nTxs));
+        } else if (benchmarktype == "ccdecode") {
+            int nDecodes = 100000;
+            if (params.size() >= 3) {
+                nDecodes = params[2].get_int();
+            }
+            sample_times.push_back(benchmark_ccdecode(nDecodes));
+        } else if (benchmarktype == "ccsigcache" || benchmarktype == "ccsigcache_uncached") {
+            int nInputs = 1000;
+            if (params.size() >= 3) {
+                nInputs = params[2].get_int();
+            }
+            sample_times.push_back(benchmark_ccsigcache(nInputs, benchmarktype == "ccsigcache"));
+        } else if (benchmarktype == "blocktemplate") {
+            if (Params().NetworkIDString() != "regtest") {
+                throw JSONRPCError(RPC_TYPE_ERROR, "Benchmark must be run in regtest mode");
+            }
+            int nTxs = 5000;
+            if (params.size() >= 3) {
+                nTxs = params[2].get_int();
+            }
+            sample_times.push_back(benchmark_blocktemplate(nTxs));
+        } else if (benchmarktype == "indexdb") {
+            int nBlocks = 500;
+            if (params.size() >= 3) {
+                nBlocks = params[2].get_int();
+            }
+            sample_times.push_back(benchmark_indexdb(nBlocks));
+        } else if (benchmarktype == "coinscache") {
+            if (Params().NetworkIDString() != "regtest") {
+                throw JSONRPCError(RPC_TYPE_ERROR, "Benchmark must be run in regtest mode");
+            }
+            int nTxs = 10000;
+            if (params.size() >= 3) {
+                nTxs = params[2].get_int();
+            }
+            sample_times.push_back(benchmark_coinscache(nTxs));
+        } else if (benchmarktype == "coinsmap" || benchmarktype == "coinsmap_unordered") {
+            int nEntries = 100000;
+            if (params.size() >= 3) {
+                nEntries = params[2].get_int();
+            }
+            sample_times.push_back(benchmark_coinsmap(nEntries, benchmarktype == "coinsmap_unordered"));
         } else if (benchmarktype == "sendtoaddress") {
             if (Params().NetworkIDString() != "regtest") {
                 throw JSONRPCError(RPC_TYPE_ERROR, "Benchmark must be run in regtest mode");
@@ -6830,6 +6906,32 @@ UniValue oraclessamples(const UniValue& params, bool fHelp, const CPubKey& mypk)
     return (OracleDataSamples(txid, batonaddr, num));
 }
 
+UniValue oraclesseries(const UniValue& params, bool fHelp, const CPubKey& mypk)
+{
+    uint256 txid;
+    int32_t fromheight = 0, toheight = 0, num = 0;
+    bool fColumnar = false;
+    char* batonaddr;
+    if (fHelp || params.size() < 2 || params.size() > 6)
+        throw runtime_error("oraclesseries oracletxid batonaddress [fromheight] [toheight] [num] [columnar]\n"
+                            "returns the samples published to batonaddress between fromheight and toheight (0 for the tip), oldest first, up to num (0 for all)\n"
+                            "with columnar=true the samples are returned as height, txid and data arrays\n"
+                            "requires -oracledataindex\n");
+    if (ensure_CCrequirements(EVAL_ORACLES) < 0)
+        throw runtime_error(CC_REQUIREMENTS_MSG);
+    txid = Parseuint256((char*)params[0].get_str().c_str());
+    batonaddr = (char*)params[1].get_str().c_str();
+    if (params.size() > 2)
+        fromheight = atoi((char*)params[2].get_str().c_str());
+    if (params.size() > 3)
+        toheight = atoi((char*)params[3].get_str().c_str());
+    if (params.size() > 4)
+        num = atoi((char*)params[4].get_str().c_str());
+    if (params.size() > 5)
+        fColumnar = params[5].get_str() == "true" || params[5].get_str() == "1";
+    return (OracleDataSeries(txid, batonaddr, fromheight, toheight, num, fColumnar));
+}
+
 UniValue oraclesdata(const UniValue& params, bool fHelp, const CPubKey& mypk)
 {
     UniValue result(UniValue::VOBJ);
@@ -20,6 +20,7 @@
 
 #include "wallet/wallet.h"
 
+#include "blockreader.h"
 #include "checkpoints.h"
 #include "coincontrol.h"
 #include "consensus/upgrades.h"
@@ -2894,13 +2895,22 @@ int CWallet::ScanForWalletTransactions(CBlockIndex* pindexStart, bool fUpdate)
         ShowProgress(_("Rescanning..."), 0); // show rescan progress in GUI as dialog or on splashscreen, if -rescan on startup
         double dProgressStart = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false);
         double dProgressTip = Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), chainActive.LastTip(), false);
+
+        // the blocks to the tip are read ahead while the ones before are scanned
+        std::vector<CDiskBlockPos> vPos;
+        for (CBlockIndex* pindexRead = pindex; pindexRead; pindexRead = chainActive.Next(pindexRead))
+            vPos.push_back(pindexRead->GetBlockPos());
+        CBlockReader reader(vPos, std::max((int)GetArg("-blockreaderthreads", DEFAULT_BLOCK_READER_THREADS), 0));
+
         while (pindex)
         {
             if (pindex->GetHeight() % 100 == 0 && dProgressTip - dProgressStart > 0.0)
                 ShowProgress(_("Rescanning..."), std::max(1, std::min(99, (int)((Checkpoints::GuessVerificationProgress(chainParams.Checkpoints(), pindex, false) - dProgressStart) / (dProgressTip - dProgressStart) * 100))));
 
             CBlock block;
-            ReadBlockFromDisk(block, pindex,1);
+            bool fRead;
+            if (!reader.Next(block, fRead) || !fRead || block.GetHash() != pindex->GetBlockHash())
+                ReadBlockFromDisk(block, pindex,1);
             BOOST_FOREACH(CTransaction& tx, block.vtx)
             {
                 if (AddToWalletIfInvolvingMe(tx, &block, fUpdate)) {
@@ -1,9 +1,11 @@
+#include <algorithm>
 #include <cstdio>
 #include <future>
 #include <map>
 #include <thread>
 #include <unistd.h>
 #include <boost/filesystem.hpp>
+#include <boost/unordered_map.hpp>
 
 #include "coins.h"
 #include "util.h"
@@ -19,6 +21,8 @@
 #include "miner.h"
 #include "pow.h"
 #include "rpc/server.h"
+#include "script/cc.h"
+#include "script/serverchecker.h"
 #include "script/sign.h"
 #include "sodium.h"
 #include "streams.h"
@@ -434,6 +438,390 @@ double benchmark_connectblock_slow()
     return duration;
 }
 
+extern void komodo_segids(uint8_t *hashbuf,int32_t height,int32_t n); // in komodo_bitcoind.h
+extern uint32_t komodo_stakehash(uint256 *hashp,char *address,uint8_t *hashbuf,uint256 txid,int32_t vout);
+
+// Time one staking round (segid window plus the stake hash of every candidate) over nUtxos synthetic utxos.
+// The first round populates the segid window and stake hash memos, the second one is what a staker pays per block.
+double benchmark_stakinground(size_t nUtxos)
+{
+    std::vector<std::pair<uint256,std::string>> utxos;
+    for (size_t i = 0; i < nUtxos; i++) {
+        CKey key;
+        key.MakeNewKey(true);
+        utxos.push_back(std::make_pair(GetRandHash(), CBitcoinAddress(key.GetPubKey().GetID()).ToString()));
+    }
+
+    int32_t nHeight = chainActive.Height() + 1;
+    uint8_t hashbuf[256]; uint256 hash;
+    struct timeval tv_start;
+    for (int round = 0; round < 2; round++) {
+        timer_start(tv_start);
+        komodo_segids(hashbuf, nHeight - 101, 100);
+        for (size_t i = 0; i < utxos.size(); i++)
+            komodo_stakehash(&hash, (char *)utxos[i].second.c_str(), hashbuf, utxos[i].first, i & 3);
+    }
+    return timer_stop(tv_start);
+}
+
+double benchmark_merkleroot(size_t nTxs)
+{
+    CBlock block;
+    for (size_t i = 0; i < nTxs; i++) {
+        CMutableTransaction mtx;
+        mtx.vin.resize(1);
+        mtx.vin[0].prevout = COutPoint(GetRandHash(), 0);
+        mtx.vout.resize(1);
+        block.vtx.push_back(mtx);
+    }
+    // the txids are cached in the transactions, only the tree is timed
+    struct timeval tv_start;
+    timer_start(tv_start);
+    block.BuildMerkleTree();
+    return timer_stop(tv_start);
+}
+
+double benchmark_ccdecode(size_t nDecodes)
+{
+    // the mixed mode fulfillments of most CC spends: an eval code and a 1 of 1 or a 1 of 2
+    // threshold of secp256k1 keys, as MakeCCcond1 and MakeCCcond1of2 build them
+    std::vector<std::vector<unsigned char>> vBins;
+    for (int nKeys = 1; nKeys <= 2; nKeys++) {
+        CKey key;
+        key.MakeNewKey(true);
+        std::vector<CC*> vSigs;
+        vSigs.push_back(CCNewSecp256k1(key.GetPubKey()));
+        if (nKeys == 2) {
+            CKey other;
+            other.MakeNewKey(true);
+            vSigs.push_back(CCNewSecp256k1(other.GetPubKey()));
+        }
+        CC *cond = CCNewThreshold(2, {CCNewEval(std::vector<unsigned char>(1, 0xe3)), CCNewThreshold(1, vSigs)});
+        uint256 msg = GetRandHash();
+        cc_signTreeSecp256k1Msg32(cond, key.begin(), msg.begin());
+        std::vector<unsigned char> bin(1000);
+        bin.resize(cc_fulfillmentBinaryMixedMode(cond, bin.data(), bin.size()));
+        vBins.push_back(bin);
+        cc_free(cond);
+    }
+
+    struct timeval tv_start;
+    timer_start(tv_start);
+    for (size_t i = 0; i < nDecodes; i++) {
+        const std::vector<unsigned char> &bin = vBins[i % vBins.size()];
+        CC *cond = cc_readFulfillmentBinaryMixedMode(bin.data(), bin.size());
+        assert(cond);
+        cc_free(cond);
+    }
+    return timer_stop(tv_start);
+}
+
+double benchmark_ccsigcache(size_t nInputs, bool fCached)
+{
+    // the signature check of nInputs signed CC inputs at block connect, after (fCached) or without
+    // the check at mempool accept that stores them in the cryptocondition signature cache
+    CMutableTransaction mtx;
+    CTransaction tx(mtx);
+    std::vector<uint256> vSigHashes;
+    std::vector<std::vector<unsigned char>> vConds, vFfills;
+    for (size_t i = 0; i < nInputs; i++) {
+        CKey key;
+        key.MakeNewKey(true);
+        CC *cond = CCNewThreshold(2, {CCNewEval(std::vector<unsigned char>(1, 0xe3)), CCNewThreshold(1, {CCNewSecp256k1(key.GetPubKey())})});
+        uint256 sighash = GetRandHash();
+        cc_signTreeSecp256k1Msg32(cond, key.begin(), sighash.begin());
+        std::vector<unsigned char> bin(1000);
+        bin.resize(cc_conditionBinary(cond, bin.data()));
+        vConds.push_back(bin);
+        bin.resize(1000);
+        bin.resize(cc_fulfillmentBinary(cond, bin.data(), bin.size()));
+        bin.push_back(SIGHASH_ALL);
+        vFfills.push_back(bin);
+        vSigHashes.push_back(sighash);
+        cc_free(cond);
+    }
+
+    if (fCached) {
+        ServerTransactionSignatureChecker checker(&tx, 0, 0, true);
+        for (size_t i = 0; i < nInputs; i++) {
+            CC *cond = cc_readFulfillmentBinary(vFfills[i].data(), vFfills[i].size() - 1);
+            assert(checker.VerifyCryptoConditionSignatures(cond, vSigHashes[i], vConds[i], vFfills[i]));
+            cc_free(cond);
+        }
+    }
+
+    ServerTransactionSignatureChecker checker(&tx, 0, 0, false);
+    struct timeval tv_start;
+    timer_start(tv_start);
+    for (size_t i = 0; i < nInputs; i++) {
+        CC *cond = cc_readFulfillmentBinary(vFfills[i].data(), vFfills[i].size() - 1);
+        assert(checker.VerifyCryptoConditionSignatures(cond, vSigHashes[i], vConds[i], vFfills[i]));
+        cc_free(cond);
+    }
+    return timer_stop(tv_start);
+}
+
+double benchmark_blocktemplate(size_t nTxs)
+{
+    // a mempool of nTxs transactions spending outputs that only exist in a cache over the coins
+    // tip, the timed template follows one that already saw the pool and 100 replaced transactions,
+    // as when a miner asks again after new transactions came in
+    LOCK2(cs_main, mempool.cs);
+    const size_t nChurn = 100;
+    int nHeight = chainActive.Height();
+    uint32_t nBranchId = CurrentEpochBranchId(nHeight + 1, Params().GetConsensus());
+    CCoinsViewCache *pcoinsOld = pcoinsTip;
+    CCoinsViewCache coins(pcoinsOld);
+    std::vector<CTransaction> vtx;
+    std::vector<CAmount> vFees;
+    for (size_t i = 0; i < nTxs + nChurn; i++) {
+        CMutableTransaction prev;
+        prev.vout.resize(1);
+        prev.vout[0].nValue = COIN;
+        prev.vout[0].scriptPubKey = CScript() << OP_TRUE;
+        prev.nLockTime = i;
+        coins.ModifyCoins(prev.GetHash())->FromTx(prev, std::max(nHeight, 0));
+
+        CAmount nFee = 1000 + (i * 7919) % 100000;
+        CMutableTransaction mtx = CreateNewContextualCMutableTransaction(Params().GetConsensus(), nHeight + 1);
+        mtx.vin.push_back(CTxIn(COutPoint(prev.GetHash(), 0)));
+        for (int j = 0; j < 8; j++)
+            mtx.vout.push_back(CTxOut((COIN - nFee) / 8, CScript() << OP_TRUE));
+        vtx.push_back(mtx);
+        vFees.push_back(nFee);
+    }
+
+    CScript scriptPubKey = CScript() << OP_TRUE;
+    std::list<CTransaction> removed;
+    double elapsed = 0;
+    pcoinsTip = &coins;
+    try {
+        for (size_t i = 0; i < nTxs; i++)
+            mempool.addUnchecked(vtx[i].GetHash(), CTxMemPoolEntry(vtx[i], vFees[i], GetTime(), 0, nHeight, true, false, nBranchId));
+        delete CreateNewBlock(CPubKey(), scriptPubKey, KOMODO_MAXGPUCOUNT, false);
+        for (size_t i = 0; i < nChurn; i++) {
+            mempool.remove(vtx[i], removed, false);
+            mempool.addUnchecked(vtx[nTxs + i].GetHash(), CTxMemPoolEntry(vtx[nTxs + i], vFees[nTxs + i], GetTime(), 0, nHeight, true, false, nBranchId));
+        }
+
+        struct timeval tv_start;
+        timer_start(tv_start);
+        CBlockTemplate *pblocktemplate = CreateNewBlock(CPubKey(), scriptPubKey, KOMODO_MAXGPUCOUNT, false);
+        elapsed = timer_stop(tv_start);
+        delete pblocktemplate;
+    } catch (...) {
+        for (size_t i = 0; i < vtx.size(); i++)
+            mempool.remove(vtx[i], removed, false);
+        pcoinsTip = pcoinsOld;
+        throw;
+    }
+    for (size_t i = 0; i < vtx.size(); i++)
+        mempool.remove(vtx[i], removed, false);
+    pcoinsTip = pcoinsOld;
+    return elapsed;
+}
+
+double benchmark_indexdb(size_t nBlocks)
+{
+    // the index writes of a -reindex with every index enabled, into memory databases so the
+    // split of the families and the write buffers are measured rather than the disk
+    const size_t nTxs = 200;
+    CIndexDBCaches caches;
+    for (int i = 0; i < INDEXDB_COUNT; i++)
+        caches[i] = CIndexDBCache(8 << 20, (i == INDEXDB_ADDRESS || i == INDEXDB_SPENT) ? 4 << 20 : 0);
+    CBlockTreeDB db(8 << 20, true, false, true, 1000, caches);
+
+    std::vector<uint256> vHashes(nBlocks);
+    std::vector<CBlockIndex> vIndex(nBlocks);
+    std::vector<const CBlockIndex*> vDirty;
+    std::vector<std::pair<int, const CBlockFileInfo*> > vFiles;
+    std::vector<CAddressUnspentKey> vPrevUnspent;
+    double elapsed = 0;
+    for (size_t n = 0; n < nBlocks; n++) {
+        std::vector<std::pair<uint256, CDiskTxPos> > vTxPos;
+        std::vector<std::pair<CAddressIndexKey, CAmount> > vAddress;
+        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > vUnspent;
+        std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > vSpent;
+        std::vector<CAddressUnspentKey> vNewUnspent;
+        vHashes[n] = GetRandHash();
+        vIndex[n].phashBlock = &vHashes[n];
+        vIndex[n].SetHeight(n);
+        for (size_t i = 0; i < nTxs; i++) {
+            uint256 txid = GetRandHash();
+            uint160 addr;
+            GetRandBytes(addr.begin(), addr.size());
+            vTxPos.push_back(std::make_pair(txid, CDiskTxPos(CDiskBlockPos(0, n * 100000), i * 250)));
+            vAddress.push_back(std::make_pair(CAddressIndexKey(1, addr, n, i, txid, 0, false), 100000));
+            CAddressUnspentKey key(1, addr, txid, 0);
+            vUnspent.push_back(std::make_pair(key, CAddressUnspentValue(100000, CScript(), n)));
+            vNewUnspent.push_back(key);
+            // each tx spends an output of the previous block
+            if (i < vPrevUnspent.size()) {
+                const CAddressUnspentKey &prev = vPrevUnspent[i];
+                vAddress.push_back(std::make_pair(CAddressIndexKey(1, prev.hashBytes, n, i, txid, 0, true), -100000));
+                vUnspent.push_back(std::make_pair(prev, CAddressUnspentValue()));
+                vSpent.push_back(std::make_pair(CSpentIndexKey(prev.txhash, prev.index), CSpentIndexValue(txid, 0, n, 100000, 1, prev.hashBytes)));
+            }
+        }
+        vPrevUnspent.swap(vNewUnspent);
+
+        struct timeval tv_start;
+        timer_start(tv_start);
+        db.WriteTxIndex(vTxPos);
+        db.WriteAddressIndex(vAddress);
+        db.UpdateAddressUnspentIndex(vUnspent);
+        db.UpdateSpentIndex(vSpent);
+        db.WriteTimestampIndex(CTimestampIndexKey(n, vHashes[n]));
+        // the block index is flushed now and then, as FlushStateToDisk does
+        vDirty.push_back(&vIndex[n]);
+        if (vDirty.size() == 100 || n + 1 == nBlocks) {
+            db.WriteBatchSync(vFiles, 0, vDirty);
+            vDirty.clear();
+        }
+        elapsed += timer_stop(tv_start);
+    }
+    return elapsed;
+}
+
+double benchmark_coinscache(size_t nTxs)
+{
+    // nTxs transactions spending outputs that only exist in a cache over the coins tip. Times
+    // accepting them to the mempool, then the coins work ConnectBlock does for them: the input
+    // lookups, UpdateCoins on a cache over the tip and the flush into it
+    LOCK(cs_main);
+    int nHeight = chainActive.Height();
+    CCoinsViewCache *pcoinsOld = pcoinsTip;
+    CCoinsViewCache coins(pcoinsOld);
+    std::vector<CTransaction> vtx;
+    for (size_t i = 0; i < nTxs; i++) {
+        CMutableTransaction prev;
+        prev.vout.resize(2);
+        for (int j = 0; j < 2; j++) {
+            prev.vout[j].nValue = COIN;
+            prev.vout[j].scriptPubKey = CScript() << OP_TRUE;
+        }
+        prev.nLockTime = i;
+        coins.ModifyCoins(prev.GetHash())->FromTx(prev, std::max(nHeight, 0));
+
+        CMutableTransaction mtx = CreateNewContextualCMutableTransaction(Params().GetConsensus(), nHeight + 1);
+        mtx.vin.push_back(CTxIn(COutPoint(prev.GetHash(), 0)));
+        mtx.vin.push_back(CTxIn(COutPoint(prev.GetHash(), 1)));
+        for (int j = 0; j < 4; j++)
+            mtx.vout.push_back(CTxOut((2 * COIN - 10000) / 4, CScript() << OP_TRUE));
+        vtx.push_back(mtx);
+    }
+
+    std::list<CTransaction> removed;
+    struct timeval tv_start;
+    double elapsed = 0;
+    pcoinsTip = &coins;
+    try {
+        timer_start(tv_start);
+        for (size_t i = 0; i < vtx.size(); i++) {
+            CValidationState state;
+            bool fMissingInputs;
+            if (!AcceptToMemoryPool(mempool, state, vtx[i], false, &fMissingInputs))
+                throw std::runtime_error("benchmark transaction rejected: " + state.GetRejectReason());
+        }
+        elapsed += timer_stop(tv_start);
+    } catch (...) {
+        LOCK(mempool.cs);
+        for (size_t i = 0; i < vtx.size(); i++)
+            mempool.remove(vtx[i], removed, false);
+        pcoinsTip = pcoinsOld;
+        throw;
+    }
+    {
+        LOCK(mempool.cs);
+        for (size_t i = 0; i < vtx.size(); i++)
+            mempool.remove(vtx[i], removed, false);
+    }
+    pcoinsTip = pcoinsOld;
+
+    timer_start(tv_start);
+    {
+        CCoinsViewCache view(&coins);
+        for (size_t i = 0; i < vtx.size(); i++) {
+            assert(view.HaveInputs(vtx[i]));
+            UpdateCoins(vtx[i], view, nHeight + 1);
+        }
+        view.Flush();
+    }
+    elapsed += timer_stop(tv_start);
+    return elapsed;
+}
+
+template<typename Map>
+static double benchmark_coinsmap_ops(size_t nEntries)
+{
+    // the map work of a coins cache: ModifyCoins of txids not yet cached, AccessCoins of cached
+    // and of unknown txids, then the BatchWrite walk erasing every entry
+    std::vector<uint256> vKeys, vAbsent;
+    for (size_t i = 0; i < nEntries; i++) {
+        vKeys.push_back(GetRandHash());
+        vAbsent.push_back(GetRandHash());
+    }
+    std::vector<uint256> vLookups(vKeys);
+    std::random_shuffle(vLookups.begin(), vLookups.end());
+
+    Map cacheCoins;
+    size_t nFound = 0;
+    struct timeval tv_start;
+    timer_start(tv_start);
+    for (size_t i = 0; i < vKeys.size(); i++) {
+        typename Map::iterator it = cacheCoins.find(vKeys[i]);
+        if (it == cacheCoins.end()) {
+            it = cacheCoins.insert(std::make_pair(vKeys[i], CCoinsCacheEntry())).first;
+            it->second.coins.vout.resize(2);
+            it->second.flags = CCoinsCacheEntry::DIRTY | CCoinsCacheEntry::FRESH;
+        }
+    }
+    for (size_t i = 0; i < vLookups.size(); i++)
+        nFound += cacheCoins.find(vLookups[i]) != cacheCoins.end();
+    for (size_t i = 0; i < vAbsent.size(); i++)
+        nFound += cacheCoins.count(vAbsent[i]);
+    for (typename Map::iterator it = cacheCoins.begin(); it != cacheCoins.end(); ) {
+        typename Map::iterator itOld = it++;
+        cacheCoins.erase(itOld);
+    }
+    double elapsed = timer_stop(tv_start);
+    assert(nFound == nEntries);
+    return elapsed;
+}
+
+double benchmark_coinsmap(size_t nEntries, bool fUnordered)
+{
+    // fUnordered runs it on the boost::unordered_map CCoinsMap was before it became a flathashmap
+    if (fUnordered)
+        return benchmark_coinsmap_ops<boost::unordered_map<uint256, CCoinsCacheEntry, CCoinsKeyHasher> >(nEntries);
+    return benchmark_coinsmap_ops<CCoinsMap>(nEntries);
+}
+
+double benchmark_rpcbatch(size_t nRequests)
+{
+    int nHeight;
+    {
+        LOCK(cs_main);
+        nHeight = chainActive.Height();
+    }
+    // getblock of the latest blocks, the batch runs as if it came from the HTTP server
+    UniValue batch(UniValue::VARR);
+    for (size_t i = 0; i < nRequests; i++) {
+        UniValue params(UniValue::VARR);
+        params.push_back(std::to_string(nHeight - (int)(i % (nHeight + 1))));
+        UniValue request(UniValue::VOBJ);
+        request.push_back(Pair("method", "getblock"));
+        request.push_back(Pair("params", params));
+        request.push_back(Pair("id", (int)i));
+        batch.push_back(request);
+    }
+
+    struct timeval tv_start;
+    timer_start(tv_start);
+    JSONRPCExecBatch(batch);
+    return timer_stop(tv_start);
+}
+
 extern UniValue getnewaddress(const UniValue& params, bool fHelp, const CPubKey& mypk); // in rpcwallet.cpp
 extern UniValue sendtoaddress(const UniValue& params, bool fHelp, const CPubKey& mypk);
 
@@ -16,6 +16,15 @@ extern double benchmark_large_tx(size_t nInputs);
 extern double benchmark_try_decrypt_notes(size_t nAddrs);
 extern double benchmark_increment_note_witnesses(size_t nTxs);
 extern double benchmark_connectblock_slow();
+extern double benchmark_stakinground(size_t nUtxos);
+extern double benchmark_merkleroot(size_t nTxs);
+extern double benchmark_ccdecode(size_t nDecodes);
+extern double benchmark_ccsigcache(size_t nInputs, bool fCached);
+extern double benchmark_blocktemplate(size_t nTxs);
+extern double benchmark_indexdb(size_t nBlocks);
+extern double benchmark_coinscache(size_t nTxs);
+extern double benchmark_coinsmap(size_t nEntries, bool fUnordered);
+extern double benchmark_rpcbatch(size_t nRequests);
 extern double benchmark_sendtoaddress(CAmount amount);
 extern double benchmark_loadwallet();
 extern double benchmark_listunspent();